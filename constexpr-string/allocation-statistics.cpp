@@ -0,0 +1,689 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is to measure how strings
+// use their storage, so that the small buffer capacity and growth factor can be
+// chosen from real workloads. The string is the clang-abi-compatible string.
+//
+// allocator_traits is the one place every allocation passes through, so it
+// records allocations and deallocations. The string records its own growth and,
+// when it is destroyed or overwritten, whether it ever left the small buffer.
+// Compile with -DSTRING_STATISTICS=1 to turn this on. Without it, nothing is
+// recorded and the string has the same layout as clang-abi-compatible.
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <climits>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+template<typename T>
+struct buffer {
+	constexpr buffer() = default;
+	buffer(buffer &&) = delete;
+	buffer(buffer const &) = delete;
+	buffer & operator=(buffer &&) = delete;
+	buffer & operator=(buffer const &) = delete;
+
+	T data[5000] = {};
+	T * pointer = data;
+};
+
+template<typename T>
+struct allocator {
+	using value_type = T;
+
+	explicit constexpr allocator(buffer<T> & buffer):
+		buffer_(&buffer)
+	{
+	}
+
+	constexpr auto allocate(std::size_t size) {
+		auto const result = buffer_->pointer;
+		buffer_->pointer += size;
+		return result;
+	}
+	constexpr void deallocate(T * ptr, std::size_t size) {
+	}
+
+private:
+	buffer<T> * buffer_;
+};
+
+
+// Define STRING_STATISTICS to 1 to collect statistics. Otherwise, every
+// record_ function is empty and string has no extra members.
+#ifndef STRING_STATISTICS
+	#define STRING_STATISTICS 0
+#endif
+
+constexpr auto collect_statistics = bool(STRING_STATISTICS);
+
+struct statistics_snapshot {
+	std::size_t allocations;
+	std::size_t deallocations;
+	std::size_t bytes_requested;
+	std::size_t bytes_held;
+	std::size_t peak_bytes_held;
+	std::size_t growth_events;
+	std::size_t strings;
+	std::size_t strings_always_small;
+	// growth_by_capacity[n] counts the strings that grew away from a capacity
+	// c where std::bit_width(c) == n.
+	std::array<std::size_t, std::numeric_limits<std::size_t>::digits + 1> growth_by_capacity;
+
+	constexpr double always_small_fraction() const {
+		return strings == 0 ? 0.0 : static_cast<double>(strings_always_small) / static_cast<double>(strings);
+	}
+};
+
+// Counters are shared by all strings, so they are updated with relaxed atomics
+// to allow strings to be used from multiple threads. Nothing is recorded during
+// constant evaluation.
+struct statistics {
+	static constexpr void record_allocation(std::size_t const bytes) {
+		if constexpr (collect_statistics) {
+			if (!std::is_constant_evaluated()) {
+				allocations.fetch_add(1, std::memory_order_relaxed);
+				bytes_requested.fetch_add(bytes, std::memory_order_relaxed);
+				auto const held = bytes_held.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+				auto peak = peak_bytes_held.load(std::memory_order_relaxed);
+				while (peak < held and !peak_bytes_held.compare_exchange_weak(peak, held, std::memory_order_relaxed)) {
+				}
+			}
+		}
+	}
+	static constexpr void record_deallocation(std::size_t const bytes) {
+		if constexpr (collect_statistics) {
+			if (!std::is_constant_evaluated()) {
+				deallocations.fetch_add(1, std::memory_order_relaxed);
+				bytes_held.fetch_sub(bytes, std::memory_order_relaxed);
+			}
+		}
+	}
+	static constexpr void record_growth(std::size_t const old_capacity) {
+		if constexpr (collect_statistics) {
+			if (!std::is_constant_evaluated()) {
+				growth_events.fetch_add(1, std::memory_order_relaxed);
+				growth_by_capacity[static_cast<std::size_t>(std::bit_width(old_capacity))].fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+	}
+	static constexpr void record_lifetime(bool const was_ever_large) {
+		if constexpr (collect_statistics) {
+			if (!std::is_constant_evaluated()) {
+				strings.fetch_add(1, std::memory_order_relaxed);
+				if (!was_ever_large) {
+					strings_always_small.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+		}
+	}
+
+	static statistics_snapshot snapshot() {
+		auto result = statistics_snapshot{
+			allocations.load(std::memory_order_relaxed),
+			deallocations.load(std::memory_order_relaxed),
+			bytes_requested.load(std::memory_order_relaxed),
+			bytes_held.load(std::memory_order_relaxed),
+			peak_bytes_held.load(std::memory_order_relaxed),
+			growth_events.load(std::memory_order_relaxed),
+			strings.load(std::memory_order_relaxed),
+			strings_always_small.load(std::memory_order_relaxed),
+			{}
+		};
+		for (std::size_t n = 0; n != growth_by_capacity.size(); ++n) {
+			result.growth_by_capacity[n] = growth_by_capacity[n].load(std::memory_order_relaxed);
+		}
+		return result;
+	}
+	static void reset() {
+		for (auto * counter : {&allocations, &deallocations, &bytes_requested, &bytes_held, &peak_bytes_held, &growth_events, &strings, &strings_always_small}) {
+			counter->store(0, std::memory_order_relaxed);
+		}
+		for (auto & counter : growth_by_capacity) {
+			counter.store(0, std::memory_order_relaxed);
+		}
+	}
+
+private:
+	using counter = std::atomic<std::size_t>;
+	static inline counter allocations = 0;
+	static inline counter deallocations = 0;
+	static inline counter bytes_requested = 0;
+	static inline counter bytes_held = 0;
+	static inline counter peak_bytes_held = 0;
+	static inline counter growth_events = 0;
+	static inline counter strings = 0;
+	static inline counter strings_always_small = 0;
+	static inline std::array<counter, std::tuple_size_v<decltype(statistics_snapshot::growth_by_capacity)>> growth_by_capacity{};
+};
+
+
+// Tracks whether a string value ever needed the heap. A moved-from string is
+// not counted again unless it grows into the heap itself.
+enum class lifetime : unsigned char {
+	always_small,
+	was_large,
+	moved_from
+};
+
+template<bool enabled>
+struct lifetime_tracker {
+	constexpr void set(lifetime const value) {
+		value_ = value;
+	}
+	constexpr void record() const {
+		if (value_ != lifetime::moved_from) {
+			statistics::record_lifetime(value_ == lifetime::was_large);
+		}
+	}
+private:
+	lifetime value_ = lifetime::always_small;
+};
+
+template<>
+struct lifetime_tracker<false> {
+	constexpr void set(lifetime) {
+	}
+	constexpr void record() const {
+	}
+};
+
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		statistics::record_allocation(size * sizeof(value_type));
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		statistics::record_deallocation(size * sizeof(value_type));
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = allocator<char>;
+
+private:
+	static constexpr std::size_t small_buffer_capacity = 23;
+
+	struct small_t {
+		char data[small_buffer_capacity] = {};
+	};
+	struct [[gnu::packed]] large_t {
+		static constexpr std::size_t bytes_remaining = 7;
+
+		template<typename It>
+		class range_view {
+		public:
+			constexpr range_view(It first, It last):
+				first_(first),
+				last_(last)
+			{
+			}
+			constexpr auto begin() const {
+				return first_;
+			}
+			constexpr auto end() const {
+				return last_;
+			}
+		private:
+			It first_;
+			It last_;
+		};
+
+		constexpr auto little_endian_capacity() const {
+			return range_view(
+				std::rbegin(rest_of_capacity),
+				std::rend(rest_of_capacity)
+			);
+		}
+		constexpr auto big_endian_capacity() {
+			return range_view(
+				std::begin(rest_of_capacity),
+				std::end(rest_of_capacity)
+			);
+		}
+
+		constexpr large_t(std::size_t set_size, std::size_t capacity, char * pointer) noexcept:
+			rest_of_capacity{},
+			size(set_size),
+			data(pointer)
+		{
+			assert(data != nullptr);
+			for (unsigned char & byte : big_endian_capacity()) {
+				capacity >>= CHAR_BIT;
+				byte = capacity;
+			}
+		}
+
+		unsigned char rest_of_capacity[bytes_remaining];
+		std::size_t size;
+		char * data;
+	};
+
+	[[no_unique_address]] allocator_type allocator_;
+	unsigned char size_or_first_byte_of_capacity_;
+	union U {
+		constexpr U() noexcept:
+			small{}
+		{
+		}
+		explicit constexpr U(std::size_t size, std::size_t capacity, char * data) noexcept:
+			large(size, capacity, data)
+		{
+		}
+		constexpr U(large_t set_large) noexcept:
+			large(set_large)
+		{
+		}
+
+		small_t small;
+		large_t large;
+	} u_;
+	[[no_unique_address]] lifetime_tracker<collect_statistics> lifetime_;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return size_or_first_byte_of_capacity_ & 1;
+	}
+
+	constexpr void increment_size() {
+		if (is_large()) {
+			++u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ += (1 << 1);
+		}
+	}
+	constexpr void decrement_size() {
+		if (is_large()) {
+			--u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ -= (1 << 1);
+		}
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, u_.large.data, capacity());
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		auto const old_capacity = capacity();
+		if (new_capacity > old_capacity) {
+			statistics::record_growth(old_capacity);
+		}
+		lifetime_.set(lifetime::was_large);
+		deallocate();
+		u_ = U(size(), new_capacity, new_data);
+		assert(new_capacity & 1);
+		size_or_first_byte_of_capacity_ = new_capacity;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		new_capacity |= 1;
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy(begin(), end(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		size_or_first_byte_of_capacity_(0),
+		u_{},
+		lifetime_{}
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		lifetime_.set(lifetime::moved_from);
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		lifetime_.record();
+		deallocate();
+		lifetime_ = other.lifetime_;
+		other.lifetime_.set(lifetime::moved_from);
+
+		if (other.is_large()) {
+			u_ = U(other.u_.large);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+
+			other.u_ = U{};
+			other.size_or_first_byte_of_capacity_ = 0;
+		} else {
+			auto & osmall = other.u_.small;
+			u_ = U{};
+			copy(osmall.data, osmall.data + (other.size_or_first_byte_of_capacity_ >> 1), u_.small.data);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		lifetime_.record();
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr char * data() {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr std::size_t size() const {
+		return is_large() ? u_.large.size : (size_or_first_byte_of_capacity_ >> 1);
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		if (!is_large()) {
+			return small_buffer_capacity;
+		}
+		std::size_t result = 0;
+		for (unsigned char const byte : u_.large.little_endian_capacity()) {
+			result |= byte;
+			result <<= CHAR_BIT;
+		}
+		result |= size_or_first_byte_of_capacity_;
+		return result;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		auto const local_size = size();
+		if (is_large() && capacity() > (local_size | 1)) {
+			if (local_size > small_buffer_capacity) {
+				force_reserve(local_size);
+			} else {
+				auto const data = u_.large.data;
+				auto const original_capacity = capacity();
+				u_ = U{};
+				size_or_first_byte_of_capacity_ = local_size << 1;
+				copy(data, data + local_size, u_.small.data);
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = std::prev(end());
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = (capacity() * growth_factor) | 1;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+
+			relocate(temp, new_capacity);
+		}
+		increment_size();
+		return begin() + offset;
+	}
+
+	constexpr void pop_back() {
+		decrement_size();
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+
+static_assert(collect_statistics or sizeof(string) == sizeof(string::allocator_type) + 24);
+
+constexpr void test_individual(string & str, char const * source) {
+	string temp(str.get_allocator());
+	for (auto it = source; *it != '\0'; ++it) {
+		str.insert(str.end(), *it);
+		temp.insert(temp.end(), *it);
+	}
+
+	temp.insert(temp.begin(), 'a');
+	temp.insert(temp.begin() + temp.size() / 2, 'b');
+	auto const size = std::char_traits<char>::length(source);
+	auto const middle = (size + 1) / 2;
+	assert(temp.size() == size + 2);
+	for (std::size_t n = 0; n != temp.size(); ++n) {
+		auto const expected = n == 0 ? 'a' : n == middle ? 'b' : n < middle ? source[n - 1] : source[n - 2];
+		assert(temp.data()[n] == expected);
+	}
+
+	// Inserting at the front, including each time that reallocates
+	string front(str.get_allocator());
+	for (std::size_t n = 0; n != 100; ++n) {
+		front.insert(front.begin(), static_cast<char>('0' + n % 10));
+	}
+	for (std::size_t n = 0; n != front.size(); ++n) {
+		assert(front.data()[n] == static_cast<char>('0' + (99 - n) % 10));
+	}
+
+	while (temp.size() != 0) {
+		temp.pop_back();
+	}
+	assert(temp.size() == 0);
+
+	auto temp2 = std::move(str);
+	str = std::move(temp2);
+
+	assert(str.data() != temp.data());
+	assert(str.size() == std::char_traits<char>::length(source));
+	assert(std::char_traits<char>::compare(str.data(), source, str.size()) == 0);
+	assert(str.capacity() >= str.size());
+
+	str.reserve(50);
+	str.shrink_to_fit();
+}
+
+constexpr bool test() {
+	buffer<char> buff{};
+	auto alloc = allocator(buff);
+
+	char const * short_source = "0123";
+	char const * long_source =
+		"0123456789"
+		"0123456789"
+		"0123456789"
+		"0123456789"
+		"0123456789";
+
+	string short_str(alloc);
+	test_individual(short_str, short_source);
+
+	string long_str(alloc);
+	test_individual(long_str, long_source);
+
+	assert(short_str.data() != long_str.data());
+
+	string temp(alloc);
+	temp = std::move(long_str);
+	temp = std::move(short_str);
+
+	return true;
+}
+
+void test_statistics() {
+	statistics::reset();
+	{
+		buffer<char> buff{};
+		auto alloc = allocator(buff);
+		string short_str(alloc);
+		string long_str(alloc);
+		for (char const c : "0123456789""0123456789""0123456789""0123456789""0123456789") {
+			if (short_str.size() < 4) {
+				short_str.insert(short_str.end(), c);
+			}
+			long_str.insert(long_str.end(), c);
+		}
+		// Neither the moved-from string nor the string it is assigned over
+		// is a separate value of its own
+		auto moved = std::move(long_str);
+		long_str = std::move(moved);
+	}
+	auto const result = statistics::snapshot();
+	if constexpr (collect_statistics) {
+		// 23 -> 47 -> 95
+		assert(result.allocations == 2);
+		assert(result.deallocations == 2);
+		assert(result.bytes_requested == 47 + 95);
+		assert(result.bytes_held == 0);
+		assert(result.peak_bytes_held == 47 + 95);
+		assert(result.growth_events == 2);
+		assert(result.growth_by_capacity[std::bit_width(23U)] == 1);
+		assert(result.growth_by_capacity[std::bit_width(47U)] == 1);
+		assert(result.strings == 2);
+		assert(result.strings_always_small == 1);
+		assert(result.always_small_fraction() == 0.5);
+	} else {
+		assert(result.allocations == 0);
+		assert(result.strings == 0);
+	}
+}
+
+void print(statistics_snapshot const & result) {
+	std::printf("allocations: %zu\n", result.allocations);
+	std::printf("deallocations: %zu\n", result.deallocations);
+	std::printf("bytes requested: %zu\n", result.bytes_requested);
+	std::printf("bytes held: %zu (peak %zu)\n", result.bytes_held, result.peak_bytes_held);
+	std::printf("growth events: %zu\n", result.growth_events);
+	std::printf("strings always small: %zu of %zu (%.1f%%)\n", result.strings_always_small, result.strings, 100.0 * result.always_small_fraction());
+	std::printf("growth from capacity:\n");
+	for (std::size_t n = 1; n != result.growth_by_capacity.size(); ++n) {
+		if (result.growth_by_capacity[n] != 0) {
+			std::printf("\t[%zu, %zu]: %zu\n", std::size_t(1) << (n - 1), (std::size_t(1) << (n - 1)) * 2 - 1, result.growth_by_capacity[n]);
+		}
+	}
+}
+
+int main() {
+	test();
+	static_assert(test());
+	test_statistics();
+	if constexpr (collect_statistics) {
+		statistics::reset();
+		test();
+		print(statistics::snapshot());
+	} else {
+		std::printf("Compile with -DSTRING_STATISTICS=1 to collect statistics\n");
+	}
+}
@@ -0,0 +1,1072 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is to append numbers to
+// both layouts without formatting them somewhere else first.
+//
+// append_and_overwrite makes room for a number at the end of the string,
+// growing it only if its spare capacity is not enough, and then the number is
+// written straight into the string. Integers can be in any base from 2 to 36
+// and padded to a width. Their exact size is counted first. Base 10 is then
+// written two digits at a time, which also works in constant evaluation, and
+// the other bases use std::to_chars. Floating point numbers are written with
+// std::to_chars in the shortest form that reads back as the same value, or in
+// fixed notation with a given precision, and only at run time.
+//
+// This builds on concatenation.cpp, which added the range append.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+// char is trivial, so outside of constant evaluation the characters can be
+// copied with memcpy instead of being constructed one at a time
+template<typename Allocator>
+constexpr char * copy_characters(Allocator alloc, char const * const first, char const * const last, char * const out) {
+	if (std::is_constant_evaluated()) {
+		return uninitialized_copy(alloc, first, last, out);
+	}
+	auto const count = static_cast<std::size_t>(last - first);
+	if (count != 0) {
+		std::memcpy(out, first, count);
+	}
+	return out + count;
+}
+
+
+namespace clang {
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	static constexpr std::size_t small_buffer_capacity = 23;
+
+	struct small_t {
+		char data[small_buffer_capacity] = {};
+	};
+	struct [[gnu::packed]] large_t {
+		static constexpr std::size_t bytes_remaining = 7;
+
+		template<typename It>
+		class range_view {
+		public:
+			constexpr range_view(It first, It last):
+				first_(first),
+				last_(last)
+			{
+			}
+			constexpr auto begin() const {
+				return first_;
+			}
+			constexpr auto end() const {
+				return last_;
+			}
+		private:
+			It first_;
+			It last_;
+		};
+
+		constexpr auto little_endian_capacity() const {
+			return range_view(
+				std::rbegin(rest_of_capacity),
+				std::rend(rest_of_capacity)
+			);
+		}
+		constexpr auto big_endian_capacity() {
+			return range_view(
+				std::begin(rest_of_capacity),
+				std::end(rest_of_capacity)
+			);
+		}
+
+		constexpr large_t(std::size_t set_size, std::size_t capacity, char * pointer) noexcept:
+			rest_of_capacity{},
+			size(set_size),
+			data(pointer)
+		{
+			assert(data != nullptr);
+			for (unsigned char & byte : big_endian_capacity()) {
+				capacity >>= CHAR_BIT;
+				byte = capacity;
+			}
+		}
+
+		unsigned char rest_of_capacity[bytes_remaining];
+		std::size_t size;
+		char * data;
+	};
+
+	[[no_unique_address]] allocator_type allocator_;
+	unsigned char size_or_first_byte_of_capacity_;
+	union U {
+		constexpr U() noexcept:
+			small{}
+		{
+		}
+		explicit constexpr U(std::size_t size, std::size_t capacity, char * data) noexcept:
+			large(size, capacity, data)
+		{
+		}
+		constexpr U(large_t set_large) noexcept:
+			large(set_large)
+		{
+		}
+
+		small_t small;
+		large_t large;
+	} u_;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return size_or_first_byte_of_capacity_ & 1;
+	}
+
+	constexpr void increment_size() {
+		if (is_large()) {
+			++u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ += (1 << 1);
+		}
+	}
+	constexpr void set_size(std::size_t const new_size) {
+		if (is_large()) {
+			u_.large.size = new_size;
+		} else {
+			size_or_first_byte_of_capacity_ = static_cast<unsigned char>(new_size << 1);
+		}
+	}
+	constexpr void decrement_size() {
+		if (is_large()) {
+			--u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ -= (1 << 1);
+		}
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, u_.large.data, capacity());
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(size(), new_capacity, new_data);
+		assert(new_capacity & 1);
+		size_or_first_byte_of_capacity_ = new_capacity;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		new_capacity |= 1;
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy_characters(alloc, data(), data() + size(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		size_or_first_byte_of_capacity_(0),
+		u_{}
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.large);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+
+			other.u_ = U{};
+			other.size_or_first_byte_of_capacity_ = 0;
+		} else {
+			auto & osmall = other.u_.small;
+			u_ = U{};
+			copy(osmall.data, osmall.data + (other.size_or_first_byte_of_capacity_ >> 1), u_.small.data);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr char * data() {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr std::size_t size() const {
+		return is_large() ? u_.large.size : (size_or_first_byte_of_capacity_ >> 1);
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		if (!is_large()) {
+			return small_buffer_capacity;
+		}
+		// The bytes after the first are the rest of the capacity in
+		// little-endian order, so on a little-endian target this is one load
+		// instead of a loop. append_and_overwrite checks the capacity for
+		// every number.
+		if (!std::is_constant_evaluated() and std::endian::native == std::endian::little) {
+			auto rest = std::size_t(0);
+			std::memcpy(&rest, u_.large.rest_of_capacity, large_t::bytes_remaining);
+			return (rest << CHAR_BIT) | size_or_first_byte_of_capacity_;
+		}
+		std::size_t result = 0;
+		for (unsigned char const byte : u_.large.little_endian_capacity()) {
+			result |= byte;
+			result <<= CHAR_BIT;
+		}
+		result |= size_or_first_byte_of_capacity_;
+		return result;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		auto const local_size = size();
+		if (is_large() && capacity() > (local_size | 1)) {
+			if (local_size > small_buffer_capacity) {
+				force_reserve(local_size);
+			} else {
+				auto const data = u_.large.data;
+				auto const original_capacity = capacity();
+				u_ = U{};
+				size_or_first_byte_of_capacity_ = local_size << 1;
+				copy(data, data + local_size, u_.small.data);
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = std::prev(end());
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = (capacity() * growth_factor) | 1;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+
+			relocate(temp, new_capacity);
+		}
+		increment_size();
+		return begin() + offset;
+	}
+
+	// Range append, which the proposal leaves out for brevity. A reallocation
+	// at least doubles the capacity, like insert, and copies the old
+	// characters and the new ones straight into place. That also makes it
+	// safe to append part of the string to itself.
+	constexpr void append(char const * const first, char const * const last) {
+		auto const new_size = size() + static_cast<std::size_t>(last - first);
+		auto alloc = get_allocator();
+		if (new_size <= capacity()) {
+			copy_characters(alloc, first, last, end());
+		} else {
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = std::max(new_size, capacity() * growth_factor) | 1;
+			char * temp = Alloc::allocate(alloc, new_capacity);
+			copy_characters(alloc, first, last, copy_characters(alloc, data(), data() + size(), temp));
+			relocate(temp, new_capacity);
+		}
+		set_size(new_size);
+	}
+
+	// Makes room for up to max_count more characters, then operation writes
+	// characters starting at the end and returns where it stopped. This is
+	// like resize_and_overwrite, except that it keeps what is already there.
+	template<typename Operation>
+	constexpr void append_and_overwrite(std::size_t const max_count, Operation operation) {
+		auto const required = size() + max_count;
+		if (required > capacity()) {
+			constexpr auto growth_factor = std::size_t{2};
+			force_reserve(std::max(required, capacity() * growth_factor));
+		}
+		char * const last = operation(end());
+		set_size(static_cast<std::size_t>(last - begin()));
+	}
+
+	constexpr void pop_back() {
+		decrement_size();
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace clang
+
+namespace gcc {
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	[[no_unique_address]] allocator_type allocator_;
+	// This could be set to 8 to reduce the size of our string to 24 bytes
+	// (just like clang), but 7 characters (plus a null terminator) is likely
+	// too small of a buffer for most users.
+	static constexpr std::size_t small_buffer_capacity = 16;
+	union U{
+		constexpr U():
+			buffer{}
+		{
+		}
+		constexpr U(std::size_t c):
+			capacity(c)
+		{
+		}
+
+		char buffer[small_buffer_capacity];
+		std::size_t capacity;
+	} u_;
+	char * data_;
+	std::size_t size_ : 63;
+	// gcc and MSVC do not allow accessing the inactive member of a union just
+	// to get its address, so we use a bitfield to work around this.
+	bool is_large_ : 1;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return is_large_;
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, data_, u_.capacity);
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(new_capacity);
+		data_ = new_data;
+		is_large_ = true;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy_characters(alloc, data(), data() + size(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_{},
+		data_(u_.buffer),
+		size_(0),
+		is_large_(false)
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.capacity);
+			other.u_ = U{};
+		
+			data_ = other.data_;
+			other.data_ = other.u_.buffer;
+		
+			size_ = other.size_;
+			other.size_ = 0U;
+		
+			is_large_ = true;
+			other.is_large_ = false;
+
+		} else {
+			u_ = U{};
+			copy(other.data_, other.data_ + other.size_, u_.buffer);
+			data_ = u_.buffer;
+			size_ = other.size_;
+			is_large_ = false;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return data_;
+	}
+	constexpr char * data() {
+		return data_;
+	}
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		return is_large() ? u_.capacity : small_buffer_capacity;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		if (is_large() && capacity() > size()) {
+			if (size() > small_buffer_capacity) {
+				force_reserve(size());
+			} else {
+				auto const data = data_;
+				auto const original_capacity = u_.capacity;
+				u_ = U{};
+				copy(data, data + size_, u_.buffer);
+				data_ = u_.buffer;
+				is_large_ = false;
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = end() - 1;
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = capacity() * growth_factor;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+		
+			relocate(temp, new_capacity);
+		}
+		++size_;
+		return begin() + offset;
+	}
+
+	// Range append, which the proposal leaves out for brevity. A reallocation
+	// at least doubles the capacity, like insert, and copies the old
+	// characters and the new ones straight into place. That also makes it
+	// safe to append part of the string to itself.
+	constexpr void append(char const * const first, char const * const last) {
+		auto const new_size = size() + static_cast<std::size_t>(last - first);
+		auto alloc = get_allocator();
+		if (new_size <= capacity()) {
+			copy_characters(alloc, first, last, end());
+		} else {
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = std::max(new_size, capacity() * growth_factor);
+			char * temp = Alloc::allocate(alloc, new_capacity);
+			copy_characters(alloc, first, last, copy_characters(alloc, data(), data() + size(), temp));
+			relocate(temp, new_capacity);
+		}
+		size_ = new_size;
+	}
+
+	// Makes room for up to max_count more characters, then operation writes
+	// characters starting at the end and returns where it stopped. This is
+	// like resize_and_overwrite, except that it keeps what is already there.
+	template<typename Operation>
+	constexpr void append_and_overwrite(std::size_t const max_count, Operation operation) {
+		auto const required = size() + max_count;
+		if (required > capacity()) {
+			constexpr auto growth_factor = std::size_t{2};
+			force_reserve(std::max(required, capacity() * growth_factor));
+		}
+		char * const last = operation(end());
+		size_ = static_cast<std::size_t>(last - begin());
+	}
+
+	constexpr void pop_back() {
+		--size_;
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace gcc
+
+
+struct integer_format {
+	int base = 10;
+	// Pads on the left to at least this many characters. Zeros go between the
+	// sign and the digits.
+	std::size_t width = 0;
+	char fill = ' ';
+};
+
+template<typename Unsigned>
+constexpr std::size_t digit_count(Unsigned value, Unsigned const base) {
+	auto result = std::size_t(1);
+	// Division by a constant is a multiplication, so base 10 gets its own
+	// loop, which also handles four digits at a time
+	if (base == 10) {
+		while (true) {
+			if (value < 10) {
+				return result;
+			}
+			if (value < 100) {
+				return result + 1;
+			}
+			if (value < 1000) {
+				return result + 2;
+			}
+			if (value < 10000) {
+				return result + 3;
+			}
+			value /= 10000;
+			result += 4;
+		}
+	}
+	for (; value >= base; value /= base) {
+		++result;
+	}
+	return result;
+}
+
+constexpr char decimal_pairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+// Writes the digits of value so that they end at last, two at a time. The
+// caller has already counted them, which std::to_chars would do again, so
+// this is faster than calling it for base 10.
+template<typename Unsigned>
+constexpr void write_decimal(char * last, Unsigned value) {
+	while (value >= 100) {
+		auto const pair = static_cast<std::size_t>(value % 100) * 2;
+		value /= 100;
+		last -= 2;
+		last[0] = decimal_pairs[pair];
+		last[1] = decimal_pairs[pair + 1];
+	}
+	if (value >= 10) {
+		auto const pair = static_cast<std::size_t>(value) * 2;
+		last -= 2;
+		last[0] = decimal_pairs[pair];
+		last[1] = decimal_pairs[pair + 1];
+	} else {
+		--last;
+		*last = static_cast<char>('0' + value);
+	}
+}
+
+// Writes straight into the spare capacity of target, which grows only if the
+// result does not fit. Digits above 9 are lowercase letters.
+template<typename String, std::integral Integer> requires(!std::same_as<Integer, bool>)
+constexpr void append_number(String & target, Integer const value, integer_format const format = {}) {
+	assert(2 <= format.base and format.base <= 36);
+	using unsigned_type = std::make_unsigned_t<Integer>;
+	auto const negative = value < 0;
+	// Negating as unsigned works for the smallest value of a signed type
+	auto const magnitude = negative ? static_cast<unsigned_type>(unsigned_type(0) - static_cast<unsigned_type>(value)) : static_cast<unsigned_type>(value);
+	auto const base = static_cast<unsigned_type>(format.base);
+	auto const digits = digit_count(magnitude, base);
+	auto const size = digits + (negative ? 1 : 0);
+	auto const padding = format.width > size ? format.width - size : 0;
+	target.append_and_overwrite(padding + size, [&](char * out) {
+		if (format.fill != '0') {
+			out = std::fill_n(out, padding, format.fill);
+		}
+		if (negative) {
+			*out = '-';
+			++out;
+		}
+		if (format.fill == '0') {
+			out = std::fill_n(out, padding, '0');
+		}
+		auto const last = out + digits;
+		if (base == 10) {
+			write_decimal(last, magnitude);
+		} else if (!std::is_constant_evaluated()) {
+			[[maybe_unused]] auto const result = std::to_chars(out, last, magnitude, format.base);
+			assert(result.ptr == last);
+		} else {
+			auto remaining = magnitude;
+			for (auto it = last; it != out; ) {
+				--it;
+				*it = "0123456789abcdefghijklmnopqrstuvwxyz"[remaining % base];
+				remaining /= base;
+			}
+		}
+		return last;
+	});
+}
+
+struct floating_format {
+	// Without a precision, the result is the shortest one that reads back as
+	// the same value. With one, it is fixed notation with that many digits
+	// after the decimal point.
+	std::optional<int> precision = std::nullopt;
+};
+
+// The most characters that fixed notation can need for value. Below 2^n
+// there are at most n * log10(2) + 1 digits before the decimal point.
+template<std::floating_point Floating>
+std::size_t max_fixed_size(Floating const value, int const precision) {
+	if (!std::isfinite(value)) {
+		return 4;
+	}
+	// Avoids frexp for most values
+	if (std::abs(value) < Floating(1e15)) {
+		return 1 + 15 + 1 + static_cast<std::size_t>(precision);
+	}
+	auto exponent = 0;
+	std::frexp(value, &exponent);
+	auto const integer_digits = exponent > 0 ? static_cast<std::size_t>(exponent) * 30103 / 100000 + 1 : 1;
+	return 1 + integer_digits + 1 + static_cast<std::size_t>(precision);
+}
+
+// Floating point numbers only have an upper bound on their size without
+// formatting them. When the spare capacity is less than that bound, a short
+// result goes through a buffer on the stack, so that the string grows only
+// if the characters actually written need it.
+template<typename String, typename Write>
+void append_bounded(String & target, std::size_t const max_size, Write write) {
+	constexpr auto buffer_size = std::size_t(64);
+	if (target.capacity() - target.size() >= max_size or max_size > buffer_size) {
+		target.append_and_overwrite(max_size, write);
+	} else {
+		char buffer[buffer_size];
+		target.append(buffer, write(buffer));
+	}
+}
+
+// std::to_chars for floating point is not constexpr, and a shortest
+// round-trip algorithm is too much code to repeat here, so this only works at
+// run time.
+template<typename String, std::floating_point Floating>
+void append_number(String & target, Floating const value, floating_format const format = {}) {
+	if (!format.precision) {
+		// A sign, every digit, a decimal point, and an exponent such as e-4951.
+		// The shortest result is never longer than scientific notation.
+		constexpr auto max_size = std::size_t(std::numeric_limits<Floating>::max_digits10 + 8);
+		append_bounded(target, max_size, [&](char * const out) {
+			auto const result = std::to_chars(out, out + max_size, value);
+			assert(result.ec == std::errc());
+			return result.ptr;
+		});
+	} else {
+		assert(*format.precision >= 0);
+		auto const max_size = max_fixed_size(value, *format.precision);
+		append_bounded(target, max_size, [&](char * const out) {
+			auto const result = std::to_chars(out, out + max_size, value, std::chars_format::fixed, *format.precision);
+			assert(result.ec == std::errc());
+			return result.ptr;
+		});
+	}
+}
+
+
+template<typename String>
+constexpr String make_string(std::string_view const source) {
+	auto result = String(typename String::allocator_type());
+	result.append(source.data(), source.data() + source.size());
+	return result;
+}
+
+constexpr bool equal(auto const & str, std::string_view const expected) {
+	return std::string_view(str.data(), str.size()) == expected;
+}
+
+template<typename String>
+constexpr void test_layout() {
+	auto check = [](auto const value, integer_format const format, std::string_view const expected) {
+		auto str = make_string<String>("x=");
+		append_number(str, value, format);
+		assert(equal(str, "x=" + std::string(expected)));
+	};
+	check(0, {}, "0");
+	check(7, {}, "7");
+	check(-42, {}, "-42");
+	check(1234567890u, {}, "1234567890");
+	check(std::numeric_limits<std::int64_t>::min(), {}, "-9223372036854775808");
+	check(std::numeric_limits<std::uint64_t>::max(), {}, "18446744073709551615");
+	check(std::numeric_limits<std::int64_t>::min(), {.base = 2}, "-1" + std::string(63, '0'));
+	check(std::int8_t(-128), {}, "-128");
+	check(255, {.base = 16}, "ff");
+	check(35, {.base = 36}, "z");
+	check(42, {.width = 5}, "   42");
+	check(42, {.width = 5, .fill = '0'}, "00042");
+	check(-42, {.width = 5, .fill = '0'}, "-0042");
+	check(-42, {.width = 5, .fill = '*'}, "**-42");
+	check(123456, {.width = 3, .fill = '0'}, "123456");
+	check(0xbeef, {.base = 16, .width = 8, .fill = '0'}, "0000beef");
+
+	// Several numbers in a row, growing past the small buffer
+	auto row = make_string<String>("");
+	for (int n = 0; n != 20; ++n) {
+		append_number(row, n * 1000, {.width = 6, .fill = '0'});
+	}
+	assert(row.size() == 120);
+	assert(equal(row, "000000001000002000003000004000005000006000007000008000009000010000011000012000013000014000015000016000017000018000019000"));
+}
+
+constexpr bool test() {
+	using allocator_type = std::allocator<char>;
+	test_layout<clang::string<allocator_type>>();
+	test_layout<gcc::string<allocator_type>>();
+	return true;
+}
+
+template<typename String>
+void test_against_to_chars() {
+	auto engine = std::mt19937_64(1);
+	char expected[400];
+	for (int n = 0; n != 100'000; ++n) {
+		auto const bits = engine();
+		auto const integer = static_cast<std::int64_t>(bits) >> (bits % 64);
+		auto str = make_string<String>("");
+		append_number(str, integer);
+		assert(equal(str, std::to_string(integer)));
+
+		auto const floating = std::bit_cast<double>(engine());
+		auto shortest = make_string<String>("");
+		append_number(shortest, floating);
+		assert(equal(shortest, std::string_view(expected, std::to_chars(std::begin(expected), std::end(expected), floating).ptr)));
+		if (!std::isnan(floating)) {
+			auto const parsed = std::strtod(std::string(shortest.data(), shortest.size()).c_str(), nullptr);
+			assert(parsed == floating);
+		}
+
+		auto const scaled = static_cast<double>(integer) / 1000.0;
+		auto fixed = make_string<String>("");
+		append_number(fixed, scaled, {.precision = 3});
+		assert(equal(fixed, std::string_view(expected, std::to_chars(std::begin(expected), std::end(expected), scaled, std::chars_format::fixed, 3).ptr)));
+	}
+
+	for (auto const value : {0.0, -0.0, 1.5, 1e308, -1.7976931348623157e308, 5e-324, std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(), std::numeric_limits<double>::quiet_NaN()}) {
+		for (auto const precision : {0, 3, 20}) {
+			auto str = make_string<String>("");
+			append_number(str, value, {.precision = precision});
+			assert(equal(str, std::string_view(expected, std::to_chars(std::begin(expected), std::end(expected), value, std::chars_format::fixed, precision).ptr)));
+		}
+	}
+
+	// Short numbers fit in the small buffer without allocating
+	auto small = make_string<String>("");
+	auto const capacity = small.capacity();
+	append_number(small, 1.25);
+	append_number(small, -7);
+	assert(equal(small, "1.25-7"));
+	assert(small.capacity() == capacity);
+}
+
+template<typename Function>
+double nanoseconds_per_operation(std::size_t const count, Function && function) {
+	auto const start = std::chrono::steady_clock::now();
+	function();
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+}
+
+struct row {
+	std::uint32_t id;
+	std::int64_t timestamp;
+	std::int32_t status;
+	std::uint64_t bytes;
+	double latency;
+	double cpu;
+};
+
+std::vector<row> make_rows(std::size_t const count) {
+	auto engine = std::mt19937_64(1);
+	auto result = std::vector<row>(count);
+	for (auto & element : result) {
+		element = {
+			static_cast<std::uint32_t>(engine()),
+			1'700'000'000'000 + static_cast<std::int64_t>(engine() % 100'000'000),
+			static_cast<std::int32_t>(200 + engine() % 400),
+			engine() % 10'000'000,
+			static_cast<double>(engine() % 1'000'000) / 997.0,
+			static_cast<double>(engine() % 1'000) / 7.0,
+		};
+	}
+	return result;
+}
+
+// Writes each row as a line of CSV into one string, the way a metrics or CSV
+// writer fills its output buffer before writing it out
+template<typename String>
+double benchmark_layout(std::vector<row> const & rows, std::size_t & sink) {
+	return nanoseconds_per_operation(rows.size(), [&] {
+		auto output = make_string<String>("");
+		auto separator = [&](char const c) {
+			output.append(&c, &c + 1);
+		};
+		for (auto const & element : rows) {
+			append_number(output, element.id);
+			separator(',');
+			append_number(output, element.timestamp);
+			separator(',');
+			append_number(output, element.status);
+			separator(',');
+			append_number(output, element.bytes);
+			separator(',');
+			append_number(output, element.latency, {.precision = 3});
+			separator(',');
+			append_number(output, element.cpu);
+			separator('\n');
+		}
+		sink += output.size();
+	});
+}
+
+double benchmark_std_string(std::vector<row> const & rows, std::size_t & sink) {
+	return nanoseconds_per_operation(rows.size(), [&] {
+		auto output = std::string();
+		for (auto const & element : rows) {
+			output += std::to_string(element.id);
+			output += ',';
+			output += std::to_string(element.timestamp);
+			output += ',';
+			output += std::to_string(element.status);
+			output += ',';
+			output += std::to_string(element.bytes);
+			output += ',';
+			char buffer[64];
+			output.append(buffer, std::to_chars(std::begin(buffer), std::end(buffer), element.latency, std::chars_format::fixed, 3).ptr);
+			output += ',';
+			output.append(buffer, std::to_chars(std::begin(buffer), std::end(buffer), element.cpu).ptr);
+			output += '\n';
+		}
+		sink += output.size();
+	});
+}
+
+void benchmark() {
+	auto const rows = make_rows(1'000'000);
+	auto sink = std::size_t(0);
+	// The best of several runs, because the machine is noisy
+	auto std_time = std::numeric_limits<double>::max();
+	auto clang_time = std::numeric_limits<double>::max();
+	auto gcc_time = std::numeric_limits<double>::max();
+	for (int n = 0; n != 5; ++n) {
+		std_time = std::min(std_time, benchmark_std_string(rows, sink));
+		clang_time = std::min(clang_time, benchmark_layout<clang::string<std::allocator<char>>>(rows, sink));
+		gcc_time = std::min(gcc_time, benchmark_layout<gcc::string<std::allocator<char>>>(rows, sink));
+	}
+	assert(sink % 15 == 0);
+	std::printf("%-40s %14s\n", "", "ns per row");
+	std::printf("%-40s %14.1f\n", "std::string, to_string and to_chars", std_time);
+	std::printf("%-40s %14.1f\n", "clang layout, append_number", clang_time);
+	std::printf("%-40s %14.1f\n", "gcc layout, append_number", gcc_time);
+}
+
+int main() {
+	test();
+	static_assert(test());
+	test_against_to_chars<clang::string<std::allocator<char>>>();
+	test_against_to_chars<gcc::string<std::allocator<char>>>();
+	benchmark();
+}
@@ -0,0 +1,2009 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is to give both layouts
+// the ASCII transforms that HTTP and JSON code runs on every request, working
+// on 16 or 32 characters at a time.
+//
+// to_lower, to_upper, equal_case_insensitive, compare_case_insensitive,
+// hash_case_insensitive, trim, escape_json, unescape_json, escape_url, and
+// unescape_url all work on the characters where they are, in the small
+// buffer or on the heap. At run time on x86-64 they use SSE2, or AVX2 when
+// the processor has it, with the same dispatch as search.cpp. In constant
+// evaluation they look at one character at a time.
+//
+// The escapes first count the characters of the result, so the string grows
+// at most once, and then move each character once, starting from the end.
+// The unescapes only make the string shorter, so they never allocate.
+// resize_and_overwrite is added to both layouts for this.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cctype>
+#include <chrono>
+#include <climits>
+#include <compare>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+// char is trivial, so outside of constant evaluation the characters can be
+// copied with memcpy instead of being constructed one at a time
+template<typename Allocator>
+constexpr char * copy_characters(Allocator alloc, char const * const first, char const * const last, char * const out) {
+	if (std::is_constant_evaluated()) {
+		return uninitialized_copy(alloc, first, last, out);
+	}
+	auto const count = static_cast<std::size_t>(last - first);
+	if (count != 0) {
+		std::memcpy(out, first, count);
+	}
+	return out + count;
+}
+
+
+namespace clang {
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	static constexpr std::size_t small_buffer_capacity = 23;
+
+	struct small_t {
+		char data[small_buffer_capacity] = {};
+	};
+	struct [[gnu::packed]] large_t {
+		static constexpr std::size_t bytes_remaining = 7;
+
+		template<typename It>
+		class range_view {
+		public:
+			constexpr range_view(It first, It last):
+				first_(first),
+				last_(last)
+			{
+			}
+			constexpr auto begin() const {
+				return first_;
+			}
+			constexpr auto end() const {
+				return last_;
+			}
+		private:
+			It first_;
+			It last_;
+		};
+
+		constexpr auto little_endian_capacity() const {
+			return range_view(
+				std::rbegin(rest_of_capacity),
+				std::rend(rest_of_capacity)
+			);
+		}
+		constexpr auto big_endian_capacity() {
+			return range_view(
+				std::begin(rest_of_capacity),
+				std::end(rest_of_capacity)
+			);
+		}
+
+		constexpr large_t(std::size_t set_size, std::size_t capacity, char * pointer) noexcept:
+			rest_of_capacity{},
+			size(set_size),
+			data(pointer)
+		{
+			assert(data != nullptr);
+			for (unsigned char & byte : big_endian_capacity()) {
+				capacity >>= CHAR_BIT;
+				byte = capacity;
+			}
+		}
+
+		unsigned char rest_of_capacity[bytes_remaining];
+		std::size_t size;
+		char * data;
+	};
+
+	[[no_unique_address]] allocator_type allocator_;
+	unsigned char size_or_first_byte_of_capacity_;
+	union U {
+		constexpr U() noexcept:
+			small{}
+		{
+		}
+		explicit constexpr U(std::size_t size, std::size_t capacity, char * data) noexcept:
+			large(size, capacity, data)
+		{
+		}
+		constexpr U(large_t set_large) noexcept:
+			large(set_large)
+		{
+		}
+
+		small_t small;
+		large_t large;
+	} u_;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return size_or_first_byte_of_capacity_ & 1;
+	}
+
+	constexpr void increment_size() {
+		if (is_large()) {
+			++u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ += (1 << 1);
+		}
+	}
+	constexpr void set_size(std::size_t const new_size) {
+		if (is_large()) {
+			u_.large.size = new_size;
+		} else {
+			size_or_first_byte_of_capacity_ = static_cast<unsigned char>(new_size << 1);
+		}
+	}
+	constexpr void decrement_size() {
+		if (is_large()) {
+			--u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ -= (1 << 1);
+		}
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, u_.large.data, capacity());
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(size(), new_capacity, new_data);
+		assert(new_capacity & 1);
+		size_or_first_byte_of_capacity_ = new_capacity;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		new_capacity |= 1;
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy_characters(alloc, data(), data() + size(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		size_or_first_byte_of_capacity_(0),
+		u_{}
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.large);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+
+			other.u_ = U{};
+			other.size_or_first_byte_of_capacity_ = 0;
+		} else {
+			auto & osmall = other.u_.small;
+			u_ = U{};
+			copy(osmall.data, osmall.data + (other.size_or_first_byte_of_capacity_ >> 1), u_.small.data);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr char * data() {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr std::size_t size() const {
+		return is_large() ? u_.large.size : (size_or_first_byte_of_capacity_ >> 1);
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		if (!is_large()) {
+			return small_buffer_capacity;
+		}
+		// The bytes after the first are the rest of the capacity in
+		// little-endian order, so on a little-endian target this is one load
+		// instead of a loop. append_and_overwrite checks the capacity for
+		// every number.
+		if (!std::is_constant_evaluated() and std::endian::native == std::endian::little) {
+			auto rest = std::size_t(0);
+			std::memcpy(&rest, u_.large.rest_of_capacity, large_t::bytes_remaining);
+			return (rest << CHAR_BIT) | size_or_first_byte_of_capacity_;
+		}
+		std::size_t result = 0;
+		for (unsigned char const byte : u_.large.little_endian_capacity()) {
+			result |= byte;
+			result <<= CHAR_BIT;
+		}
+		result |= size_or_first_byte_of_capacity_;
+		return result;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		auto const local_size = size();
+		if (is_large() && capacity() > (local_size | 1)) {
+			if (local_size > small_buffer_capacity) {
+				force_reserve(local_size);
+			} else {
+				auto const data = u_.large.data;
+				auto const original_capacity = capacity();
+				u_ = U{};
+				size_or_first_byte_of_capacity_ = local_size << 1;
+				copy(data, data + local_size, u_.small.data);
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = std::prev(end());
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = (capacity() * growth_factor) | 1;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+
+			relocate(temp, new_capacity);
+		}
+		increment_size();
+		return begin() + offset;
+	}
+
+	// Range append, which the proposal leaves out for brevity. A reallocation
+	// at least doubles the capacity, like insert, and copies the old
+	// characters and the new ones straight into place. That also makes it
+	// safe to append part of the string to itself.
+	constexpr void append(char const * const first, char const * const last) {
+		auto const new_size = size() + static_cast<std::size_t>(last - first);
+		auto alloc = get_allocator();
+		if (new_size <= capacity()) {
+			copy_characters(alloc, first, last, end());
+		} else {
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = std::max(new_size, capacity() * growth_factor) | 1;
+			char * temp = Alloc::allocate(alloc, new_capacity);
+			copy_characters(alloc, first, last, copy_characters(alloc, data(), data() + size(), temp));
+			relocate(temp, new_capacity);
+		}
+		set_size(new_size);
+	}
+
+	// Makes room for up to max_count more characters, then operation writes
+	// characters starting at the end and returns where it stopped. This is
+	// like resize_and_overwrite, except that it keeps what is already there.
+	template<typename Operation>
+	constexpr void append_and_overwrite(std::size_t const max_count, Operation operation) {
+		auto const required = size() + max_count;
+		if (required > capacity()) {
+			constexpr auto growth_factor = std::size_t{2};
+			force_reserve(std::max(required, capacity() * growth_factor));
+		}
+		char * const last = operation(end());
+		set_size(static_cast<std::size_t>(last - begin()));
+	}
+
+	// Like std::string::resize_and_overwrite: makes room for count
+	// characters, keeping the ones that are already there, and then
+	// operation(data(), count) writes them and returns the new size.
+	template<typename Operation>
+	constexpr void resize_and_overwrite(std::size_t const count, Operation operation) {
+		if (count > capacity()) {
+			force_reserve(count);
+		}
+		set_size(static_cast<std::size_t>(operation(data(), count)));
+	}
+
+	constexpr void pop_back() {
+		decrement_size();
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace clang
+
+namespace gcc {
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	[[no_unique_address]] allocator_type allocator_;
+	// This could be set to 8 to reduce the size of our string to 24 bytes
+	// (just like clang), but 7 characters (plus a null terminator) is likely
+	// too small of a buffer for most users.
+	static constexpr std::size_t small_buffer_capacity = 16;
+	union U{
+		constexpr U():
+			buffer{}
+		{
+		}
+		constexpr U(std::size_t c):
+			capacity(c)
+		{
+		}
+
+		char buffer[small_buffer_capacity];
+		std::size_t capacity;
+	} u_;
+	char * data_;
+	std::size_t size_ : 63;
+	// gcc and MSVC do not allow accessing the inactive member of a union just
+	// to get its address, so we use a bitfield to work around this.
+	bool is_large_ : 1;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return is_large_;
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, data_, u_.capacity);
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(new_capacity);
+		data_ = new_data;
+		is_large_ = true;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy_characters(alloc, data(), data() + size(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_{},
+		data_(u_.buffer),
+		size_(0),
+		is_large_(false)
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.capacity);
+			other.u_ = U{};
+		
+			data_ = other.data_;
+			other.data_ = other.u_.buffer;
+		
+			size_ = other.size_;
+			other.size_ = 0U;
+		
+			is_large_ = true;
+			other.is_large_ = false;
+
+		} else {
+			u_ = U{};
+			copy(other.data_, other.data_ + other.size_, u_.buffer);
+			data_ = u_.buffer;
+			size_ = other.size_;
+			is_large_ = false;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return data_;
+	}
+	constexpr char * data() {
+		return data_;
+	}
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		return is_large() ? u_.capacity : small_buffer_capacity;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		if (is_large() && capacity() > size()) {
+			if (size() > small_buffer_capacity) {
+				force_reserve(size());
+			} else {
+				auto const data = data_;
+				auto const original_capacity = u_.capacity;
+				u_ = U{};
+				copy(data, data + size_, u_.buffer);
+				data_ = u_.buffer;
+				is_large_ = false;
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = end() - 1;
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = capacity() * growth_factor;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+		
+			relocate(temp, new_capacity);
+		}
+		++size_;
+		return begin() + offset;
+	}
+
+	// Range append, which the proposal leaves out for brevity. A reallocation
+	// at least doubles the capacity, like insert, and copies the old
+	// characters and the new ones straight into place. That also makes it
+	// safe to append part of the string to itself.
+	constexpr void append(char const * const first, char const * const last) {
+		auto const new_size = size() + static_cast<std::size_t>(last - first);
+		auto alloc = get_allocator();
+		if (new_size <= capacity()) {
+			copy_characters(alloc, first, last, end());
+		} else {
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = std::max(new_size, capacity() * growth_factor);
+			char * temp = Alloc::allocate(alloc, new_capacity);
+			copy_characters(alloc, first, last, copy_characters(alloc, data(), data() + size(), temp));
+			relocate(temp, new_capacity);
+		}
+		size_ = new_size;
+	}
+
+	// Makes room for up to max_count more characters, then operation writes
+	// characters starting at the end and returns where it stopped. This is
+	// like resize_and_overwrite, except that it keeps what is already there.
+	template<typename Operation>
+	constexpr void append_and_overwrite(std::size_t const max_count, Operation operation) {
+		auto const required = size() + max_count;
+		if (required > capacity()) {
+			constexpr auto growth_factor = std::size_t{2};
+			force_reserve(std::max(required, capacity() * growth_factor));
+		}
+		char * const last = operation(end());
+		size_ = static_cast<std::size_t>(last - begin());
+	}
+
+	// Like std::string::resize_and_overwrite: makes room for count
+	// characters, keeping the ones that are already there, and then
+	// operation(data(), count) writes them and returns the new size.
+	template<typename Operation>
+	constexpr void resize_and_overwrite(std::size_t const count, Operation operation) {
+		if (count > capacity()) {
+			force_reserve(count);
+		}
+		size_ = static_cast<std::size_t>(operation(data(), count));
+	}
+
+	constexpr void pop_back() {
+		--size_;
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace gcc
+
+template<typename T>
+constexpr bool is_prototype_string = false;
+template<typename Allocator>
+constexpr bool is_prototype_string<clang::string<Allocator>> = true;
+template<typename Allocator>
+constexpr bool is_prototype_string<gcc::string<Allocator>> = true;
+
+template<typename T>
+concept prototype_string = is_prototype_string<T>;
+
+// Either string, or anything that converts to std::string_view
+template<typename T>
+concept string_like = prototype_string<T> or std::convertible_to<T const &, std::string_view>;
+
+template<string_like T>
+constexpr std::string_view as_view(T const & value) {
+	if constexpr (prototype_string<T>) {
+		return std::string_view(value.data(), value.size());
+	} else {
+		return std::string_view(value);
+	}
+}
+
+// Like memmove, for moving characters within one string
+constexpr void move_characters(char const * const first, char const * const last, char * const out) {
+	if (std::is_constant_evaluated()) {
+		if (out < first) {
+			std::copy(first, last, out);
+		} else {
+			std::copy_backward(first, last, out + (last - first));
+		}
+		return;
+	}
+	auto const count = static_cast<std::size_t>(last - first);
+	if (count != 0) {
+		std::memmove(out, first, count);
+	}
+}
+
+// The sets of characters that the kernels look for. Bytes of 0x80 and above
+// are not ASCII, so they are never letters or whitespace.
+enum class byte_class {
+	upper,
+	lower,
+	whitespace,
+	// What escape_json has to escape: ", \, and control characters
+	json_special,
+	// Everything other than letters, digits, -, ., _, and ~
+	url_reserved,
+	backslash,
+	percent,
+};
+
+template<byte_class c>
+constexpr bool in_class(char const x) {
+	if constexpr (c == byte_class::upper) {
+		return 'A' <= x and x <= 'Z';
+	} else if constexpr (c == byte_class::lower) {
+		return 'a' <= x and x <= 'z';
+	} else if constexpr (c == byte_class::whitespace) {
+		return x == ' ' or ('\t' <= x and x <= '\r');
+	} else if constexpr (c == byte_class::json_special) {
+		return x == '"' or x == '\\' or static_cast<unsigned char>(x) < 0x20;
+	} else if constexpr (c == byte_class::url_reserved) {
+		auto const unreserved =
+			('0' <= x and x <= '9') or
+			('A' <= x and x <= 'Z') or
+			('a' <= x and x <= 'z') or
+			x == '-' or x == '.' or x == '_' or x == '~';
+		return !unreserved;
+	} else if constexpr (c == byte_class::backslash) {
+		return x == '\\';
+	} else {
+		static_assert(c == byte_class::percent);
+		return x == '%';
+	}
+}
+
+// The characters that are in the class, as a bit mask of the first
+// min(size, 64) characters
+template<byte_class c>
+constexpr std::uint64_t scalar_class_mask(char const * const data, std::size_t const size) {
+	auto mask = std::uint64_t(0);
+	for (std::size_t n = 0; n != std::min(size, std::size_t(64)); ++n) {
+		mask |= std::uint64_t(in_class<c>(data[n])) << n;
+	}
+	return mask;
+}
+
+#if defined(__x86_64__)
+
+inline bool const has_avx2 = __builtin_cpu_supports("avx2");
+
+inline __m128i load16(char const * const data) {
+	return _mm_loadu_si128(reinterpret_cast<__m128i const *>(data));
+}
+inline void store16(char * const data, __m128i const block) {
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(data), block);
+}
+[[gnu::target("avx2")]] inline __m256i load32(char const * const data) {
+	return _mm256_loadu_si256(reinterpret_cast<__m256i const *>(data));
+}
+[[gnu::target("avx2")]] inline void store32(char * const data, __m256i const block) {
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(data), block);
+}
+
+// The comparisons are signed, so bytes of 0x80 and above are less than every
+// ASCII character
+inline __m128i in_range(__m128i const block, char const first, char const last) {
+	return _mm_and_si128(
+		_mm_cmpgt_epi8(block, _mm_set1_epi8(static_cast<char>(first - 1))),
+		_mm_cmplt_epi8(block, _mm_set1_epi8(static_cast<char>(last + 1)))
+	);
+}
+[[gnu::target("avx2")]] inline __m256i in_range(__m256i const block, char const first, char const last) {
+	return _mm256_and_si256(
+		_mm256_cmpgt_epi8(block, _mm256_set1_epi8(static_cast<char>(first - 1))),
+		_mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(last + 1)), block)
+	);
+}
+inline __m128i equal(__m128i const block, char const c) {
+	return _mm_cmpeq_epi8(block, _mm_set1_epi8(c));
+}
+[[gnu::target("avx2")]] inline __m256i equal(__m256i const block, char const c) {
+	return _mm256_cmpeq_epi8(block, _mm256_set1_epi8(c));
+}
+
+// 0xff in each byte that is in the class, and 0 in the others
+template<byte_class c>
+__m128i sse2_classify(__m128i const block) {
+	if constexpr (c == byte_class::upper) {
+		return in_range(block, 'A', 'Z');
+	} else if constexpr (c == byte_class::lower) {
+		return in_range(block, 'a', 'z');
+	} else if constexpr (c == byte_class::whitespace) {
+		return _mm_or_si128(equal(block, ' '), in_range(block, '\t', '\r'));
+	} else if constexpr (c == byte_class::json_special) {
+		return _mm_or_si128(_mm_or_si128(equal(block, '"'), equal(block, '\\')), in_range(block, '\0', '\x1f'));
+	} else if constexpr (c == byte_class::url_reserved) {
+		auto const alphanumeric = _mm_or_si128(in_range(block, '0', '9'), in_range(_mm_or_si128(block, _mm_set1_epi8(0x20)), 'a', 'z'));
+		auto const punctuation = _mm_or_si128(_mm_or_si128(equal(block, '-'), equal(block, '.')), _mm_or_si128(equal(block, '_'), equal(block, '~')));
+		return _mm_andnot_si128(_mm_or_si128(alphanumeric, punctuation), _mm_set1_epi8(-1));
+	} else if constexpr (c == byte_class::backslash) {
+		return equal(block, '\\');
+	} else {
+		static_assert(c == byte_class::percent);
+		return equal(block, '%');
+	}
+}
+template<byte_class c>
+[[gnu::target("avx2")]] __m256i avx2_classify(__m256i const block) {
+	if constexpr (c == byte_class::upper) {
+		return in_range(block, 'A', 'Z');
+	} else if constexpr (c == byte_class::lower) {
+		return in_range(block, 'a', 'z');
+	} else if constexpr (c == byte_class::whitespace) {
+		return _mm256_or_si256(equal(block, ' '), in_range(block, '\t', '\r'));
+	} else if constexpr (c == byte_class::json_special) {
+		return _mm256_or_si256(_mm256_or_si256(equal(block, '"'), equal(block, '\\')), in_range(block, '\0', '\x1f'));
+	} else if constexpr (c == byte_class::url_reserved) {
+		auto const alphanumeric = _mm256_or_si256(in_range(block, '0', '9'), in_range(_mm256_or_si256(block, _mm256_set1_epi8(0x20)), 'a', 'z'));
+		auto const punctuation = _mm256_or_si256(_mm256_or_si256(equal(block, '-'), equal(block, '.')), _mm256_or_si256(equal(block, '_'), equal(block, '~')));
+		return _mm256_andnot_si256(_mm256_or_si256(alphanumeric, punctuation), _mm256_set1_epi8(-1));
+	} else if constexpr (c == byte_class::backslash) {
+		return equal(block, '\\');
+	} else {
+		static_assert(c == byte_class::percent);
+		return equal(block, '%');
+	}
+}
+
+inline std::uint64_t bit_mask(__m128i const block) {
+	return static_cast<std::uint32_t>(_mm_movemask_epi8(block));
+}
+[[gnu::target("avx2")]] inline std::uint64_t bit_mask(__m256i const block) {
+	return static_cast<std::uint32_t>(_mm256_movemask_epi8(block));
+}
+
+// Inputs shorter than one vector are handled by the narrower version. When
+// the input ends partway through a vector, the last vector is loaded from the
+// end of the input instead, so nothing is read past the end. The bytes that
+// overlap get the same bits twice.
+
+template<byte_class c>
+std::uint64_t sse2_class_mask(char const * const data, std::size_t const size) {
+	assert(size >= 16);
+	auto const count = std::min(size, std::size_t(64));
+	auto mask = std::uint64_t(0);
+	auto n = std::size_t(0);
+	for (; n + 16 <= count; n += 16) {
+		mask |= bit_mask(sse2_classify<c>(load16(data + n))) << n;
+	}
+	if (n != count) {
+		mask |= bit_mask(sse2_classify<c>(load16(data + count - 16))) << (count - 16);
+	}
+	return mask;
+}
+template<byte_class c>
+[[gnu::target("avx2")]] std::uint64_t avx2_class_mask(char const * const data, std::size_t const size) {
+	if (size < 32) {
+		return sse2_class_mask<c>(data, size);
+	}
+	auto const count = std::min(size, std::size_t(64));
+	auto mask = bit_mask(avx2_classify<c>(load32(data)));
+	if (count == 64) {
+		mask |= bit_mask(avx2_classify<c>(load32(data + 32))) << 32;
+	} else if (count != 32) {
+		mask |= bit_mask(avx2_classify<c>(load32(data + count - 32))) << (count - 32);
+	}
+	return mask;
+}
+
+#endif
+
+template<byte_class c>
+constexpr std::uint64_t class_mask(char const * const data, std::size_t const size) {
+#if defined(__x86_64__)
+	if (!std::is_constant_evaluated() and size >= 16) {
+		return has_avx2 ? avx2_class_mask<c>(data, size) : sse2_class_mask<c>(data, size);
+	}
+#endif
+	return scalar_class_mask<c>(data, size);
+}
+
+constexpr std::uint64_t low_bits(std::size_t const count) {
+	return count >= 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << count) - 1;
+}
+
+// The index of the first character in the class, or size if there is none
+template<byte_class c>
+constexpr std::size_t find_in_class(char const * const data, std::size_t const size) {
+	for (std::size_t offset = 0; offset < size; offset += 64) {
+		if (auto const mask = class_mask<c>(data + offset, size - offset)) {
+			return offset + static_cast<std::size_t>(std::countr_zero(mask));
+		}
+	}
+	return size;
+}
+
+// The index of the first character not in the class, or size if there is
+// none
+template<byte_class c>
+constexpr std::size_t find_not_in_class(char const * const data, std::size_t const size) {
+	for (std::size_t offset = 0; offset < size; offset += 64) {
+		auto const count = std::min(size - offset, std::size_t(64));
+		if (auto const mask = ~class_mask<c>(data + offset, count) & low_bits(count)) {
+			return offset + static_cast<std::size_t>(std::countr_zero(mask));
+		}
+	}
+	return size;
+}
+
+// One past the last character not in the class, or 0 if there is none
+template<byte_class c>
+constexpr std::size_t end_of_last_not_in_class(char const * const data, std::size_t const size) {
+	for (auto last = size; last != 0;) {
+		auto const first = last >= 64 ? last - 64 : 0;
+		if (auto const mask = ~class_mask<c>(data + first, last - first) & low_bits(last - first)) {
+			return first + static_cast<std::size_t>(std::bit_width(mask));
+		}
+		last = first;
+	}
+	return 0;
+}
+
+// Calls function(index) for each character in the class, starting from the
+// end. function can write to characters after index.
+template<byte_class c, typename Function>
+constexpr void for_each_in_class_backward(char const * const data, std::size_t const size, Function function) {
+	for (auto last = size; last != 0;) {
+		auto const first = last >= 64 ? last - 64 : 0;
+		for (auto mask = class_mask<c>(data + first, last - first); mask != 0;) {
+			auto const bit = static_cast<std::size_t>(std::bit_width(mask)) - 1;
+			function(first + bit);
+			mask ^= std::uint64_t(1) << bit;
+		}
+		last = first;
+	}
+}
+
+// Reads bytes in little-endian order on every target, so that a hash computed
+// during constant evaluation matches the one computed at run time.
+constexpr std::uint64_t load_little_endian(char const * const data) {
+	auto result = std::uint64_t(0);
+	if (std::is_constant_evaluated()) {
+		for (std::size_t n = 0; n != sizeof(result); ++n) {
+			result |= std::uint64_t(static_cast<unsigned char>(data[n])) << (n * CHAR_BIT);
+		}
+		return result;
+	}
+	std::memcpy(&result, data, sizeof(result));
+	if constexpr (std::endian::native == std::endian::big) {
+		result = __builtin_bswap64(result);
+	}
+	return result;
+}
+
+constexpr void store_little_endian(char * const data, std::uint64_t value) {
+	if (std::is_constant_evaluated()) {
+		for (std::size_t n = 0; n != sizeof(value); ++n) {
+			data[n] = static_cast<char>(static_cast<unsigned char>(value >> (n * CHAR_BIT)));
+		}
+		return;
+	}
+	if constexpr (std::endian::native == std::endian::big) {
+		value = __builtin_bswap64(value);
+	}
+	std::memcpy(data, &value, sizeof(value));
+}
+
+// 0x20 in each byte of word that is in the class, which is upper or lower.
+// Adding to the low seven bits of a byte cannot carry into the next byte, so
+// the high bit of each sum says whether that byte is at least the first
+// letter, or after the last one. Strings that are too short for a vector
+// use this on two words that can overlap.
+template<byte_class c>
+constexpr std::uint64_t case_bits(std::uint64_t const word) {
+	static_assert(c == byte_class::upper or c == byte_class::lower);
+	constexpr auto first = c == byte_class::upper ? 'A' : 'a';
+	constexpr auto last = c == byte_class::upper ? 'Z' : 'z';
+	constexpr auto ones = std::uint64_t(0x0101'0101'0101'0101);
+	constexpr auto high_bits = 0x80 * ones;
+	auto const low_seven = word & ~high_bits;
+	auto const at_least_first = low_seven + (0x80 - first) * ones;
+	auto const after_last = low_seven + (0x80 - last - 1) * ones;
+	return (at_least_first & ~after_last & ~word & high_bits) >> 2;
+}
+
+// Flipping bit 5 changes the case of an ASCII letter. Flipping a letter
+// takes it out of the class, so the last vector can overlap characters that
+// were already changed.
+
+#if defined(__x86_64__)
+
+template<byte_class c>
+void sse2_flip_block(char * const position) {
+	auto const block = load16(position);
+	store16(position, _mm_xor_si128(block, _mm_and_si128(sse2_classify<c>(block), _mm_set1_epi8(0x20))));
+}
+template<byte_class c>
+[[gnu::target("avx2")]] void avx2_flip_block(char * const position) {
+	auto const block = load32(position);
+	store32(position, _mm256_xor_si256(block, _mm256_and_si256(avx2_classify<c>(block), _mm256_set1_epi8(0x20))));
+}
+
+template<byte_class c>
+void sse2_flip_case(char * const data, std::size_t const size) {
+	assert(size >= 16);
+	for (std::size_t n = 0; n + 16 <= size; n += 16) {
+		sse2_flip_block<c>(data + n);
+	}
+	sse2_flip_block<c>(data + size - 16);
+}
+template<byte_class c>
+[[gnu::target("avx2")]] void avx2_flip_case(char * const data, std::size_t const size) {
+	if (size < 32) {
+		sse2_flip_case<c>(data, size);
+		return;
+	}
+	for (std::size_t n = 0; n + 32 <= size; n += 32) {
+		avx2_flip_block<c>(data + n);
+	}
+	avx2_flip_block<c>(data + size - 32);
+}
+
+#endif
+
+template<byte_class c>
+constexpr void flip_case(char * const data, std::size_t const size) {
+	static_assert(c == byte_class::upper or c == byte_class::lower);
+#if defined(__x86_64__)
+	if (!std::is_constant_evaluated() and size >= 16) {
+		if (has_avx2) {
+			avx2_flip_case<c>(data, size);
+		} else {
+			sse2_flip_case<c>(data, size);
+		}
+		return;
+	}
+#endif
+	if (!std::is_constant_evaluated() and size >= 8) {
+		auto flip = [=](char * const position) {
+			auto const word = load_little_endian(position);
+			store_little_endian(position, word ^ case_bits<c>(word));
+		};
+		flip(data);
+		flip(data + size - 8);
+		return;
+	}
+	for (std::size_t n = 0; n != size; ++n) {
+		if (in_class<c>(data[n])) {
+			data[n] = static_cast<char>(data[n] ^ 0x20);
+		}
+	}
+}
+
+// Only changes ASCII letters. Bytes of UTF-8 sequences stay the same.
+template<prototype_string String>
+constexpr void to_lower(String & str) {
+	flip_case<byte_class::upper>(str.data(), str.size());
+}
+template<prototype_string String>
+constexpr void to_upper(String & str) {
+	flip_case<byte_class::lower>(str.data(), str.size());
+}
+
+
+// The hash from hash.cpp
+
+// Strings of up to this many characters hash as three words, padded with 0.
+constexpr std::size_t short_hash_size = 24;
+using short_hash_words = std::array<std::uint64_t, short_hash_size / sizeof(std::uint64_t)>;
+
+constexpr std::uint64_t hash_keys[] = {
+	0xbe4b'a423'396c'feb8,
+	0x1cad'21f7'2c81'017c,
+	0xdb97'9083'e96d'd4de,
+	0x1f67'b3b7'a4a4'4072,
+};
+constexpr std::uint64_t size_key = 0x9e37'79b1'85eb'ca87;
+constexpr std::uint64_t lane_multiplier = 0x9fb2'1c65'1e98'df25;
+
+constexpr std::uint64_t accumulate(std::uint64_t const word, std::uint64_t const key) {
+	auto const keyed = word ^ key;
+	return (keyed & 0xffff'ffff) * (keyed >> 32) + std::rotl(word, 32);
+}
+
+constexpr std::uint64_t avalanche(std::uint64_t hash) {
+	hash ^= hash >> 37;
+	hash *= 0x1656'6791'9e37'79f9;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+constexpr std::size_t hash_short(short_hash_words const & words, std::size_t const size) {
+	auto result = size * size_key;
+	for (std::size_t n = 0; n != words.size(); ++n) {
+		result += accumulate(words[n], hash_keys[n]);
+	}
+	return avalanche(result);
+}
+
+// load_word turns 8 characters into a word, so that the case-insensitive
+// hash can change the case as it goes
+template<typename LoadWord>
+constexpr std::size_t hash_long(char const * const data, std::size_t const size, LoadWord const load_word) {
+	assert(size > short_hash_size);
+	constexpr auto block_size = std::size(hash_keys) * sizeof(std::uint64_t);
+	auto lanes = std::array<std::uint64_t, std::size(hash_keys)>();
+	auto add_block = [&](auto const word_offset) {
+		for (std::size_t n = 0; n != lanes.size(); ++n) {
+			lanes[n] = (lanes[n] + accumulate(load_word(data + word_offset(n)), hash_keys[n])) * lane_multiplier;
+		}
+	};
+	if (size < block_size) {
+		add_block([=](std::size_t const n) { return std::min(n * sizeof(std::uint64_t), size - sizeof(std::uint64_t)); });
+	} else {
+		auto offset = std::size_t(0);
+		for (; offset + block_size <= size; offset += block_size) {
+			add_block([=](std::size_t const n) { return offset + n * sizeof(std::uint64_t); });
+		}
+		if (offset != size) {
+			add_block([=](std::size_t const n) { return size - block_size + n * sizeof(std::uint64_t); });
+		}
+	}
+	auto result = size * size_key;
+	for (std::size_t n = 0; n != lanes.size(); ++n) {
+		result += std::rotl(lanes[n], static_cast<int>(n * 16));
+	}
+	return avalanche(result);
+}
+
+template<typename LoadWord>
+constexpr short_hash_words padded_words(char const * const data, std::size_t const size, LoadWord const load_word) {
+	assert(size <= short_hash_size);
+	char padded[short_hash_size] = {};
+	copy(data, data + size, padded);
+	auto result = short_hash_words();
+	for (std::size_t n = 0; n != result.size(); ++n) {
+		result[n] = load_word(padded + n * sizeof(std::uint64_t));
+	}
+	return result;
+}
+
+template<typename LoadWord>
+constexpr std::size_t hash_words(char const * const data, std::size_t const size, LoadWord const load_word) {
+	return size <= short_hash_size ? hash_short(padded_words(data, size, load_word), size) : hash_long(data, size, load_word);
+}
+
+constexpr std::size_t hash_bytes(char const * const data, std::size_t const size) {
+	return hash_words(data, size, load_little_endian);
+}
+
+constexpr std::uint64_t lower_word(std::uint64_t const word) {
+	return word ^ case_bits<byte_class::upper>(word);
+}
+
+// The same as hash_bytes of the text after to_lower, so it goes with
+// equal_case_insensitive in a hash table
+constexpr std::size_t hash_case_insensitive(string_like auto const & value) {
+	auto const view = as_view(value);
+	return hash_words(view.data(), view.size(), [](char const * const data) {
+		return lower_word(load_little_endian(data));
+	});
+}
+
+
+constexpr char to_lower(char const c) {
+	return in_class<byte_class::upper>(c) ? static_cast<char>(c ^ 0x20) : c;
+}
+
+#if defined(__x86_64__)
+
+inline __m128i lower_block(__m128i const block) {
+	return _mm_or_si128(block, _mm_and_si128(sse2_classify<byte_class::upper>(block), _mm_set1_epi8(0x20)));
+}
+[[gnu::target("avx2")]] inline __m256i lower_block(__m256i const block) {
+	return _mm256_or_si256(block, _mm256_and_si256(avx2_classify<byte_class::upper>(block), _mm256_set1_epi8(0x20)));
+}
+
+inline std::uint64_t sse2_equal_bits(char const * const lhs, char const * const rhs) {
+	return bit_mask(_mm_cmpeq_epi8(lower_block(load16(lhs)), lower_block(load16(rhs))));
+}
+[[gnu::target("avx2")]] inline std::uint64_t avx2_equal_bits(char const * const lhs, char const * const rhs) {
+	return bit_mask(_mm256_cmpeq_epi8(lower_block(load32(lhs)), lower_block(load32(rhs))));
+}
+
+inline std::uint64_t sse2_mismatch_mask(char const * const lhs, char const * const rhs, std::size_t const size) {
+	assert(size >= 16);
+	auto const count = std::min(size, std::size_t(64));
+	auto equal_bits = std::uint64_t(0);
+	auto n = std::size_t(0);
+	for (; n + 16 <= count; n += 16) {
+		equal_bits |= sse2_equal_bits(lhs + n, rhs + n) << n;
+	}
+	if (n != count) {
+		equal_bits |= sse2_equal_bits(lhs + count - 16, rhs + count - 16) << (count - 16);
+	}
+	return ~equal_bits & low_bits(count);
+}
+[[gnu::target("avx2")]] inline std::uint64_t avx2_mismatch_mask(char const * const lhs, char const * const rhs, std::size_t const size) {
+	if (size < 32) {
+		return sse2_mismatch_mask(lhs, rhs, size);
+	}
+	auto const count = std::min(size, std::size_t(64));
+	auto equal_bits = avx2_equal_bits(lhs, rhs);
+	if (count != 32) {
+		equal_bits |= avx2_equal_bits(lhs + count - 32, rhs + count - 32) << (count - 32);
+	}
+	return ~equal_bits & low_bits(count);
+}
+
+#endif
+
+// The characters that differ other than by ASCII case, as a bit mask of the
+// first min(size, 64) characters
+constexpr std::uint64_t mismatch_mask(char const * const lhs, char const * const rhs, std::size_t const size) {
+#if defined(__x86_64__)
+	if (!std::is_constant_evaluated() and size >= 16) {
+		return has_avx2 ? avx2_mismatch_mask(lhs, rhs, size) : sse2_mismatch_mask(lhs, rhs, size);
+	}
+#endif
+	auto mask = std::uint64_t(0);
+	for (std::size_t n = 0; n != std::min(size, std::size_t(64)); ++n) {
+		mask |= std::uint64_t(to_lower(lhs[n]) != to_lower(rhs[n])) << n;
+	}
+	return mask;
+}
+
+// The index of the first character that differs other than by ASCII case, or
+// size if there is none
+constexpr std::size_t case_insensitive_mismatch(char const * const lhs, char const * const rhs, std::size_t const size) {
+	if (!std::is_constant_evaluated() and 8 <= size and size < 16) {
+		auto mismatch = [=](std::size_t const offset) {
+			return lower_word(load_little_endian(lhs + offset)) ^ lower_word(load_little_endian(rhs + offset));
+		};
+		if (auto const bits = mismatch(0)) {
+			return static_cast<std::size_t>(std::countr_zero(bits)) / CHAR_BIT;
+		}
+		if (auto const bits = mismatch(size - 8)) {
+			return size - 8 + static_cast<std::size_t>(std::countr_zero(bits)) / CHAR_BIT;
+		}
+		return size;
+	}
+	for (std::size_t offset = 0; offset < size; offset += 64) {
+		if (auto const mask = mismatch_mask(lhs + offset, rhs + offset, size - offset)) {
+			return offset + static_cast<std::size_t>(std::countr_zero(mask));
+		}
+	}
+	return size;
+}
+
+// Compares as if both were converted with to_lower, for header names and
+// other ASCII identifiers
+constexpr bool equal_case_insensitive(string_like auto const & lhs, string_like auto const & rhs) {
+	auto const lhs_view = as_view(lhs);
+	auto const rhs_view = as_view(rhs);
+	return
+		lhs_view.size() == rhs_view.size() and
+		case_insensitive_mismatch(lhs_view.data(), rhs_view.data(), lhs_view.size()) == lhs_view.size();
+}
+constexpr std::weak_ordering compare_case_insensitive(string_like auto const & lhs, string_like auto const & rhs) {
+	auto const lhs_view = as_view(lhs);
+	auto const rhs_view = as_view(rhs);
+	auto const common = std::min(lhs_view.size(), rhs_view.size());
+	auto const index = case_insensitive_mismatch(lhs_view.data(), rhs_view.data(), common);
+	if (index == common) {
+		return lhs_view.size() <=> rhs_view.size();
+	}
+	return static_cast<unsigned char>(to_lower(lhs_view[index])) <=> static_cast<unsigned char>(to_lower(rhs_view[index]));
+}
+
+
+// Removes whitespace from both ends
+constexpr std::string_view trim(std::string_view const text) {
+	auto const first = find_not_in_class<byte_class::whitespace>(text.data(), text.size());
+	auto const rest = text.substr(first);
+	return rest.substr(0, end_of_last_not_in_class<byte_class::whitespace>(rest.data(), rest.size()));
+}
+// Moves the characters to the start, and never allocates
+template<prototype_string String>
+constexpr void trim(String & str) {
+	auto const trimmed = trim(as_view(str));
+	if (trimmed.size() == str.size()) {
+		return;
+	}
+	auto const offset = static_cast<std::size_t>(trimmed.data() - str.data());
+	str.resize_and_overwrite(trimmed.size(), [=](char * const data, std::size_t const size) {
+		move_characters(data + offset, data + offset + size, data);
+		return size;
+	});
+}
+
+
+constexpr char hex_digit(unsigned const value) {
+	return "0123456789ABCDEF"[value];
+}
+
+// -1 if c is not a hex digit
+constexpr int hex_value(char const c) {
+	if ('0' <= c and c <= '9') {
+		return c - '0';
+	}
+	auto const lower = to_lower(c);
+	if ('a' <= lower and lower <= 'f') {
+		return lower - 'a' + 10;
+	}
+	return -1;
+}
+
+// Escapes grow the string, so they first count how many characters there
+// will be. That is one resize_and_overwrite, which reallocates at most once,
+// and then the characters are moved back from the end, so that each one is
+// moved once and nothing is written over before it is read.
+template<byte_class c, typename String, typename EscapedSize, typename WriteEscape>
+constexpr void escape_in_place(String & str, EscapedSize const escaped_size, WriteEscape const write_escape) {
+	auto const size = str.size();
+	auto new_size = size;
+	auto const data = str.data();
+	for (std::size_t offset = 0; offset < size; offset += 64) {
+		for (auto mask = class_mask<c>(data + offset, size - offset); mask != 0; mask &= mask - 1) {
+			new_size += escaped_size(data[offset + static_cast<std::size_t>(std::countr_zero(mask))]) - 1;
+		}
+	}
+	if (new_size == size) {
+		return;
+	}
+	str.resize_and_overwrite(new_size, [=](char * const data, std::size_t) {
+		auto out = new_size;
+		auto last = size;
+		for_each_in_class_backward<c>(data, size, [&](std::size_t const index) {
+			out -= last - (index + 1);
+			move_characters(data + index + 1, data + last, data + out);
+			auto const character = data[index];
+			out -= escaped_size(character);
+			write_escape(character, data + out);
+			last = index;
+		});
+		assert(out == last);
+		return new_size;
+	});
+}
+
+constexpr char json_short_escape(char const c) {
+	switch (c) {
+		case '"': return '"';
+		case '\\': return '\\';
+		case '\b': return 'b';
+		case '\f': return 'f';
+		case '\n': return 'n';
+		case '\r': return 'r';
+		case '\t': return 't';
+		default: return '\0';
+	}
+}
+
+// Escapes ", \, and control characters, so that the string can go between
+// quotes in JSON. Other characters, including UTF-8, stay the same.
+template<prototype_string String>
+constexpr void escape_json(String & str) {
+	escape_in_place<byte_class::json_special>(
+		str,
+		[](char const c) { return json_short_escape(c) != '\0' ? std::size_t(2) : std::size_t(6); },
+		[](char const c, char * const out) {
+			out[0] = '\\';
+			if (auto const escape = json_short_escape(c)) {
+				out[1] = escape;
+			} else {
+				auto const value = static_cast<unsigned char>(c);
+				out[1] = 'u';
+				out[2] = '0';
+				out[3] = '0';
+				out[4] = hex_digit(value >> 4U);
+				out[5] = hex_digit(value & 0xfU);
+			}
+		}
+	);
+}
+
+// Percent-encodes everything but letters, digits, -, ., _, and ~, as
+// RFC 3986 says for a URL component
+template<prototype_string String>
+constexpr void escape_url(String & str) {
+	escape_in_place<byte_class::url_reserved>(
+		str,
+		[](char) { return std::size_t(3); },
+		[](char const c, char * const out) {
+			auto const value = static_cast<unsigned char>(c);
+			out[0] = '%';
+			out[1] = hex_digit(value >> 4U);
+			out[2] = hex_digit(value & 0xfU);
+		}
+	);
+}
+
+// Unescapes shrink the string, so they write over it from the front and
+// never allocate. parse_escape(first, last, out) reads the escape sequence
+// that starts at first, writes what it stands for to out unless out is null,
+// and returns where the sequence ends and how many characters it stands for.
+// It returns a null end if the sequence is not valid. The first pass only
+// checks, so an invalid string stays as it was.
+struct parsed_escape {
+	char const * last;
+	std::size_t size;
+};
+
+template<byte_class c, typename String, typename ParseEscape>
+constexpr bool unescape_in_place(String & str, ParseEscape const parse_escape) {
+	auto const data = str.data();
+	auto const size = str.size();
+	auto const first_escape = find_in_class<c>(data, size);
+	if (first_escape == size) {
+		return true;
+	}
+	// Returns the new size, or nothing if an escape sequence is not valid
+	auto unescape = [=](char * out) -> std::optional<std::size_t> {
+		auto new_size = first_escape;
+		auto const last = data + size;
+		for (char const * position = data + first_escape; position != last;) {
+			auto const parsed = parse_escape(position, last, out);
+			if (parsed.last == nullptr) {
+				return std::nullopt;
+			}
+			auto const next = parsed.last + find_in_class<c>(parsed.last, static_cast<std::size_t>(last - parsed.last));
+			auto const unescaped = static_cast<std::size_t>(next - parsed.last);
+			if (out != nullptr) {
+				out += parsed.size;
+				move_characters(parsed.last, next, out);
+				out += unescaped;
+			}
+			new_size += parsed.size + unescaped;
+			position = next;
+		}
+		return new_size;
+	};
+	auto const new_size = unescape(nullptr);
+	if (!new_size) {
+		return false;
+	}
+	str.resize_and_overwrite(*new_size, [&](char * const new_data, std::size_t const count) {
+		unescape(new_data + first_escape);
+		return count;
+	});
+	return true;
+}
+
+// Four hex digits, or -1
+constexpr int hex_quad(char const * const first) {
+	auto result = 0;
+	for (std::size_t n = 0; n != 4; ++n) {
+		auto const digit = hex_value(first[n]);
+		if (digit == -1) {
+			return -1;
+		}
+		result = result * 16 + digit;
+	}
+	return result;
+}
+
+constexpr std::size_t utf8_size(char32_t const code_point) {
+	return code_point < 0x80 ? 1 : code_point < 0x800 ? 2 : code_point < 0x10000 ? 3 : 4;
+}
+
+constexpr void write_utf8(char32_t const code_point, char * const out) {
+	auto const byte = [](char32_t const value) { return static_cast<char>(static_cast<unsigned char>(value)); };
+	switch (utf8_size(code_point)) {
+		case 1:
+			out[0] = byte(code_point);
+			break;
+		case 2:
+			out[0] = byte(0xc0 | (code_point >> 6));
+			out[1] = byte(0x80 | (code_point & 0x3f));
+			break;
+		case 3:
+			out[0] = byte(0xe0 | (code_point >> 12));
+			out[1] = byte(0x80 | ((code_point >> 6) & 0x3f));
+			out[2] = byte(0x80 | (code_point & 0x3f));
+			break;
+		default:
+			out[0] = byte(0xf0 | (code_point >> 18));
+			out[1] = byte(0x80 | ((code_point >> 12) & 0x3f));
+			out[2] = byte(0x80 | ((code_point >> 6) & 0x3f));
+			out[3] = byte(0x80 | (code_point & 0x3f));
+			break;
+	}
+}
+
+constexpr parsed_escape parse_json_escape(char const * const first, char const * const last, char * const out) {
+	constexpr auto invalid = parsed_escape{nullptr, 0};
+	if (last - first < 2) {
+		return invalid;
+	}
+	if (first[1] != 'u') {
+		auto result = '\0';
+		switch (first[1]) {
+			case '"': result = '"'; break;
+			case '\\': result = '\\'; break;
+			case '/': result = '/'; break;
+			case 'b': result = '\b'; break;
+			case 'f': result = '\f'; break;
+			case 'n': result = '\n'; break;
+			case 'r': result = '\r'; break;
+			case 't': result = '\t'; break;
+			default: return invalid;
+		}
+		if (out != nullptr) {
+			*out = result;
+		}
+		return {first + 2, 1};
+	}
+	if (last - first < 6) {
+		return invalid;
+	}
+	auto const high = hex_quad(first + 2);
+	if (high == -1 or (0xdc00 <= high and high <= 0xdfff)) {
+		return invalid;
+	}
+	auto code_point = static_cast<char32_t>(high);
+	auto sequence_last = first + 6;
+	// Characters outside of the basic multilingual plane are a surrogate pair
+	if (0xd800 <= high and high <= 0xdbff) {
+		if (last - sequence_last < 6 or sequence_last[0] != '\\' or sequence_last[1] != 'u') {
+			return invalid;
+		}
+		auto const low = hex_quad(sequence_last + 2);
+		if (low < 0xdc00 or low > 0xdfff) {
+			return invalid;
+		}
+		code_point = 0x10000 + ((static_cast<char32_t>(high) - 0xd800) << 10) + (static_cast<char32_t>(low) - 0xdc00);
+		sequence_last += 6;
+	}
+	if (out != nullptr) {
+		write_utf8(code_point, out);
+	}
+	return {sequence_last, utf8_size(code_point)};
+}
+
+// Replaces the JSON escape sequences with the characters they stand for,
+// with \u escapes as UTF-8. Returns false if there is one that is not valid,
+// such as an unpaired surrogate.
+template<prototype_string String>
+constexpr bool unescape_json(String & str) {
+	return unescape_in_place<byte_class::backslash>(str, parse_json_escape);
+}
+
+// Replaces each %XX with the byte it stands for. Returns false if a % is not
+// followed by two hex digits. A + stays a +, since only form data uses it
+// for a space.
+template<prototype_string String>
+constexpr bool unescape_url(String & str) {
+	return unescape_in_place<byte_class::percent>(str, [](char const * const first, char const * const last, char * const out) {
+		if (last - first < 3) {
+			return parsed_escape{nullptr, 0};
+		}
+		auto const high = hex_value(first[1]);
+		auto const low = hex_value(first[2]);
+		if (high == -1 or low == -1) {
+			return parsed_escape{nullptr, 0};
+		}
+		if (out != nullptr) {
+			*out = static_cast<char>(high * 16 + low);
+		}
+		return parsed_escape{first + 3, 1};
+	});
+}
+
+template<typename String>
+constexpr String make_string(std::string_view const source) {
+	auto result = String(typename String::allocator_type());
+	result.append(source.data(), source.data() + source.size());
+	return result;
+}
+
+constexpr bool equal(auto const & str, std::string_view const expected) {
+	return std::string_view(str.data(), str.size()) == expected;
+}
+
+template<typename String, typename Function>
+constexpr void check(std::string_view const input, std::string_view const expected, Function const function) {
+	auto str = make_string<String>(input);
+	function(str);
+	assert(equal(str, expected));
+}
+
+template<typename String>
+constexpr void check_unescape(std::string_view const input, std::string_view const expected, bool (*unescape)(String &)) {
+	auto str = make_string<String>(input);
+	assert(unescape(str));
+	assert(equal(str, expected));
+}
+
+template<typename String>
+constexpr void check_invalid(std::string_view const input, bool (*unescape)(String &)) {
+	auto str = make_string<String>(input);
+	assert(!unescape(str));
+	assert(equal(str, input));
+}
+
+template<typename String>
+constexpr void test_layout() {
+	constexpr auto lower = [](String & str) { to_lower(str); };
+	constexpr auto upper = [](String & str) { to_upper(str); };
+	check<String>("Content-Type", "content-type", lower);
+	check<String>("X-Forwarded-For: 10.0.0.1, 10.0.0.2", "x-forwarded-for: 10.0.0.1, 10.0.0.2", lower);
+	check<String>("gr\xc3\xbc\xc3\x9f Gott", "GR\xc3\xbc\xc3\x9f GOTT", upper);
+	check<String>("@[`{", "@[`{", lower);
+	check<String>("@[`{", "@[`{", upper);
+
+	constexpr auto trim_string = [](String & str) { trim(str); };
+	check<String>("  text/html \r\n", "text/html", trim_string);
+	check<String>("\t\v\f", "", trim_string);
+	check<String>("", "", trim_string);
+	check<String>("no space", "no space", trim_string);
+
+	constexpr auto json = [](String & str) { escape_json(str); };
+	check<String>("plain", "plain", json);
+	check<String>("say \"hi\"\n", "say \\\"hi\\\"\\n", json);
+	check<String>(std::string_view("\x01\x1f\\\0", 4), "\\u0001\\u001F\\\\\\u0000", json);
+	check<String>("caf\xc3\xa9", "caf\xc3\xa9", json);
+
+	constexpr auto url = [](String & str) { escape_url(str); };
+	check<String>("a-b.c_d~e", "a-b.c_d~e", url);
+	check<String>("a b&c=d/\xc3\xa9", "a%20b%26c%3Dd%2F%C3%A9", url);
+
+	check_unescape<String>("say \\\"hi\\\"\\n\\/", "say \"hi\"\n/", unescape_json);
+	check_unescape<String>("\\u00e9\\u20AC\\ud83d\\ude00", "\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80", unescape_json);
+	check_unescape<String>("\\\\\\\\", "\\\\", unescape_json);
+	check_invalid<String>("\\x", unescape_json);
+	check_invalid<String>("ends with \\", unescape_json);
+	check_invalid<String>("\\ud83d alone", unescape_json);
+	check_invalid<String>("\\ude00", unescape_json);
+	check_invalid<String>("\\u12g4", unescape_json);
+
+	check_unescape<String>("a%20b%26c%3dd%2F%C3%A9+", "a b&c=d/\xc3\xa9+", unescape_url);
+	check_invalid<String>("100%", unescape_url);
+	check_invalid<String>("%2x", unescape_url);
+
+	// Fits in the small buffer of either layout
+	auto small = make_string<String>("\"a\"");
+	auto const small_capacity = small.capacity();
+	escape_json(small);
+	assert(equal(small, "\\\"a\\\""));
+	assert(small.capacity() == small_capacity);
+
+	// Grows once, to exactly the right size
+	auto large = make_string<String>("/path with spaces/and more spaces/");
+	escape_url(large);
+	assert(equal(large, "%2Fpath%20with%20spaces%2Fand%20more%20spaces%2F"));
+	assert((large.capacity() | 1) == (large.size() | 1));
+
+	auto const header = make_string<String>("Accept-Encoding");
+	assert(equal_case_insensitive(header, "accept-encoding"));
+	assert(!equal_case_insensitive(header, "accept-encodinG "));
+	assert(!equal_case_insensitive(header, "accept_encoding"));
+	assert(compare_case_insensitive(header, "ACCEPT") == std::weak_ordering::greater);
+	assert(compare_case_insensitive(header, "accept-language") == std::weak_ordering::less);
+	assert(compare_case_insensitive("[", "a") == std::weak_ordering::less);
+	assert(hash_case_insensitive(header) == hash_case_insensitive("ACCEPT-ENCODING"));
+	assert(hash_case_insensitive(header) == hash_bytes("accept-encoding", 15));
+}
+
+constexpr bool test() {
+	using allocator_type = std::allocator<char>;
+	test_layout<clang::string<allocator_type>>();
+	test_layout<gcc::string<allocator_type>>();
+	assert(trim(std::string_view(" \t a b \n")) == "a b");
+	assert(lower_word(0x415a'405b'617a'c1da) == 0x617a'405b'617a'c1da);
+	return true;
+}
+
+// Each kernel against a scalar version, for every size up to a few vectors
+// and a mix of the characters that the kernels look for
+
+std::string naive_lower(std::string text) {
+	for (auto & c : text) {
+		c = to_lower(c);
+	}
+	return text;
+}
+
+std::string naive_trim(std::string_view const text) {
+	auto const is_space = [](char const c) { return std::string_view(" \t\n\v\f\r").find(c) != std::string_view::npos; };
+	auto first = std::size_t(0);
+	while (first != text.size() and is_space(text[first])) {
+		++first;
+	}
+	auto last = text.size();
+	while (last != first and is_space(text[last - 1])) {
+		--last;
+	}
+	return std::string(text.substr(first, last - first));
+}
+
+std::string naive_escape_json(std::string_view const text) {
+	auto result = std::string();
+	for (auto const c : text) {
+		switch (c) {
+			case '"': result += "\\\""; break;
+			case '\\': result += "\\\\"; break;
+			case '\b': result += "\\b"; break;
+			case '\f': result += "\\f"; break;
+			case '\n': result += "\\n"; break;
+			case '\r': result += "\\r"; break;
+			case '\t': result += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					char buffer[7];
+					std::snprintf(buffer, sizeof(buffer), "\\u%04X", static_cast<unsigned>(c));
+					result += buffer;
+				} else {
+					result += c;
+				}
+				break;
+		}
+	}
+	return result;
+}
+
+std::string naive_escape_url(std::string_view const text) {
+	auto result = std::string();
+	for (auto const c : text) {
+		if (std::isalnum(static_cast<unsigned char>(c)) or c == '-' or c == '.' or c == '_' or c == '~') {
+			result += c;
+		} else {
+			char buffer[4];
+			std::snprintf(buffer, sizeof(buffer), "%%%02X", static_cast<unsigned>(static_cast<unsigned char>(c)));
+			result += buffer;
+		}
+	}
+	return result;
+}
+
+template<typename String>
+void test_against_naive() {
+	constexpr std::string_view alphabet = "aZz@[`{ \t\r\n\"\\%/~-._0\x01\x7f\x80\xc3\xa9\xff";
+	auto engine = std::mt19937_64(1);
+	auto text = std::string();
+	for (int n = 0; n != 50'000; ++n) {
+		text.clear();
+		auto const size = engine() % 200;
+		for (std::size_t index = 0; index != size; ++index) {
+			text += engine() % 2 == 0 ? static_cast<char>('A' + engine() % 58) : alphabet[engine() % alphabet.size()];
+		}
+		if (engine() % 4 == 0) {
+			text.insert(0, engine() % 70, ' ');
+			text.append(engine() % 70, '\n');
+		}
+
+		auto str = make_string<String>(text);
+		to_lower(str);
+		auto const lowered = naive_lower(text);
+		assert(equal(str, lowered));
+		assert(hash_case_insensitive(text) == hash_bytes(lowered.data(), lowered.size()));
+		to_upper(str);
+		assert(equal_case_insensitive(str, text));
+		assert(compare_case_insensitive(str, text) == 0);
+		if (!text.empty()) {
+			auto other = text;
+			auto const index = engine() % other.size();
+			other[index] = static_cast<char>(other[index] ^ 1);
+			auto const expected = naive_lower(text) <=> naive_lower(other);
+			assert(compare_case_insensitive(text, other) == expected);
+			assert(equal_case_insensitive(text, other) == (expected == 0));
+		}
+
+		auto trimmed = make_string<String>(text);
+		trim(trimmed);
+		assert(equal(trimmed, naive_trim(text)));
+
+		auto json = make_string<String>(text);
+		escape_json(json);
+		assert(equal(json, naive_escape_json(text)));
+		assert(unescape_json(json));
+		assert(equal(json, text));
+
+		auto url = make_string<String>(text);
+		escape_url(url);
+		assert(equal(url, naive_escape_url(text)));
+		assert(unescape_url(url));
+		assert(equal(url, text));
+	}
+}
+
+// Counts calls to the global operator new, which std::allocator uses
+std::size_t allocations = 0;
+
+void * operator new(std::size_t const size) {
+	++allocations;
+	if (auto const result = std::malloc(size)) {
+		return result;
+	}
+	throw std::bad_alloc();
+}
+void operator delete(void * const ptr) noexcept {
+	std::free(ptr);
+}
+void operator delete(void * const ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+template<typename Function>
+double nanoseconds_per_operation(std::size_t const count, Function && function) {
+	auto const start = std::chrono::steady_clock::now();
+	function();
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+}
+
+struct header {
+	std::string name;
+	std::string value;
+};
+
+std::vector<header> make_headers(std::size_t const count) {
+	auto engine = std::mt19937_64(1);
+	constexpr std::string_view names[] = {"Content-Type", "content-length", "Accept-Encoding", "X-Forwarded-For", "User-Agent", "X-Request-Id", "Cache-Control", "Authorization"};
+	constexpr std::string_view values[] = {
+		" application/json",
+		" 1234 ",
+		" gzip, deflate, br",
+		" 203.0.113.195, 70.41.3.18, 150.172.238.178",
+		" Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36",
+		" 6f1c0a6e-3b4d-4f1e-9a55-2c7d3c1e0b9a\r",
+		" no-cache",
+		" Bearer eyJhbGciOiJIUzI1NiIsInR5cCI6IkpXVCJ9.eyJzdWIiOiIxMjM0NTY3ODkwIn0",
+	};
+	auto result = std::vector<header>(count);
+	for (auto & element : result) {
+		element.name = names[engine() % std::size(names)];
+		element.value = values[engine() % std::size(values)];
+	}
+	return result;
+}
+
+// String fields of JSON documents. Most of them have nothing to escape.
+std::vector<std::string> make_json_fields(std::size_t const count) {
+	auto engine = std::mt19937_64(1);
+	constexpr std::string_view fields[] = {
+		"d3b07384d113edec49eaa6238ad5ff00",
+		"Order shipped to warehouse 12",
+		"The quick brown fox jumps over the lazy dog, again and again and again.",
+		"He said \"no\"",
+		"line one\nline two\nline three",
+		"C:\\Program Files\\Service\\config.json",
+	};
+	auto result = std::vector<std::string>(count);
+	for (auto & element : result) {
+		auto const index = engine() % 8;
+		element = fields[index < 3 ? index : index < 6 ? index % 3 : index - 3];
+	}
+	return result;
+}
+
+template<typename Function>
+void benchmark_one(char const * const name, std::size_t const count, Function function) {
+	auto sink = std::size_t(0);
+	auto const before = allocations;
+	auto const time = nanoseconds_per_operation(count, [&] {
+		for (std::size_t n = 0; n != count; ++n) {
+			sink += function(n);
+		}
+	});
+	assert(sink != 0);
+	std::printf("%-52s %14.1f %14.2f\n", name, time, static_cast<double>(allocations - before) / static_cast<double>(count));
+}
+
+// Each layout is compared against a plain loop over std::string, the way a
+// gateway would write it without these functions. The strings are copied
+// first in every version.
+template<typename String>
+void benchmark_layout(char const * const layout, std::vector<header> const & headers, std::vector<std::string> const & fields) {
+	auto name = [&](char const * const operation) {
+		static char buffer[100];
+		std::snprintf(buffer, sizeof(buffer), "%s, %s", layout, operation);
+		return buffer;
+	};
+	auto const as_string = [](std::string const & source) { return make_string<String>(source); };
+	benchmark_one(name("to_lower and trim header"), headers.size(), [&](std::size_t const n) {
+		auto header_name = as_string(headers[n].name);
+		auto value = as_string(headers[n].value);
+		to_lower(header_name);
+		trim(value);
+		return header_name.size() + value.size();
+	});
+	benchmark_one(name("hash_case_insensitive header name"), headers.size(), [&](std::size_t const n) {
+		return hash_case_insensitive(headers[n].name);
+	});
+	benchmark_one(name("equal_case_insensitive header name"), headers.size(), [&](std::size_t const n) {
+		return std::size_t(equal_case_insensitive(headers[n].name, "x-forwarded-for")) + 1;
+	});
+	benchmark_one(name("escape_json"), fields.size(), [&](std::size_t const n) {
+		auto str = as_string(fields[n]);
+		escape_json(str);
+		return str.size();
+	});
+	benchmark_one(name("escape_url and unescape_url"), headers.size(), [&](std::size_t const n) {
+		auto str = as_string(headers[n].value);
+		escape_url(str);
+		auto const escaped = str.size();
+		unescape_url(str);
+		return escaped + str.size();
+	});
+}
+
+void benchmark() {
+	auto const headers = make_headers(1'000'000);
+	auto const fields = make_json_fields(1'000'000);
+	std::printf("%-52s %14s %14s\n", "", "ns per string", "allocations");
+
+	benchmark_one("std::string, to_lower and trim header", headers.size(), [&](std::size_t const n) {
+		auto header_name = headers[n].name;
+		auto value = headers[n].value;
+		std::ranges::transform(header_name, header_name.begin(), [](char const c) { return to_lower(c); });
+		value = naive_trim(value);
+		return header_name.size() + value.size();
+	});
+	benchmark_one("std::string, lower copy and hash header name", headers.size(), [&](std::size_t const n) {
+		auto const lowered = naive_lower(headers[n].name);
+		return hash_bytes(lowered.data(), lowered.size());
+	});
+	benchmark_one("std::string, equal with to_lower header name", headers.size(), [&](std::size_t const n) {
+		return std::size_t(std::ranges::equal(headers[n].name, std::string_view("x-forwarded-for"), {}, [](char const c) { return to_lower(c); })) + 1;
+	});
+	benchmark_one("std::string, escape json", fields.size(), [&](std::size_t const n) {
+		auto const str = fields[n];
+		return naive_escape_json(str).size();
+	});
+	benchmark_one("std::string, escape and unescape url", headers.size(), [&](std::size_t const n) {
+		auto const str = headers[n].value;
+		auto const escaped = naive_escape_url(str);
+		auto unescaped = std::string();
+		for (std::size_t index = 0; index != escaped.size(); ++index) {
+			if (escaped[index] == '%') {
+				unescaped += static_cast<char>(hex_value(escaped[index + 1]) * 16 + hex_value(escaped[index + 2]));
+				index += 2;
+			} else {
+				unescaped += escaped[index];
+			}
+		}
+		return escaped.size() + unescaped.size();
+	});
+	benchmark_layout<clang::string<std::allocator<char>>>("clang layout", headers, fields);
+	benchmark_layout<gcc::string<std::allocator<char>>>("gcc layout", headers, fields);
+}
+
+int main() {
+	test();
+	static_assert(test());
+	test_against_naive<clang::string<std::allocator<char>>>();
+	test_against_naive<gcc::string<std::allocator<char>>>();
+	benchmark();
+}
@@ -0,0 +1,773 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is to let a string
+// reserve the capacity it will end up needing as soon as it is constructed,
+// based on what strings constructed at the same place needed in an earlier
+// run. The string is the clang-abi-compatible string.
+//
+// The constructor takes a std::source_location defaulted to its caller. A
+// profiling run (compiled with -DSTRING_CAPACITY_PROFILE=N) records the final
+// size of about one in N strings at each site when it is destroyed and saves
+// the sizes to a file. A later run loads that file, and the constructor reserves the
+// learned capacity instead of growing to it one reallocation at a time.
+//
+// Running the program builds a few strings at two sites. Pass the name of a
+// profile file to save it in a profiling build or to load it otherwise.
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <source_location>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+template<typename T>
+struct buffer {
+	constexpr buffer() = default;
+	buffer(buffer &&) = delete;
+	buffer(buffer const &) = delete;
+	buffer & operator=(buffer &&) = delete;
+	buffer & operator=(buffer const &) = delete;
+
+	T data[5000] = {};
+	T * pointer = data;
+};
+
+template<typename T>
+struct allocator {
+	using value_type = T;
+
+	explicit constexpr allocator(buffer<T> & buffer):
+		buffer_(&buffer)
+	{
+	}
+
+	constexpr auto allocate(std::size_t size) {
+		auto const result = buffer_->pointer;
+		buffer_->pointer += size;
+		return result;
+	}
+	constexpr void deallocate(T * ptr, std::size_t size) {
+	}
+
+private:
+	buffer<T> * buffer_;
+};
+
+
+// Define STRING_CAPACITY_PROFILE to N to record the final size of about one in
+// N strings in a profiling run. Otherwise, string does not remember where it was
+// constructed. Hints from an earlier run can be loaded either way.
+#ifndef STRING_CAPACITY_PROFILE
+	#define STRING_CAPACITY_PROFILE 0
+#endif
+
+constexpr auto capacity_sample_period = std::size_t(STRING_CAPACITY_PROFILE);
+
+struct site_key {
+	std::string_view file;
+	std::uint_least32_t line;
+	std::uint_least32_t column;
+
+	friend bool operator==(site_key, site_key) = default;
+};
+
+constexpr site_key make_site_key(std::source_location const site) {
+	return site_key{site.file_name(), site.line(), site.column()};
+}
+
+struct site_key_hash {
+	std::size_t operator()(site_key const key) const {
+		auto const position = (std::size_t(key.line) << 16) ^ std::size_t(key.column);
+		return std::hash<std::string_view>()(key.file) ^ (position * 0x9E37'79B9'7F4A'7C15);
+	}
+};
+
+// The final sizes of the sampled strings constructed at each site
+class capacity_recorder {
+public:
+	void record(std::source_location const site, std::size_t const size) {
+		auto const lock = std::lock_guard(mutex_);
+		sizes_[make_site_key(site)].push_back(size);
+	}
+
+	// Writes one line per site: the capacity that `fraction` of the strings
+	// constructed there fit in, then the line, column, and file of the site.
+	// Sites where that fits in the small buffer are left out.
+	void save(std::ostream & stream, std::size_t const small_buffer_capacity, double const fraction = 0.9) const {
+		auto const lock = std::lock_guard(mutex_);
+		for (auto const & [site, site_sizes] : sizes_) {
+			auto sorted = site_sizes;
+			auto const index = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size() - 1));
+			std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(index), sorted.end());
+			auto const capacity = sorted[index];
+			if (capacity > small_buffer_capacity) {
+				stream << capacity << ' ' << site.line << ' ' << site.column << ' ' << site.file << '\n';
+			}
+		}
+	}
+
+	void clear() {
+		auto const lock = std::lock_guard(mutex_);
+		sizes_.clear();
+	}
+
+private:
+	mutable std::mutex mutex_;
+	std::unordered_map<site_key, std::vector<std::size_t>, site_key_hash> sizes_;
+};
+
+// Loaded once at startup, then only read, so lookups need no lock
+class capacity_hints {
+public:
+	// Reads lines in the format that capacity_recorder::save writes. Throws
+	// std::runtime_error naming the first line that is not in that format, in
+	// which case nothing from this stream is kept.
+	void load(std::istream & stream) {
+		auto loaded = capacity_hints();
+		auto text = std::string();
+		for (std::size_t line_number = 1; std::getline(stream, text); ++line_number) {
+			if (text.empty()) {
+				continue;
+			}
+			auto fields = std::istringstream(text);
+			auto capacity = std::size_t();
+			auto line = std::uint_least32_t();
+			auto column = std::uint_least32_t();
+			auto file = std::string();
+			if (!(fields >> capacity >> line >> column) or fields.get() != ' ' or !std::getline(fields, file) or file.empty()) {
+				throw std::runtime_error("malformed capacity hint on line " + std::to_string(line_number) + ": " + text);
+			}
+			loaded.insert(capacity, line, column, std::move(file));
+		}
+		if (!stream.eof()) {
+			throw std::runtime_error("could not read capacity hints");
+		}
+		for (auto const & [site, capacity] : loaded.hints_) {
+			insert(capacity, site.line, site.column, std::string(site.file));
+		}
+	}
+
+	// Returns 0 if there is no hint for this site. Most sites have none, so
+	// the line number is checked against a filter first, which spares those
+	// sites from hashing the file name.
+	std::size_t lookup(std::source_location const site) const {
+		if (!might_contain(site.line())) {
+			return 0;
+		}
+		auto const it = hints_.find(make_site_key(site));
+		return it == hints_.end() ? 0 : it->second;
+	}
+
+	void clear() {
+		hints_.clear();
+		files_.clear();
+		line_filter_ = {};
+	}
+
+private:
+	static constexpr auto filter_bits = std::size_t(64) * 64;
+
+	void insert(std::size_t const capacity, std::uint_least32_t const line, std::uint_least32_t const column, std::string file) {
+		auto const & stored_file = *files_.insert(std::move(file)).first;
+		hints_.insert_or_assign(site_key{stored_file, line, column}, capacity);
+		auto const bit = line % filter_bits;
+		line_filter_[bit / 64] |= std::uint64_t(1) << (bit % 64);
+	}
+
+	bool might_contain(std::uint_least32_t const line) const {
+		auto const bit = line % filter_bits;
+		return (line_filter_[bit / 64] >> (bit % 64)) & 1;
+	}
+
+	// Node-based, so the views in the keys of hints_ stay valid
+	std::unordered_set<std::string> files_;
+	std::unordered_map<site_key, std::size_t, site_key_hash> hints_;
+	// Bit line % filter_bits is set if any hint is for that line
+	std::array<std::uint64_t, filter_bits / 64> line_filter_ = {};
+};
+
+inline auto global_capacity_recorder = capacity_recorder();
+inline auto global_capacity_hints = capacity_hints();
+
+// xorshift64*. Each string is sampled with probability 1 / N, so every site
+// gets its own share of samples no matter how the constructions of different
+// sites interleave. A countdown shared by all sites would skip a site whose
+// strings are always constructed in step with another site's.
+inline thread_local auto sample_state = std::uint64_t(0x9E37'79B9'7F4A'7C15);
+
+template<bool enabled>
+struct site_tracker {
+	// Only called outside of constant evaluation. No lookup is done here; the
+	// recorder's map is only touched when a sampled string is destroyed.
+	void start(std::source_location const site) {
+		if (take_sample()) {
+			site_ = site;
+		}
+	}
+	constexpr void record(std::size_t const final_size) const {
+		if (!std::is_constant_evaluated() and site_.line() != 0) {
+			global_capacity_recorder.record(site_, final_size);
+		}
+	}
+	constexpr void clear() {
+		site_ = std::source_location();
+	}
+private:
+	static bool take_sample() {
+		sample_state ^= sample_state >> 12;
+		sample_state ^= sample_state << 25;
+		sample_state ^= sample_state >> 27;
+		// Only instantiated when capacity_sample_period != 0
+		constexpr auto period = enabled ? capacity_sample_period : 1;
+		return (sample_state * 0x2545'F491'4F6C'DD1D) % period == 0;
+	}
+
+	std::source_location site_;
+};
+
+template<>
+struct site_tracker<false> {
+	void start(std::source_location) {
+	}
+	constexpr void record(std::size_t) const {
+	}
+	constexpr void clear() {
+	}
+};
+
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = allocator<char>;
+
+	static constexpr std::size_t small_buffer_capacity = 23;
+
+private:
+	struct small_t {
+		char data[small_buffer_capacity] = {};
+	};
+	struct [[gnu::packed]] large_t {
+		static constexpr std::size_t bytes_remaining = 7;
+
+		template<typename It>
+		class range_view {
+		public:
+			constexpr range_view(It first, It last):
+				first_(first),
+				last_(last)
+			{
+			}
+			constexpr auto begin() const {
+				return first_;
+			}
+			constexpr auto end() const {
+				return last_;
+			}
+		private:
+			It first_;
+			It last_;
+		};
+
+		constexpr auto little_endian_capacity() const {
+			return range_view(
+				std::rbegin(rest_of_capacity),
+				std::rend(rest_of_capacity)
+			);
+		}
+		constexpr auto big_endian_capacity() {
+			return range_view(
+				std::begin(rest_of_capacity),
+				std::end(rest_of_capacity)
+			);
+		}
+
+		constexpr large_t(std::size_t set_size, std::size_t capacity, char * pointer) noexcept:
+			rest_of_capacity{},
+			size(set_size),
+			data(pointer)
+		{
+			assert(data != nullptr);
+			for (unsigned char & byte : big_endian_capacity()) {
+				capacity >>= CHAR_BIT;
+				byte = capacity;
+			}
+		}
+
+		unsigned char rest_of_capacity[bytes_remaining];
+		std::size_t size;
+		char * data;
+	};
+
+	[[no_unique_address]] allocator_type allocator_;
+	unsigned char size_or_first_byte_of_capacity_;
+	union U {
+		constexpr U() noexcept:
+			small{}
+		{
+		}
+		explicit constexpr U(std::size_t size, std::size_t capacity, char * data) noexcept:
+			large(size, capacity, data)
+		{
+		}
+		constexpr U(large_t set_large) noexcept:
+			large(set_large)
+		{
+		}
+
+		small_t small;
+		large_t large;
+	} u_;
+	[[no_unique_address]] site_tracker<capacity_sample_period != 0> site_;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return size_or_first_byte_of_capacity_ & 1;
+	}
+
+	constexpr void increment_size() {
+		if (is_large()) {
+			++u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ += (1 << 1);
+		}
+	}
+	constexpr void decrement_size() {
+		if (is_large()) {
+			--u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ -= (1 << 1);
+		}
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, u_.large.data, capacity());
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(size(), new_capacity, new_data);
+		assert(new_capacity & 1);
+		size_or_first_byte_of_capacity_ = new_capacity;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		new_capacity |= 1;
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy(begin(), end(), temp);
+		relocate(temp, new_capacity);
+	}
+
+	struct no_hint_t {
+	};
+
+	constexpr string(no_hint_t, allocator_type alloc) noexcept:
+		allocator_(alloc),
+		size_or_first_byte_of_capacity_(0),
+		u_{},
+		site_{}
+	{
+	}
+
+public:
+	// The default argument is evaluated where the string is constructed, which
+	// is what identifies the site.
+	explicit constexpr string(allocator_type alloc, std::source_location const site = std::source_location::current()):
+		string(no_hint_t(), alloc)
+	{
+		if (!std::is_constant_evaluated()) {
+			site_.start(site);
+			if (auto const hint = global_capacity_hints.lookup(site); hint != 0) {
+				reserve(hint);
+			}
+		}
+	}
+
+	// Moving a string does not start a new one, so this neither takes a hint
+	// nor records a site.
+	constexpr string(string && other) noexcept:
+		string(no_hint_t(), other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		site_.record(size());
+		deallocate();
+		site_ = other.site_;
+		other.site_.clear();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.large);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+
+			other.u_ = U{};
+			other.size_or_first_byte_of_capacity_ = 0;
+		} else {
+			auto & osmall = other.u_.small;
+			u_ = U{};
+			copy(osmall.data, osmall.data + (other.size_or_first_byte_of_capacity_ >> 1), u_.small.data);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		site_.record(size());
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr char * data() {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr std::size_t size() const {
+		return is_large() ? u_.large.size : (size_or_first_byte_of_capacity_ >> 1);
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		if (!is_large()) {
+			return small_buffer_capacity;
+		}
+		std::size_t result = 0;
+		for (unsigned char const byte : u_.large.little_endian_capacity()) {
+			result |= byte;
+			result <<= CHAR_BIT;
+		}
+		result |= size_or_first_byte_of_capacity_;
+		return result;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		auto const local_size = size();
+		if (is_large() && capacity() > (local_size | 1)) {
+			if (local_size > small_buffer_capacity) {
+				force_reserve(local_size);
+			} else {
+				auto const data = u_.large.data;
+				auto const original_capacity = capacity();
+				u_ = U{};
+				size_or_first_byte_of_capacity_ = local_size << 1;
+				copy(data, data + local_size, u_.small.data);
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = std::prev(end());
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = (capacity() * growth_factor) | 1;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+
+			relocate(temp, new_capacity);
+		}
+		increment_size();
+		return begin() + offset;
+	}
+
+	constexpr void pop_back() {
+		decrement_size();
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+
+constexpr void test_individual(string & str, char const * source) {
+	string temp(str.get_allocator());
+	for (auto it = source; *it != '\0'; ++it) {
+		str.insert(str.end(), *it);
+		temp.insert(temp.end(), *it);
+	}
+
+	temp.insert(temp.begin(), 'a');
+	temp.insert(temp.begin() + temp.size() / 2, 'b');
+	auto const size = std::char_traits<char>::length(source);
+	auto const middle = (size + 1) / 2;
+	assert(temp.size() == size + 2);
+	for (std::size_t n = 0; n != temp.size(); ++n) {
+		auto const expected = n == 0 ? 'a' : n == middle ? 'b' : n < middle ? source[n - 1] : source[n - 2];
+		assert(temp.data()[n] == expected);
+	}
+
+	// Inserting at the front, including each time that reallocates
+	string front(str.get_allocator());
+	for (std::size_t n = 0; n != 100; ++n) {
+		front.insert(front.begin(), static_cast<char>('0' + n % 10));
+	}
+	for (std::size_t n = 0; n != front.size(); ++n) {
+		assert(front.data()[n] == static_cast<char>('0' + (99 - n) % 10));
+	}
+
+	while (temp.size() != 0) {
+		temp.pop_back();
+	}
+	assert(temp.size() == 0);
+
+	auto temp2 = std::move(str);
+	str = std::move(temp2);
+
+	assert(str.data() != temp.data());
+	assert(str.size() == std::char_traits<char>::length(source));
+	assert(std::char_traits<char>::compare(str.data(), source, str.size()) == 0);
+	assert(str.capacity() >= str.size());
+
+	str.reserve(50);
+	str.shrink_to_fit();
+}
+
+constexpr bool test() {
+	buffer<char> buff{};
+	auto alloc = allocator(buff);
+
+	char const * short_source = "0123";
+	char const * long_source =
+		"0123456789"
+		"0123456789"
+		"0123456789"
+		"0123456789"
+		"0123456789";
+
+	string short_str(alloc);
+	test_individual(short_str, short_source);
+
+	string long_str(alloc);
+	test_individual(long_str, long_source);
+
+	assert(short_str.data() != long_str.data());
+
+	string temp(alloc);
+	temp = std::move(long_str);
+	temp = std::move(short_str);
+
+	return true;
+}
+
+void test_hints() {
+	auto recorder = capacity_recorder();
+	auto const hinted_site = std::source_location::current();
+	auto const small_site = std::source_location::current();
+	for (std::size_t size = 1; size <= 100; ++size) {
+		recorder.record(hinted_site, size);
+		recorder.record(small_site, size % 10);
+	}
+	auto profile = std::stringstream();
+	recorder.save(profile, string::small_buffer_capacity);
+
+	auto line = std::string();
+	std::getline(profile, line);
+	auto const expected = "90 " + std::to_string(hinted_site.line()) + ' ' + std::to_string(hinted_site.column()) + ' ' + hinted_site.file_name();
+	assert(line == expected);
+	assert(!std::getline(profile, line));
+
+	profile.clear();
+	global_capacity_hints.load(profile.seekg(0));
+	assert(global_capacity_hints.lookup(hinted_site) == 90);
+	assert(global_capacity_hints.lookup(small_site) == 0);
+
+	buffer<char> buff{};
+	auto alloc = allocator(buff);
+	auto hinted = string(alloc, hinted_site);
+	assert(hinted.capacity() == 91);
+	auto const unhinted = string(alloc);
+	assert(unhinted.capacity() == string::small_buffer_capacity);
+	auto const moved = string(std::move(hinted));
+	assert(moved.capacity() == 91);
+	global_capacity_hints.clear();
+
+	auto const is_rejected = [](std::string const & text) {
+		auto hints = capacity_hints();
+		auto stream = std::istringstream(text);
+		try {
+			hints.load(stream);
+		} catch (std::runtime_error const &) {
+			return hints.lookup(std::source_location::current()) == 0;
+		}
+		return false;
+	};
+	assert(is_rejected("90 12 3\n"));
+	assert(is_rejected("90 12 3 \n"));
+	assert(is_rejected("90 12 file.cpp\n"));
+	assert(is_rejected("ninety 12 3 file.cpp\n"));
+	assert(is_rejected("90 12 3 file.cpp\n90 12\n"));
+	assert(!is_rejected("90 12 3 file.cpp\n\n80 13 3 other file.cpp"));
+}
+
+// Each site builds strings of roughly the same length every time
+std::size_t build_strings() {
+	auto buff = std::make_unique<buffer<char>>();
+	auto alloc = allocator(*buff);
+	for (std::size_t n = 0; n != 20; ++n) {
+		string name(alloc);
+		for (std::size_t index = 0; index != 10; ++index) {
+			name.insert(name.end(), 'n');
+		}
+		string path(alloc);
+		for (std::size_t index = 0; index != 55 + n % 5; ++index) {
+			path.insert(path.end(), 'p');
+		}
+	}
+	return static_cast<std::size_t>(buff->pointer - buff->data);
+}
+
+int main(int argc, char ** argv) {
+	test();
+	static_assert(test());
+	test_hints();
+
+	auto const profile_name = argc > 1 ? argv[1] : nullptr;
+	if (profile_name and capacity_sample_period == 0) {
+		auto file = std::ifstream(profile_name);
+		try {
+			global_capacity_hints.load(file);
+		} catch (std::runtime_error const & error) {
+			std::fprintf(stderr, "%s: %s\n", profile_name, error.what());
+			return 1;
+		}
+	}
+	std::printf("bytes allocated: %zu\n", build_strings());
+	if (profile_name and capacity_sample_period != 0) {
+		auto file = std::ofstream(profile_name);
+		global_capacity_recorder.save(file, string::small_buffer_capacity);
+	}
+}
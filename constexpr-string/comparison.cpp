@@ -0,0 +1,872 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is to add operator== and
+// operator<=> to both layouts, taking advantage of the small buffer.
+//
+// Both layouts keep every byte of the small buffer past the size 0 (only
+// pop_back needed to change for that). Two small strings are then equal if
+// their sizes and their whole buffers are equal, which is three 64-bit loads
+// per string for the clang layout and two for the gcc / MSVC layout, with no
+// loop and no branch on the size. Ordering loads the same words in big-endian
+// order, so comparing them as integers compares the characters as unsigned
+// char, and the zero padding means the shorter of two strings with a common
+// prefix never compares greater. Large strings compare sizes first for
+// equality and fall back to memcmp.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <climits>
+#include <compare>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+template<typename T>
+struct buffer {
+	constexpr buffer() = default;
+	buffer(buffer &&) = delete;
+	buffer(buffer const &) = delete;
+	buffer & operator=(buffer &&) = delete;
+	buffer & operator=(buffer const &) = delete;
+
+	T data[5000] = {};
+	T * pointer = data;
+};
+
+template<typename T>
+struct allocator {
+	using value_type = T;
+
+	explicit constexpr allocator(buffer<T> & buffer):
+		buffer_(&buffer)
+	{
+	}
+
+	constexpr auto allocate(std::size_t size) {
+		auto const result = buffer_->pointer;
+		buffer_->pointer += size;
+		return result;
+	}
+	constexpr void deallocate(T * ptr, std::size_t size) {
+	}
+
+private:
+	buffer<T> * buffer_;
+};
+
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+
+// Reads bytes in memory order, so that comparing two words as integers
+// compares them as unsigned characters, the same as memcmp.
+inline std::uint64_t load_big_endian(char const * const data) {
+	auto result = std::uint64_t();
+	std::memcpy(&result, data, sizeof(result));
+	if constexpr (std::endian::native == std::endian::little) {
+		result = __builtin_bswap64(result);
+	}
+	return result;
+}
+
+// The offsets of the words covering a small buffer of `capacity` bytes. The
+// last word overlaps the one before it when capacity is not a multiple of the
+// word size. The overlapping bytes are already known to be equal by the time
+// the last word matters, so this does not change any result.
+template<std::size_t capacity>
+constexpr auto word_offsets = [] {
+	static_assert(capacity >= sizeof(std::uint64_t));
+	constexpr auto word = sizeof(std::uint64_t);
+	auto result = std::array<std::size_t, (capacity + word - 1) / word>();
+	for (std::size_t n = 0; n != result.size(); ++n) {
+		result[n] = std::min(n * word, capacity - word);
+	}
+	return result;
+}();
+
+// These rely on every byte of both buffers past the size being 0.
+
+template<std::size_t capacity>
+bool small_buffer_equal(char const * const lhs, char const * const rhs) {
+	auto difference = std::uint64_t(0);
+	for (auto const offset : word_offsets<capacity>) {
+		difference |= load_big_endian(lhs + offset) ^ load_big_endian(rhs + offset);
+	}
+	return difference == 0;
+}
+
+// Bytes past the end of the shorter string are 0 in that string, and at
+// least 0 in the longer one, so comparing them cannot put the longer string
+// first. If everything matches, the shorter string is a prefix of the longer.
+template<std::size_t capacity>
+std::strong_ordering small_buffer_compare(char const * const lhs, std::size_t const lhs_size, char const * const rhs, std::size_t const rhs_size) {
+	for (auto const offset : word_offsets<capacity>) {
+		auto const lhs_word = load_big_endian(lhs + offset);
+		auto const rhs_word = load_big_endian(rhs + offset);
+		if (lhs_word != rhs_word) {
+			return lhs_word <=> rhs_word;
+		}
+	}
+	return lhs_size <=> rhs_size;
+}
+
+// glibc's memcmp, which this calls at run time, is already vectorized.
+constexpr std::strong_ordering compare(char const * const lhs, std::size_t const lhs_size, char const * const rhs, std::size_t const rhs_size) {
+	auto const result = std::char_traits<char>::compare(lhs, rhs, std::min(lhs_size, rhs_size));
+	return result != 0 ? result <=> 0 : lhs_size <=> rhs_size;
+}
+
+
+namespace clang {
+
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = allocator<char>;
+
+private:
+	static constexpr std::size_t small_buffer_capacity = 23;
+
+	struct small_t {
+		char data[small_buffer_capacity] = {};
+	};
+	struct [[gnu::packed]] large_t {
+		static constexpr std::size_t bytes_remaining = 7;
+
+		template<typename It>
+		class range_view {
+		public:
+			constexpr range_view(It first, It last):
+				first_(first),
+				last_(last)
+			{
+			}
+			constexpr auto begin() const {
+				return first_;
+			}
+			constexpr auto end() const {
+				return last_;
+			}
+		private:
+			It first_;
+			It last_;
+		};
+
+		constexpr auto little_endian_capacity() const {
+			return range_view(
+				std::rbegin(rest_of_capacity),
+				std::rend(rest_of_capacity)
+			);
+		}
+		constexpr auto big_endian_capacity() {
+			return range_view(
+				std::begin(rest_of_capacity),
+				std::end(rest_of_capacity)
+			);
+		}
+
+		constexpr large_t(std::size_t set_size, std::size_t capacity, char * pointer) noexcept:
+			rest_of_capacity{},
+			size(set_size),
+			data(pointer)
+		{
+			assert(data != nullptr);
+			for (unsigned char & byte : big_endian_capacity()) {
+				capacity >>= CHAR_BIT;
+				byte = capacity;
+			}
+		}
+
+		unsigned char rest_of_capacity[bytes_remaining];
+		std::size_t size;
+		char * data;
+	};
+
+	[[no_unique_address]] allocator_type allocator_;
+	unsigned char size_or_first_byte_of_capacity_;
+	union U {
+		constexpr U() noexcept:
+			small{}
+		{
+		}
+		explicit constexpr U(std::size_t size, std::size_t capacity, char * data) noexcept:
+			large(size, capacity, data)
+		{
+		}
+		constexpr U(large_t set_large) noexcept:
+			large(set_large)
+		{
+		}
+
+		small_t small;
+		large_t large;
+	} u_;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return size_or_first_byte_of_capacity_ & 1;
+	}
+
+	constexpr void increment_size() {
+		if (is_large()) {
+			++u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ += (1 << 1);
+		}
+	}
+	constexpr void decrement_size() {
+		if (is_large()) {
+			--u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ -= (1 << 1);
+		}
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, u_.large.data, capacity());
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(size(), new_capacity, new_data);
+		assert(new_capacity & 1);
+		size_or_first_byte_of_capacity_ = new_capacity;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		new_capacity |= 1;
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy(begin(), end(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		size_or_first_byte_of_capacity_(0),
+		u_{}
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.large);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+
+			other.u_ = U{};
+			other.size_or_first_byte_of_capacity_ = 0;
+		} else {
+			auto & osmall = other.u_.small;
+			u_ = U{};
+			copy(osmall.data, osmall.data + (other.size_or_first_byte_of_capacity_ >> 1), u_.small.data);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr char * data() {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr std::size_t size() const {
+		return is_large() ? u_.large.size : (size_or_first_byte_of_capacity_ >> 1);
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		if (!is_large()) {
+			return small_buffer_capacity;
+		}
+		std::size_t result = 0;
+		for (unsigned char const byte : u_.large.little_endian_capacity()) {
+			result |= byte;
+			result <<= CHAR_BIT;
+		}
+		result |= size_or_first_byte_of_capacity_;
+		return result;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		auto const local_size = size();
+		if (is_large() && capacity() > (local_size | 1)) {
+			if (local_size > small_buffer_capacity) {
+				force_reserve(local_size);
+			} else {
+				auto const data = u_.large.data;
+				auto const original_capacity = capacity();
+				u_ = U{};
+				size_or_first_byte_of_capacity_ = local_size << 1;
+				copy(data, data + local_size, u_.small.data);
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = std::prev(end());
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = (capacity() * growth_factor) | 1;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+
+			relocate(temp, new_capacity);
+		}
+		increment_size();
+		return begin() + offset;
+	}
+
+	constexpr void pop_back() {
+		decrement_size();
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+		// Keeps the bytes of the small buffer past the size 0, which the
+		// comparisons rely on
+		*end() = '\0';
+	}
+
+	friend constexpr bool operator==(string const & lhs, string const & rhs) {
+		if (!std::is_constant_evaluated() and !lhs.is_large() and !rhs.is_large()) {
+			return lhs.size_or_first_byte_of_capacity_ == rhs.size_or_first_byte_of_capacity_ and small_buffer_equal<small_buffer_capacity>(lhs.u_.small.data, rhs.u_.small.data);
+		}
+		return lhs.size() == rhs.size() and std::char_traits<char>::compare(lhs.data(), rhs.data(), lhs.size()) == 0;
+	}
+	friend constexpr std::strong_ordering operator<=>(string const & lhs, string const & rhs) {
+		if (!std::is_constant_evaluated() and !lhs.is_large() and !rhs.is_large()) {
+			return small_buffer_compare<small_buffer_capacity>(lhs.u_.small.data, lhs.size(), rhs.u_.small.data, rhs.size());
+		}
+		return compare(lhs.data(), lhs.size(), rhs.data(), rhs.size());
+	}
+};
+
+} // namespace clang
+
+namespace gcc {
+
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = allocator<char>;
+
+private:
+	[[no_unique_address]] allocator_type allocator_;
+	// This could be set to 8 to reduce the size of our string to 24 bytes
+	// (just like clang), but 7 characters (plus a null terminator) is likely
+	// too small of a buffer for most users.
+	static constexpr std::size_t small_buffer_capacity = 16;
+	union U{
+		constexpr U():
+			buffer{}
+		{
+		}
+		constexpr U(std::size_t c):
+			capacity(c)
+		{
+		}
+
+		char buffer[small_buffer_capacity];
+		std::size_t capacity;
+	} u_;
+	char * data_;
+	std::size_t size_ : 63;
+	// gcc and MSVC do not allow accessing the inactive member of a union just
+	// to get its address, so we use a bitfield to work around this.
+	bool is_large_ : 1;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return is_large_;
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, data_, u_.capacity);
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(new_capacity);
+		data_ = new_data;
+		is_large_ = true;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy(begin(), end(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_{},
+		data_(u_.buffer),
+		size_(0),
+		is_large_(false)
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.capacity);
+			other.u_ = U{};
+		
+			data_ = other.data_;
+			other.data_ = other.u_.buffer;
+		
+			size_ = other.size_;
+			other.size_ = 0U;
+		
+			is_large_ = true;
+			other.is_large_ = false;
+
+		} else {
+			u_ = U{};
+			copy(other.data_, other.data_ + other.size_, u_.buffer);
+			data_ = u_.buffer;
+			size_ = other.size_;
+			is_large_ = false;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return data_;
+	}
+	constexpr char * data() {
+		return data_;
+	}
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		return is_large() ? u_.capacity : small_buffer_capacity;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		if (is_large() && capacity() > size()) {
+			if (size() > small_buffer_capacity) {
+				force_reserve(size());
+			} else {
+				auto const data = data_;
+				auto const original_capacity = u_.capacity;
+				u_ = U{};
+				copy(data, data + size_, u_.buffer);
+				data_ = u_.buffer;
+				is_large_ = false;
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = end() - 1;
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = capacity() * growth_factor;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+		
+			relocate(temp, new_capacity);
+		}
+		++size_;
+		return begin() + offset;
+	}
+
+	constexpr void pop_back() {
+		--size_;
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+		// Keeps the bytes of the small buffer past the size 0, which the
+		// comparisons rely on
+		*end() = '\0';
+	}
+
+	friend constexpr bool operator==(string const & lhs, string const & rhs) {
+		if (!std::is_constant_evaluated() and !lhs.is_large() and !rhs.is_large()) {
+			return lhs.size_ == rhs.size_ and small_buffer_equal<small_buffer_capacity>(lhs.u_.buffer, rhs.u_.buffer);
+		}
+		return lhs.size() == rhs.size() and std::char_traits<char>::compare(lhs.data(), rhs.data(), lhs.size()) == 0;
+	}
+	friend constexpr std::strong_ordering operator<=>(string const & lhs, string const & rhs) {
+		if (!std::is_constant_evaluated() and !lhs.is_large() and !rhs.is_large()) {
+			return small_buffer_compare<small_buffer_capacity>(lhs.u_.buffer, lhs.size_, rhs.u_.buffer, rhs.size_);
+		}
+		return compare(lhs.data(), lhs.size(), rhs.data(), rhs.size());
+	}
+};
+
+} // namespace gcc
+
+template<typename String>
+constexpr String make_string(allocator<char> alloc, std::string_view const source) {
+	auto result = String(alloc);
+	for (char const c : source) {
+		result.insert(result.end(), c);
+	}
+	return result;
+}
+
+constexpr void test_individual(auto & str, char const * source) {
+	using String = std::remove_reference_t<decltype(str)>;
+	String temp(str.get_allocator());
+	for (auto it = source; *it != '\0'; ++it) {
+		str.insert(str.end(), *it);
+		temp.insert(temp.end(), *it);
+	}
+
+	temp.insert(temp.begin(), 'a');
+	temp.insert(temp.begin() + temp.size() / 2, 'b');
+	auto const size = std::char_traits<char>::length(source);
+	auto const middle = (size + 1) / 2;
+	assert(temp.size() == size + 2);
+	for (std::size_t n = 0; n != temp.size(); ++n) {
+		auto const expected = n == 0 ? 'a' : n == middle ? 'b' : n < middle ? source[n - 1] : source[n - 2];
+		assert(temp.data()[n] == expected);
+	}
+
+	// Inserting at the front, including each time that reallocates
+	String front(str.get_allocator());
+	for (std::size_t n = 0; n != 100; ++n) {
+		front.insert(front.begin(), static_cast<char>('0' + n % 10));
+	}
+	for (std::size_t n = 0; n != front.size(); ++n) {
+		assert(front.data()[n] == static_cast<char>('0' + (99 - n) % 10));
+	}
+
+	while (temp.size() != 0) {
+		temp.pop_back();
+	}
+	assert(temp.size() == 0);
+
+	auto temp2 = std::move(str);
+	str = std::move(temp2);
+
+	assert(str.data() != temp.data());
+	assert(str.size() == std::char_traits<char>::length(source));
+	assert(std::char_traits<char>::compare(str.data(), source, str.size()) == 0);
+	assert(str.capacity() >= str.size());
+
+	str.reserve(50);
+	str.shrink_to_fit();
+}
+
+template<typename String>
+constexpr void test_comparison(allocator<char> alloc) {
+	auto const empty = String(alloc);
+	auto const a = make_string<String>(alloc, "a");
+	auto const ab = make_string<String>(alloc, "ab");
+	auto const b = make_string<String>(alloc, "b");
+	auto const long_a = make_string<String>(alloc, "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa");
+	auto const long_b = make_string<String>(alloc, "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab");
+
+	assert(empty == empty);
+	assert(a == a);
+	assert(a != ab);
+	assert(long_a == long_a);
+	assert(long_a != long_b);
+
+	assert(empty < a);
+	assert(a < ab);
+	assert(ab < b);
+	assert(a < long_a);
+	assert(long_a < long_b);
+	assert(long_b < b);
+	assert((long_b <=> long_b) == std::strong_ordering::equal);
+
+	auto popped = make_string<String>(alloc, "ab");
+	popped.pop_back();
+	assert(popped == a);
+	assert((popped <=> a) == std::strong_ordering::equal);
+}
+
+template<typename String>
+constexpr void test_layout() {
+	buffer<char> buff{};
+	auto alloc = allocator(buff);
+
+	char const * short_source = "0123";
+	char const * long_source =
+		"0123456789"
+		"0123456789"
+		"0123456789"
+		"0123456789"
+		"0123456789";
+
+	String short_str(alloc);
+	test_individual(short_str, short_source);
+
+	String long_str(alloc);
+	test_individual(long_str, long_source);
+
+	String temp(alloc);
+	temp = std::move(long_str);
+	temp = std::move(short_str);
+
+	test_comparison<String>(alloc);
+}
+
+constexpr bool test() {
+	test_layout<clang::string>();
+	test_layout<gcc::string>();
+	return true;
+}
+
+// Compares against std::string_view for pairs of strings that share long
+// prefixes, contain null and non-ASCII characters, and reach their size in
+// different ways: directly, by popping characters from a longer string, and
+// by shrinking a large string back into the small buffer.
+template<typename String>
+void test_against_string_view() {
+	auto engine = std::minstd_rand(1);
+	auto random_string = [&] {
+		auto const size = std::uniform_int_distribution<std::size_t>(0, 40)(engine);
+		auto result = std::string(size, ' ');
+		for (char & c : result) {
+			constexpr char alphabet[] = {'\0', 'a', 'b', '\xff'};
+			c = alphabet[std::uniform_int_distribution(0, 3)(engine)];
+		}
+		return result;
+	};
+	auto build = [&](allocator<char> alloc, std::string const & source) {
+		switch (std::uniform_int_distribution(0, 2)(engine)) {
+			case 0:
+				return make_string<String>(alloc, source);
+			case 1: {
+				auto result = make_string<String>(alloc, source + "abcdefghijklmnopqrstuvwxyz");
+				for (std::size_t n = 0; n != 26; ++n) {
+					result.pop_back();
+				}
+				return result;
+			}
+			default: {
+				auto result = make_string<String>(alloc, source);
+				result.reserve(100);
+				result.shrink_to_fit();
+				return result;
+			}
+		}
+	};
+	for (std::size_t n = 0; n != 20'000; ++n) {
+		auto buff = std::make_unique<buffer<char>>();
+		auto alloc = allocator(*buff);
+		auto const lhs_source = random_string();
+		auto const rhs_source = engine() % 4 == 0 ? lhs_source : random_string();
+		auto const lhs = build(alloc, lhs_source);
+		auto const rhs = build(alloc, rhs_source);
+		assert((lhs == rhs) == (lhs_source == rhs_source));
+		assert((lhs <=> rhs) == (std::string_view(lhs_source) <=> std::string_view(rhs_source)));
+	}
+}
+
+int main() {
+	test();
+	static_assert(test());
+	test_against_string_view<clang::string>();
+	test_against_string_view<gcc::string>();
+}
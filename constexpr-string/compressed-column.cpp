@@ -0,0 +1,1530 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is to keep a large
+// number of strings with a lot of repetition, such as URLs and log lines, in
+// a fraction of the memory, and still read any one of them quickly.
+//
+// This is FSST ("Fast Static Symbol Table"). A table of up to 255 common
+// substrings of 1 to 8 characters is trained on a sample of the strings, and
+// each string is stored as one byte codes for those substrings. Unlike a
+// general purpose compressor, every string is compressed on its own, so any
+// one of them can be decompressed without the ones around it, and one byte
+// of code turns into up to 8 characters with one copy.
+//
+// compressed_column keeps the codes in the string_column from
+// string-column.cpp. Decompressing works out the size first and writes the
+// characters straight into the string it is given, which for a short string
+// is the small buffer. Compressing a given string always gives the same
+// codes, so finding the strings equal to a value compresses the value once
+// and compares codes, without decompressing anything.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <random>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+// char is trivial, so outside of constant evaluation the characters can be
+// copied with memcpy instead of being constructed one at a time
+template<typename Allocator>
+constexpr char * copy_characters(Allocator alloc, char const * const first, char const * const last, char * const out) {
+	if (std::is_constant_evaluated()) {
+		return uninitialized_copy(alloc, first, last, out);
+	}
+	auto const count = static_cast<std::size_t>(last - first);
+	if (count != 0) {
+		std::memcpy(out, first, count);
+	}
+	return out + count;
+}
+
+
+namespace clang {
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	static constexpr std::size_t small_buffer_capacity = 23;
+
+	struct small_t {
+		char data[small_buffer_capacity] = {};
+	};
+	struct [[gnu::packed]] large_t {
+		static constexpr std::size_t bytes_remaining = 7;
+
+		template<typename It>
+		class range_view {
+		public:
+			constexpr range_view(It first, It last):
+				first_(first),
+				last_(last)
+			{
+			}
+			constexpr auto begin() const {
+				return first_;
+			}
+			constexpr auto end() const {
+				return last_;
+			}
+		private:
+			It first_;
+			It last_;
+		};
+
+		constexpr auto little_endian_capacity() const {
+			return range_view(
+				std::rbegin(rest_of_capacity),
+				std::rend(rest_of_capacity)
+			);
+		}
+		constexpr auto big_endian_capacity() {
+			return range_view(
+				std::begin(rest_of_capacity),
+				std::end(rest_of_capacity)
+			);
+		}
+
+		constexpr large_t(std::size_t set_size, std::size_t capacity, char * pointer) noexcept:
+			rest_of_capacity{},
+			size(set_size),
+			data(pointer)
+		{
+			assert(data != nullptr);
+			for (unsigned char & byte : big_endian_capacity()) {
+				capacity >>= CHAR_BIT;
+				byte = capacity;
+			}
+		}
+
+		unsigned char rest_of_capacity[bytes_remaining];
+		std::size_t size;
+		char * data;
+	};
+
+	[[no_unique_address]] allocator_type allocator_;
+	unsigned char size_or_first_byte_of_capacity_;
+	union U {
+		constexpr U() noexcept:
+			small{}
+		{
+		}
+		explicit constexpr U(std::size_t size, std::size_t capacity, char * data) noexcept:
+			large(size, capacity, data)
+		{
+		}
+		constexpr U(large_t set_large) noexcept:
+			large(set_large)
+		{
+		}
+
+		small_t small;
+		large_t large;
+	} u_;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return size_or_first_byte_of_capacity_ & 1;
+	}
+
+	constexpr void increment_size() {
+		if (is_large()) {
+			++u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ += (1 << 1);
+		}
+	}
+	constexpr void set_size(std::size_t const new_size) {
+		if (is_large()) {
+			u_.large.size = new_size;
+		} else {
+			size_or_first_byte_of_capacity_ = static_cast<unsigned char>(new_size << 1);
+		}
+	}
+	constexpr void decrement_size() {
+		if (is_large()) {
+			--u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ -= (1 << 1);
+		}
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, u_.large.data, capacity());
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(size(), new_capacity, new_data);
+		assert(new_capacity & 1);
+		size_or_first_byte_of_capacity_ = new_capacity;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		new_capacity |= 1;
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy_characters(alloc, data(), data() + size(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		size_or_first_byte_of_capacity_(0),
+		u_{}
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.large);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+
+			other.u_ = U{};
+			other.size_or_first_byte_of_capacity_ = 0;
+		} else {
+			auto & osmall = other.u_.small;
+			u_ = U{};
+			copy(osmall.data, osmall.data + (other.size_or_first_byte_of_capacity_ >> 1), u_.small.data);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr char * data() {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr std::size_t size() const {
+		return is_large() ? u_.large.size : (size_or_first_byte_of_capacity_ >> 1);
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		if (!is_large()) {
+			return small_buffer_capacity;
+		}
+		// The bytes after the first are the rest of the capacity in
+		// little-endian order, so on a little-endian target this is one load
+		// instead of a loop. append_and_overwrite checks the capacity for
+		// every number.
+		if (!std::is_constant_evaluated() and std::endian::native == std::endian::little) {
+			auto rest = std::size_t(0);
+			std::memcpy(&rest, u_.large.rest_of_capacity, large_t::bytes_remaining);
+			return (rest << CHAR_BIT) | size_or_first_byte_of_capacity_;
+		}
+		std::size_t result = 0;
+		for (unsigned char const byte : u_.large.little_endian_capacity()) {
+			result |= byte;
+			result <<= CHAR_BIT;
+		}
+		result |= size_or_first_byte_of_capacity_;
+		return result;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		auto const local_size = size();
+		if (is_large() && capacity() > (local_size | 1)) {
+			if (local_size > small_buffer_capacity) {
+				force_reserve(local_size);
+			} else {
+				auto const data = u_.large.data;
+				auto const original_capacity = capacity();
+				u_ = U{};
+				size_or_first_byte_of_capacity_ = local_size << 1;
+				copy(data, data + local_size, u_.small.data);
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = std::prev(end());
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = (capacity() * growth_factor) | 1;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+
+			relocate(temp, new_capacity);
+		}
+		increment_size();
+		return begin() + offset;
+	}
+
+	// Range append, which the proposal leaves out for brevity. A reallocation
+	// at least doubles the capacity, like insert, and copies the old
+	// characters and the new ones straight into place. That also makes it
+	// safe to append part of the string to itself.
+	constexpr void append(char const * const first, char const * const last) {
+		auto const new_size = size() + static_cast<std::size_t>(last - first);
+		auto alloc = get_allocator();
+		if (new_size <= capacity()) {
+			copy_characters(alloc, first, last, end());
+		} else {
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = std::max(new_size, capacity() * growth_factor) | 1;
+			char * temp = Alloc::allocate(alloc, new_capacity);
+			copy_characters(alloc, first, last, copy_characters(alloc, data(), data() + size(), temp));
+			relocate(temp, new_capacity);
+		}
+		set_size(new_size);
+	}
+
+	// Makes room for up to max_count more characters, then operation writes
+	// characters starting at the end and returns where it stopped. This is
+	// like resize_and_overwrite, except that it keeps what is already there.
+	template<typename Operation>
+	constexpr void append_and_overwrite(std::size_t const max_count, Operation operation) {
+		auto const required = size() + max_count;
+		if (required > capacity()) {
+			constexpr auto growth_factor = std::size_t{2};
+			force_reserve(std::max(required, capacity() * growth_factor));
+		}
+		char * const last = operation(end());
+		set_size(static_cast<std::size_t>(last - begin()));
+	}
+
+	constexpr void pop_back() {
+		decrement_size();
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace clang
+
+namespace gcc {
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	[[no_unique_address]] allocator_type allocator_;
+	// This could be set to 8 to reduce the size of our string to 24 bytes
+	// (just like clang), but 7 characters (plus a null terminator) is likely
+	// too small of a buffer for most users.
+	static constexpr std::size_t small_buffer_capacity = 16;
+	union U{
+		constexpr U():
+			buffer{}
+		{
+		}
+		constexpr U(std::size_t c):
+			capacity(c)
+		{
+		}
+
+		char buffer[small_buffer_capacity];
+		std::size_t capacity;
+	} u_;
+	char * data_;
+	std::size_t size_ : 63;
+	// gcc and MSVC do not allow accessing the inactive member of a union just
+	// to get its address, so we use a bitfield to work around this.
+	bool is_large_ : 1;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return is_large_;
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, data_, u_.capacity);
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(new_capacity);
+		data_ = new_data;
+		is_large_ = true;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy_characters(alloc, data(), data() + size(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_{},
+		data_(u_.buffer),
+		size_(0),
+		is_large_(false)
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.capacity);
+			other.u_ = U{};
+		
+			data_ = other.data_;
+			other.data_ = other.u_.buffer;
+		
+			size_ = other.size_;
+			other.size_ = 0U;
+		
+			is_large_ = true;
+			other.is_large_ = false;
+
+		} else {
+			u_ = U{};
+			copy(other.data_, other.data_ + other.size_, u_.buffer);
+			data_ = u_.buffer;
+			size_ = other.size_;
+			is_large_ = false;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return data_;
+	}
+	constexpr char * data() {
+		return data_;
+	}
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		return is_large() ? u_.capacity : small_buffer_capacity;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		if (is_large() && capacity() > size()) {
+			if (size() > small_buffer_capacity) {
+				force_reserve(size());
+			} else {
+				auto const data = data_;
+				auto const original_capacity = u_.capacity;
+				u_ = U{};
+				copy(data, data + size_, u_.buffer);
+				data_ = u_.buffer;
+				is_large_ = false;
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = end() - 1;
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = capacity() * growth_factor;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+		
+			relocate(temp, new_capacity);
+		}
+		++size_;
+		return begin() + offset;
+	}
+
+	// Range append, which the proposal leaves out for brevity. A reallocation
+	// at least doubles the capacity, like insert, and copies the old
+	// characters and the new ones straight into place. That also makes it
+	// safe to append part of the string to itself.
+	constexpr void append(char const * const first, char const * const last) {
+		auto const new_size = size() + static_cast<std::size_t>(last - first);
+		auto alloc = get_allocator();
+		if (new_size <= capacity()) {
+			copy_characters(alloc, first, last, end());
+		} else {
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = std::max(new_size, capacity() * growth_factor);
+			char * temp = Alloc::allocate(alloc, new_capacity);
+			copy_characters(alloc, first, last, copy_characters(alloc, data(), data() + size(), temp));
+			relocate(temp, new_capacity);
+		}
+		size_ = new_size;
+	}
+
+	// Makes room for up to max_count more characters, then operation writes
+	// characters starting at the end and returns where it stopped. This is
+	// like resize_and_overwrite, except that it keeps what is already there.
+	template<typename Operation>
+	constexpr void append_and_overwrite(std::size_t const max_count, Operation operation) {
+		auto const required = size() + max_count;
+		if (required > capacity()) {
+			constexpr auto growth_factor = std::size_t{2};
+			force_reserve(std::max(required, capacity() * growth_factor));
+		}
+		char * const last = operation(end());
+		size_ = static_cast<std::size_t>(last - begin());
+	}
+
+	constexpr void pop_back() {
+		--size_;
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace gcc
+
+// Anything with a data() and a size() of characters, such as string,
+// std::string, and std::string_view
+template<typename T>
+concept string_like = requires(T const & value) {
+	{ value.data() } -> std::convertible_to<char const *>;
+	{ value.size() } -> std::convertible_to<std::size_t>;
+};
+
+constexpr std::string_view as_view(string_like auto const & value) {
+	return std::string_view(value.data(), value.size());
+}
+
+// Many strings stored as their characters back to back in one array, and an
+// array of where each one starts, the same as an Arrow string column.
+// Offset is std::uint32_t for up to 4 GiB of characters, which makes the cost
+// of each string 4 bytes on top of its characters, or std::uint64_t for more.
+// Element n is the characters from offsets_[n] to offsets_[n + 1], so there
+// is one more offset than there are strings, and the first is 0.
+//
+// Adding strings can move the characters, which leaves any std::string_view
+// from before that pointing at the old ones.
+template<std::unsigned_integral Offset = std::uint32_t>
+class string_column {
+public:
+	class iterator {
+	public:
+		using value_type = std::string_view;
+		using difference_type = std::ptrdiff_t;
+
+		constexpr iterator() = default;
+		constexpr iterator(char const * const characters, Offset const * const offset):
+			characters_(characters),
+			offset_(offset)
+		{
+		}
+
+		constexpr std::string_view operator*() const {
+			return std::string_view(characters_ + offset_[0], static_cast<std::size_t>(offset_[1] - offset_[0]));
+		}
+		constexpr std::string_view operator[](difference_type const index) const {
+			return *(*this + index);
+		}
+
+		constexpr iterator & operator++() {
+			++offset_;
+			return *this;
+		}
+		constexpr iterator operator++(int) {
+			auto const result = *this;
+			++*this;
+			return result;
+		}
+		constexpr iterator & operator--() {
+			--offset_;
+			return *this;
+		}
+		constexpr iterator operator--(int) {
+			auto const result = *this;
+			--*this;
+			return result;
+		}
+		constexpr iterator & operator+=(difference_type const offset) {
+			offset_ += offset;
+			return *this;
+		}
+		constexpr iterator & operator-=(difference_type const offset) {
+			offset_ -= offset;
+			return *this;
+		}
+		friend constexpr iterator operator+(iterator it, difference_type const offset) {
+			return it += offset;
+		}
+		friend constexpr iterator operator+(difference_type const offset, iterator it) {
+			return it += offset;
+		}
+		friend constexpr iterator operator-(iterator it, difference_type const offset) {
+			return it -= offset;
+		}
+		friend constexpr difference_type operator-(iterator const lhs, iterator const rhs) {
+			return lhs.offset_ - rhs.offset_;
+		}
+
+		friend constexpr bool operator==(iterator const lhs, iterator const rhs) {
+			return lhs.offset_ == rhs.offset_;
+		}
+		friend constexpr auto operator<=>(iterator const lhs, iterator const rhs) {
+			return lhs.offset_ <=> rhs.offset_;
+		}
+
+	private:
+		char const * characters_ = nullptr;
+		Offset const * offset_ = nullptr;
+	};
+	using const_iterator = iterator;
+
+	constexpr string_column():
+		offsets_(1, Offset(0))
+	{
+	}
+
+	constexpr std::size_t size() const {
+		return offsets_.size() - 1;
+	}
+	constexpr bool empty() const {
+		return size() == 0;
+	}
+	// All of the characters, with no separators between strings
+	constexpr std::string_view characters() const {
+		return std::string_view(characters_.data(), characters_.size());
+	}
+
+	constexpr std::string_view operator[](std::size_t const index) const {
+		assert(index < size());
+		auto const first = static_cast<std::size_t>(offsets_[index]);
+		auto const last = static_cast<std::size_t>(offsets_[index + 1]);
+		return std::string_view(characters_.data() + first, last - first);
+	}
+
+	constexpr iterator begin() const {
+		return iterator(characters_.data(), offsets_.data());
+	}
+	constexpr iterator end() const {
+		return iterator(characters_.data(), offsets_.data() + size());
+	}
+
+	constexpr void reserve(std::size_t const string_count, std::size_t const character_count) {
+		offsets_.reserve(string_count + 1);
+		characters_.reserve(character_count);
+	}
+
+	// If this throws, the column is unchanged. value can be an element of
+	// this column, which is copied before the characters can move.
+	constexpr void push_back(string_like auto const & value) {
+		auto const view = as_view(value);
+		if (contains_characters(view)) {
+			auto const copy = std::vector<char>(view.begin(), view.end());
+			push_back(std::string_view(copy.data(), copy.size()));
+			return;
+		}
+		auto const offset = next_offset(view.size());
+		// Growing offsets_ is the only thing after changing characters_ that
+		// could throw, so it is done first.
+		if (offsets_.size() == offsets_.capacity()) {
+			offsets_.reserve(2 * offsets_.size());
+		}
+		characters_.insert(characters_.end(), view.begin(), view.end());
+		offsets_.push_back(offset);
+	}
+
+	// Adds every string in range. For a forward range this adds up the sizes
+	// first, so that each array grows at most once.
+	template<std::ranges::input_range Range> requires string_like<std::ranges::range_value_t<Range>>
+	constexpr void append_range(Range && range) {
+		if constexpr (std::ranges::forward_range<Range>) {
+			auto string_count = std::size_t(0);
+			auto character_count = std::size_t(0);
+			for (auto const & value : range) {
+				++string_count;
+				character_count += value.size();
+			}
+			reserve(size() + string_count, characters_.size() + character_count);
+		}
+		for (auto const & value : range) {
+			push_back(value);
+		}
+	}
+
+	// What the column holds in memory, not counting the capacity that it has
+	// not used
+	constexpr std::size_t bytes_used() const {
+		return characters_.size() + offsets_.size() * sizeof(Offset);
+	}
+
+private:
+	// Comparing pointers into different objects with < is unspecified, and not
+	// allowed in constant evaluation, where this compares the start of view
+	// with each character instead.
+	constexpr bool contains_characters(std::string_view const view) const {
+		if (view.empty()) {
+			return false;
+		}
+		auto const first = characters_.data();
+		auto const last = first + characters_.size();
+		if (std::is_constant_evaluated()) {
+			for (auto it = first; it != last; ++it) {
+				if (it == view.data()) {
+					return true;
+				}
+			}
+			return false;
+		}
+		return std::less<>()(view.data(), last) and std::less<>()(first, view.data() + view.size());
+	}
+
+	// Where the next string ends, if it has size characters. Like
+	// std::vector, this throws std::length_error if that does not fit.
+	constexpr Offset next_offset(std::size_t const size) const {
+		if (size > std::numeric_limits<Offset>::max() - characters_.size()) {
+			throw std::length_error("string_column: too many characters for the offset type");
+		}
+		return static_cast<Offset>(characters_.size() + size);
+	}
+
+	std::vector<char> characters_;
+	std::vector<Offset> offsets_;
+};
+
+static_assert(std::random_access_iterator<string_column<>::iterator>);
+static_assert(std::ranges::random_access_range<string_column<> const>);
+
+
+// Up to 8 characters starting at data, in the low bytes of the result in
+// memory order, with 0 for any past the end
+constexpr std::uint64_t load_word(char const * const data, std::size_t const size) {
+	constexpr auto word = sizeof(std::uint64_t);
+	auto result = std::uint64_t(0);
+	if (!std::is_constant_evaluated() and size >= word and std::endian::native == std::endian::little) {
+		std::memcpy(&result, data, word);
+		return result;
+	}
+	for (std::size_t n = 0; n != std::min(size, word); ++n) {
+		result |= std::uint64_t(static_cast<unsigned char>(data[n])) << (CHAR_BIT * n);
+	}
+	return result;
+}
+
+// The low size characters of a word from load_word
+constexpr std::uint64_t low_characters(std::uint64_t const word, std::size_t const size) {
+	return size == sizeof(std::uint64_t) ? word : word & ((std::uint64_t(1) << (CHAR_BIT * size)) - 1);
+}
+
+// A code and how many characters it stands for
+struct symbol_match {
+	std::uint8_t code;
+	std::uint8_t size;
+};
+
+// Up to 255 symbols of 1 to 8 characters, each of which is written as a
+// one byte code. Code 255 is an escape: the byte after it is a character
+// that is not in any symbol. This is the static symbol table of FSST.
+//
+// Compressing matches the longest symbol it can at each position, and does
+// not look back, so compressing the same string always gives the same codes.
+// Two strings are equal exactly when their codes are.
+//
+// To find that symbol quickly there are three tables:
+// * symbols of 3 or more characters, in a hash table on their first 3
+//   characters, with room for one symbol in each slot
+// * for every 2 characters, the symbol of those 2 characters, if there is
+//   one
+// * for every character, its symbol or the escape code
+// A symbol of 3 or more characters that lands in a slot that is already
+// taken is left out.
+class symbol_table {
+public:
+	static constexpr auto escape = std::uint8_t(255);
+	static constexpr auto max_symbols = std::size_t(255);
+	static constexpr auto max_symbol_size = sizeof(std::uint64_t);
+
+	// Every character is escaped
+	constexpr symbol_table():
+		short_codes_(std::size_t(1) << 16),
+		long_symbols_(long_symbol_slots)
+	{
+		for (auto & match : byte_codes_) {
+			match = symbol_match(escape, 1);
+		}
+	}
+
+	// Keeps the symbols in order until there are 255, skipping any that are
+	// the same as one it already has or that do not fit in the hash table
+	template<std::ranges::input_range Range> requires std::convertible_to<std::ranges::range_value_t<Range>, std::string_view>
+	constexpr explicit symbol_table(Range && symbols):
+		symbol_table()
+	{
+		for (std::string_view const value : symbols) {
+			if (size() == max_symbols) {
+				break;
+			}
+			assert(1 <= value.size() and value.size() <= max_symbol_size);
+			auto const word = load_word(value.data(), value.size());
+			auto const code = static_cast<std::uint8_t>(size());
+			switch (value.size()) {
+				case 1: {
+					auto & match = byte_codes_[word];
+					if (match.code != escape) {
+						continue;
+					}
+					match = symbol_match(code, 1);
+					break;
+				}
+				case 2: {
+					auto & match = short_codes_[word];
+					if (match.size == 2) {
+						continue;
+					}
+					match = symbol_match(code, 2);
+					break;
+				}
+				default: {
+					auto & slot = long_symbols_[long_slot(word)];
+					if (slot.size != 0) {
+						continue;
+					}
+					slot = long_symbol(word, code, static_cast<std::uint8_t>(value.size()));
+					break;
+				}
+			}
+			std::ranges::copy(value, characters_.begin() + static_cast<std::ptrdiff_t>(code * max_symbol_size));
+			sizes_[code] = static_cast<std::uint8_t>(value.size());
+			++size_;
+		}
+	}
+
+	constexpr std::size_t size() const {
+		return size_;
+	}
+	constexpr std::string_view symbol(std::uint8_t const code) const {
+		assert(code < size());
+		return std::string_view(characters_.data() + code * max_symbol_size, sizes_[code]);
+	}
+
+	// The longest symbol at the start of data, which has at least one
+	// character, or the escape code with a size of 1
+	constexpr symbol_match match(char const * const data, std::size_t const size) const {
+		assert(size != 0);
+		auto const word = load_word(data, size);
+		auto const & slot = long_symbols_[long_slot(word)];
+		if (slot.size != 0 and slot.size <= size and low_characters(word, slot.size) == slot.value) {
+			return symbol_match(slot.code, slot.size);
+		}
+		// With one character left, the second character of the word is the 0
+		// that load_word filled in, not part of the string
+		auto const pair = short_codes_[word & 0xFFFF];
+		return pair.size == 2 and size != 1 ? pair : byte_codes_[word & 0xFF];
+	}
+
+	// Writes the codes for value to out, which needs room for twice as many
+	// codes as value has characters, and returns the end of the codes
+	constexpr char * compress(std::string_view const value, char * out) const {
+		auto data = value.data();
+		auto remaining = value.size();
+		while (remaining != 0) {
+			auto const [code, size] = match(data, remaining);
+			*out = static_cast<char>(code);
+			++out;
+			if (code == escape) {
+				*out = *data;
+				++out;
+			}
+			data += size;
+			remaining -= size;
+		}
+		return out;
+	}
+	constexpr std::vector<char> compress(std::string_view const value) const {
+		auto result = std::vector<char>(2 * value.size());
+		result.resize(static_cast<std::size_t>(compress(value, result.data()) - result.data()));
+		return result;
+	}
+
+	constexpr std::size_t decompressed_size(std::string_view const codes) const {
+		auto result = std::size_t(0);
+		for (std::size_t n = 0; n != codes.size(); ++n) {
+			auto const code = static_cast<std::uint8_t>(codes[n]);
+			if (code == escape) {
+				++n;
+				++result;
+			} else {
+				result += sizes_[code];
+			}
+		}
+		return result;
+	}
+
+	// Writes the characters for codes to out and returns the end of them.
+	// The characters of every symbol are stored in 8 bytes, so while there
+	// is room before last, this copies all 8 and then moves forward by the
+	// size of the symbol. That is one store whatever the size.
+	constexpr char * decompress(std::string_view const codes, char * out, char const * const last) const {
+		for (std::size_t n = 0; n != codes.size(); ++n) {
+			auto const code = static_cast<std::uint8_t>(codes[n]);
+			if (code == escape) {
+				++n;
+				*out = codes[n];
+				++out;
+				continue;
+			}
+			auto const symbol_characters = characters_.data() + code * max_symbol_size;
+			if (!std::is_constant_evaluated() and last - out >= static_cast<std::ptrdiff_t>(max_symbol_size)) {
+				std::memcpy(out, symbol_characters, max_symbol_size);
+			} else {
+				std::copy_n(symbol_characters, sizes_[code], out);
+			}
+			out += sizes_[code];
+		}
+		return out;
+	}
+
+private:
+	struct long_symbol {
+		std::uint64_t value = 0;
+		std::uint8_t code = 0;
+		std::uint8_t size = 0;
+	};
+	static constexpr auto long_slot_bits = 12;
+	static constexpr auto long_symbol_slots = std::size_t(1) << long_slot_bits;
+	static constexpr std::size_t long_slot(std::uint64_t const word) {
+		return static_cast<std::size_t>((low_characters(word, 3) * 0x9E37'79B9'7F4A'7C15) >> (64 - long_slot_bits));
+	}
+
+	std::size_t size_ = 0;
+	std::array<char, 256 * max_symbol_size> characters_ = {};
+	std::array<std::uint8_t, 256> sizes_ = {};
+	std::array<symbol_match, 256> byte_codes_ = {};
+	std::vector<symbol_match> short_codes_;
+	std::vector<long_symbol> long_symbols_;
+};
+
+// Builds a symbol table for strings like the ones in range, following the
+// FSST paper. Starting from no symbols, each round compresses a sample with
+// the table so far and counts how often each symbol or escaped character
+// comes up, and how often each one comes right after another. A symbol, or
+// two of them next to each other joined into one, is worth how many
+// characters it would cover. The next table is the 255 that are worth the
+// most. Like the paper, this stops after 5 rounds.
+template<std::ranges::forward_range Range> requires string_like<std::ranges::range_value_t<Range>>
+symbol_table train_symbol_table(Range && range, std::size_t const sample_size = 1 << 16) {
+	auto total_size = std::size_t(0);
+	for (auto const & value : range) {
+		total_size += as_view(value).size();
+	}
+	// Every step-th string, spread over the whole range
+	auto sample = std::vector<std::string_view>();
+	auto const step = std::max(total_size / sample_size, std::size_t(1));
+	auto index = std::size_t(0);
+	for (auto const & value : range) {
+		if (index % step == 0) {
+			sample.push_back(as_view(value));
+		}
+		++index;
+	}
+
+	// 0 to 254 are symbols, 256 to 511 are escaped characters
+	constexpr auto unit_count = std::size_t(512);
+	// Every character, so that there is something for the std::string_view
+	// of an escaped character to point to
+	static constexpr auto all_characters = [] {
+		auto result = std::array<char, 256>();
+		for (std::size_t n = 0; n != result.size(); ++n) {
+			result[n] = static_cast<char>(n);
+		}
+		return result;
+	}();
+	struct candidate {
+		std::array<char, symbol_table::max_symbol_size> characters;
+		std::size_t size;
+		std::size_t gain;
+	};
+	auto table = symbol_table();
+	constexpr auto rounds = 5;
+	for (int round = 0; round != rounds; ++round) {
+		auto counts = std::vector<std::size_t>(unit_count);
+		auto pair_counts = std::vector<std::size_t>(unit_count * unit_count);
+		for (auto const value : sample) {
+			auto previous = unit_count;
+			for (std::size_t position = 0; position != value.size();) {
+				auto const [code, size] = table.match(value.data() + position, value.size() - position);
+				auto const unit = code == symbol_table::escape ? 256 + static_cast<unsigned char>(value[position]) : std::size_t(code);
+				++counts[unit];
+				if (previous != unit_count) {
+					++pair_counts[previous * unit_count + unit];
+				}
+				previous = unit;
+				position += size;
+			}
+		}
+
+		auto const characters = [&](std::size_t const unit) {
+			return unit < 256 ?
+				table.symbol(static_cast<std::uint8_t>(unit)) :
+				std::string_view(all_characters.data() + (unit - 256), 1);
+		};
+		auto candidates = std::vector<candidate>();
+		auto const add = [&](std::string_view const first, std::string_view const second, std::size_t const count) {
+			auto result = candidate{{}, first.size() + second.size(), count * (first.size() + second.size())};
+			std::ranges::copy(second, std::ranges::copy(first, result.characters.begin()).out);
+			candidates.push_back(result);
+		};
+		for (std::size_t unit = 0; unit != unit_count; ++unit) {
+			if (counts[unit] == 0) {
+				continue;
+			}
+			add(characters(unit), "", counts[unit]);
+			for (std::size_t next = 0; next != unit_count; ++next) {
+				auto const count = pair_counts[unit * unit_count + next];
+				if (count != 0 and characters(unit).size() + characters(next).size() <= symbol_table::max_symbol_size) {
+					add(characters(unit), characters(next), count);
+				}
+			}
+		}
+
+		// The same characters can come from more than one pair
+		auto const view = [](candidate const & value) {
+			return std::string_view(value.characters.data(), value.size);
+		};
+		std::ranges::sort(candidates, std::less(), view);
+		auto merged = std::vector<candidate>();
+		for (auto const & value : candidates) {
+			if (!merged.empty() and view(merged.back()) == view(value)) {
+				merged.back().gain += value.gain;
+			} else {
+				merged.push_back(value);
+			}
+		}
+		std::ranges::stable_sort(merged, std::greater(), &candidate::gain);
+		table = symbol_table(merged | std::views::transform(view));
+	}
+	return table;
+}
+
+// Strings compressed with a symbol_table, in a string_column of codes
+class compressed_column {
+public:
+	constexpr explicit compressed_column(symbol_table table):
+		table_(std::move(table))
+	{
+	}
+
+	constexpr symbol_table const & table() const {
+		return table_;
+	}
+	constexpr std::size_t size() const {
+		return codes_.size();
+	}
+	constexpr bool empty() const {
+		return codes_.empty();
+	}
+	constexpr std::string_view codes(std::size_t const index) const {
+		return codes_[index];
+	}
+
+	constexpr void push_back(string_like auto const & value) {
+		auto const view = as_view(value);
+		if (buffer_.size() < 2 * view.size()) {
+			buffer_.resize(2 * view.size());
+		}
+		auto const last = table_.compress(view, buffer_.data());
+		codes_.push_back(std::string_view(buffer_.data(), last));
+	}
+	template<std::ranges::input_range Range> requires string_like<std::ranges::range_value_t<Range>>
+	constexpr void append_range(Range && range) {
+		for (auto const & value : range) {
+			push_back(value);
+		}
+	}
+
+	// Appends element index to str. This works out the size first and makes
+	// room for it, so a string that fits in the small buffer of str is
+	// written straight into it, and a longer one into its allocation. If str
+	// has to allocate anyway, it asks for room for the 7 extra characters
+	// that copying a whole symbol can write past the end, so that every copy
+	// can be 8 bytes.
+	template<typename String>
+	constexpr void decompress(std::size_t const index, String & str) const {
+		auto const codes = codes_[index];
+		auto const size = table_.decompressed_size(codes);
+		auto const room = str.capacity() - str.size();
+		auto const max_count = size <= room ? size : size + symbol_table::max_symbol_size - 1;
+		str.append_and_overwrite(max_count, [&](char * const out) {
+			// Past the new size, up to the capacity, is also ours to write
+			auto const last = str.data() + str.capacity();
+			return table_.decompress(codes, out, last);
+		});
+	}
+	constexpr std::size_t decompressed_size(std::size_t const index) const {
+		return table_.decompressed_size(codes_[index]);
+	}
+
+	// These compare the codes and do not decompress anything. Pass the
+	// codes from table().compress to compare many elements to the same value.
+	constexpr bool equals(std::size_t const index, std::string_view const compressed_value) const {
+		return codes_[index] == compressed_value;
+	}
+	constexpr std::size_t count_equal(std::string_view const value) const {
+		auto const compressed_value = table_.compress(value);
+		return static_cast<std::size_t>(std::ranges::count(codes_, as_view(compressed_value)));
+	}
+	constexpr std::vector<std::size_t> find_all_equal(std::string_view const value) const {
+		auto const compressed_value = table_.compress(value);
+		auto result = std::vector<std::size_t>();
+		for (std::size_t index = 0; index != size(); ++index) {
+			if (equals(index, as_view(compressed_value))) {
+				result.push_back(index);
+			}
+		}
+		return result;
+	}
+
+	// The codes and their offsets, not counting the symbol table, which is
+	// the same size however many strings there are
+	constexpr std::size_t bytes_used() const {
+		return codes_.bytes_used();
+	}
+
+private:
+	symbol_table table_;
+	string_column<> codes_;
+	std::vector<char> buffer_;
+};
+
+
+template<typename String>
+constexpr bool round_trips(compressed_column const & column, std::vector<std::string_view> const & expected) {
+	if (column.size() != expected.size()) {
+		return false;
+	}
+	for (std::size_t index = 0; index != expected.size(); ++index) {
+		auto str = String(typename String::allocator_type());
+		column.decompress(index, str);
+		if (as_view(str) != expected[index] or column.decompressed_size(index) != expected[index].size()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+constexpr bool test() {
+	using allocator_type = std::allocator<char>;
+	auto const symbols = std::vector<std::string_view>{"https://", "www.", ".com", "/", "ex", "example", "a", "a", "tt", "ample"};
+	auto const table = symbol_table(symbols);
+	// The second "a" is the same as the first, so it is left out
+	assert(table.size() == 9);
+	assert(table.symbol(0) == "https://");
+	assert(table.symbol(5) == "example");
+
+	auto const codes = table.compress("https://www.example.com/");
+	assert(codes.size() == 5);
+	assert(static_cast<std::uint8_t>(codes[0]) == 0);
+	assert(static_cast<std::uint8_t>(codes[2]) == 5);
+
+	// Characters that are in no symbol are escaped
+	auto const escaped = table.compress("xaz");
+	assert(escaped.size() == 5);
+	assert(static_cast<std::uint8_t>(escaped[0]) == symbol_table::escape);
+	assert(escaped[1] == 'x');
+	assert(table.decompressed_size(as_view(escaped)) == 3);
+
+	auto column = compressed_column(table);
+	auto const values = std::vector<std::string_view>{
+		"https://www.example.com/",
+		"",
+		"x",
+		"https://www.example.com/a/long/path/that/does/not/fit/in/a/small/buffer",
+		"https://www.example.com/",
+		"\xff\x80",
+		"www.example.com/a",
+	};
+	column.append_range(values);
+	assert(round_trips<clang::string<allocator_type>>(column, values));
+	assert(round_trips<gcc::string<allocator_type>>(column, values));
+	assert(column.count_equal("https://www.example.com/") == 2);
+	assert(column.count_equal("https://www.example.com") == 0);
+	assert(column.count_equal("") == 1);
+	assert(column.find_all_equal("https://www.example.com/") == (std::vector<std::size_t>{0, 4}));
+	assert(column.equals(2, as_view(table.compress("x"))));
+
+	// Decompressing appends, and a short result goes in the small buffer
+	auto str = clang::string<allocator_type>(allocator_type());
+	str.append_and_overwrite(2, [](char * out) {
+		*out = '>';
+		++out;
+		*out = ' ';
+		++out;
+		return out;
+	});
+	column.decompress(0, str);
+	assert(as_view(str) == "> https://www.example.com/");
+
+	auto small = clang::string<allocator_type>(allocator_type());
+	column.decompress(6, small);
+	assert(small.capacity() == 23);
+	assert(as_view(small) == "www.example.com/a");
+	return true;
+}
+
+// Random strings with a lot of repetition, some of which are not in the sample
+void test_against_uncompressed() {
+	using allocator_type = std::allocator<char>;
+	auto engine = std::mt19937_64(1);
+	constexpr std::string_view words[] = {"GET ", "POST ", "/api/v1/", "users/", "orders/", "?id=", "&page=", " 200", " 404", "\n"};
+	for (int n = 0; n != 100; ++n) {
+		auto expected = std::vector<std::string>(engine() % 300);
+		for (auto & value : expected) {
+			for (auto count = engine() % 12; count != 0; --count) {
+				if (engine() % 4 == 0) {
+					value += static_cast<char>(engine());
+				} else {
+					value += words[engine() % std::size(words)];
+				}
+			}
+		}
+		auto const sample = std::span(expected).first(expected.size() / 2);
+		auto column = compressed_column(train_symbol_table(sample, engine() % 2000 + 1));
+		column.append_range(expected);
+		auto const views = std::vector<std::string_view>(expected.begin(), expected.end());
+		assert(round_trips<clang::string<allocator_type>>(column, views));
+		assert(round_trips<gcc::string<allocator_type>>(column, views));
+		for (std::size_t index = 0; index < expected.size(); index += 7) {
+			auto const & value = expected[index];
+			assert(column.count_equal(value) == static_cast<std::size_t>(std::ranges::count(expected, value)));
+		}
+	}
+}
+
+template<typename Function>
+double nanoseconds_per_operation(std::size_t const count, Function && function) {
+	auto const start = std::chrono::steady_clock::now();
+	function();
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+}
+
+// URLs from a few sites and paths, and lines of a service log
+std::vector<std::string> make_values(std::size_t const count) {
+	auto engine = std::mt19937_64(1);
+	constexpr std::string_view hosts[] = {"https://www.example.com", "https://cdn.example.net", "http://api.internal.example.org:8080"};
+	constexpr std::string_view paths[] = {"/assets/", "/api/v2/users/", "/api/v2/orders/", "/search?q=", "/static/js/", "/images/products/"};
+	constexpr std::string_view levels[] = {"INFO", "INFO", "INFO", "WARN", "ERROR"};
+	constexpr std::string_view messages[] = {"request served", "cache miss", "upstream timeout", "retrying", "connection reset by peer"};
+	auto result = std::vector<std::string>(count);
+	for (auto & value : result) {
+		if (engine() % 2 == 0) {
+			value += hosts[engine() % std::size(hosts)];
+			value += paths[engine() % std::size(paths)];
+			value += std::to_string(engine() % 100'000);
+		} else {
+			value += "2026-10-18T";
+			value += std::to_string(10 + engine() % 14);
+			value += ':';
+			value += std::to_string(10 + engine() % 50);
+			value += " host-";
+			value += std::to_string(engine() % 100);
+			value += ' ';
+			value += levels[engine() % std::size(levels)];
+			value += ' ';
+			value += messages[engine() % std::size(messages)];
+		}
+	}
+	return result;
+}
+
+void benchmark() {
+	using benchmark_string = clang::string<std::allocator<char>>;
+	constexpr auto count = std::size_t(2'000'000);
+	auto const values = make_values(count);
+	auto characters = std::size_t(0);
+	for (auto const & value : values) {
+		characters += value.size();
+	}
+
+	auto uncompressed = string_column<>();
+	uncompressed.append_range(values);
+
+	auto table = symbol_table();
+	auto const train_time = nanoseconds_per_operation(1, [&] {
+		table = train_symbol_table(values);
+	});
+	auto column = compressed_column(std::move(table));
+	auto const compress_time = nanoseconds_per_operation(count, [&] {
+		column.append_range(values);
+	});
+	std::printf("%zu values, %.1f characters each\n", count, static_cast<double>(characters) / static_cast<double>(count));
+	std::printf("trained %zu symbols in %.1f ms, compressed at %.1f ns per value\n", column.table().size(), train_time / 1e6, compress_time);
+	std::printf("bytes per value: uncompressed column %.1f, compressed column %.1f, %.2fx smaller\n",
+		static_cast<double>(uncompressed.bytes_used()) / static_cast<double>(count),
+		static_cast<double>(column.bytes_used()) / static_cast<double>(count),
+		static_cast<double>(uncompressed.bytes_used()) / static_cast<double>(column.bytes_used())
+	);
+
+	auto engine = std::mt19937_64(2);
+	auto indices = std::vector<std::uint32_t>(1'000'000);
+	for (auto & index : indices) {
+		index = static_cast<std::uint32_t>(engine() % count);
+	}
+	auto total = std::size_t(0);
+	auto const copy_time = nanoseconds_per_operation(indices.size(), [&] {
+		for (auto const index : indices) {
+			auto str = benchmark_string(std::allocator<char>());
+			auto const value = uncompressed[index];
+			str.append(value.data(), value.data() + value.size());
+			total += str.size();
+		}
+	});
+	auto const decompress_time = nanoseconds_per_operation(indices.size(), [&] {
+		for (auto const index : indices) {
+			auto str = benchmark_string(std::allocator<char>());
+			column.decompress(index, str);
+			total += str.size();
+		}
+	});
+	std::printf("%-44s %10s\n", "", "ns");
+	std::printf("%-44s %10.1f\n", "random element into a string, uncompressed", copy_time);
+	std::printf("%-44s %10.1f\n", "random element into a string, compressed", decompress_time);
+
+	auto const needle = values[12345];
+	auto matches = std::size_t(0);
+	auto const uncompressed_equal = nanoseconds_per_operation(count, [&] {
+		matches = static_cast<std::size_t>(std::ranges::count(uncompressed, std::string_view(needle)));
+	});
+	auto const compressed_equal = nanoseconds_per_operation(count, [&] {
+		assert(column.count_equal(needle) == matches);
+	});
+	auto const decompress_and_compare = nanoseconds_per_operation(count, [&] {
+		auto found = std::size_t(0);
+		auto str = benchmark_string(std::allocator<char>());
+		for (std::size_t index = 0; index != column.size(); ++index) {
+			str = benchmark_string(std::allocator<char>());
+			column.decompress(index, str);
+			found += as_view(str) == needle ? 1 : 0;
+		}
+		assert(found == matches);
+	});
+	std::printf("%-44s %10.1f\n", "count equal, uncompressed", uncompressed_equal);
+	std::printf("%-44s %10.1f\n", "count equal, on the codes", compressed_equal);
+	std::printf("%-44s %10.1f\n", "count equal, decompressing each", decompress_and_compare);
+	assert(total != 0 and matches != 0);
+}
+
+int main() {
+	test();
+	static_assert(test());
+	test_against_uncompressed();
+	benchmark();
+}
@@ -0,0 +1,967 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is to add operator+ and
+// operator+= to both layouts, so that concatenating several pieces allocates
+// once.
+//
+// Both are built on a range append, which is the only new member function.
+// Adding pieces when none of them is an rvalue string gives a concatenation,
+// which holds views of the pieces and allocates the whole result when it is
+// converted to a string. Adding to an rvalue string instead appends to it,
+// which reuses its capacity. operator+= is defined in terms of operator+, as
+// in generate-operators.md.
+//
+// Both strings are made generic over the allocator so that the benchmark can
+// use std::allocator and count its calls to operator new.
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <concepts>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+// char is trivial, so outside of constant evaluation the characters can be
+// copied with memcpy instead of being constructed one at a time
+template<typename Allocator>
+constexpr char * copy_characters(Allocator alloc, char const * const first, char const * const last, char * const out) {
+	if (std::is_constant_evaluated()) {
+		return uninitialized_copy(alloc, first, last, out);
+	}
+	auto const count = static_cast<std::size_t>(last - first);
+	if (count != 0) {
+		std::memcpy(out, first, count);
+	}
+	return out + count;
+}
+
+
+namespace clang {
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	static constexpr std::size_t small_buffer_capacity = 23;
+
+	struct small_t {
+		char data[small_buffer_capacity] = {};
+	};
+	struct [[gnu::packed]] large_t {
+		static constexpr std::size_t bytes_remaining = 7;
+
+		template<typename It>
+		class range_view {
+		public:
+			constexpr range_view(It first, It last):
+				first_(first),
+				last_(last)
+			{
+			}
+			constexpr auto begin() const {
+				return first_;
+			}
+			constexpr auto end() const {
+				return last_;
+			}
+		private:
+			It first_;
+			It last_;
+		};
+
+		constexpr auto little_endian_capacity() const {
+			return range_view(
+				std::rbegin(rest_of_capacity),
+				std::rend(rest_of_capacity)
+			);
+		}
+		constexpr auto big_endian_capacity() {
+			return range_view(
+				std::begin(rest_of_capacity),
+				std::end(rest_of_capacity)
+			);
+		}
+
+		constexpr large_t(std::size_t set_size, std::size_t capacity, char * pointer) noexcept:
+			rest_of_capacity{},
+			size(set_size),
+			data(pointer)
+		{
+			assert(data != nullptr);
+			for (unsigned char & byte : big_endian_capacity()) {
+				capacity >>= CHAR_BIT;
+				byte = capacity;
+			}
+		}
+
+		unsigned char rest_of_capacity[bytes_remaining];
+		std::size_t size;
+		char * data;
+	};
+
+	[[no_unique_address]] allocator_type allocator_;
+	unsigned char size_or_first_byte_of_capacity_;
+	union U {
+		constexpr U() noexcept:
+			small{}
+		{
+		}
+		explicit constexpr U(std::size_t size, std::size_t capacity, char * data) noexcept:
+			large(size, capacity, data)
+		{
+		}
+		constexpr U(large_t set_large) noexcept:
+			large(set_large)
+		{
+		}
+
+		small_t small;
+		large_t large;
+	} u_;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return size_or_first_byte_of_capacity_ & 1;
+	}
+
+	constexpr void increment_size() {
+		if (is_large()) {
+			++u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ += (1 << 1);
+		}
+	}
+	constexpr void set_size(std::size_t const new_size) {
+		if (is_large()) {
+			u_.large.size = new_size;
+		} else {
+			size_or_first_byte_of_capacity_ = static_cast<unsigned char>(new_size << 1);
+		}
+	}
+	constexpr void decrement_size() {
+		if (is_large()) {
+			--u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ -= (1 << 1);
+		}
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, u_.large.data, capacity());
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(size(), new_capacity, new_data);
+		assert(new_capacity & 1);
+		size_or_first_byte_of_capacity_ = new_capacity;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		new_capacity |= 1;
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy(begin(), end(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		size_or_first_byte_of_capacity_(0),
+		u_{}
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.large);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+
+			other.u_ = U{};
+			other.size_or_first_byte_of_capacity_ = 0;
+		} else {
+			auto & osmall = other.u_.small;
+			u_ = U{};
+			copy(osmall.data, osmall.data + (other.size_or_first_byte_of_capacity_ >> 1), u_.small.data);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr char * data() {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr std::size_t size() const {
+		return is_large() ? u_.large.size : (size_or_first_byte_of_capacity_ >> 1);
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		if (!is_large()) {
+			return small_buffer_capacity;
+		}
+		std::size_t result = 0;
+		for (unsigned char const byte : u_.large.little_endian_capacity()) {
+			result |= byte;
+			result <<= CHAR_BIT;
+		}
+		result |= size_or_first_byte_of_capacity_;
+		return result;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		auto const local_size = size();
+		if (is_large() && capacity() > (local_size | 1)) {
+			if (local_size > small_buffer_capacity) {
+				force_reserve(local_size);
+			} else {
+				auto const data = u_.large.data;
+				auto const original_capacity = capacity();
+				u_ = U{};
+				size_or_first_byte_of_capacity_ = local_size << 1;
+				copy(data, data + local_size, u_.small.data);
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = std::prev(end());
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = (capacity() * growth_factor) | 1;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+
+			relocate(temp, new_capacity);
+		}
+		increment_size();
+		return begin() + offset;
+	}
+
+	// Range append, which the proposal leaves out for brevity. A reallocation
+	// at least doubles the capacity, like insert, and copies the old
+	// characters and the new ones straight into place. That also makes it
+	// safe to append part of the string to itself.
+	constexpr void append(char const * const first, char const * const last) {
+		auto const new_size = size() + static_cast<std::size_t>(last - first);
+		auto alloc = get_allocator();
+		if (new_size <= capacity()) {
+			copy_characters(alloc, first, last, end());
+		} else {
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = std::max(new_size, capacity() * growth_factor) | 1;
+			char * temp = Alloc::allocate(alloc, new_capacity);
+			copy_characters(alloc, first, last, copy_characters(alloc, data(), data() + size(), temp));
+			relocate(temp, new_capacity);
+		}
+		set_size(new_size);
+	}
+
+	constexpr void pop_back() {
+		decrement_size();
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace clang
+
+namespace gcc {
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	[[no_unique_address]] allocator_type allocator_;
+	// This could be set to 8 to reduce the size of our string to 24 bytes
+	// (just like clang), but 7 characters (plus a null terminator) is likely
+	// too small of a buffer for most users.
+	static constexpr std::size_t small_buffer_capacity = 16;
+	union U{
+		constexpr U():
+			buffer{}
+		{
+		}
+		constexpr U(std::size_t c):
+			capacity(c)
+		{
+		}
+
+		char buffer[small_buffer_capacity];
+		std::size_t capacity;
+	} u_;
+	char * data_;
+	std::size_t size_ : 63;
+	// gcc and MSVC do not allow accessing the inactive member of a union just
+	// to get its address, so we use a bitfield to work around this.
+	bool is_large_ : 1;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return is_large_;
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, data_, u_.capacity);
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(new_capacity);
+		data_ = new_data;
+		is_large_ = true;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy(begin(), end(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_{},
+		data_(u_.buffer),
+		size_(0),
+		is_large_(false)
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.capacity);
+			other.u_ = U{};
+		
+			data_ = other.data_;
+			other.data_ = other.u_.buffer;
+		
+			size_ = other.size_;
+			other.size_ = 0U;
+		
+			is_large_ = true;
+			other.is_large_ = false;
+
+		} else {
+			u_ = U{};
+			copy(other.data_, other.data_ + other.size_, u_.buffer);
+			data_ = u_.buffer;
+			size_ = other.size_;
+			is_large_ = false;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return data_;
+	}
+	constexpr char * data() {
+		return data_;
+	}
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		return is_large() ? u_.capacity : small_buffer_capacity;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		if (is_large() && capacity() > size()) {
+			if (size() > small_buffer_capacity) {
+				force_reserve(size());
+			} else {
+				auto const data = data_;
+				auto const original_capacity = u_.capacity;
+				u_ = U{};
+				copy(data, data + size_, u_.buffer);
+				data_ = u_.buffer;
+				is_large_ = false;
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = end() - 1;
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = capacity() * growth_factor;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+		
+			relocate(temp, new_capacity);
+		}
+		++size_;
+		return begin() + offset;
+	}
+
+	// Range append, which the proposal leaves out for brevity. A reallocation
+	// at least doubles the capacity, like insert, and copies the old
+	// characters and the new ones straight into place. That also makes it
+	// safe to append part of the string to itself.
+	constexpr void append(char const * const first, char const * const last) {
+		auto const new_size = size() + static_cast<std::size_t>(last - first);
+		auto alloc = get_allocator();
+		if (new_size <= capacity()) {
+			copy_characters(alloc, first, last, end());
+		} else {
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = std::max(new_size, capacity() * growth_factor);
+			char * temp = Alloc::allocate(alloc, new_capacity);
+			copy_characters(alloc, first, last, copy_characters(alloc, data(), data() + size(), temp));
+			relocate(temp, new_capacity);
+		}
+		size_ = new_size;
+	}
+
+	constexpr void pop_back() {
+		--size_;
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace gcc
+
+
+template<typename T>
+constexpr bool is_prototype_string = false;
+template<typename Allocator>
+constexpr bool is_prototype_string<clang::string<Allocator>> = true;
+template<typename Allocator>
+constexpr bool is_prototype_string<gcc::string<Allocator>> = true;
+
+template<typename T>
+concept prototype_string = is_prototype_string<T>;
+
+// Anything that can be one of the operands of a concatenation: either
+// string, or anything that converts to std::string_view
+template<typename T>
+concept string_piece = prototype_string<T> or std::convertible_to<T const &, std::string_view>;
+
+template<string_piece T>
+constexpr std::string_view as_view(T const & value) {
+	if constexpr (prototype_string<T>) {
+		return std::string_view(value.data(), value.size());
+	} else {
+		return std::string_view(value);
+	}
+}
+
+// The result of adding pieces when none of them is a string that can be
+// reused. It only holds views of the pieces, so that a longer chain of
+// additions can add up the size of all of them and allocate once, when it is
+// converted to String. The pieces have to outlive it, so everything but the
+// conversion and adding another piece only works on an rvalue, the way it is
+// used within one full expression:
+//
+//     String const url = scheme + "://" + host + path + "?" + query;
+template<prototype_string String, std::size_t count>
+class concatenation {
+public:
+	using allocator_type = typename String::allocator_type;
+
+	constexpr concatenation(allocator_type alloc, std::array<std::string_view, count> const & pieces):
+		allocator_(alloc),
+		pieces_(pieces)
+	{
+	}
+
+	constexpr std::size_t size() const {
+		auto result = std::size_t(0);
+		for (auto const piece : pieces_) {
+			result += piece.size();
+		}
+		return result;
+	}
+
+	// Appends every piece to target with at most one reallocation. If target
+	// has to grow, or a piece is part of target, the result is built in new
+	// storage and only then moved into target, so that no piece is freed or
+	// overwritten before it is copied.
+	constexpr void append_to(String & target) const {
+		auto const new_size = target.size() + size();
+		if (new_size <= target.capacity() and !overlaps(target)) {
+			append_pieces(target);
+			return;
+		}
+		auto result = String(target.get_allocator());
+		result.reserve(new_size);
+		result.append(std::as_const(target).data(), std::as_const(target).data() + target.size());
+		append_pieces(result);
+		target = std::move(result);
+	}
+
+	constexpr operator String() && {
+		auto result = String(allocator_);
+		append_to(result);
+		return result;
+	}
+
+	template<string_piece Piece>
+	friend constexpr auto operator+(concatenation && lhs, Piece const & rhs) {
+		return concatenation<String, count + 1>(lhs.allocator_, append_piece(lhs.pieces_, as_view(rhs)));
+	}
+
+	friend constexpr String operator+(String && lhs, concatenation && rhs) {
+		rhs.append_to(lhs);
+		return std::move(lhs);
+	}
+
+private:
+	constexpr void append_pieces(String & target) const {
+		for (auto const piece : pieces_) {
+			target.append(piece.data(), piece.data() + piece.size());
+		}
+	}
+
+	// Comparing pointers into different objects with < is unspecified, and
+	// not allowed in constant evaluation, where this compares the start of
+	// each piece with each character of target instead.
+	constexpr bool overlaps(String const & target) const {
+		auto const first = target.data();
+		auto const last = first + target.size();
+		for (auto const piece : pieces_) {
+			if (piece.empty()) {
+				continue;
+			}
+			if (std::is_constant_evaluated()) {
+				for (auto it = first; it != last; ++it) {
+					if (it == piece.data()) {
+						return true;
+					}
+				}
+			} else if (std::less<>()(piece.data(), last) and std::less<>()(first, piece.data() + piece.size())) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static constexpr std::array<std::string_view, count + 1> append_piece(std::array<std::string_view, count> const & pieces, std::string_view const piece) {
+		auto result = std::array<std::string_view, count + 1>();
+		::copy(pieces.begin(), pieces.end(), result.begin());
+		result.back() = piece;
+		return result;
+	}
+
+	[[no_unique_address]] allocator_type allocator_;
+	std::array<std::string_view, count> pieces_;
+};
+
+// An rvalue string on the left already has storage, so the rest is appended
+// to it. It grows only if the result does not fit in its capacity.
+template<typename String, string_piece Piece> requires prototype_string<String>
+constexpr String operator+(String && lhs, Piece const & rhs) {
+	auto const view = as_view(rhs);
+	lhs.append(view.data(), view.data() + view.size());
+	return std::move(lhs);
+}
+
+template<prototype_string String, string_piece Piece>
+constexpr auto operator+(String const & lhs, Piece const & rhs) {
+	return concatenation<String, 2>(lhs.get_allocator(), {as_view(lhs), as_view(rhs)});
+}
+
+template<string_piece Piece, prototype_string String> requires(!prototype_string<Piece>)
+constexpr auto operator+(Piece const & lhs, String const & rhs) {
+	return concatenation<String, 2>(rhs.get_allocator(), {as_view(lhs), as_view(rhs)});
+}
+
+// Defined in terms of operator+, as in generate-operators.md. The string
+// moved into operator+ is a different object from the one it returns, so
+// this is not a self-move-assignment.
+template<prototype_string String, typename Other>
+constexpr String & operator+=(String & lhs, Other && rhs) {
+	lhs = std::move(lhs) + std::forward<Other>(rhs);
+	return lhs;
+}
+
+namespace clang {
+	using ::operator+;
+	using ::operator+=;
+} // namespace clang
+
+namespace gcc {
+	using ::operator+;
+	using ::operator+=;
+} // namespace gcc
+
+
+template<typename String>
+constexpr String make_string(std::string_view const source) {
+	auto result = String(typename String::allocator_type());
+	result.append(source.data(), source.data() + source.size());
+	return result;
+}
+
+constexpr bool equal(auto const & str, std::string_view const expected) {
+	return std::string_view(str.data(), str.size()) == expected;
+}
+
+template<typename String>
+constexpr void test_layout() {
+	auto const scheme = make_string<String>("https");
+	auto const host = make_string<String>("api.example.com");
+	auto const path = make_string<String>("/v1/users/12345/preferences");
+	auto const query = std::string_view("fields=all");
+
+	// One allocation of exactly the right size
+	String const url = scheme + "://" + host + path + "?" + query;
+	assert(equal(url, "https://api.example.com/v1/users/12345/preferences?fields=all"));
+	assert((url.capacity() | 1) == (url.size() | 1));
+
+	// Fits in the small buffer of either layout
+	String const small = "/" + scheme + "/";
+	assert(equal(small, "/https/"));
+
+	auto const empty = String(typename String::allocator_type());
+	String const nothing = empty + "";
+	assert(nothing.size() == 0);
+
+	// Appends into the storage of the rvalue on the left
+	auto reused = make_string<String>("prefix");
+	reused.reserve(100);
+	auto const storage = std::as_const(reused).data();
+	auto const result = std::move(reused) + host + "/" + path;
+	assert(equal(result, "prefixapi.example.com//v1/users/12345/preferences"));
+	assert(result.data() == storage);
+
+	auto const combined = std::move(make_string<String>("a")) + (host + "/");
+	assert(equal(combined, "aapi.example.com/"));
+
+	auto appended = make_string<String>("key");
+	appended += ":";
+	appended += host;
+	appended += std::string_view(":");
+	appended += scheme + "/" + path;
+	assert(equal(appended, "key:api.example.com:https//v1/users/12345/preferences"));
+
+	// Appending a string to itself
+	auto doubled = make_string<String>("abc");
+	doubled += doubled;
+	assert(equal(doubled, "abcabc"));
+	for (int n = 0; n != 4; ++n) {
+		doubled += doubled;
+	}
+	assert(doubled.size() == 96);
+	assert(equal(doubled, "abcabcabcabcabcabcabcabcabcabcabcabcabcabcabcabc"
+		"abcabcabcabcabcabcabcabcabcabcabcabcabcabcabcabc"));
+
+	// A concatenation that reads the string it is appended to, both when the
+	// result fits in the small buffer and when it has to reallocate
+	auto self = make_string<String>("ab");
+	self += self + "/";
+	assert(equal(self, "abab/"));
+	auto long_self = make_string<String>("https://api.example.com/v1/users/123");
+	long_self += long_self + "/";
+	assert(equal(long_self, "https://api.example.com/v1/users/123https://api.example.com/v1/users/123/"));
+}
+
+constexpr bool test() {
+	using allocator_type = std::allocator<char>;
+	test_layout<clang::string<allocator_type>>();
+	test_layout<gcc::string<allocator_type>>();
+
+	// A string of the other layout is just another piece
+	auto const clang_string = make_string<clang::string<allocator_type>>("clang");
+	auto const gcc_string = make_string<gcc::string<allocator_type>>("gcc");
+	clang::string<allocator_type> const mixed = clang_string + " and " + gcc_string;
+	assert(equal(mixed, "clang and gcc"));
+	return true;
+}
+
+// Counts calls to the global operator new, which std::allocator uses
+std::size_t allocations = 0;
+
+void * operator new(std::size_t const size) {
+	++allocations;
+	if (auto const result = std::malloc(size)) {
+		return result;
+	}
+	throw std::bad_alloc();
+}
+void operator delete(void * const ptr) noexcept {
+	std::free(ptr);
+}
+void operator delete(void * const ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+template<typename Function>
+double nanoseconds_per_operation(std::size_t const count, Function && function) {
+	auto const start = std::chrono::steady_clock::now();
+	function();
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+}
+
+// Builds a URL and a cache key from six pieces per request, with
+// std::string and with each layout
+template<typename String>
+void benchmark_layout(char const * const name) {
+	constexpr auto count = std::size_t(1'000'000);
+	auto const host = make_string<String>("api.example.com");
+	auto const path = make_string<String>("/v1/users/12345/preferences");
+	auto const tenant = make_string<String>("tenant-42");
+	auto sink = std::size_t(0);
+	auto const before = allocations;
+	auto const time = nanoseconds_per_operation(count, [&] {
+		for (std::size_t n = 0; n != count; ++n) {
+			String const url = "https://" + host + path + "?tenant=" + tenant + "&v=2";
+			String const key = tenant + ":" + host + ":" + path;
+			sink += url.size() + key.size();
+		}
+	});
+	assert(sink == count * 124);
+	std::printf("%-20s %14.1f %14.2f\n", name, time, static_cast<double>(allocations - before) / count);
+}
+
+void benchmark_std_string() {
+	constexpr auto count = std::size_t(1'000'000);
+	auto const host = std::string("api.example.com");
+	auto const path = std::string("/v1/users/12345/preferences");
+	auto const tenant = std::string("tenant-42");
+	auto sink = std::size_t(0);
+	auto const before = allocations;
+	auto const time = nanoseconds_per_operation(count, [&] {
+		for (std::size_t n = 0; n != count; ++n) {
+			auto const url = "https://" + host + path + "?tenant=" + tenant + "&v=2";
+			auto const key = tenant + ":" + host + ":" + path;
+			sink += url.size() + key.size();
+		}
+	});
+	assert(sink == count * 124);
+	std::printf("%-20s %14.1f %14.2f\n", "std::string", time, static_cast<double>(allocations - before) / count);
+}
+
+int main() {
+	test();
+	static_assert(test());
+
+	std::printf("%-20s %14s %14s\n", "", "ns per request", "allocations");
+	benchmark_std_string();
+	benchmark_layout<clang::string<std::allocator<char>>>("clang layout");
+	benchmark_layout<gcc::string<std::allocator<char>>>("gcc layout");
+}
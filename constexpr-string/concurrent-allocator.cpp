@@ -0,0 +1,719 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is to show that the
+// stack-buffer allocator used by the other versions can be shared between
+// threads without giving up the constexpr single-threaded one. The string is
+// the clang-abi-compatible string, templated on its allocator.
+//
+// concurrent_allocator hands out cache-line-aligned chunks from a shared arena
+// with a single atomic fetch-add, so strings built on different threads never
+// share a cache line. per_thread_allocator takes a large chunk at a time from
+// that arena into a thread_local cache and then bumps a plain pointer, so the
+// atomic is only touched once per chunk.
+//
+// Running the program benchmarks building strings on 1 to 64 threads with each
+// allocator and with std::string.
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+template<typename T>
+struct buffer {
+	constexpr buffer() = default;
+	buffer(buffer &&) = delete;
+	buffer(buffer const &) = delete;
+	buffer & operator=(buffer &&) = delete;
+	buffer & operator=(buffer const &) = delete;
+
+	T data[5000] = {};
+	T * pointer = data;
+};
+
+template<typename T>
+struct allocator {
+	using value_type = T;
+
+	explicit constexpr allocator(buffer<T> & buffer):
+		buffer_(&buffer)
+	{
+	}
+
+	constexpr auto allocate(std::size_t size) {
+		auto const result = buffer_->pointer;
+		buffer_->pointer += size;
+		return result;
+	}
+	constexpr void deallocate(T * ptr, std::size_t size) {
+	}
+
+private:
+	buffer<T> * buffer_;
+};
+
+
+constexpr auto cache_line_size = std::size_t(64);
+
+// Every buffer, and every reset of one, takes an id that no other buffer has
+// had, so that a chunk a thread cached from a buffer that has since been
+// destroyed is never taken for a chunk of a new buffer at the same address.
+// 0 is never used.
+inline std::atomic<std::uint64_t> next_buffer_id = 1;
+
+// Unlike buffer, this lives on the heap: an arena shared by many threads is
+// much larger than anything we want on a stack.
+template<typename T>
+struct concurrent_buffer {
+	static_assert(cache_line_size % sizeof(T) == 0);
+	static constexpr auto elements_per_cache_line = cache_line_size / sizeof(T);
+
+	explicit concurrent_buffer(std::size_t const size):
+		data(static_cast<T *>(::operator new(size * sizeof(T), std::align_val_t(cache_line_size)))),
+		size(size)
+	{
+	}
+	concurrent_buffer(concurrent_buffer &&) = delete;
+	concurrent_buffer(concurrent_buffer const &) = delete;
+	concurrent_buffer & operator=(concurrent_buffer &&) = delete;
+	concurrent_buffer & operator=(concurrent_buffer const &) = delete;
+
+	~concurrent_buffer() {
+		::operator delete(data, std::align_val_t(cache_line_size));
+	}
+
+	// Rounding every chunk up to a whole number of cache lines keeps the next
+	// chunk aligned, no matter which thread gets it.
+	T * allocate_chunk(std::size_t const count) {
+		auto const rounded = (count + elements_per_cache_line - 1) / elements_per_cache_line * elements_per_cache_line;
+		auto const offset = used.fetch_add(rounded, std::memory_order_relaxed);
+		if (offset + rounded > size) {
+			throw std::bad_alloc();
+		}
+		return data + offset;
+	}
+
+	// Must not be called while any thread is still allocating.
+	void reset() {
+		used.store(0, std::memory_order_relaxed);
+		id = next_buffer_id.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	T * const data;
+	std::size_t const size;
+	std::uint64_t id = next_buffer_id.fetch_add(1, std::memory_order_relaxed);
+	// On its own cache line so that bumping it does not evict the members
+	// above, which every thread reads.
+	alignas(cache_line_size) std::atomic<std::size_t> used = 0;
+};
+
+template<typename T>
+struct concurrent_allocator {
+	using value_type = T;
+
+	explicit constexpr concurrent_allocator(concurrent_buffer<T> & buffer):
+		buffer_(&buffer)
+	{
+	}
+
+	auto allocate(std::size_t size) {
+		return buffer_->allocate_chunk(size);
+	}
+	constexpr void deallocate(T * ptr, std::size_t size) {
+	}
+
+private:
+	concurrent_buffer<T> * buffer_;
+};
+
+
+template<typename T>
+struct thread_chunk {
+	std::uint64_t buffer_id = 0;
+	T * pointer = nullptr;
+	T * end = nullptr;
+};
+
+// Trivially constructible, so accessing it is a single offset from the thread
+// pointer with no initialization guard.
+template<typename T>
+inline thread_local thread_chunk<T> current_chunk;
+
+template<typename T>
+struct per_thread_allocator {
+	using value_type = T;
+
+	static constexpr auto chunk_size = std::size_t(64 * 1024) / sizeof(T);
+
+	explicit constexpr per_thread_allocator(concurrent_buffer<T> & buffer):
+		buffer_(&buffer)
+	{
+	}
+
+	auto allocate(std::size_t size) {
+		auto & chunk = current_chunk<T>;
+		if (chunk.buffer_id != buffer_->id or static_cast<std::size_t>(chunk.end - chunk.pointer) < size) [[unlikely]] {
+			refill(chunk, size);
+		}
+		auto const result = chunk.pointer;
+		chunk.pointer += size;
+		return result;
+	}
+	constexpr void deallocate(T * ptr, std::size_t size) {
+	}
+
+private:
+	// Whatever is left of the previous chunk is abandoned. With chunks much
+	// larger than a typical string, that is a small fraction of the arena.
+	void refill(thread_chunk<T> & chunk, std::size_t const size) {
+		auto const count = std::max(chunk_size, size);
+		// Only once allocate_chunk has not thrown, or the old chunk would be
+		// taken for one from this buffer
+		chunk.pointer = buffer_->allocate_chunk(count);
+		chunk.end = chunk.pointer + count;
+		chunk.buffer_id = buffer_->id;
+	}
+
+	concurrent_buffer<T> * buffer_;
+};
+
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	static constexpr std::size_t small_buffer_capacity = 23;
+
+	struct small_t {
+		char data[small_buffer_capacity] = {};
+	};
+	struct [[gnu::packed]] large_t {
+		static constexpr std::size_t bytes_remaining = 7;
+
+		template<typename It>
+		class range_view {
+		public:
+			constexpr range_view(It first, It last):
+				first_(first),
+				last_(last)
+			{
+			}
+			constexpr auto begin() const {
+				return first_;
+			}
+			constexpr auto end() const {
+				return last_;
+			}
+		private:
+			It first_;
+			It last_;
+		};
+
+		constexpr auto little_endian_capacity() const {
+			return range_view(
+				std::rbegin(rest_of_capacity),
+				std::rend(rest_of_capacity)
+			);
+		}
+		constexpr auto big_endian_capacity() {
+			return range_view(
+				std::begin(rest_of_capacity),
+				std::end(rest_of_capacity)
+			);
+		}
+
+		constexpr large_t(std::size_t set_size, std::size_t capacity, char * pointer) noexcept:
+			rest_of_capacity{},
+			size(set_size),
+			data(pointer)
+		{
+			assert(data != nullptr);
+			for (unsigned char & byte : big_endian_capacity()) {
+				capacity >>= CHAR_BIT;
+				byte = capacity;
+			}
+		}
+
+		unsigned char rest_of_capacity[bytes_remaining];
+		std::size_t size;
+		char * data;
+	};
+
+	[[no_unique_address]] allocator_type allocator_;
+	unsigned char size_or_first_byte_of_capacity_;
+	union U {
+		constexpr U() noexcept:
+			small{}
+		{
+		}
+		explicit constexpr U(std::size_t size, std::size_t capacity, char * data) noexcept:
+			large(size, capacity, data)
+		{
+		}
+		constexpr U(large_t set_large) noexcept:
+			large(set_large)
+		{
+		}
+
+		small_t small;
+		large_t large;
+	} u_;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return size_or_first_byte_of_capacity_ & 1;
+	}
+
+	constexpr void increment_size() {
+		if (is_large()) {
+			++u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ += (1 << 1);
+		}
+	}
+	constexpr void decrement_size() {
+		if (is_large()) {
+			--u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ -= (1 << 1);
+		}
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, u_.large.data, capacity());
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(size(), new_capacity, new_data);
+		assert(new_capacity & 1);
+		size_or_first_byte_of_capacity_ = new_capacity;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		new_capacity |= 1;
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy(begin(), end(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		size_or_first_byte_of_capacity_(0),
+		u_{}
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.large);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+
+			other.u_ = U{};
+			other.size_or_first_byte_of_capacity_ = 0;
+		} else {
+			auto & osmall = other.u_.small;
+			u_ = U{};
+			copy(osmall.data, osmall.data + (other.size_or_first_byte_of_capacity_ >> 1), u_.small.data);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr char * data() {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr std::size_t size() const {
+		return is_large() ? u_.large.size : (size_or_first_byte_of_capacity_ >> 1);
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		if (!is_large()) {
+			return small_buffer_capacity;
+		}
+		std::size_t result = 0;
+		for (unsigned char const byte : u_.large.little_endian_capacity()) {
+			result |= byte;
+			result <<= CHAR_BIT;
+		}
+		result |= size_or_first_byte_of_capacity_;
+		return result;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		auto const local_size = size();
+		if (is_large() && capacity() > (local_size | 1)) {
+			if (local_size > small_buffer_capacity) {
+				force_reserve(local_size);
+			} else {
+				auto const data = u_.large.data;
+				auto const original_capacity = capacity();
+				u_ = U{};
+				size_or_first_byte_of_capacity_ = local_size << 1;
+				copy(data, data + local_size, u_.small.data);
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = std::prev(end());
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = (capacity() * growth_factor) | 1;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+
+			relocate(temp, new_capacity);
+		}
+		increment_size();
+		return begin() + offset;
+	}
+
+	constexpr void pop_back() {
+		decrement_size();
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+template<typename Allocator>
+string(Allocator) -> string<Allocator>;
+
+template<typename String>
+constexpr void test_individual(String & str, char const * source) {
+	String temp(str.get_allocator());
+	for (auto it = source; *it != '\0'; ++it) {
+		str.insert(str.end(), *it);
+		temp.insert(temp.end(), *it);
+	}
+
+	temp.insert(temp.begin(), 'a');
+	temp.insert(temp.begin() + temp.size() / 2, 'b');
+	auto const size = std::char_traits<char>::length(source);
+	auto const middle = (size + 1) / 2;
+	assert(temp.size() == size + 2);
+	for (std::size_t n = 0; n != temp.size(); ++n) {
+		auto const expected = n == 0 ? 'a' : n == middle ? 'b' : n < middle ? source[n - 1] : source[n - 2];
+		assert(temp.data()[n] == expected);
+	}
+
+	// Inserting at the front, including each time that reallocates
+	String front(str.get_allocator());
+	for (std::size_t n = 0; n != 100; ++n) {
+		front.insert(front.begin(), static_cast<char>('0' + n % 10));
+	}
+	for (std::size_t n = 0; n != front.size(); ++n) {
+		assert(front.data()[n] == static_cast<char>('0' + (99 - n) % 10));
+	}
+
+	while (temp.size() != 0) {
+		temp.pop_back();
+	}
+	assert(temp.size() == 0);
+
+	auto temp2 = std::move(str);
+	str = std::move(temp2);
+
+	assert(str.data() != temp.data());
+	assert(str.size() == std::char_traits<char>::length(source));
+	assert(std::char_traits<char>::compare(str.data(), source, str.size()) == 0);
+	assert(str.capacity() >= str.size());
+
+	str.reserve(50);
+	str.shrink_to_fit();
+}
+
+template<typename Allocator>
+constexpr void test_allocator(Allocator alloc) {
+	char const * short_source = "0123";
+	char const * long_source =
+		"0123456789"
+		"0123456789"
+		"0123456789"
+		"0123456789"
+		"0123456789";
+
+	string short_str(alloc);
+	test_individual(short_str, short_source);
+
+	string long_str(alloc);
+	test_individual(long_str, long_source);
+
+	assert(short_str.data() != long_str.data());
+}
+
+constexpr bool test() {
+	buffer<char> buff{};
+	test_allocator(allocator(buff));
+	return true;
+}
+
+void test_concurrent() {
+	auto buff = concurrent_buffer<char>(1 << 20);
+	test_allocator(concurrent_allocator(buff));
+	test_allocator(per_thread_allocator(buff));
+
+	auto const first = concurrent_allocator(buff).allocate(1);
+	auto const second = concurrent_allocator(buff).allocate(cache_line_size + 1);
+	auto const third = concurrent_allocator(buff).allocate(1);
+	assert(reinterpret_cast<std::uintptr_t>(first) % cache_line_size == 0);
+	assert(second - first == cache_line_size);
+	assert(third - second == 2 * cache_line_size);
+
+	// Chunks cached by a thread from before a reset must not be reused
+	auto const before = per_thread_allocator(buff).allocate(1);
+	buff.reset();
+	auto const after = per_thread_allocator(buff).allocate(1);
+	assert(after == buff.data);
+	assert(before != after);
+
+	// Nor chunks cached from a destroyed buffer, when a new buffer is built
+	// at the same address
+	for (int n = 0; n != 2; ++n) {
+		auto scoped = concurrent_buffer<char>(per_thread_allocator<char>::chunk_size);
+		assert(per_thread_allocator(scoped).allocate(16) == scoped.data);
+	}
+
+	// Nor when taking a chunk from the new buffer throws
+	{
+		auto destroyed = concurrent_buffer<char>(per_thread_allocator<char>::chunk_size);
+		per_thread_allocator(destroyed).allocate(16);
+	}
+	auto too_small = concurrent_buffer<char>(16);
+	for (int n = 0; n != 2; ++n) {
+		auto threw = false;
+		try {
+			per_thread_allocator(too_small).allocate(16);
+		} catch (std::bad_alloc const &) {
+			threw = true;
+		}
+		assert(threw);
+	}
+}
+
+
+constexpr auto strings_per_thread = std::size_t(4000);
+// Covers both strings that stay in the small buffer and strings that grow
+// through a few reallocations.
+constexpr auto max_length = std::size_t(100);
+
+template<typename String>
+std::size_t build_strings(auto make_string) {
+	auto result = std::size_t(0);
+	for (std::size_t n = 0; n != strings_per_thread; ++n) {
+		String str = make_string();
+		auto const length = n % max_length;
+		for (std::size_t index = 0; index != length; ++index) {
+			str.insert(str.end(), static_cast<char>('a' + index % 26));
+		}
+		result += str.size() + static_cast<std::size_t>(str.data()[length / 2]);
+	}
+	return result;
+}
+
+// Returns nanoseconds per string, averaged over all threads
+double time_threads(std::size_t const thread_count, auto const & work) {
+	auto checksum = std::atomic<std::size_t>(0);
+	auto threads = std::vector<std::thread>();
+	threads.reserve(thread_count);
+	auto const start = std::chrono::steady_clock::now();
+	for (std::size_t n = 0; n != thread_count; ++n) {
+		threads.emplace_back([&] {
+			checksum += work();
+		});
+	}
+	for (auto & thread : threads) {
+		thread.join();
+	}
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+	assert(checksum != 0);
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(thread_count * strings_per_thread);
+}
+
+void benchmark() {
+	// Enough for every string to reach its final capacity through a
+	// cache-line-rounded allocation at each growth step, plus one partially
+	// used chunk per thread.
+	constexpr auto bytes_per_thread = strings_per_thread * 512 + per_thread_allocator<char>::chunk_size;
+	constexpr auto max_threads = std::size_t(64);
+	auto buff = concurrent_buffer<char>(max_threads * bytes_per_thread);
+
+	std::printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+	std::printf("%8s %14s %14s %14s   (ns per string)\n", "threads", "std::string", "concurrent", "per_thread");
+	for (std::size_t thread_count = 1; thread_count <= max_threads; thread_count *= 2) {
+		auto const standard = time_threads(thread_count, [] {
+			return build_strings<std::string>([] { return std::string(); });
+		});
+		buff.reset();
+		auto const concurrent = time_threads(thread_count, [&] {
+			return build_strings<string<concurrent_allocator<char>>>([&] {
+				return string(concurrent_allocator(buff));
+			});
+		});
+		buff.reset();
+		auto const per_thread = time_threads(thread_count, [&] {
+			return build_strings<string<per_thread_allocator<char>>>([&] {
+				return string(per_thread_allocator(buff));
+			});
+		});
+		std::printf("%8zu %14.1f %14.1f %14.1f\n", thread_count, standard, concurrent, per_thread);
+	}
+}
+
+int main() {
+	test();
+	static_assert(test());
+	test_concurrent();
+	benchmark();
+}
@@ -0,0 +1,547 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is to put together
+// strings that are known at compile time, such as metric names and log
+// prefixes, at compile time, so that nothing formats them at run time.
+//
+// fixed_string<N> holds exactly N characters and a null terminator, and can
+// be a template parameter. operator+ and to_fixed_string give results of
+// exactly the right size, which is part of the type. make_fixed_string turns
+// a string built during constant evaluation into a fixed_string, since the
+// string itself cannot outlive the constant evaluation. This is the kind of
+// code that constexpr function parameters (constexpr-parameters.md) would let
+// users write with ordinary function arguments instead of template
+// arguments.
+//
+// The string is the gcc and MSVC layout, made generic over the allocator so
+// that it can use std::allocator during constant evaluation.
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	[[no_unique_address]] allocator_type allocator_;
+	// This could be set to 8 to reduce the size of our string to 24 bytes
+	// (just like clang), but 7 characters (plus a null terminator) is likely
+	// too small of a buffer for most users.
+	static constexpr std::size_t small_buffer_capacity = 16;
+	union U{
+		constexpr U():
+			buffer{}
+		{
+		}
+		constexpr U(std::size_t c):
+			capacity(c)
+		{
+		}
+
+		char buffer[small_buffer_capacity];
+		std::size_t capacity;
+	} u_;
+	char * data_;
+	std::size_t size_ : 63;
+	// gcc and MSVC do not allow accessing the inactive member of a union just
+	// to get its address, so we use a bitfield to work around this.
+	bool is_large_ : 1;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return is_large_;
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, data_, u_.capacity);
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(new_capacity);
+		data_ = new_data;
+		is_large_ = true;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy(begin(), end(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_{},
+		data_(u_.buffer),
+		size_(0),
+		is_large_(false)
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.capacity);
+			other.u_ = U{};
+		
+			data_ = other.data_;
+			other.data_ = other.u_.buffer;
+		
+			size_ = other.size_;
+			other.size_ = 0U;
+		
+			is_large_ = true;
+			other.is_large_ = false;
+
+		} else {
+			u_ = U{};
+			copy(other.data_, other.data_ + other.size_, u_.buffer);
+			data_ = u_.buffer;
+			size_ = other.size_;
+			is_large_ = false;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return data_;
+	}
+	constexpr char * data() {
+		return data_;
+	}
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		return is_large() ? u_.capacity : small_buffer_capacity;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		if (is_large() && capacity() > size()) {
+			if (size() > small_buffer_capacity) {
+				force_reserve(size());
+			} else {
+				auto const data = data_;
+				auto const original_capacity = u_.capacity;
+				u_ = U{};
+				copy(data, data + size_, u_.buffer);
+				data_ = u_.buffer;
+				is_large_ = false;
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = end() - 1;
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = capacity() * growth_factor;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+		
+			relocate(temp, new_capacity);
+		}
+		++size_;
+		return begin() + offset;
+	}
+
+	constexpr void pop_back() {
+		--size_;
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+template<typename Allocator>
+string(Allocator) -> string<Allocator>;
+
+
+// A string whose size is part of its type, which can be a template
+// parameter. Everything is public because class types can only be template
+// parameters when all of their members are.
+//
+// The characters of a template parameter object are in static storage, so a
+// std::string_view of one is valid for the whole program.
+template<std::size_t size_>
+struct fixed_string {
+	constexpr fixed_string() = default;
+
+	// For string literals, which include the null terminator
+	constexpr fixed_string(char const (&value)[size_ + 1]) {
+		assert(value[size_] == '\0');
+		copy(value, value + size_, data_);
+	}
+
+	static constexpr std::size_t size() {
+		return size_;
+	}
+	constexpr char const * data() const {
+		return data_;
+	}
+	constexpr char * data() {
+		return data_;
+	}
+	constexpr char const * c_str() const {
+		return data_;
+	}
+
+	constexpr char const * begin() const {
+		return data_;
+	}
+	constexpr char * begin() {
+		return data_;
+	}
+	constexpr char const * end() const {
+		return data_ + size_;
+	}
+	constexpr char * end() {
+		return data_ + size_;
+	}
+
+	constexpr operator std::string_view() const {
+		return std::string_view(data_, size_);
+	}
+
+	constexpr bool operator==(std::string_view const other) const {
+		return std::string_view(*this) == other;
+	}
+
+	char data_[size_ + 1] = {};
+};
+
+template<std::size_t size>
+fixed_string(char const (&)[size]) -> fixed_string<size - 1>;
+
+template<std::size_t lhs_size, std::size_t rhs_size>
+constexpr auto operator+(fixed_string<lhs_size> const & lhs, fixed_string<rhs_size> const & rhs) {
+	auto result = fixed_string<lhs_size + rhs_size>();
+	copy(rhs.begin(), rhs.end(), copy(lhs.begin(), lhs.end(), result.begin()));
+	return result;
+}
+template<std::size_t lhs_size, std::size_t rhs_size>
+constexpr auto operator+(fixed_string<lhs_size> const & lhs, char const (&rhs)[rhs_size]) {
+	return lhs + fixed_string(rhs);
+}
+template<std::size_t lhs_size, std::size_t rhs_size>
+constexpr auto operator+(char const (&lhs)[lhs_size], fixed_string<rhs_size> const & rhs) {
+	return fixed_string(lhs) + rhs;
+}
+
+// Pads on the left up to width characters. A string that is already at
+// least that long is unchanged.
+template<std::size_t width, char fill = ' ', std::size_t size>
+constexpr auto pad_left(fixed_string<size> const & value) {
+	constexpr auto padding = width > size ? width - size : 0;
+	auto result = fixed_string<padding + size>();
+	std::fill_n(result.begin(), padding, fill);
+	copy(value.begin(), value.end(), result.begin() + padding);
+	return result;
+}
+
+// The digits of value in base, with a '-' in front if it is negative. The
+// digits above 9 are lowercase letters.
+template<auto value, int base = 10> requires std::integral<decltype(value)>
+constexpr auto to_fixed_string() {
+	static_assert(2 <= base and base <= 36);
+	using unsigned_type = std::make_unsigned_t<decltype(value)>;
+	// Negating as unsigned works for the smallest value of a signed type
+	constexpr auto magnitude = value < 0 ? static_cast<unsigned_type>(unsigned_type(0) - static_cast<unsigned_type>(value)) : static_cast<unsigned_type>(value);
+	constexpr auto size = [] {
+		auto result = std::size_t(value < 0 ? 2 : 1);
+		for (auto remaining = magnitude; remaining >= static_cast<unsigned_type>(base); remaining /= static_cast<unsigned_type>(base)) {
+			++result;
+		}
+		return result;
+	}();
+	auto result = fixed_string<size>();
+	auto remaining = magnitude;
+	for (auto it = result.end(); it != result.begin() + (value < 0 ? 1 : 0); ) {
+		--it;
+		*it = "0123456789abcdefghijklmnopqrstuvwxyz"[remaining % static_cast<unsigned_type>(base)];
+		remaining /= static_cast<unsigned_type>(base);
+	}
+	if constexpr (value < 0) {
+		result.data_[0] = '-';
+	}
+	return result;
+}
+
+// make is a lambda that returns a string built during constant evaluation.
+template<auto make>
+consteval auto make_fixed_string() {
+	constexpr auto size = make().size();
+	auto const value = make();
+	auto result = fixed_string<size>();
+	copy(value.begin(), value.end(), result.begin());
+	return result;
+}
+
+// A std::string_view of value that can be used at run time
+template<fixed_string value>
+inline constexpr auto static_view = std::string_view(value);
+
+
+using allocator_type = std::allocator<char>;
+
+constexpr void append(string<allocator_type> & target, std::string_view const value) {
+	for (auto const c : value) {
+		target.insert(target.end(), c);
+	}
+}
+
+template<fixed_string name, int status>
+constexpr std::string_view metric_name() {
+	return static_view<name + ".status_" + to_fixed_string<status>()>;
+}
+
+template<fixed_string component>
+struct logger {
+	static constexpr auto prefix = "[" + component + "] ";
+
+	void log(std::string & out, std::string_view const message) const {
+		out.append(prefix);
+		out.append(message);
+		out.push_back('\n');
+	}
+};
+
+static_assert(std::is_same_v<decltype(fixed_string("abc")), fixed_string<3>>);
+static_assert(std::is_same_v<decltype(fixed_string("ab") + "cd"), fixed_string<4>>);
+static_assert(std::is_same_v<decltype(to_fixed_string<-100>()), fixed_string<4>>);
+static_assert(std::is_same_v<decltype(pad_left<8>(fixed_string("abc"))), fixed_string<8>>);
+
+constexpr bool test() {
+	constexpr auto abc = fixed_string("abc");
+	assert(abc == "abc");
+	assert(abc != "ab");
+	assert(abc.c_str()[3] == '\0');
+	assert(fixed_string("") == "");
+
+	assert(fixed_string("ab") + fixed_string("cd") == "abcd");
+	assert("x." + abc + ".y" == "x.abc.y");
+	assert(abc + fixed_string("") == abc);
+
+	assert(to_fixed_string<0>() == "0");
+	assert(to_fixed_string<7>() == "7");
+	assert(to_fixed_string<10>() == "10");
+	assert(to_fixed_string<-42>() == "-42");
+	assert((to_fixed_string<255, 16>() == "ff"));
+	assert((to_fixed_string<255, 2>() == "11111111"));
+	assert((to_fixed_string<35, 36>() == "z"));
+	assert(to_fixed_string<std::numeric_limits<std::int64_t>::min()>() == "-9223372036854775808");
+	assert(to_fixed_string<std::numeric_limits<std::uint64_t>::max()>() == "18446744073709551615");
+	assert(to_fixed_string<std::numeric_limits<std::int8_t>::min()>() == "-128");
+
+	assert((pad_left<5, '0'>(to_fixed_string<42>()) == "00042"));
+	assert(pad_left<1>(abc) == "abc");
+	assert(pad_left<3>(abc) == "abc");
+
+	constexpr auto built = make_fixed_string<[] {
+		auto result = string(allocator_type());
+		append(result, "built by a string that allocates during constant evaluation");
+		return result;
+	}>();
+	assert(built == "built by a string that allocates during constant evaluation");
+	assert(built.size() == 59);
+
+	assert((metric_name<"http.server.requests", 200>() == "http.server.requests.status_200"));
+	assert((metric_name<"rpc", -1>() == "rpc.status_-1"));
+	assert(logger<"db">::prefix == "[db] ");
+	return true;
+}
+
+template<typename Function>
+double nanoseconds_per_operation(std::size_t const count, Function && function) {
+	auto const start = std::chrono::steady_clock::now();
+	function();
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+}
+
+// Formatting a metric name on each call, which is what a hot path does when
+// the name is only put together at run time, against a name that was put
+// together at compile time.
+void benchmark() {
+	constexpr auto count = std::size_t(10'000'000);
+	auto sink = std::size_t(0);
+	auto const run_time = nanoseconds_per_operation(count, [&] {
+		for (std::size_t n = 0; n != count; ++n) {
+			auto const name = std::string("http.server.requests") + ".status_" + std::to_string(200);
+			sink += name.size();
+		}
+	});
+	auto const compile_time = nanoseconds_per_operation(count, [&] {
+		for (std::size_t n = 0; n != count; ++n) {
+			auto const name = metric_name<"http.server.requests", 200>();
+			sink += name.size();
+		}
+	});
+	assert((sink == 2 * count * metric_name<"http.server.requests", 200>().size()));
+	std::printf("%-30s %14s\n", "", "ns per name");
+	std::printf("%-30s %14.1f\n", "std::string at run time", run_time);
+	std::printf("%-30s %14.1f\n", "fixed_string template argument", compile_time);
+}
+
+int main() {
+	test();
+	static_assert(test());
+
+	// Every use of the same template argument refers to the same object
+	assert((metric_name<"http.server.requests", 200>().data() == metric_name<"http.server.requests", 200>().data()));
+
+	auto out = std::string();
+	logger<"db">().log(out, "connected");
+	assert(out == "[db] connected\n");
+	benchmark();
+}
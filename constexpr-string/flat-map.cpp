@@ -0,0 +1,1353 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is a hash map with
+// string keys that is built around the clang layout, instead of a node-based
+// std::unordered_map<std::string, T>, which costs a cache miss for every node
+// and another for every key that does not fit in the small buffer.
+//
+// The slot array holds the keys themselves, so a key of up to 23 characters
+// is found with no pointer chasing at all. A separate array holds a control
+// byte per slot with 7 bits of the hash, and a lookup compares 16 of those at
+// a time with SSE2 before it compares any keys. The string here is the one
+// from hash.cpp, made generic over the allocator so that the key is 24 bytes
+// with std::allocator. Its hash, cached for long keys, means growing the table
+// does not rehash their characters.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <compare>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__)
+	#include <immintrin.h>
+#endif
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+
+// Reads bytes in memory order, so that comparing two words as integers
+// compares them as unsigned characters, the same as memcmp.
+inline std::uint64_t load_big_endian(char const * const data) {
+	auto result = std::uint64_t();
+	std::memcpy(&result, data, sizeof(result));
+	if constexpr (std::endian::native == std::endian::little) {
+		result = __builtin_bswap64(result);
+	}
+	return result;
+}
+
+// The offsets of the words covering a small buffer of `capacity` bytes. The
+// last word overlaps the one before it when capacity is not a multiple of the
+// word size. The overlapping bytes are already known to be equal by the time
+// the last word matters, so this does not change any result.
+template<std::size_t capacity>
+constexpr auto word_offsets = [] {
+	static_assert(capacity >= sizeof(std::uint64_t));
+	constexpr auto word = sizeof(std::uint64_t);
+	auto result = std::array<std::size_t, (capacity + word - 1) / word>();
+	for (std::size_t n = 0; n != result.size(); ++n) {
+		result[n] = std::min(n * word, capacity - word);
+	}
+	return result;
+}();
+
+// These rely on every byte of both buffers past the size being 0.
+
+template<std::size_t capacity>
+bool small_buffer_equal(char const * const lhs, char const * const rhs) {
+	auto difference = std::uint64_t(0);
+	for (auto const offset : word_offsets<capacity>) {
+		difference |= load_big_endian(lhs + offset) ^ load_big_endian(rhs + offset);
+	}
+	return difference == 0;
+}
+
+// Bytes past the end of the shorter string are 0 in that string, and at
+// least 0 in the longer one, so comparing them cannot put the longer string
+// first. If everything matches, the shorter string is a prefix of the longer.
+template<std::size_t capacity>
+std::strong_ordering small_buffer_compare(char const * const lhs, std::size_t const lhs_size, char const * const rhs, std::size_t const rhs_size) {
+	for (auto const offset : word_offsets<capacity>) {
+		auto const lhs_word = load_big_endian(lhs + offset);
+		auto const rhs_word = load_big_endian(rhs + offset);
+		if (lhs_word != rhs_word) {
+			return lhs_word <=> rhs_word;
+		}
+	}
+	return lhs_size <=> rhs_size;
+}
+
+// glibc's memcmp, which this calls at run time, is already vectorized.
+constexpr std::strong_ordering compare(char const * const lhs, std::size_t const lhs_size, char const * const rhs, std::size_t const rhs_size) {
+	auto const result = std::char_traits<char>::compare(lhs, rhs, std::min(lhs_size, rhs_size));
+	return result != 0 ? result <=> 0 : lhs_size <=> rhs_size;
+}
+
+
+// Define STRING_CACHE_HASH to 0 to hash large strings every time.
+#ifndef STRING_CACHE_HASH
+	#define STRING_CACHE_HASH 1
+#endif
+
+constexpr auto cache_hashes = bool(STRING_CACHE_HASH);
+
+// Reads bytes in little-endian order on every target, so that a hash computed
+// during constant evaluation matches the one computed at run time.
+constexpr std::uint64_t load_little_endian(char const * const data) {
+	auto result = std::uint64_t(0);
+	if (std::is_constant_evaluated()) {
+		for (std::size_t n = 0; n != sizeof(result); ++n) {
+			result |= std::uint64_t(static_cast<unsigned char>(data[n])) << (n * CHAR_BIT);
+		}
+		return result;
+	}
+	std::memcpy(&result, data, sizeof(result));
+	if constexpr (std::endian::native == std::endian::big) {
+		result = __builtin_bswap64(result);
+	}
+	return result;
+}
+
+// Strings of up to this many characters hash as three words, padded with 0.
+constexpr std::size_t short_hash_size = 24;
+using short_hash_words = std::array<std::uint64_t, short_hash_size / sizeof(std::uint64_t)>;
+
+constexpr std::uint64_t hash_keys[] = {
+	0xbe4b'a423'396c'feb8,
+	0x1cad'21f7'2c81'017c,
+	0xdb97'9083'e96d'd4de,
+	0x1f67'b3b7'a4a4'4072,
+};
+constexpr std::uint64_t size_key = 0x9e37'79b1'85eb'ca87;
+constexpr std::uint64_t lane_multiplier = 0x9fb2'1c65'1e98'df25;
+
+// The multiply is of the 32-bit halves of the keyed word, which is what
+// _mm256_mul_epu32 computes in each lane. Adding the word with its halves
+// swapped keeps a word from being lost when one of those halves is 0.
+constexpr std::uint64_t accumulate(std::uint64_t const word, std::uint64_t const key) {
+	auto const keyed = word ^ key;
+	return (keyed & 0xffff'ffff) * (keyed >> 32) + std::rotl(word, 32);
+}
+
+constexpr std::uint64_t avalanche(std::uint64_t hash) {
+	hash ^= hash >> 37;
+	hash *= 0x1656'6791'9e37'79f9;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+constexpr std::size_t hash_short(short_hash_words const & words, std::size_t const size) {
+	auto result = size * size_key;
+	for (std::size_t n = 0; n != words.size(); ++n) {
+		result += accumulate(words[n], hash_keys[n]);
+	}
+	return avalanche(result);
+}
+
+// Each lane takes one word of every 32-byte block, and the last block
+// overlaps the one before it. Multiplying the lanes between blocks makes the
+// result depend on the order of the blocks.
+constexpr std::size_t hash_long(char const * const data, std::size_t const size) {
+	assert(size > short_hash_size);
+	constexpr auto block_size = std::size(hash_keys) * sizeof(std::uint64_t);
+	auto lanes = std::array<std::uint64_t, std::size(hash_keys)>();
+	auto add_block = [&](auto const word_offset) {
+		for (std::size_t n = 0; n != lanes.size(); ++n) {
+			lanes[n] = (lanes[n] + accumulate(load_little_endian(data + word_offset(n)), hash_keys[n])) * lane_multiplier;
+		}
+	};
+	if (size < block_size) {
+		add_block([=](std::size_t const n) { return std::min(n * sizeof(std::uint64_t), size - sizeof(std::uint64_t)); });
+	} else {
+		auto offset = std::size_t(0);
+		for (; offset + block_size <= size; offset += block_size) {
+			add_block([=](std::size_t const n) { return offset + n * sizeof(std::uint64_t); });
+		}
+		if (offset != size) {
+			add_block([=](std::size_t const n) { return size - block_size + n * sizeof(std::uint64_t); });
+		}
+	}
+	auto result = size * size_key;
+	for (std::size_t n = 0; n != lanes.size(); ++n) {
+		result += std::rotl(lanes[n], static_cast<int>(n * 16));
+	}
+	return avalanche(result);
+}
+
+constexpr short_hash_words padded_words(char const * const data, std::size_t const size) {
+	assert(size <= short_hash_size);
+	char padded[short_hash_size] = {};
+	copy(data, data + size, padded);
+	auto result = short_hash_words();
+	for (std::size_t n = 0; n != result.size(); ++n) {
+		result[n] = load_little_endian(padded + n * sizeof(std::uint64_t));
+	}
+	return result;
+}
+
+// This relies on every byte of the buffer past the size being 0. When the
+// buffer ends partway through the last word, that word is loaded from the end
+// of the buffer and shifted down, which fills the rest of it with 0.
+template<std::size_t capacity>
+short_hash_words small_buffer_words(char const * const buffer) {
+	static_assert(capacity >= 2 * sizeof(std::uint64_t) and capacity <= short_hash_size);
+	auto last = std::uint64_t(0);
+	if constexpr (capacity > 2 * sizeof(std::uint64_t)) {
+		last = load_little_endian(buffer + capacity - sizeof(std::uint64_t)) >> ((short_hash_size - capacity) * CHAR_BIT);
+	}
+	return {load_little_endian(buffer), load_little_endian(buffer + sizeof(std::uint64_t)), last};
+}
+
+// Hashes the same way as either string, so it can look them up by
+// std::string_view.
+constexpr std::size_t hash_bytes(char const * const data, std::size_t const size) {
+	return size <= short_hash_size ? hash_short(padded_words(data, size), size) : hash_long(data, size);
+}
+
+
+// With hash caching on, every heap allocation starts with a slot that holds
+// the hash of the string, or 0 if it is not known, followed by the
+// characters. Allocations are rounded up to a multiple of the slot size so
+// that every slot is aligned. Constant evaluation does not use the slot.
+constexpr std::size_t hash_slot_size = sizeof(std::size_t);
+
+constexpr std::size_t heap_allocation_size(std::size_t const capacity) {
+	return (capacity + 2 * hash_slot_size - 1) / hash_slot_size * hash_slot_size;
+}
+
+template<typename Allocator>
+constexpr char * allocate_heap(Allocator & alloc, std::size_t const capacity) {
+	using Alloc = allocator_traits<Allocator>;
+	if (std::is_constant_evaluated() or !cache_hashes) {
+		return Alloc::allocate(alloc, capacity);
+	}
+	auto const allocation = Alloc::allocate(alloc, heap_allocation_size(capacity));
+	::new(static_cast<void *>(allocation)) std::size_t(0);
+	return allocation + hash_slot_size;
+}
+
+template<typename Allocator>
+constexpr void deallocate_heap(Allocator & alloc, char * const data, std::size_t const capacity) {
+	using Alloc = allocator_traits<Allocator>;
+	if (std::is_constant_evaluated() or !cache_hashes) {
+		Alloc::deallocate(alloc, data, capacity);
+	} else {
+		Alloc::deallocate(alloc, data - hash_slot_size, heap_allocation_size(capacity));
+	}
+}
+
+inline std::atomic_ref<std::size_t> hash_slot(char * const data) {
+	return std::atomic_ref(*std::launder(reinterpret_cast<std::size_t *>(data - hash_slot_size)));
+}
+
+inline void invalidate_hash(char * const data) {
+	if constexpr (cache_hashes) {
+		hash_slot(data).store(0, std::memory_order_relaxed);
+	}
+}
+
+// Relaxed is enough: hash is const, so every thread that computes the hash of
+// the same characters stores the same value. A hash that happens to be 0 is
+// never cached.
+inline std::size_t cached_hash(char * const data, std::size_t const size) {
+	if constexpr (!cache_hashes) {
+		return hash_long(data, size);
+	} else {
+		auto const slot = hash_slot(data);
+		auto result = slot.load(std::memory_order_relaxed);
+		if (result == 0) {
+			result = hash_long(data, size);
+			slot.store(result, std::memory_order_relaxed);
+		}
+		return result;
+	}
+}
+
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	static constexpr std::size_t small_buffer_capacity = 23;
+
+	struct small_t {
+		char data[small_buffer_capacity] = {};
+	};
+	struct [[gnu::packed]] large_t {
+		static constexpr std::size_t bytes_remaining = 7;
+
+		template<typename It>
+		class range_view {
+		public:
+			constexpr range_view(It first, It last):
+				first_(first),
+				last_(last)
+			{
+			}
+			constexpr auto begin() const {
+				return first_;
+			}
+			constexpr auto end() const {
+				return last_;
+			}
+		private:
+			It first_;
+			It last_;
+		};
+
+		constexpr auto little_endian_capacity() const {
+			return range_view(
+				std::rbegin(rest_of_capacity),
+				std::rend(rest_of_capacity)
+			);
+		}
+		constexpr auto big_endian_capacity() {
+			return range_view(
+				std::begin(rest_of_capacity),
+				std::end(rest_of_capacity)
+			);
+		}
+
+		constexpr large_t(std::size_t set_size, std::size_t capacity, char * pointer) noexcept:
+			rest_of_capacity{},
+			size(set_size),
+			data(pointer)
+		{
+			assert(data != nullptr);
+			for (unsigned char & byte : big_endian_capacity()) {
+				capacity >>= CHAR_BIT;
+				byte = capacity;
+			}
+		}
+
+		unsigned char rest_of_capacity[bytes_remaining];
+		std::size_t size;
+		char * data;
+	};
+
+	[[no_unique_address]] allocator_type allocator_;
+	unsigned char size_or_first_byte_of_capacity_;
+	union U {
+		constexpr U() noexcept:
+			small{}
+		{
+		}
+		explicit constexpr U(std::size_t size, std::size_t capacity, char * data) noexcept:
+			large(size, capacity, data)
+		{
+		}
+		constexpr U(large_t set_large) noexcept:
+			large(set_large)
+		{
+		}
+
+		small_t small;
+		large_t large;
+	} u_;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return size_or_first_byte_of_capacity_ & 1;
+	}
+
+	constexpr void increment_size() {
+		if (is_large()) {
+			++u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ += (1 << 1);
+		}
+	}
+	constexpr void decrement_size() {
+		if (is_large()) {
+			--u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ -= (1 << 1);
+		}
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			deallocate_heap(alloc, u_.large.data, capacity());
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(size(), new_capacity, new_data);
+		assert(new_capacity & 1);
+		size_or_first_byte_of_capacity_ = new_capacity;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		new_capacity |= 1;
+		auto alloc = get_allocator();
+		char * temp = allocate_heap(alloc, new_capacity);
+		copy(begin(), end(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		size_or_first_byte_of_capacity_(0),
+		u_{}
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.large);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+
+			other.u_ = U{};
+			other.size_or_first_byte_of_capacity_ = 0;
+		} else {
+			auto & osmall = other.u_.small;
+			u_ = U{};
+			copy(osmall.data, osmall.data + (other.size_or_first_byte_of_capacity_ >> 1), u_.small.data);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	// Everything that can change the characters goes through here, including
+	// insert and pop_back.
+	constexpr char * data() {
+		if (!is_large()) {
+			return u_.small.data;
+		}
+		if (!std::is_constant_evaluated()) {
+			invalidate_hash(u_.large.data);
+		}
+		return u_.large.data;
+	}
+	constexpr std::size_t size() const {
+		return is_large() ? u_.large.size : (size_or_first_byte_of_capacity_ >> 1);
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		if (!is_large()) {
+			return small_buffer_capacity;
+		}
+		std::size_t result = 0;
+		for (unsigned char const byte : u_.large.little_endian_capacity()) {
+			result |= byte;
+			result <<= CHAR_BIT;
+		}
+		result |= size_or_first_byte_of_capacity_;
+		return result;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		auto const local_size = size();
+		if (is_large() && capacity() > (local_size | 1)) {
+			if (local_size > small_buffer_capacity) {
+				force_reserve(local_size);
+			} else {
+				auto const data = u_.large.data;
+				auto const original_capacity = capacity();
+				u_ = U{};
+				size_or_first_byte_of_capacity_ = local_size << 1;
+				copy(data, data + local_size, u_.small.data);
+				auto alloc = get_allocator();
+				deallocate_heap(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = std::prev(end());
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = (capacity() * growth_factor) | 1;
+
+			auto alloc = get_allocator();
+			char * temp = allocate_heap(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+
+			relocate(temp, new_capacity);
+		}
+		increment_size();
+		return begin() + offset;
+	}
+
+	constexpr void pop_back() {
+		decrement_size();
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+		// Keeps the bytes of the small buffer past the size 0, which the
+		// comparisons and the hash rely on
+		*end() = '\0';
+	}
+
+	friend constexpr bool operator==(string const & lhs, string const & rhs) {
+		if (!std::is_constant_evaluated() and !lhs.is_large() and !rhs.is_large()) {
+			return lhs.size_or_first_byte_of_capacity_ == rhs.size_or_first_byte_of_capacity_ and small_buffer_equal<small_buffer_capacity>(lhs.u_.small.data, rhs.u_.small.data);
+		}
+		return lhs.size() == rhs.size() and std::char_traits<char>::compare(lhs.data(), rhs.data(), lhs.size()) == 0;
+	}
+	friend constexpr std::strong_ordering operator<=>(string const & lhs, string const & rhs) {
+		if (!std::is_constant_evaluated() and !lhs.is_large() and !rhs.is_large()) {
+			return small_buffer_compare<small_buffer_capacity>(lhs.u_.small.data, lhs.size(), rhs.u_.small.data, rhs.size());
+		}
+		return compare(lhs.data(), lhs.size(), rhs.data(), rhs.size());
+	}
+
+	// Requires size() <= short_hash_size
+	constexpr short_hash_words hash_words() const {
+		if (!std::is_constant_evaluated() and !is_large()) {
+			return small_buffer_words<small_buffer_capacity>(u_.small.data);
+		}
+		return padded_words(data(), size());
+	}
+	constexpr std::size_t hash() const {
+		if (size() <= short_hash_size) {
+			return hash_short(hash_words(), size());
+		}
+		if (std::is_constant_evaluated()) {
+			return hash_long(data(), size());
+		}
+		return cached_hash(u_.large.data, u_.large.size);
+	}
+};
+
+template<typename Allocator>
+string(Allocator) -> string<Allocator>;
+
+template<typename Allocator>
+struct std::hash<::string<Allocator>> {
+	constexpr std::size_t operator()(::string<Allocator> const & str) const {
+		return str.hash();
+	}
+};
+
+
+// Each slot has a control byte, which is either empty, deleted, or the low 7
+// bits of the hash of the key in the slot. Slots are probed a group of 16 at a
+// time, so a lookup usually compares one group of control bytes and then one
+// key.
+enum class control : signed char {
+	empty = -128,
+	deleted = -2,
+};
+
+constexpr signed char to_byte(control const value) {
+	return static_cast<signed char>(value);
+}
+
+constexpr bool is_full(signed char const byte) {
+	return byte >= 0;
+}
+
+constexpr std::size_t group_size = 16;
+
+// Bit n is set for the nth control byte in a group that matches
+class group_mask {
+public:
+	constexpr explicit group_mask(std::uint32_t const bits):
+		bits_(bits)
+	{
+	}
+	constexpr explicit operator bool() const {
+		return bits_ != 0;
+	}
+	constexpr std::size_t lowest() const {
+		return static_cast<std::size_t>(std::countr_zero(bits_));
+	}
+	constexpr void clear_lowest() {
+		bits_ &= bits_ - 1;
+	}
+private:
+	std::uint32_t bits_;
+};
+
+class group {
+public:
+	constexpr explicit group(signed char const * const control):
+		control_(control)
+	{
+	}
+
+	constexpr group_mask match(signed char const fingerprint) const {
+		if (std::is_constant_evaluated()) {
+			return scalar_mask([=](signed char const byte) { return byte == fingerprint; });
+		}
+#if defined(__x86_64__)
+		return group_mask(movemask(_mm_cmpeq_epi8(load(), _mm_set1_epi8(fingerprint))));
+#else
+		return scalar_mask([=](signed char const byte) { return byte == fingerprint; });
+#endif
+	}
+	constexpr group_mask match_empty() const {
+		return match(to_byte(control::empty));
+	}
+	// Both special values are less than -1, and a full slot is at least 0
+	constexpr group_mask match_empty_or_deleted() const {
+		if (std::is_constant_evaluated()) {
+			return scalar_mask([](signed char const byte) { return !is_full(byte); });
+		}
+#if defined(__x86_64__)
+		return group_mask(movemask(_mm_cmpgt_epi8(_mm_set1_epi8(-1), load())));
+#else
+		return scalar_mask([](signed char const byte) { return !is_full(byte); });
+#endif
+	}
+
+private:
+	constexpr group_mask scalar_mask(auto const predicate) const {
+		auto result = std::uint32_t(0);
+		for (std::size_t n = 0; n != group_size; ++n) {
+			result |= std::uint32_t(predicate(control_[n])) << n;
+		}
+		return group_mask(result);
+	}
+#if defined(__x86_64__)
+	__m128i load() const {
+		return _mm_loadu_si128(reinterpret_cast<__m128i const *>(control_));
+	}
+	static std::uint32_t movemask(__m128i const value) {
+		return static_cast<std::uint32_t>(_mm_movemask_epi8(value));
+	}
+#endif
+
+	signed char const * control_;
+};
+
+// The upper bits of the hash pick the first group, and the lowest 7 bits are
+// the fingerprint stored in the control byte.
+constexpr std::size_t first_group(std::size_t const hash) {
+	return hash >> 7;
+}
+constexpr signed char fingerprint(std::size_t const hash) {
+	return static_cast<signed char>(hash & 0x7f);
+}
+
+// An open-addressing hash map with string keys, in the style of abseil's
+// flat_hash_map. Keys are stored in the slot array as the clang layout, so a
+// key of up to 23 characters is in the slot itself and any key is 24 bytes.
+//
+// Lookup works with a key, a std::string_view, or a char const * without
+// building a string. All three hash the same way (see hash.cpp).
+//
+// The table is a power of two number of groups, and at most 7/8 of the slots
+// are in use. Probing visits groups in triangular order, which reaches every
+// group. Erasing from a group that has never been full just empties the slot,
+// because no probe has continued past that group. Otherwise the slot becomes
+// deleted, so that lookups keep probing past it.
+template<typename Value, typename Allocator = std::allocator<char>>
+class flat_string_map {
+public:
+	using key_type = string<Allocator>;
+	using mapped_type = Value;
+	using value_type = std::pair<key_type, Value>;
+	using size_type = std::size_t;
+	using allocator_type = Allocator;
+
+private:
+	using slot_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>;
+	using control_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<signed char>;
+
+	template<bool is_const>
+	class iterator_base {
+	public:
+		using value_type = flat_string_map::value_type;
+		using difference_type = std::ptrdiff_t;
+		using reference = std::conditional_t<is_const, value_type const &, value_type &>;
+		using pointer = std::conditional_t<is_const, value_type const *, value_type *>;
+		using iterator_category = std::forward_iterator_tag;
+
+		constexpr iterator_base() = default;
+		template<bool other_is_const> requires(is_const and !other_is_const)
+		constexpr iterator_base(iterator_base<other_is_const> const other):
+			control_(other.control_),
+			control_end_(other.control_end_),
+			slot_(other.slot_)
+		{
+		}
+
+		constexpr reference operator*() const {
+			return *slot_;
+		}
+		constexpr pointer operator->() const {
+			return slot_;
+		}
+		constexpr iterator_base & operator++() {
+			++control_;
+			++slot_;
+			skip_to_full();
+			return *this;
+		}
+		constexpr iterator_base operator++(int) {
+			auto const previous = *this;
+			++*this;
+			return previous;
+		}
+		friend constexpr bool operator==(iterator_base const lhs, iterator_base const rhs) {
+			return lhs.control_ == rhs.control_;
+		}
+
+	private:
+		friend flat_string_map;
+		friend iterator_base<true>;
+
+		constexpr iterator_base(signed char const * const control, signed char const * const control_end, pointer const slot):
+			control_(control),
+			control_end_(control_end),
+			slot_(slot)
+		{
+		}
+		constexpr void skip_to_full() {
+			while (control_ != control_end_ and !is_full(*control_)) {
+				++control_;
+				++slot_;
+			}
+		}
+
+		signed char const * control_ = nullptr;
+		signed char const * control_end_ = nullptr;
+		pointer slot_ = nullptr;
+	};
+
+public:
+	using iterator = iterator_base<false>;
+	using const_iterator = iterator_base<true>;
+
+	constexpr flat_string_map() = default;
+	constexpr explicit flat_string_map(allocator_type alloc):
+		allocator_(alloc)
+	{
+	}
+
+	constexpr flat_string_map(flat_string_map && other) noexcept:
+		allocator_(other.allocator_),
+		control_(std::exchange(other.control_, nullptr)),
+		slots_(std::exchange(other.slots_, nullptr)),
+		capacity_(std::exchange(other.capacity_, 0)),
+		size_(std::exchange(other.size_, 0)),
+		growth_left_(std::exchange(other.growth_left_, 0))
+	{
+	}
+	constexpr flat_string_map & operator=(flat_string_map && other) noexcept {
+		destroy_table();
+		allocator_ = other.allocator_;
+		control_ = std::exchange(other.control_, nullptr);
+		slots_ = std::exchange(other.slots_, nullptr);
+		capacity_ = std::exchange(other.capacity_, 0);
+		size_ = std::exchange(other.size_, 0);
+		growth_left_ = std::exchange(other.growth_left_, 0);
+		return *this;
+	}
+
+	constexpr ~flat_string_map() {
+		destroy_table();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr size_type size() const {
+		return size_;
+	}
+	constexpr bool empty() const {
+		return size_ == 0;
+	}
+	constexpr size_type capacity() const {
+		return capacity_;
+	}
+
+	constexpr iterator begin() {
+		auto result = iterator(control_, control_ + capacity_, slots_);
+		result.skip_to_full();
+		return result;
+	}
+	constexpr const_iterator begin() const {
+		auto result = const_iterator(control_, control_ + capacity_, slots_);
+		result.skip_to_full();
+		return result;
+	}
+	constexpr iterator end() {
+		return iterator(control_ + capacity_, control_ + capacity_, slots_ + capacity_);
+	}
+	constexpr const_iterator end() const {
+		return const_iterator(control_ + capacity_, control_ + capacity_, slots_ + capacity_);
+	}
+
+	constexpr iterator find(std::string_view const key) {
+		return to_iterator(find_index(key, hash_bytes(key.data(), key.size())));
+	}
+	constexpr const_iterator find(std::string_view const key) const {
+		return to_iterator(find_index(key, hash_bytes(key.data(), key.size())));
+	}
+	constexpr iterator find(key_type const & key) {
+		return to_iterator(find_index(key, key.hash()));
+	}
+	constexpr const_iterator find(key_type const & key) const {
+		return to_iterator(find_index(key, key.hash()));
+	}
+	constexpr bool contains(std::string_view const key) const {
+		return find(key) != end();
+	}
+	constexpr bool contains(key_type const & key) const {
+		return find(key) != end();
+	}
+
+	// Only builds a key_type if the key is not already in the map
+	template<typename... Args>
+	constexpr std::pair<iterator, bool> try_emplace(std::string_view const key, Args && ... args) {
+		return try_emplace_impl(key, hash_bytes(key.data(), key.size()), [&] {
+			return make_key(key);
+		}, std::forward<Args>(args)...);
+	}
+	template<typename... Args>
+	constexpr std::pair<iterator, bool> try_emplace(key_type && key, Args && ... args) {
+		return try_emplace_impl(key, key.hash(), [&] {
+			return std::move(key);
+		}, std::forward<Args>(args)...);
+	}
+	template<typename V>
+	constexpr std::pair<iterator, bool> insert_or_assign(std::string_view const key, V && value) {
+		auto result = try_emplace(key, std::forward<V>(value));
+		if (!result.second) {
+			result.first->second = std::forward<V>(value);
+		}
+		return result;
+	}
+	constexpr Value & operator[](std::string_view const key) {
+		return try_emplace(key).first->second;
+	}
+
+	constexpr iterator erase(iterator const position) {
+		erase_index(static_cast<std::size_t>(position.slot_ - slots_));
+		auto result = position;
+		result.skip_to_full();
+		return result;
+	}
+	constexpr size_type erase(std::string_view const key) {
+		auto const index = find_index(key, hash_bytes(key.data(), key.size()));
+		if (index == capacity_) {
+			return 0;
+		}
+		erase_index(index);
+		return 1;
+	}
+
+	constexpr void clear() {
+		for (std::size_t n = 0; n != capacity_; ++n) {
+			if (is_full(control_[n])) {
+				std::destroy_at(slots_ + n);
+				control_[n] = to_byte(control::empty);
+			}
+		}
+		size_ = 0;
+		growth_left_ = max_load(capacity_);
+	}
+
+	constexpr void reserve(size_type const count) {
+		if (count > size_ + growth_left_) {
+			rehash(std::bit_ceil(std::max(count + count / 7, group_size)));
+		}
+	}
+
+private:
+	static constexpr std::size_t max_load(std::size_t const capacity) {
+		return capacity - capacity / 8;
+	}
+
+	constexpr std::size_t group_count() const {
+		return capacity_ / group_size;
+	}
+
+	// Returns capacity_ if the key is not in the map
+	constexpr std::size_t find_index(auto const & key, std::size_t const hash) const {
+		if (capacity_ == 0) {
+			return capacity_;
+		}
+		auto const mask = group_count() - 1;
+		auto index = first_group(hash) & mask;
+		for (std::size_t step = 1; ; ++step) {
+			auto const g = group(control_ + index * group_size);
+			for (auto matches = g.match(fingerprint(hash)); matches; matches.clear_lowest()) {
+				auto const slot = index * group_size + matches.lowest();
+				if (keys_equal(slots_[slot].first, key)) {
+					return slot;
+				}
+			}
+			if (g.match_empty()) {
+				return capacity_;
+			}
+			index = (index + step) & mask;
+		}
+	}
+
+	// Requires a slot that is empty or deleted, which the load factor
+	// guarantees
+	constexpr std::size_t find_insert_index(std::size_t const hash) const {
+		auto const mask = group_count() - 1;
+		auto index = first_group(hash) & mask;
+		for (std::size_t step = 1; ; ++step) {
+			if (auto const available = group(control_ + index * group_size).match_empty_or_deleted()) {
+				return index * group_size + available.lowest();
+			}
+			index = (index + step) & mask;
+		}
+	}
+
+	static constexpr bool keys_equal(key_type const & lhs, key_type const & rhs) {
+		return lhs == rhs;
+	}
+	static constexpr bool keys_equal(key_type const & lhs, std::string_view const rhs) {
+		return lhs.size() == rhs.size() and std::char_traits<char>::compare(lhs.data(), rhs.data(), rhs.size()) == 0;
+	}
+
+	constexpr key_type make_key(std::string_view const source) const {
+		auto result = key_type(allocator_);
+		result.reserve(source.size());
+		for (char const c : source) {
+			result.insert(result.end(), c);
+		}
+		return result;
+	}
+
+	constexpr iterator to_iterator(std::size_t const index) {
+		return iterator(control_ + index, control_ + capacity_, slots_ + index);
+	}
+	constexpr const_iterator to_iterator(std::size_t const index) const {
+		return const_iterator(control_ + index, control_ + capacity_, slots_ + index);
+	}
+
+	template<typename... Args>
+	constexpr std::pair<iterator, bool> try_emplace_impl(auto const & key, std::size_t const hash, auto && build_key, Args && ... args) {
+		if (auto const index = find_index(key, hash); index != capacity_) {
+			return {to_iterator(index), false};
+		}
+		if (growth_left_ == 0) {
+			grow();
+		}
+		auto const index = find_insert_index(hash);
+		if (control_[index] == to_byte(control::empty)) {
+			--growth_left_;
+		}
+		std::construct_at(slots_ + index, std::piecewise_construct, std::forward_as_tuple(build_key()), std::forward_as_tuple(std::forward<Args>(args)...));
+		control_[index] = fingerprint(hash);
+		++size_;
+		return {to_iterator(index), true};
+	}
+
+	constexpr void erase_index(std::size_t const index) {
+		std::destroy_at(slots_ + index);
+		auto const group_start = index / group_size * group_size;
+		if (group(control_ + group_start).match_empty()) {
+			control_[index] = to_byte(control::empty);
+			++growth_left_;
+		} else {
+			control_[index] = to_byte(control::deleted);
+		}
+		--size_;
+	}
+
+	// When most of the unusable slots are deleted rather than full, rebuilding
+	// at the same size is enough.
+	constexpr void grow() {
+		if (capacity_ == 0) {
+			rehash(group_size);
+		} else if (size_ > max_load(capacity_) / 2) {
+			rehash(capacity_ * 2);
+		} else {
+			rehash(capacity_);
+		}
+	}
+
+	// Keys move without being rehashed when they have a cached hash. Both new
+	// arrays are allocated before the map gives up the old ones, so if either
+	// allocation throws, the map is unchanged.
+	constexpr void rehash(std::size_t const new_capacity) {
+		assert(new_capacity % group_size == 0 and std::has_single_bit(new_capacity));
+		auto control_alloc = control_allocator(allocator_);
+		auto const new_control = std::allocator_traits<control_allocator>::allocate(control_alloc, new_capacity);
+		auto slot_alloc = slot_allocator(allocator_);
+		auto new_slots = static_cast<value_type *>(nullptr);
+		try {
+			new_slots = std::allocator_traits<slot_allocator>::allocate(slot_alloc, new_capacity);
+		} catch (...) {
+			std::allocator_traits<control_allocator>::deallocate(control_alloc, new_control, new_capacity);
+			throw;
+		}
+		std::fill_n(new_control, new_capacity, to_byte(control::empty));
+
+		auto old = flat_string_map(allocator_);
+		std::swap(old.control_, control_);
+		std::swap(old.slots_, slots_);
+		std::swap(old.capacity_, capacity_);
+		std::swap(old.size_, size_);
+		control_ = new_control;
+		slots_ = new_slots;
+		capacity_ = new_capacity;
+		growth_left_ = max_load(new_capacity);
+
+		for (std::size_t n = 0; n != old.capacity_; ++n) {
+			if (!is_full(old.control_[n])) {
+				continue;
+			}
+			auto & element = old.slots_[n];
+			auto const hash = element.first.hash();
+			auto const index = find_insert_index(hash);
+			std::construct_at(slots_ + index, std::move(element));
+			control_[index] = fingerprint(hash);
+			--growth_left_;
+			++size_;
+		}
+	}
+
+	constexpr void destroy_table() {
+		if (capacity_ == 0) {
+			return;
+		}
+		for (std::size_t n = 0; n != capacity_; ++n) {
+			if (is_full(control_[n])) {
+				std::destroy_at(slots_ + n);
+			}
+		}
+		auto control_alloc = control_allocator(allocator_);
+		std::allocator_traits<control_allocator>::deallocate(control_alloc, control_, capacity_);
+		auto slot_alloc = slot_allocator(allocator_);
+		std::allocator_traits<slot_allocator>::deallocate(slot_alloc, slots_, capacity_);
+		control_ = nullptr;
+		slots_ = nullptr;
+		capacity_ = 0;
+		size_ = 0;
+		growth_left_ = 0;
+	}
+
+	[[no_unique_address]] allocator_type allocator_;
+	signed char * control_ = nullptr;
+	value_type * slots_ = nullptr;
+	std::size_t capacity_ = 0;
+	std::size_t size_ = 0;
+	std::size_t growth_left_ = 0;
+};
+
+constexpr bool test() {
+	auto map = flat_string_map<int>();
+	assert(map.empty());
+	assert(map.find("a") == map.end());
+
+	auto const long_key = std::string_view("a key that is too long for the small buffer");
+	assert(map.try_emplace("a", 1).second);
+	assert(map.try_emplace(long_key, 2).second);
+	assert(!map.try_emplace("a", 3).second);
+	assert(map.find("a")->second == 1);
+	assert(map.find(long_key)->second == 2);
+	assert(map.contains(map.find(long_key)->first));
+
+	map.insert_or_assign("a", 4);
+	assert(map["a"] == 4);
+	assert(map["b"] == 0);
+	assert(map.size() == 3);
+
+	for (int n = 0; n != 100; ++n) {
+		char const key[] = {'k', static_cast<char>('0' + n / 10), static_cast<char>('0' + n % 10), '\0'};
+		map[key] = n;
+	}
+	assert(map.size() == 103);
+	assert(map.find("k42")->second == 42);
+
+	assert(map.erase("k42") == 1);
+	assert(map.erase("k42") == 0);
+	assert(!map.contains("k42"));
+	assert(map.size() == 102);
+
+	auto count = std::size_t(0);
+	for (auto const & element : std::as_const(map)) {
+		assert(element.first.size() != 0);
+		++count;
+	}
+	assert(count == map.size());
+
+	for (auto it = map.begin(); it != map.end(); ) {
+		it = it->second % 2 == 0 ? map.erase(it) : std::next(it);
+	}
+	assert(!map.contains("k10"));
+	assert(map.contains("k11"));
+
+	auto moved = std::move(map);
+	assert(moved.contains("k11"));
+	moved.clear();
+	assert(moved.empty());
+	assert(!moved.contains("k11"));
+
+	// Inserting at the front of a key, including each time that reallocates
+	auto front = string(std::allocator<char>());
+	for (std::size_t n = 0; n != 100; ++n) {
+		front.insert(front.begin(), static_cast<char>('0' + n % 10));
+	}
+	for (std::size_t n = 0; n != front.size(); ++n) {
+		assert(front.data()[n] == static_cast<char>('0' + (99 - n) % 10));
+	}
+
+	return true;
+}
+
+// Runs random inserts, lookups, and erases against std::unordered_map, with
+// a small key space so that slots are reused after being deleted.
+void test_against_unordered_map() {
+	auto engine = std::minstd_rand(1);
+	auto random_key = [&] {
+		auto const size = std::uniform_int_distribution<std::size_t>(0, 40)(engine);
+		auto result = std::string(size, 'x');
+		result.front() = static_cast<char>(std::uniform_int_distribution(0, 50)(engine));
+		return result;
+	};
+	auto map = flat_string_map<int>();
+	auto expected = std::unordered_map<std::string, int>();
+	for (int n = 0; n != 200'000; ++n) {
+		auto const key = random_key();
+		switch (std::uniform_int_distribution(0, 3)(engine)) {
+			case 0:
+				assert(map.try_emplace(key, n).second == expected.try_emplace(key, n).second);
+				break;
+			case 1:
+				map.insert_or_assign(key, n);
+				expected.insert_or_assign(key, n);
+				break;
+			case 2:
+				assert(map.erase(key) == expected.erase(key));
+				break;
+			default: {
+				auto const it = map.find(key);
+				auto const expected_it = expected.find(key);
+				assert((it == map.end()) == (expected_it == expected.end()));
+				assert(it == map.end() or it->second == expected_it->second);
+				break;
+			}
+		}
+		assert(map.size() == expected.size());
+	}
+	for (auto const & [key, value] : map) {
+		assert(expected.at(std::string(key.data(), key.size())) == value);
+	}
+}
+
+struct transparent_hash {
+	using is_transparent = void;
+	std::size_t operator()(std::string_view const str) const {
+		return std::hash<std::string_view>()(str);
+	}
+};
+
+template<typename Function>
+double nanoseconds_per_operation(std::size_t const count, Function && function) {
+	auto const start = std::chrono::steady_clock::now();
+	function();
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+}
+
+// Builds each map from the same keys and looks every key up by
+// std::string_view, in a random order so that lookups miss the cache.
+void benchmark() {
+	auto engine = std::minstd_rand(1);
+	auto run = [&](char const * const name, std::size_t const count, std::size_t const min_size, std::size_t const max_size) {
+		auto keys = std::vector<std::string>(count);
+		for (auto & key : keys) {
+			key.resize(std::uniform_int_distribution(min_size, max_size)(engine));
+			for (char & c : key) {
+				c = static_cast<char>(std::uniform_int_distribution(32, 126)(engine));
+			}
+		}
+		auto lookups = std::vector<std::string_view>(keys.begin(), keys.end());
+		std::shuffle(lookups.begin(), lookups.end(), engine);
+
+		auto sink = 0;
+		auto flat = flat_string_map<int>();
+		auto const flat_insert = nanoseconds_per_operation(count, [&] {
+			for (auto const & key : keys) {
+				flat.try_emplace(key, 1);
+			}
+		});
+		auto const flat_find = nanoseconds_per_operation(count, [&] {
+			for (auto const key : lookups) {
+				sink += flat.find(key)->second;
+			}
+		});
+
+		auto node = std::unordered_map<std::string, int, transparent_hash, std::equal_to<>>();
+		auto const node_insert = nanoseconds_per_operation(count, [&] {
+			for (auto const & key : keys) {
+				node.try_emplace(key, 1);
+			}
+		});
+		auto const node_find = nanoseconds_per_operation(count, [&] {
+			for (auto const key : lookups) {
+				sink += node.find(key)->second;
+			}
+		});
+		std::printf("%-20s %14.1f %14.1f %14.1f %14.1f\n", name, node_insert, flat_insert, node_find, flat_find);
+		assert(sink == static_cast<int>(2 * count));
+	};
+	std::printf("%-20s %14s %14s %14s %14s   (ns per operation)\n", "characters", "unordered ins", "flat ins", "unordered find", "flat find");
+	for (auto const count : {std::size_t(10'000), std::size_t(1'000'000)}) {
+		std::printf("%zu keys\n", count);
+		run("4 to 16", count, 4, 16);
+		run("24 to 64", count, 24, 64);
+	}
+}
+
+int main() {
+	test();
+	static_assert(test());
+	test_against_unordered_map();
+	benchmark();
+}
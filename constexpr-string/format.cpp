@@ -0,0 +1,1380 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is to format into both
+// layouts with at most one allocation, and none when the result fits in the
+// small buffer.
+//
+// format_to(target, format, args...) appends to target. It takes one pass
+// over the arguments to work out the exact size of the result, and then
+// append_and_overwrite from append-number.cpp grows target once if needed
+// and the second pass writes straight into it. The format string is parsed
+// and checked against the types of the arguments at compile time, like
+// std::format_string.
+//
+// The standard library that this was tested with does not have <format>
+// yet, so this has its own formatter with a small part of the std::format
+// syntax: {}, {{, }}, and a spec of [0][width][.precision][type] with type d,
+// x, or f. Floating point arguments use std::to_chars, which is not
+// constexpr, so only the rest works in constant evaluation.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+// char is trivial, so outside of constant evaluation the characters can be
+// copied with memcpy instead of being constructed one at a time
+template<typename Allocator>
+constexpr char * copy_characters(Allocator alloc, char const * const first, char const * const last, char * const out) {
+	if (std::is_constant_evaluated()) {
+		return uninitialized_copy(alloc, first, last, out);
+	}
+	auto const count = static_cast<std::size_t>(last - first);
+	if (count != 0) {
+		std::memcpy(out, first, count);
+	}
+	return out + count;
+}
+
+
+namespace clang {
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	static constexpr std::size_t small_buffer_capacity = 23;
+
+	struct small_t {
+		char data[small_buffer_capacity] = {};
+	};
+	struct [[gnu::packed]] large_t {
+		static constexpr std::size_t bytes_remaining = 7;
+
+		template<typename It>
+		class range_view {
+		public:
+			constexpr range_view(It first, It last):
+				first_(first),
+				last_(last)
+			{
+			}
+			constexpr auto begin() const {
+				return first_;
+			}
+			constexpr auto end() const {
+				return last_;
+			}
+		private:
+			It first_;
+			It last_;
+		};
+
+		constexpr auto little_endian_capacity() const {
+			return range_view(
+				std::rbegin(rest_of_capacity),
+				std::rend(rest_of_capacity)
+			);
+		}
+		constexpr auto big_endian_capacity() {
+			return range_view(
+				std::begin(rest_of_capacity),
+				std::end(rest_of_capacity)
+			);
+		}
+
+		constexpr large_t(std::size_t set_size, std::size_t capacity, char * pointer) noexcept:
+			rest_of_capacity{},
+			size(set_size),
+			data(pointer)
+		{
+			assert(data != nullptr);
+			for (unsigned char & byte : big_endian_capacity()) {
+				capacity >>= CHAR_BIT;
+				byte = capacity;
+			}
+		}
+
+		unsigned char rest_of_capacity[bytes_remaining];
+		std::size_t size;
+		char * data;
+	};
+
+	[[no_unique_address]] allocator_type allocator_;
+	unsigned char size_or_first_byte_of_capacity_;
+	union U {
+		constexpr U() noexcept:
+			small{}
+		{
+		}
+		explicit constexpr U(std::size_t size, std::size_t capacity, char * data) noexcept:
+			large(size, capacity, data)
+		{
+		}
+		constexpr U(large_t set_large) noexcept:
+			large(set_large)
+		{
+		}
+
+		small_t small;
+		large_t large;
+	} u_;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return size_or_first_byte_of_capacity_ & 1;
+	}
+
+	constexpr void increment_size() {
+		if (is_large()) {
+			++u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ += (1 << 1);
+		}
+	}
+	constexpr void set_size(std::size_t const new_size) {
+		if (is_large()) {
+			u_.large.size = new_size;
+		} else {
+			size_or_first_byte_of_capacity_ = static_cast<unsigned char>(new_size << 1);
+		}
+	}
+	constexpr void decrement_size() {
+		if (is_large()) {
+			--u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ -= (1 << 1);
+		}
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, u_.large.data, capacity());
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(size(), new_capacity, new_data);
+		assert(new_capacity & 1);
+		size_or_first_byte_of_capacity_ = new_capacity;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		new_capacity |= 1;
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy_characters(alloc, data(), data() + size(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		size_or_first_byte_of_capacity_(0),
+		u_{}
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.large);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+
+			other.u_ = U{};
+			other.size_or_first_byte_of_capacity_ = 0;
+		} else {
+			auto & osmall = other.u_.small;
+			u_ = U{};
+			copy(osmall.data, osmall.data + (other.size_or_first_byte_of_capacity_ >> 1), u_.small.data);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr char * data() {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr std::size_t size() const {
+		return is_large() ? u_.large.size : (size_or_first_byte_of_capacity_ >> 1);
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		if (!is_large()) {
+			return small_buffer_capacity;
+		}
+		// The bytes after the first are the rest of the capacity in
+		// little-endian order, so on a little-endian target this is one load
+		// instead of a loop. append_and_overwrite checks the capacity for
+		// every number.
+		if (!std::is_constant_evaluated() and std::endian::native == std::endian::little) {
+			auto rest = std::size_t(0);
+			std::memcpy(&rest, u_.large.rest_of_capacity, large_t::bytes_remaining);
+			return (rest << CHAR_BIT) | size_or_first_byte_of_capacity_;
+		}
+		std::size_t result = 0;
+		for (unsigned char const byte : u_.large.little_endian_capacity()) {
+			result |= byte;
+			result <<= CHAR_BIT;
+		}
+		result |= size_or_first_byte_of_capacity_;
+		return result;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		auto const local_size = size();
+		if (is_large() && capacity() > (local_size | 1)) {
+			if (local_size > small_buffer_capacity) {
+				force_reserve(local_size);
+			} else {
+				auto const data = u_.large.data;
+				auto const original_capacity = capacity();
+				u_ = U{};
+				size_or_first_byte_of_capacity_ = local_size << 1;
+				copy(data, data + local_size, u_.small.data);
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = std::prev(end());
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = (capacity() * growth_factor) | 1;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+
+			relocate(temp, new_capacity);
+		}
+		increment_size();
+		return begin() + offset;
+	}
+
+	// Range append, which the proposal leaves out for brevity. A reallocation
+	// at least doubles the capacity, like insert, and copies the old
+	// characters and the new ones straight into place. That also makes it
+	// safe to append part of the string to itself.
+	constexpr void append(char const * const first, char const * const last) {
+		auto const new_size = size() + static_cast<std::size_t>(last - first);
+		auto alloc = get_allocator();
+		if (new_size <= capacity()) {
+			copy_characters(alloc, first, last, end());
+		} else {
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = std::max(new_size, capacity() * growth_factor) | 1;
+			char * temp = Alloc::allocate(alloc, new_capacity);
+			copy_characters(alloc, first, last, copy_characters(alloc, data(), data() + size(), temp));
+			relocate(temp, new_capacity);
+		}
+		set_size(new_size);
+	}
+
+	// Makes room for up to max_count more characters, then operation writes
+	// characters starting at the end and returns where it stopped. This is
+	// like resize_and_overwrite, except that it keeps what is already there.
+	template<typename Operation>
+	constexpr void append_and_overwrite(std::size_t const max_count, Operation operation) {
+		auto const required = size() + max_count;
+		if (required > capacity()) {
+			constexpr auto growth_factor = std::size_t{2};
+			force_reserve(std::max(required, capacity() * growth_factor));
+		}
+		char * const last = operation(end());
+		set_size(static_cast<std::size_t>(last - begin()));
+	}
+
+	constexpr void pop_back() {
+		decrement_size();
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace clang
+
+namespace gcc {
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	[[no_unique_address]] allocator_type allocator_;
+	// This could be set to 8 to reduce the size of our string to 24 bytes
+	// (just like clang), but 7 characters (plus a null terminator) is likely
+	// too small of a buffer for most users.
+	static constexpr std::size_t small_buffer_capacity = 16;
+	union U{
+		constexpr U():
+			buffer{}
+		{
+		}
+		constexpr U(std::size_t c):
+			capacity(c)
+		{
+		}
+
+		char buffer[small_buffer_capacity];
+		std::size_t capacity;
+	} u_;
+	char * data_;
+	std::size_t size_ : 63;
+	// gcc and MSVC do not allow accessing the inactive member of a union just
+	// to get its address, so we use a bitfield to work around this.
+	bool is_large_ : 1;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return is_large_;
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, data_, u_.capacity);
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(new_capacity);
+		data_ = new_data;
+		is_large_ = true;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy_characters(alloc, data(), data() + size(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_{},
+		data_(u_.buffer),
+		size_(0),
+		is_large_(false)
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.capacity);
+			other.u_ = U{};
+		
+			data_ = other.data_;
+			other.data_ = other.u_.buffer;
+		
+			size_ = other.size_;
+			other.size_ = 0U;
+		
+			is_large_ = true;
+			other.is_large_ = false;
+
+		} else {
+			u_ = U{};
+			copy(other.data_, other.data_ + other.size_, u_.buffer);
+			data_ = u_.buffer;
+			size_ = other.size_;
+			is_large_ = false;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return data_;
+	}
+	constexpr char * data() {
+		return data_;
+	}
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		return is_large() ? u_.capacity : small_buffer_capacity;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		if (is_large() && capacity() > size()) {
+			if (size() > small_buffer_capacity) {
+				force_reserve(size());
+			} else {
+				auto const data = data_;
+				auto const original_capacity = u_.capacity;
+				u_ = U{};
+				copy(data, data + size_, u_.buffer);
+				data_ = u_.buffer;
+				is_large_ = false;
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = end() - 1;
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = capacity() * growth_factor;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+		
+			relocate(temp, new_capacity);
+		}
+		++size_;
+		return begin() + offset;
+	}
+
+	// Range append, which the proposal leaves out for brevity. A reallocation
+	// at least doubles the capacity, like insert, and copies the old
+	// characters and the new ones straight into place. That also makes it
+	// safe to append part of the string to itself.
+	constexpr void append(char const * const first, char const * const last) {
+		auto const new_size = size() + static_cast<std::size_t>(last - first);
+		auto alloc = get_allocator();
+		if (new_size <= capacity()) {
+			copy_characters(alloc, first, last, end());
+		} else {
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = std::max(new_size, capacity() * growth_factor);
+			char * temp = Alloc::allocate(alloc, new_capacity);
+			copy_characters(alloc, first, last, copy_characters(alloc, data(), data() + size(), temp));
+			relocate(temp, new_capacity);
+		}
+		size_ = new_size;
+	}
+
+	// Makes room for up to max_count more characters, then operation writes
+	// characters starting at the end and returns where it stopped. This is
+	// like resize_and_overwrite, except that it keeps what is already there.
+	template<typename Operation>
+	constexpr void append_and_overwrite(std::size_t const max_count, Operation operation) {
+		auto const required = size() + max_count;
+		if (required > capacity()) {
+			constexpr auto growth_factor = std::size_t{2};
+			force_reserve(std::max(required, capacity() * growth_factor));
+		}
+		char * const last = operation(end());
+		size_ = static_cast<std::size_t>(last - begin());
+	}
+
+	constexpr void pop_back() {
+		--size_;
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace gcc
+
+
+template<typename T>
+constexpr bool is_prototype_string = false;
+template<typename Allocator>
+constexpr bool is_prototype_string<clang::string<Allocator>> = true;
+template<typename Allocator>
+constexpr bool is_prototype_string<gcc::string<Allocator>> = true;
+
+template<typename T>
+concept prototype_string = is_prototype_string<T>;
+
+template<typename T>
+constexpr std::string_view as_view(T const & value) {
+	if constexpr (prototype_string<T>) {
+		return std::string_view(value.data(), value.size());
+	} else {
+		return std::string_view(value);
+	}
+}
+
+// One {} in a format string, and the text before it. The text can contain
+// {{ and }}, which stand for { and }.
+//
+// The format spec is a small part of what std::format accepts:
+// [0][width][.precision][type], where type is d, x, or f. A 0 pads a number
+// with zeros after its sign. Otherwise numbers are padded with spaces on the
+// left, and strings on the right. A precision needs type f.
+struct replacement_field {
+	std::size_t text_begin = 0;
+	std::size_t text_end = 0;
+	bool text_has_escapes = false;
+	std::size_t width = 0;
+	bool zero_pad = false;
+	int precision = -1;
+	char type = '\0';
+};
+
+constexpr auto max_precision = 99;
+
+// Splits a format string into its replacement fields and the text after the
+// last of them. Anything that is not valid throws, which makes it a compile
+// error when this runs in the constructor of format_string.
+template<std::size_t count>
+struct parsed_format {
+	constexpr explicit parsed_format(std::string_view const format) {
+		auto position = std::size_t(0);
+		auto text_begin = std::size_t(0);
+		auto has_escapes = false;
+		auto field_index = std::size_t(0);
+		auto digits = [&](std::size_t & value) {
+			value = 0;
+			for (; position != format.size() and '0' <= format[position] and format[position] <= '9'; ++position) {
+				value = value * 10 + static_cast<std::size_t>(format[position] - '0');
+			}
+		};
+		while (position != format.size()) {
+			auto const c = format[position];
+			if (c == '}') {
+				if (position + 1 == format.size() or format[position + 1] != '}') {
+					throw std::logic_error("A } must be written as }}");
+				}
+				has_escapes = true;
+				position += 2;
+				continue;
+			}
+			if (c != '{') {
+				++position;
+				continue;
+			}
+			if (position + 1 != format.size() and format[position + 1] == '{') {
+				has_escapes = true;
+				position += 2;
+				continue;
+			}
+			if (field_index == count) {
+				throw std::logic_error("More replacement fields than arguments");
+			}
+			auto & field = fields[field_index];
+			field.text_begin = text_begin;
+			field.text_end = position;
+			field.text_has_escapes = has_escapes;
+			++position;
+			if (position != format.size() and format[position] == ':') {
+				++position;
+				if (position != format.size() and format[position] == '0') {
+					field.zero_pad = true;
+					++position;
+				}
+				digits(field.width);
+				if (position != format.size() and format[position] == '.') {
+					++position;
+					auto precision = std::size_t(0);
+					auto const start = position;
+					digits(precision);
+					if (position == start or precision > max_precision) {
+						throw std::logic_error("A precision must be a number from 0 to 99");
+					}
+					field.precision = static_cast<int>(precision);
+				}
+				if (position != format.size() and format[position] != '}') {
+					field.type = format[position];
+					if (field.type != 'd' and field.type != 'x' and field.type != 'f') {
+						throw std::logic_error("The only types are d, x, and f");
+					}
+					++position;
+				}
+				if (field.precision != -1 and field.type != 'f') {
+					throw std::logic_error("A precision needs type f");
+				}
+			}
+			if (position == format.size() or format[position] != '}') {
+				throw std::logic_error("A replacement field must end with }");
+			}
+			++position;
+			++field_index;
+			text_begin = position;
+			has_escapes = false;
+		}
+		if (field_index != count) {
+			throw std::logic_error("Fewer replacement fields than arguments");
+		}
+		last_text_begin = text_begin;
+		last_text_has_escapes = has_escapes;
+	}
+
+	std::array<replacement_field, count> fields;
+	std::size_t last_text_begin = 0;
+	bool last_text_has_escapes = false;
+};
+
+// Like std::format_string: constructing one from a string literal parses it
+// during constant evaluation and checks it against the types of the
+// arguments, so a mistake is a compile error instead of an exception.
+template<typename... Args>
+class format_string {
+public:
+	template<typename T> requires std::convertible_to<T const &, std::string_view>
+	consteval format_string(T const & format):
+		format_(format),
+		parsed_(format_)
+	{
+		auto index = std::size_t(0);
+		(check_type<Args>(parsed_.fields[index++].type), ...);
+	}
+
+	constexpr std::string_view get() const {
+		return format_;
+	}
+	constexpr parsed_format<sizeof...(Args)> const & parsed() const {
+		return parsed_;
+	}
+
+private:
+	template<typename Arg>
+	static consteval void check_type(char const type) {
+		if (type == 'f' and !std::floating_point<Arg>) {
+			throw std::logic_error("Type f needs a floating point argument");
+		}
+		if ((type == 'd' or type == 'x') and !(std::integral<Arg> and !std::same_as<Arg, char>)) {
+			throw std::logic_error("Types d and x need an integer argument");
+		}
+	}
+
+	std::string_view format_;
+	parsed_format<sizeof...(Args)> parsed_;
+};
+
+// The size of the text once {{ and }} are replaced
+constexpr std::size_t text_size(std::string_view const text, bool const has_escapes) {
+	if (!has_escapes) {
+		return text.size();
+	}
+	auto result = text.size();
+	for (std::size_t n = 0; n + 1 < text.size(); ++n) {
+		if ((text[n] == '{' or text[n] == '}') and text[n + 1] == text[n]) {
+			--result;
+			++n;
+		}
+	}
+	return result;
+}
+
+constexpr char * write_text(char * out, std::string_view const text, bool const has_escapes) {
+	if (!has_escapes) {
+		return copy_characters(std::allocator<char>(), text.data(), text.data() + text.size(), out);
+	}
+	for (std::size_t n = 0; n != text.size(); ++n) {
+		*out = text[n];
+		++out;
+		if ((text[n] == '{' or text[n] == '}') and n + 1 != text.size() and text[n + 1] == text[n]) {
+			++n;
+		}
+	}
+	return out;
+}
+
+template<typename Unsigned>
+constexpr std::size_t digit_count(Unsigned value, Unsigned const base) {
+	auto result = std::size_t(1);
+	// Division by a constant is a multiplication, so base 10 gets its own
+	// loop, which also handles four digits at a time
+	if (base == 10) {
+		while (true) {
+			if (value < 10) {
+				return result;
+			}
+			if (value < 100) {
+				return result + 1;
+			}
+			if (value < 1000) {
+				return result + 2;
+			}
+			if (value < 10000) {
+				return result + 3;
+			}
+			value /= 10000;
+			result += 4;
+		}
+	}
+	for (; value >= base; value /= base) {
+		++result;
+	}
+	return result;
+}
+
+constexpr char decimal_pairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+// Writes the digits of value so that they end at last
+template<typename Unsigned>
+constexpr void write_digits(char * last, Unsigned value, Unsigned const base) {
+	if (base != 10) {
+		do {
+			--last;
+			*last = "0123456789abcdef"[value % base];
+			value /= base;
+		} while (value != 0);
+		return;
+	}
+	while (value >= 100) {
+		auto const pair = static_cast<std::size_t>(value % 100) * 2;
+		value /= 100;
+		last -= 2;
+		last[0] = decimal_pairs[pair];
+		last[1] = decimal_pairs[pair + 1];
+	}
+	if (value >= 10) {
+		auto const pair = static_cast<std::size_t>(value) * 2;
+		last -= 2;
+		last[0] = decimal_pairs[pair];
+		last[1] = decimal_pairs[pair + 1];
+	} else {
+		--last;
+		*last = static_cast<char>('0' + value);
+	}
+}
+
+// Everything about one argument that is needed to know its size, so that
+// the second pass only writes. Floating point numbers are formatted in the
+// first pass into a buffer on the stack, since their size is not known
+// otherwise.
+template<typename T>
+struct prepared_argument;
+
+template<typename T> requires(prototype_string<T> or std::convertible_to<T const &, std::string_view>)
+struct prepared_argument<T> {
+	constexpr prepared_argument(T const & value, replacement_field const &):
+		view(as_view(value))
+	{
+	}
+	constexpr std::size_t size() const {
+		return view.size();
+	}
+	constexpr char * write(char * const out) const {
+		return copy_characters(std::allocator<char>(), view.data(), view.data() + view.size(), out);
+	}
+	static constexpr bool right_align = false;
+
+	std::string_view view;
+};
+
+template<>
+struct prepared_argument<char> {
+	constexpr prepared_argument(char const value, replacement_field const &):
+		value(value)
+	{
+	}
+	static constexpr std::size_t size() {
+		return 1;
+	}
+	constexpr char * write(char * const out) const {
+		*out = value;
+		return out + 1;
+	}
+	static constexpr bool right_align = false;
+
+	char value;
+};
+
+template<std::integral Integer> requires(!std::same_as<Integer, char> and !std::same_as<Integer, bool>)
+struct prepared_argument<Integer> {
+	using unsigned_type = std::make_unsigned_t<Integer>;
+
+	constexpr prepared_argument(Integer const value, replacement_field const & field):
+		negative(value < 0),
+		// Negating as unsigned works for the smallest value of a signed type
+		magnitude(negative ? static_cast<unsigned_type>(unsigned_type(0) - static_cast<unsigned_type>(value)) : static_cast<unsigned_type>(value)),
+		base(field.type == 'x' ? 16 : 10),
+		digits(digit_count(magnitude, base)),
+		zero_pad(field.zero_pad ? field.width : 0)
+	{
+	}
+	constexpr std::size_t size() const {
+		return std::max(digits + (negative ? 1 : 0), zero_pad);
+	}
+	constexpr char * write(char * out) const {
+		if (negative) {
+			*out = '-';
+			++out;
+		}
+		auto const last = out + (size() - (negative ? 1 : 0));
+		std::fill(out, last - digits, '0');
+		write_digits(last, magnitude, base);
+		return last;
+	}
+	static constexpr bool right_align = true;
+
+	bool negative;
+	unsigned_type magnitude;
+	unsigned_type base;
+	std::size_t digits;
+	std::size_t zero_pad;
+};
+
+// std::to_chars for floating point is not constexpr, so this only works at
+// run time
+template<std::floating_point Floating>
+struct prepared_argument<Floating> {
+	prepared_argument(Floating const value, replacement_field const & field) {
+		auto const result = field.precision == -1 ?
+			std::to_chars(std::begin(buffer), std::end(buffer), value) :
+			std::to_chars(std::begin(buffer), std::end(buffer), value, std::chars_format::fixed, field.precision);
+		assert(result.ec == std::errc());
+		characters = static_cast<std::size_t>(result.ptr - buffer);
+		// Like std::format, infinity and NaN are padded with spaces even with
+		// the 0 flag
+		if (field.zero_pad and std::isfinite(value) and field.width > characters) {
+			zero_pad = field.width - characters;
+		}
+	}
+	constexpr std::size_t size() const {
+		return characters + zero_pad;
+	}
+	char * write(char * out) const {
+		auto first = buffer;
+		if (zero_pad != 0 and *first == '-') {
+			*out = '-';
+			++out;
+			++first;
+		}
+		out = std::fill_n(out, zero_pad, '0');
+		return copy_characters(std::allocator<char>(), first, buffer + characters, out);
+	}
+	static constexpr bool right_align = true;
+
+	// Fixed notation with the largest precision, for the largest value
+	char buffer[std::numeric_limits<Floating>::max_exponent10 + max_precision + 4];
+	std::size_t characters;
+	std::size_t zero_pad = 0;
+};
+
+template<typename Arg>
+using prepared_for = prepared_argument<std::remove_cv_t<std::decay_t<Arg const &>>>;
+
+template<typename... Args, std::size_t... indexes>
+constexpr auto prepare(parsed_format<sizeof...(Args)> const & parsed, std::index_sequence<indexes...>, Args const & ... args) {
+	return std::tuple<prepared_for<Args>...>(prepared_for<Args>(args, parsed.fields[indexes])...);
+}
+
+template<std::size_t... indexes>
+constexpr std::size_t formatted_size_impl(std::string_view const format, parsed_format<sizeof...(indexes)> const & parsed, std::index_sequence<indexes...>, auto const & prepared) {
+	[[maybe_unused]] auto field_size = [&](replacement_field const & field, auto const & element) {
+		return text_size(format.substr(field.text_begin, field.text_end - field.text_begin), field.text_has_escapes) + std::max(element.size(), field.width);
+	};
+	return (text_size(format.substr(parsed.last_text_begin), parsed.last_text_has_escapes) + ... + field_size(parsed.fields[indexes], std::get<indexes>(prepared)));
+}
+
+template<typename... Args>
+constexpr std::size_t formatted_size(format_string<std::type_identity_t<Args>...> const format, Args const & ... args) {
+	auto const indexes = std::index_sequence_for<Args...>();
+	return formatted_size_impl(format.get(), format.parsed(), indexes, prepare(format.parsed(), indexes, args...));
+}
+
+// Whether an argument is a view of characters of target. Comparing pointers
+// into different objects with < is unspecified, and not allowed in constant
+// evaluation, where this compares the start of the view with each character
+// of target instead.
+template<typename String>
+constexpr bool overlaps(String const & target, auto const & element) {
+	if constexpr (requires { element.view; }) {
+		auto const first = target.data();
+		auto const last = first + target.size();
+		auto const view = element.view;
+		if (view.empty()) {
+			return false;
+		}
+		if (std::is_constant_evaluated()) {
+			for (auto it = first; it != last; ++it) {
+				if (it == view.data()) {
+					return true;
+				}
+			}
+			return false;
+		}
+		return std::less<>()(view.data(), last) and std::less<>()(first, view.data() + view.size());
+	} else {
+		return false;
+	}
+}
+
+// Appends the formatted result to target. The first pass works out the exact
+// size, and the second writes straight into the storage of target, which
+// grows at most once. A result that fits in the small buffer does not
+// allocate. If target has to grow and an argument is part of target, the
+// result is written to new storage and only then moved into target, so that
+// no argument is freed or overwritten before it is copied.
+template<typename String, typename... Args>
+constexpr void format_to(String & target, format_string<std::type_identity_t<Args>...> const format, Args const & ... args) {
+	auto const text = format.get();
+	auto const & parsed = format.parsed();
+	auto const indexes = std::index_sequence_for<Args...>();
+	auto const prepared = prepare(parsed, indexes, args...);
+	auto const size = formatted_size_impl(text, parsed, indexes, prepared);
+	auto const write = [&](char * out) {
+		auto write_field = [&](replacement_field const & field, auto const & element) {
+			out = write_text(out, text.substr(field.text_begin, field.text_end - field.text_begin), field.text_has_escapes);
+			auto const padding = field.width > element.size() ? field.width - element.size() : 0;
+			if (element.right_align) {
+				out = std::fill_n(out, padding, ' ');
+			}
+			out = element.write(out);
+			if (!element.right_align) {
+				out = std::fill_n(out, padding, ' ');
+			}
+		};
+		[&]<std::size_t... index>(std::index_sequence<index...>) {
+			(write_field(parsed.fields[index], std::get<index>(prepared)), ...);
+		}(indexes);
+		return write_text(out, text.substr(parsed.last_text_begin), parsed.last_text_has_escapes);
+	};
+	auto const aliased = target.size() + size > target.capacity() and [&]<std::size_t... index>(std::index_sequence<index...>) {
+		return (... or overlaps(target, std::get<index>(prepared)));
+	}(indexes);
+	if (!aliased) {
+		target.append_and_overwrite(size, write);
+		return;
+	}
+	auto result = String(target.get_allocator());
+	result.append_and_overwrite(target.size() + size, [&](char * const out) {
+		return write(copy_characters(std::allocator<char>(), std::as_const(target).data(), std::as_const(target).data() + target.size(), out));
+	});
+	target = std::move(result);
+}
+
+
+template<typename String>
+constexpr String make_string(std::string_view const source) {
+	auto result = String(typename String::allocator_type());
+	result.append(source.data(), source.data() + source.size());
+	return result;
+}
+
+constexpr bool equal(auto const & str, std::string_view const expected) {
+	return std::string_view(str.data(), str.size()) == expected;
+}
+
+template<typename String, typename... Args>
+constexpr void check(std::string_view const expected, format_string<std::type_identity_t<Args>...> const format, Args const & ... args) {
+	auto str = make_string<String>("");
+	format_to(str, format, args...);
+	assert(equal(str, expected));
+	assert(formatted_size(format, args...) == expected.size());
+}
+
+template<typename String>
+constexpr void test_layout() {
+	check<String>("", "");
+	check<String>("no fields", "no fields");
+	check<String>("key: 42", "{}: {}", "key", 42);
+	check<String>("{} {x}", "{{}} {{x}}");
+	check<String>("{7}", "{{{}}}", 7);
+	check<String>("ab   |   42|-0042|ff|0000beef", "{:5}|{:5}|{:05}|{:x}|{:08x}", std::string_view("ab"), 42, -42, 255u, 0xbeefu);
+	check<String>("-9223372036854775808 c", "{} {}", std::numeric_limits<std::int64_t>::min(), 'c');
+
+	auto const path = make_string<String>("/v1/users/12345/preferences");
+	check<String>("GET /v1/users/12345/preferences 200", "{} {} {}", "GET", path, 200);
+
+	// Appends to what is already there
+	auto str = make_string<String>("prefix ");
+	format_to(str, "{}-{}", 1, 2);
+	assert(equal(str, "prefix 1-2"));
+
+	// Short results fit in the small buffer of either layout
+	auto small = make_string<String>("");
+	auto const small_capacity = small.capacity();
+	format_to(small, "[{}] {}={}", "info", "retries", 3);
+	assert(equal(small, "[info] retries=3"));
+	assert(small.capacity() == small_capacity);
+
+	// Longer ones grow once, to exactly the right size
+	auto large = make_string<String>("");
+	format_to(large, "{} {} {} {}", path, path, 1234567, path);
+	assert(large.size() == 3 * path.size() + 7 + 3);
+	assert((large.capacity() | 1) == (large.size() | 1));
+
+	// Arguments that are the string being appended to, when it grows out of
+	// the small buffer and when it grows on the heap
+	auto self = make_string<String>("0123456789abc");
+	format_to(self, "{}|{}", self, self);
+	assert(equal(self, "0123456789abc0123456789abc|0123456789abc"));
+	auto long_self = make_string<String>("https://api.example.com/v1/users/123");
+	format_to(long_self, "{}{}", long_self, long_self);
+	assert(equal(long_self, "https://api.example.com/v1/users/123https://api.example.com/v1/users/123https://api.example.com/v1/users/123"));
+}
+
+constexpr bool test() {
+	using allocator_type = std::allocator<char>;
+	test_layout<clang::string<allocator_type>>();
+	test_layout<gcc::string<allocator_type>>();
+	assert(formatted_size("{} and {}", "this", 1000) == 13);
+	assert(formatted_size("{:10}", 'x') == 10);
+	return true;
+}
+
+template<typename String>
+void test_against_snprintf() {
+	auto engine = std::mt19937_64(1);
+	char expected[400];
+	for (int n = 0; n != 100'000; ++n) {
+		auto const integer = static_cast<long long>(engine()) >> (engine() % 64);
+		auto const hex = static_cast<unsigned long long>(engine()) >> (engine() % 64);
+		auto const floating = static_cast<double>(static_cast<std::int64_t>(engine()) >> (engine() % 64)) / 1024.0;
+		auto str = make_string<String>("");
+		format_to(str, "{} {:x} {:.3f} {:012.2f} {:8}|", integer, hex, floating, floating, static_cast<int>(n));
+		auto const size = std::snprintf(expected, sizeof(expected), "%lld %llx %.3f %012.2f %8d|", integer, hex, floating, floating, n);
+		assert(equal(str, std::string_view(expected, static_cast<std::size_t>(size))));
+
+		auto shortest = make_string<String>("");
+		format_to(shortest, "{}", floating);
+		assert(equal(shortest, std::string_view(expected, std::to_chars(std::begin(expected), std::end(expected), floating).ptr)));
+	}
+	auto str = make_string<String>("");
+	format_to(str, "{:.2f} {:08.2f} {:.0f}", 1e300, -3.14159, 2.5);
+	auto const size = std::snprintf(expected, sizeof(expected), "%.2f -0003.14 2", 1e300);
+	assert(equal(str, std::string_view(expected, static_cast<std::size_t>(size))));
+
+	auto non_finite = make_string<String>("");
+	format_to(non_finite, "{:08.2f}|{:08.2f}|{:08}|{:08.2f}", std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(), std::numeric_limits<double>::quiet_NaN(), -std::numeric_limits<double>::quiet_NaN());
+	assert(equal(non_finite, "     inf|    -inf|     nan|    -nan"));
+}
+
+// Counts calls to the global operator new, which std::allocator uses
+std::size_t allocations = 0;
+
+void * operator new(std::size_t const size) {
+	++allocations;
+	if (auto const result = std::malloc(size)) {
+		return result;
+	}
+	throw std::bad_alloc();
+}
+void operator delete(void * const ptr) noexcept {
+	std::free(ptr);
+}
+void operator delete(void * const ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+template<typename Function>
+double nanoseconds_per_operation(std::size_t const count, Function && function) {
+	auto const start = std::chrono::steady_clock::now();
+	function();
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+}
+
+struct request {
+	std::int64_t timestamp;
+	std::string_view method;
+	std::string_view path;
+	int status;
+	double latency;
+	std::uint64_t bytes;
+};
+
+std::vector<request> make_requests(std::size_t const count) {
+	auto engine = std::mt19937_64(1);
+	constexpr std::string_view methods[] = {"GET", "PUT", "POST", "DELETE"};
+	constexpr std::string_view paths[] = {"/", "/v1/users/12345/preferences", "/health", "/v2/orders/search"};
+	auto result = std::vector<request>(count);
+	for (auto & element : result) {
+		element = {
+			1'700'000'000'000 + static_cast<std::int64_t>(engine() % 100'000'000),
+			methods[engine() % std::size(methods)],
+			paths[engine() % std::size(paths)],
+			static_cast<int>(200 + engine() % 400),
+			static_cast<double>(engine() % 1'000'000) / 997.0,
+			engine() % 10'000'000,
+		};
+	}
+	return result;
+}
+
+// Formats one log line per request into a new string
+template<typename Format>
+void benchmark_one(char const * const name, std::vector<request> const & requests, Format format) {
+	auto sink = std::size_t(0);
+	auto const before = allocations;
+	auto const time = nanoseconds_per_operation(requests.size(), [&] {
+		for (auto const & element : requests) {
+			sink += format(element);
+		}
+	});
+	assert(sink != 0);
+	std::printf("%-40s %14.1f %14.2f\n", name, time, static_cast<double>(allocations - before) / static_cast<double>(requests.size()));
+}
+
+template<typename String>
+std::size_t format_layout(request const & element) {
+	auto line = String(typename String::allocator_type());
+	format_to(line, "{} {} {} status={} latency={:.3f}ms bytes={}", element.timestamp, element.method, element.path, element.status, element.latency, element.bytes);
+	return line.size();
+}
+
+void benchmark() {
+	auto const requests = make_requests(1'000'000);
+	std::printf("%-40s %14s %14s\n", "", "ns per line", "allocations");
+	benchmark_one("std::ostringstream", requests, [](request const & element) {
+		auto stream = std::ostringstream();
+		stream << element.timestamp << ' ' << element.method << ' ' << element.path << " status=" << element.status << " latency=" << std::fixed << std::setprecision(3) << element.latency << "ms bytes=" << element.bytes;
+		return stream.str().size();
+	});
+	benchmark_one("std::string and std::to_string", requests, [](request const & element) {
+		auto line = std::to_string(element.timestamp);
+		line += ' ';
+		line += element.method;
+		line += ' ';
+		line += element.path;
+		line += " status=";
+		line += std::to_string(element.status);
+		line += " latency=";
+		char buffer[64];
+		line.append(buffer, std::to_chars(std::begin(buffer), std::end(buffer), element.latency, std::chars_format::fixed, 3).ptr);
+		line += "ms bytes=";
+		line += std::to_string(element.bytes);
+		return line.size();
+	});
+	benchmark_one("snprintf and std::string", requests, [](request const & element) {
+		char buffer[256];
+		auto const size = std::snprintf(buffer, sizeof(buffer), "%lld %.*s %.*s status=%d latency=%.3fms bytes=%llu", static_cast<long long>(element.timestamp), static_cast<int>(element.method.size()), element.method.data(), static_cast<int>(element.path.size()), element.path.data(), element.status, element.latency, static_cast<unsigned long long>(element.bytes));
+		return std::string(buffer, static_cast<std::size_t>(size)).size();
+	});
+	benchmark_one("clang layout, format_to", requests, format_layout<clang::string<std::allocator<char>>>);
+	benchmark_one("gcc layout, format_to", requests, format_layout<gcc::string<std::allocator<char>>>);
+}
+
+int main() {
+	test();
+	static_assert(test());
+	test_against_snprintf<clang::string<std::allocator<char>>>();
+	test_against_snprintf<gcc::string<std::allocator<char>>>();
+	benchmark();
+}
@@ -0,0 +1,1695 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20 and POSIX. The goal of this version is to store a
+// large sorted set of strings that share long prefixes, such as the routes of
+// a router or the entries of an autocomplete list, in much less memory than
+// the strings themselves, and still find a key quickly.
+//
+// Front coding stores each key as how many characters it shares with the key
+// before it and the characters after those. Decoding a key needs the key
+// before it, so the keys are split into blocks, and the first key of each
+// block is stored whole. Looking up a key binary searches the first keys of
+// the blocks, then decodes one block.
+//
+// A block is one string, so the blocks can go in anything that holds a
+// sequence of strings. In memory they are a string_column from
+// string-column.cpp. On disk they are a string table from string-table.cpp,
+// and a front_coded_set of a mapped string_table works in place, with no
+// loading step.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <random>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+
+// Selects the constructor that refers to characters instead of copying them
+struct external_storage_t {
+	explicit external_storage_t() = default;
+};
+inline constexpr auto external_storage = external_storage_t();
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	[[no_unique_address]] allocator_type allocator_;
+	// This could be set to 8 to reduce the size of our string to 24 bytes
+	// (just like clang), but 7 characters (plus a null terminator) is likely
+	// too small of a buffer for most users.
+	static constexpr std::size_t small_buffer_capacity = 16;
+	union U{
+		constexpr U():
+			buffer{}
+		{
+		}
+		constexpr U(std::size_t c):
+			capacity(c)
+		{
+		}
+
+		char buffer[small_buffer_capacity];
+		std::size_t capacity;
+	} u_;
+	char * data_;
+	std::size_t size_ : 63;
+	// gcc and MSVC do not allow accessing the inactive member of a union just
+	// to get its address, so we use a bitfield to work around this.
+	bool is_large_ : 1;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return is_large_;
+	}
+
+	constexpr void deallocate() {
+		if (is_large() and !is_external()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, data_, u_.capacity);
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(new_capacity);
+		data_ = new_data;
+		is_large_ = true;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy(data_, data_ + size_, temp);
+		relocate(temp, new_capacity);
+	}
+
+	constexpr void copy_external_characters() {
+		if (size_ <= small_buffer_capacity) {
+			auto const source = data_;
+			u_ = U{};
+			copy(source, source + size_, u_.buffer);
+			data_ = u_.buffer;
+			is_large_ = false;
+		} else {
+			force_reserve(size_);
+		}
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_{},
+		data_(u_.buffer),
+		size_(0),
+		is_large_(false)
+	{
+	}
+
+	// value must outlive the string and every string it is moved into
+	constexpr string(external_storage_t, std::string_view const value, allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_(0),
+		data_(const_cast<char *>(value.data())),
+		size_(value.size()),
+		is_large_(true)
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.capacity);
+			other.u_ = U{};
+		
+			data_ = other.data_;
+			other.data_ = other.u_.buffer;
+		
+			size_ = other.size_;
+			other.size_ = 0U;
+		
+			is_large_ = true;
+			other.is_large_ = false;
+
+		} else {
+			u_ = U{};
+			copy(other.data_, other.data_ + other.size_, u_.buffer);
+			data_ = u_.buffer;
+			size_ = other.size_;
+			is_large_ = false;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return data_;
+	}
+	// Does not copy the characters of an external string (see detach)
+	constexpr char * data() {
+		return data_;
+	}
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		return is_external() ? size() : is_large() ? u_.capacity : small_buffer_capacity;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		if (is_large() && capacity() > size()) {
+			if (size() > small_buffer_capacity) {
+				force_reserve(size());
+			} else {
+				auto const data = data_;
+				auto const original_capacity = u_.capacity;
+				u_ = U{};
+				copy(data, data + size_, u_.buffer);
+				data_ = u_.buffer;
+				is_large_ = false;
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		// An external string has no spare capacity, so it always takes the
+		// reallocating path, which only reads the external characters.
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = end() - 1;
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = capacity() * growth_factor;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+		
+			relocate(temp, new_capacity);
+		}
+		++size_;
+		return begin() + offset;
+	}
+
+	// A string in the external state refers to characters that it does not
+	// own, such as an element of a string_column. It is marked as large with a
+	// capacity of 0, which no allocation has.
+	constexpr bool is_external() const {
+		return is_large_ and u_.capacity == 0;
+	}
+
+	// Copies the characters of an external string into storage that this
+	// string owns, so that they can be changed through data() or an iterator.
+	// Short strings go in the small buffer. Does nothing to any other string.
+	constexpr void detach() {
+		if (is_external()) {
+			copy_external_characters();
+		}
+	}
+
+	constexpr void pop_back() {
+		detach();
+		--size_;
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+
+template<typename Allocator>
+string(Allocator) -> string<Allocator>;
+
+// Anything with a data() and a size() of characters, such as string,
+// std::string, and std::string_view
+template<typename T>
+concept string_like = requires(T const & value) {
+	{ value.data() } -> std::convertible_to<char const *>;
+	{ value.size() } -> std::convertible_to<std::size_t>;
+};
+
+constexpr std::string_view as_view(string_like auto const & value) {
+	return std::string_view(value.data(), value.size());
+}
+
+// Many strings stored as their characters back to back in one array, and an
+// array of where each one starts, the same as an Arrow string column.
+// Offset is std::uint32_t for up to 4 GiB of characters, which makes the cost
+// of each string 4 bytes on top of its characters, or std::uint64_t for more.
+// Element n is the characters from offsets_[n] to offsets_[n + 1], so there
+// is one more offset than there are strings, and the first is 0.
+//
+// Adding strings can move the characters, which leaves any std::string_view
+// or external string from before that pointing at the old ones.
+template<std::unsigned_integral Offset = std::uint32_t>
+class string_column {
+public:
+	class iterator {
+	public:
+		using value_type = std::string_view;
+		using difference_type = std::ptrdiff_t;
+
+		constexpr iterator() = default;
+		constexpr iterator(char const * const characters, Offset const * const offset):
+			characters_(characters),
+			offset_(offset)
+		{
+		}
+
+		constexpr std::string_view operator*() const {
+			return std::string_view(characters_ + offset_[0], static_cast<std::size_t>(offset_[1] - offset_[0]));
+		}
+		constexpr std::string_view operator[](difference_type const index) const {
+			return *(*this + index);
+		}
+
+		constexpr iterator & operator++() {
+			++offset_;
+			return *this;
+		}
+		constexpr iterator operator++(int) {
+			auto const result = *this;
+			++*this;
+			return result;
+		}
+		constexpr iterator & operator--() {
+			--offset_;
+			return *this;
+		}
+		constexpr iterator operator--(int) {
+			auto const result = *this;
+			--*this;
+			return result;
+		}
+		constexpr iterator & operator+=(difference_type const offset) {
+			offset_ += offset;
+			return *this;
+		}
+		constexpr iterator & operator-=(difference_type const offset) {
+			offset_ -= offset;
+			return *this;
+		}
+		friend constexpr iterator operator+(iterator it, difference_type const offset) {
+			return it += offset;
+		}
+		friend constexpr iterator operator+(difference_type const offset, iterator it) {
+			return it += offset;
+		}
+		friend constexpr iterator operator-(iterator it, difference_type const offset) {
+			return it -= offset;
+		}
+		friend constexpr difference_type operator-(iterator const lhs, iterator const rhs) {
+			return lhs.offset_ - rhs.offset_;
+		}
+
+		friend constexpr bool operator==(iterator const lhs, iterator const rhs) {
+			return lhs.offset_ == rhs.offset_;
+		}
+		friend constexpr auto operator<=>(iterator const lhs, iterator const rhs) {
+			return lhs.offset_ <=> rhs.offset_;
+		}
+
+	private:
+		char const * characters_ = nullptr;
+		Offset const * offset_ = nullptr;
+	};
+	using const_iterator = iterator;
+
+	constexpr string_column():
+		offsets_(1, Offset(0))
+	{
+	}
+
+	constexpr std::size_t size() const {
+		return offsets_.size() - 1;
+	}
+	constexpr bool empty() const {
+		return size() == 0;
+	}
+	// All of the characters, with no separators between strings
+	constexpr std::string_view characters() const {
+		return std::string_view(characters_.data(), characters_.size());
+	}
+
+	constexpr std::string_view operator[](std::size_t const index) const {
+		assert(index < size());
+		auto const first = static_cast<std::size_t>(offsets_[index]);
+		auto const last = static_cast<std::size_t>(offsets_[index + 1]);
+		return std::string_view(characters_.data() + first, last - first);
+	}
+
+	// A string that refers to the characters in the column, and copies them
+	// only when it is changed
+	template<typename Allocator = std::allocator<char>>
+	constexpr string<Allocator> as_string(std::size_t const index, Allocator alloc = Allocator()) const {
+		return string<Allocator>(external_storage, (*this)[index], alloc);
+	}
+
+	constexpr iterator begin() const {
+		return iterator(characters_.data(), offsets_.data());
+	}
+	constexpr iterator end() const {
+		return iterator(characters_.data(), offsets_.data() + size());
+	}
+
+	constexpr void reserve(std::size_t const string_count, std::size_t const character_count) {
+		offsets_.reserve(string_count + 1);
+		characters_.reserve(character_count);
+	}
+
+	// If this throws, the column is unchanged. value can be an element of
+	// this column, which is copied before the characters can move.
+	constexpr void push_back(string_like auto const & value) {
+		auto const view = as_view(value);
+		if (contains_characters(view)) {
+			auto const copy = std::vector<char>(view.begin(), view.end());
+			push_back(std::string_view(copy.data(), copy.size()));
+			return;
+		}
+		auto const offset = next_offset(view.size());
+		// Growing offsets_ is the only thing after changing characters_ that
+		// could throw, so it is done first.
+		if (offsets_.size() == offsets_.capacity()) {
+			offsets_.reserve(2 * offsets_.size());
+		}
+		characters_.insert(characters_.end(), view.begin(), view.end());
+		offsets_.push_back(offset);
+	}
+
+	// Adds every string in range. For a forward range this adds up the sizes
+	// first, so that each array grows at most once.
+	template<std::ranges::input_range Range> requires string_like<std::ranges::range_value_t<Range>>
+	constexpr void append_range(Range && range) {
+		if constexpr (std::ranges::forward_range<Range>) {
+			auto string_count = std::size_t(0);
+			auto character_count = std::size_t(0);
+			for (auto const & value : range) {
+				++string_count;
+				character_count += value.size();
+			}
+			reserve(size() + string_count, characters_.size() + character_count);
+		}
+		for (auto const & value : range) {
+			push_back(value);
+		}
+	}
+
+	// What the column holds in memory, not counting the capacity that it has
+	// not used
+	constexpr std::size_t bytes_used() const {
+		return characters_.size() + offsets_.size() * sizeof(Offset);
+	}
+
+private:
+	// Comparing pointers into different objects with < is unspecified, and not
+	// allowed in constant evaluation, where this compares the start of view
+	// with each character instead.
+	constexpr bool contains_characters(std::string_view const view) const {
+		if (view.empty()) {
+			return false;
+		}
+		auto const first = characters_.data();
+		auto const last = first + characters_.size();
+		if (std::is_constant_evaluated()) {
+			for (auto it = first; it != last; ++it) {
+				if (it == view.data()) {
+					return true;
+				}
+			}
+			return false;
+		}
+		return std::less<>()(view.data(), last) and std::less<>()(first, view.data() + view.size());
+	}
+
+	// Where the next string ends, if it has size characters. Like
+	// std::vector, this throws std::length_error if that does not fit.
+	constexpr Offset next_offset(std::size_t const size) const {
+		if (size > std::numeric_limits<Offset>::max() - characters_.size()) {
+			throw std::length_error("string_column: too many characters for the offset type");
+		}
+		return static_cast<Offset>(characters_.size() + size);
+	}
+
+	std::vector<char> characters_;
+	std::vector<Offset> offsets_;
+};
+
+static_assert(std::random_access_iterator<string_column<>::iterator>);
+static_assert(std::ranges::random_access_range<string_column<> const>);
+
+
+// On a little-endian machine, this is one load at run time
+template<std::unsigned_integral T>
+constexpr T load_little_endian(char const * const ptr) {
+	auto result = T(0);
+	if (!std::is_constant_evaluated() and std::endian::native == std::endian::little) {
+		std::memcpy(&result, ptr, sizeof(result));
+		return result;
+	}
+	for (std::size_t n = 0; n != sizeof(T); ++n) {
+		result |= static_cast<T>(static_cast<unsigned char>(ptr[n])) << (CHAR_BIT * n);
+	}
+	return result;
+}
+
+template<std::unsigned_integral T>
+constexpr void store_little_endian(char * const ptr, T const value) {
+	for (std::size_t n = 0; n != sizeof(T); ++n) {
+		ptr[n] = static_cast<char>(static_cast<unsigned char>(value >> (CHAR_BIT * n)));
+	}
+}
+
+// The layout of a string table file. Every number is little-endian.
+//
+//   header   magic, version, offset_size, string_count, data_offset,
+//            data_size, index_offset
+//   data     the characters of every string, back to back
+//   index    string_count + 1 offsets into data, each offset_size bytes
+//
+// Element n is the characters in data from index[n] to index[n + 1]. The
+// index comes after the data so that a writer can stream the strings out
+// before it knows how many there are, or whether 4 byte offsets are enough.
+// The data starts at a multiple of the alignment the writer was given, and
+// the index at a multiple of that and of offset_size, so a reader that maps
+// the file can use both where they are.
+struct string_table_header {
+	static constexpr auto magic = std::string_view("strtable");
+	static constexpr auto current_version = std::uint32_t(1);
+	static constexpr auto size = std::size_t(48);
+
+	std::uint32_t version = current_version;
+	std::uint32_t offset_size = 0;
+	std::uint64_t string_count = 0;
+	std::uint64_t data_offset = 0;
+	std::uint64_t data_size = 0;
+	std::uint64_t index_offset = 0;
+};
+
+constexpr std::array<char, string_table_header::size> encode(string_table_header const header) {
+	auto result = std::array<char, string_table_header::size>();
+	std::ranges::copy(string_table_header::magic, result.data());
+	store_little_endian(result.data() + 8, header.version);
+	store_little_endian(result.data() + 12, header.offset_size);
+	store_little_endian(result.data() + 16, header.string_count);
+	store_little_endian(result.data() + 24, header.data_offset);
+	store_little_endian(result.data() + 32, header.data_size);
+	store_little_endian(result.data() + 40, header.index_offset);
+	return result;
+}
+
+// Checks that everything the header points to is inside of file, but does
+// not look at the data or the index
+constexpr string_table_header decode_header(std::string_view const file) {
+	if (file.size() < string_table_header::size or !file.starts_with(string_table_header::magic)) {
+		throw std::runtime_error("string table: not a string table");
+	}
+	auto const header = string_table_header(
+		load_little_endian<std::uint32_t>(file.data() + 8),
+		load_little_endian<std::uint32_t>(file.data() + 12),
+		load_little_endian<std::uint64_t>(file.data() + 16),
+		load_little_endian<std::uint64_t>(file.data() + 24),
+		load_little_endian<std::uint64_t>(file.data() + 32),
+		load_little_endian<std::uint64_t>(file.data() + 40)
+	);
+	if (header.version != string_table_header::current_version) {
+		throw std::runtime_error("string table: unsupported version");
+	}
+	if (header.offset_size != 4 and header.offset_size != 8) {
+		throw std::runtime_error("string table: offsets must be 4 or 8 bytes");
+	}
+	auto const fits = [=](std::uint64_t const offset, std::uint64_t const size) {
+		return offset <= file.size() and size <= file.size() - offset;
+	};
+	auto const max_strings = (file.size() - std::min<std::uint64_t>(header.index_offset, file.size())) / header.offset_size;
+	if (!fits(header.data_offset, header.data_size) or header.index_offset % header.offset_size != 0 or header.string_count >= max_strings) {
+		throw std::runtime_error("string table: truncated");
+	}
+	return header;
+}
+
+// The strings in a string table that is already in memory. Nothing is
+// copied: every string_view and external string points into file.
+//
+// Opening a table reads the header and the first and last offset, so that it
+// costs the same however many strings there are. The offsets in between are
+// not checked unless you call offsets_are_valid.
+class string_table_view {
+public:
+	class iterator {
+	public:
+		using value_type = std::string_view;
+		using difference_type = std::ptrdiff_t;
+
+		constexpr iterator() = default;
+		constexpr iterator(string_table_view const & table, std::size_t const index):
+			table_(&table),
+			index_(index)
+		{
+		}
+
+		constexpr std::string_view operator*() const {
+			return (*table_)[index_];
+		}
+		constexpr std::string_view operator[](difference_type const index) const {
+			return *(*this + index);
+		}
+
+		constexpr iterator & operator++() {
+			++index_;
+			return *this;
+		}
+		constexpr iterator operator++(int) {
+			auto const result = *this;
+			++*this;
+			return result;
+		}
+		constexpr iterator & operator--() {
+			--index_;
+			return *this;
+		}
+		constexpr iterator operator--(int) {
+			auto const result = *this;
+			--*this;
+			return result;
+		}
+		constexpr iterator & operator+=(difference_type const offset) {
+			index_ += static_cast<std::size_t>(offset);
+			return *this;
+		}
+		constexpr iterator & operator-=(difference_type const offset) {
+			index_ -= static_cast<std::size_t>(offset);
+			return *this;
+		}
+		friend constexpr iterator operator+(iterator it, difference_type const offset) {
+			return it += offset;
+		}
+		friend constexpr iterator operator+(difference_type const offset, iterator it) {
+			return it += offset;
+		}
+		friend constexpr iterator operator-(iterator it, difference_type const offset) {
+			return it -= offset;
+		}
+		friend constexpr difference_type operator-(iterator const lhs, iterator const rhs) {
+			return static_cast<difference_type>(lhs.index_ - rhs.index_);
+		}
+
+		friend constexpr bool operator==(iterator const lhs, iterator const rhs) {
+			return lhs.index_ == rhs.index_;
+		}
+		friend constexpr auto operator<=>(iterator const lhs, iterator const rhs) {
+			return lhs.index_ <=> rhs.index_;
+		}
+
+	private:
+		string_table_view const * table_ = nullptr;
+		std::size_t index_ = 0;
+	};
+	using const_iterator = iterator;
+
+	constexpr explicit string_table_view(std::string_view const file):
+		header_(decode_header(file)),
+		data_(file.data() + header_.data_offset),
+		index_(file.data() + header_.index_offset)
+	{
+		if (offset(0) != 0 or offset(size()) != header_.data_size) {
+			throw std::runtime_error("string table: the index does not cover the data");
+		}
+	}
+
+	constexpr std::size_t size() const {
+		return static_cast<std::size_t>(header_.string_count);
+	}
+	constexpr bool empty() const {
+		return size() == 0;
+	}
+	constexpr std::string_view characters() const {
+		return std::string_view(data_, static_cast<std::size_t>(header_.data_size));
+	}
+	constexpr string_table_header const & header() const {
+		return header_;
+	}
+
+	constexpr std::string_view operator[](std::size_t const index) const {
+		assert(index < size());
+		auto const first = offset(index);
+		auto const last = offset(index + 1);
+		assert(first <= last and last <= header_.data_size);
+		return std::string_view(data_ + first, static_cast<std::size_t>(last - first));
+	}
+
+	// A string that refers to the characters in the table, and copies them
+	// only when it is changed
+	template<typename Allocator = std::allocator<char>>
+	constexpr string<Allocator> as_string(std::size_t const index, Allocator alloc = Allocator()) const {
+		return string<Allocator>(external_storage, (*this)[index], alloc);
+	}
+
+	constexpr iterator begin() const {
+		return iterator(*this, 0);
+	}
+	constexpr iterator end() const {
+		return iterator(*this, size());
+	}
+
+	// Reads the whole index. A table that passes this can be used without
+	// trusting whoever wrote it.
+	constexpr bool offsets_are_valid() const {
+		auto previous = std::uint64_t(0);
+		for (std::size_t index = 1; index <= size(); ++index) {
+			auto const current = offset(index);
+			if (current < previous) {
+				return false;
+			}
+			previous = current;
+		}
+		return true;
+	}
+
+private:
+	constexpr std::uint64_t offset(std::size_t const index) const {
+		return header_.offset_size == sizeof(std::uint32_t) ?
+			load_little_endian<std::uint32_t>(index_ + index * sizeof(std::uint32_t)) :
+			load_little_endian<std::uint64_t>(index_ + index * sizeof(std::uint64_t));
+	}
+
+	string_table_header header_;
+	char const * data_;
+	char const * index_;
+};
+
+static_assert(std::random_access_iterator<string_table_view::iterator>);
+static_assert(std::ranges::random_access_range<string_table_view const>);
+
+template<typename>
+constexpr auto is_string_column = false;
+
+template<typename Offset>
+constexpr auto is_string_column<string_column<Offset>> = true;
+
+// Where string_table_writer sends its bytes. overwrite is called once, at
+// the end, to fill in the header.
+template<typename T>
+concept string_table_output = requires(T & output, std::string_view const bytes, std::size_t const position) {
+	output.write(bytes);
+	output.overwrite(position, bytes);
+};
+
+// Keeps the table in memory, which is mostly useful for tests
+struct memory_output {
+	constexpr void write(std::string_view const bytes) {
+		contents.insert(contents.end(), bytes.begin(), bytes.end());
+	}
+	constexpr void overwrite(std::size_t const position, std::string_view const bytes) {
+		std::ranges::copy(bytes, contents.begin() + static_cast<std::ptrdiff_t>(position));
+	}
+
+	std::vector<char> contents;
+};
+
+class file_output {
+public:
+	explicit file_output(char const * const path):
+		file_(std::fopen(path, "wb"))
+	{
+		if (!file_) {
+			throw std::system_error(errno, std::generic_category(), path);
+		}
+		// The default buffer of a few KiB means a system call for every few
+		// strings
+		std::setvbuf(file_.get(), nullptr, _IOFBF, 1 << 20);
+	}
+
+	void write(std::string_view const bytes) {
+		if (std::fwrite(bytes.data(), 1, bytes.size(), file_.get()) != bytes.size()) {
+			throw std::system_error(errno, std::generic_category(), "string table: write");
+		}
+	}
+	void overwrite(std::size_t const position, std::string_view const bytes) {
+		if (std::fseek(file_.get(), static_cast<long>(position), SEEK_SET) != 0) {
+			throw std::system_error(errno, std::generic_category(), "string table: seek");
+		}
+		write(bytes);
+	}
+
+	// Unlike the destructor, this reports an error from writing what is still
+	// in the buffer
+	void close() {
+		if (std::fclose(file_.release()) != 0) {
+			throw std::system_error(errno, std::generic_category(), "string table: close");
+		}
+	}
+
+private:
+	struct closer {
+		void operator()(std::FILE * const file) const {
+			std::fclose(file);
+		}
+	};
+	std::unique_ptr<std::FILE, closer> file_;
+};
+
+// Writes the strings as they are added, and keeps only their offsets in
+// memory until finish writes the index and the header.
+template<string_table_output Output>
+class string_table_writer {
+public:
+	// alignment must be a power of 2. Aligning to the page size lets a reader
+	// map the data or the index on their own.
+	constexpr explicit string_table_writer(Output output, std::size_t const alignment = 1):
+		output_(std::move(output)),
+		alignment_(alignment)
+	{
+		assert(std::has_single_bit(alignment));
+		write_padding(string_table_header::size);
+		data_offset_ = align(alignment_);
+		offsets_.push_back(0);
+	}
+
+	constexpr void push_back(string_like auto const & value) {
+		auto const view = as_view(value);
+		output_.write(view);
+		position_ += view.size();
+		offsets_.push_back(offsets_.back() + view.size());
+	}
+
+	// A column already has its characters back to back, so they are written
+	// all at once
+	template<std::ranges::input_range Range> requires string_like<std::ranges::range_value_t<Range>>
+	constexpr void append_range(Range && range) {
+		if constexpr (is_string_column<std::remove_cvref_t<Range>>) {
+			output_.write(range.characters());
+			position_ += range.characters().size();
+			offsets_.reserve(offsets_.size() + range.size());
+			for (auto const value : range) {
+				offsets_.push_back(offsets_.back() + value.size());
+			}
+		} else {
+			for (auto const & value : range) {
+				push_back(value);
+			}
+		}
+	}
+
+	// Writes the index and the header, and gives back the output. Nothing
+	// can be added after this.
+	constexpr Output finish() && {
+		auto const data_size = offsets_.back();
+		auto const offset_size = data_size <= std::numeric_limits<std::uint32_t>::max() ? sizeof(std::uint32_t) : sizeof(std::uint64_t);
+		auto const index_offset = align(std::max(alignment_, offset_size));
+		if (offset_size == sizeof(std::uint32_t)) {
+			write_index<std::uint32_t>();
+		} else {
+			write_index<std::uint64_t>();
+		}
+		auto const header = encode(string_table_header(
+			string_table_header::current_version,
+			static_cast<std::uint32_t>(offset_size),
+			offsets_.size() - 1,
+			data_offset_,
+			data_size,
+			index_offset
+		));
+		output_.overwrite(0, std::string_view(header.data(), header.size()));
+		return std::move(output_);
+	}
+
+private:
+	constexpr void write_padding(std::size_t size) {
+		constexpr auto zeros = std::array<char, 256>();
+		while (size != 0) {
+			auto const count = std::min(size, zeros.size());
+			output_.write(std::string_view(zeros.data(), count));
+			position_ += count;
+			size -= count;
+		}
+	}
+	// Pads to the next multiple of alignment, and returns where that is
+	constexpr std::uint64_t align(std::size_t const alignment) {
+		write_padding((alignment - position_ % alignment) % alignment);
+		return position_;
+	}
+
+	template<typename Offset>
+	constexpr void write_index() {
+		auto buffer = std::array<char, 4096>();
+		auto const per_buffer = buffer.size() / sizeof(Offset);
+		for (std::size_t first = 0; first < offsets_.size(); first += per_buffer) {
+			auto const count = std::min(per_buffer, offsets_.size() - first);
+			for (std::size_t n = 0; n != count; ++n) {
+				store_little_endian(buffer.data() + n * sizeof(Offset), static_cast<Offset>(offsets_[first + n]));
+			}
+			output_.write(std::string_view(buffer.data(), count * sizeof(Offset)));
+			position_ += count * sizeof(Offset);
+		}
+	}
+
+	Output output_;
+	std::size_t alignment_;
+	std::uint64_t position_ = 0;
+	std::uint64_t data_offset_ = 0;
+	std::vector<std::uint64_t> offsets_;
+};
+
+// A whole file mapped read only. Pages are read from the file the first time
+// they are used, and because they are never written, the kernel can drop
+// them when memory is short and read them again later.
+class mapped_file {
+public:
+	explicit mapped_file(char const * const path) {
+		auto const fd = ::open(path, O_RDONLY | O_CLOEXEC);
+		if (fd == -1) {
+			throw std::system_error(errno, std::generic_category(), path);
+		}
+		struct stat status;
+		if (::fstat(fd, &status) != 0) {
+			auto const error = errno;
+			::close(fd);
+			throw std::system_error(error, std::generic_category(), path);
+		}
+		size_ = static_cast<std::size_t>(status.st_size);
+		if (size_ != 0) {
+			auto const address = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (address == MAP_FAILED) {
+				auto const error = errno;
+				::close(fd);
+				throw std::system_error(error, std::generic_category(), path);
+			}
+			data_ = static_cast<char const *>(address);
+		}
+		// The mapping keeps the file open
+		::close(fd);
+	}
+	mapped_file(mapped_file && other) noexcept:
+		data_(std::exchange(other.data_, nullptr)),
+		size_(std::exchange(other.size_, 0))
+	{
+	}
+	mapped_file & operator=(mapped_file && other) noexcept {
+		std::swap(data_, other.data_);
+		std::swap(size_, other.size_);
+		return *this;
+	}
+	~mapped_file() {
+		if (data_) {
+			::munmap(const_cast<char *>(data_), size_);
+		}
+	}
+
+	std::string_view contents() const {
+		return std::string_view(data_, size_);
+	}
+
+private:
+	char const * data_ = nullptr;
+	std::size_t size_ = 0;
+};
+
+// A string table file, mapped into memory. Moving it does not move the
+// mapping, so the strings it hands out stay valid until it is destroyed.
+class string_table {
+public:
+	explicit string_table(char const * const path):
+		file_(path),
+		view_(file_.contents())
+	{
+	}
+
+	string_table_view const & view() const {
+		return view_;
+	}
+	std::size_t size() const {
+		return view_.size();
+	}
+	std::string_view operator[](std::size_t const index) const {
+		return view_[index];
+	}
+	template<typename Allocator = std::allocator<char>>
+	string<Allocator> as_string(std::size_t const index, Allocator alloc = Allocator()) const {
+		return view_.as_string(index, alloc);
+	}
+	auto begin() const {
+		return view_.begin();
+	}
+	auto end() const {
+		return view_.end();
+	}
+
+private:
+	mapped_file file_;
+	string_table_view view_;
+};
+
+template<std::ranges::input_range Range> requires string_like<std::ranges::range_value_t<Range>>
+void write_string_table(char const * const path, Range && range, std::size_t const alignment = 1) {
+	auto writer = string_table_writer(file_output(path), alignment);
+	writer.append_range(std::forward<Range>(range));
+	std::move(writer).finish().close();
+}
+
+
+// 7 bits at a time, low bits first, with the high bit set on every byte but
+// the last (LEB128)
+constexpr void append_varint(std::string & out, std::size_t value) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+// Reads no further than end. Throws std::runtime_error if the varint does not
+// end before end or does not fit in a std::size_t.
+constexpr std::size_t read_varint(char const * & it, char const * const end) {
+	constexpr auto digits = std::numeric_limits<std::size_t>::digits;
+	auto result = std::size_t(0);
+	for (int shift = 0; ; shift += 7) {
+		if (it == end) {
+			throw std::runtime_error("front coded set: truncated number");
+		}
+		auto const byte = static_cast<unsigned char>(*it);
+		++it;
+		auto const bits = std::size_t(byte & 0x7F);
+		if (shift >= digits or (shift > digits - 7 and (bits >> (digits - shift)) != 0)) {
+			throw std::runtime_error("front coded set: number too large");
+		}
+		result |= bits << shift;
+		if (byte < 0x80) {
+			return result;
+		}
+	}
+}
+
+// Writes sorted keys in blocks of block_size, each of which is one string
+// passed to output.push_back. A block is
+//
+//   key count
+//   size of the first key, the first key
+//   for each other key: how many characters it shares with the key before
+//   it, the size of the rest, the rest
+//
+// with every number a varint. Every block but the last has block_size keys.
+// The first key of each block is stored whole, so it can be read without
+// decoding anything before it.
+//
+// output can be a string_column, to keep the set in memory, or a
+// string_table_writer, to write it to a file that can be mapped.
+template<std::ranges::input_range Range> requires string_like<std::ranges::range_value_t<Range>>
+constexpr void front_code(Range && keys, auto & output, std::size_t const block_size = 16) {
+	assert(block_size != 0);
+	auto block = std::string();
+	auto previous = std::string();
+	auto count = std::size_t(0);
+	auto body = std::string();
+	auto first = true;
+	auto const flush = [&] {
+		block.clear();
+		append_varint(block, count);
+		block += body;
+		output.push_back(block);
+		body.clear();
+		count = 0;
+	};
+	for (auto const & value : keys) {
+		auto const key = as_view(value);
+		if (!first) {
+			assert(previous <= key);
+			if (previous == key) {
+				continue;
+			}
+		}
+		first = false;
+		if (count == block_size) {
+			flush();
+		}
+		if (count == 0) {
+			append_varint(body, key.size());
+			body += key;
+		} else {
+			auto const shared = static_cast<std::size_t>(std::ranges::mismatch(previous, key).in1 - previous.begin());
+			append_varint(body, shared);
+			append_varint(body, key.size() - shared);
+			body += key.substr(shared);
+		}
+		previous = key;
+		++count;
+	}
+	if (count != 0) {
+		flush();
+	}
+}
+
+// An immutable sorted set of strings, stored as blocks of front coded keys
+// (see front_code). Blocks is a random access range of the blocks, such as a
+// string_column or a string_table.
+//
+// Finding a key binary searches the first keys of the blocks, which are
+// stored whole, and then decodes the keys of one block in order. The first
+// keys are the sparse index: there is no other copy of them.
+template<typename Blocks>
+class front_coded_set {
+public:
+	// Reads the keys in order. A key is decoded into the iterator, so the
+	// std::string_view from operator* is valid until the iterator changes.
+	class iterator {
+	public:
+		using value_type = std::string_view;
+		using difference_type = std::ptrdiff_t;
+
+		constexpr iterator() = default;
+
+		constexpr std::string_view operator*() const {
+			return std::string_view(key_.data(), key_.size());
+		}
+		constexpr iterator & operator++() {
+			++index_;
+			if (keys_left_ != 0) {
+				--keys_left_;
+				auto const shared = read_varint(next_, block_end_);
+				auto const size = read_varint(next_, block_end_);
+				if (shared > key_.size() or size > static_cast<std::size_t>(block_end_ - next_)) {
+					throw std::runtime_error("front coded set: key does not fit in its block");
+				}
+				key_.resize(shared + size);
+				std::copy_n(next_, size, key_.data() + shared);
+				next_ += size;
+			} else {
+				if (next_ != block_end_) {
+					throw std::runtime_error("front coded set: bytes after the last key of a block");
+				}
+				if (block_index_ + 1 != set_->block_count()) {
+					start_block(block_index_ + 1);
+				}
+			}
+			return *this;
+		}
+		constexpr iterator operator++(int) {
+			auto result = *this;
+			++*this;
+			return result;
+		}
+
+		// Where the key is in the set
+		constexpr std::size_t index() const {
+			return index_;
+		}
+
+		friend constexpr bool operator==(iterator const & lhs, iterator const & rhs) {
+			return lhs.index_ == rhs.index_;
+		}
+
+	private:
+		friend front_coded_set;
+
+		constexpr iterator(front_coded_set const & set, std::size_t const block_index):
+			set_(&set)
+		{
+			if (block_index == set.block_count()) {
+				index_ = set.size();
+			} else {
+				start_block(block_index);
+			}
+		}
+		constexpr iterator(front_coded_set const & set, std::size_t const block_index, std::size_t const index):
+			set_(&set),
+			index_(index),
+			block_index_(block_index)
+		{
+		}
+
+		constexpr void start_block(std::size_t const block_index) {
+			auto const block = set_->blocks_[block_index];
+			block_index_ = block_index;
+			index_ = block_index * set_->block_size_;
+			keys_left_ = set_->key_count(block_index) - 1;
+			auto const key = set_->first_key(block_index);
+			key_.assign(key.begin(), key.end());
+			next_ = key.data() + key.size();
+			block_end_ = block.data() + block.size();
+		}
+
+		front_coded_set const * set_ = nullptr;
+		std::size_t index_ = 0;
+		std::size_t block_index_ = 0;
+		// How many keys of the block are after this one
+		std::size_t keys_left_ = 0;
+		char const * next_ = nullptr;
+		char const * block_end_ = nullptr;
+		std::vector<char> key_;
+	};
+	using const_iterator = iterator;
+
+	// blocks should be from front_code, but they can come from a file. Like
+	// string_table_view, the constructor only checks what it reads, the first
+	// and last blocks, so that opening a set costs the same however many
+	// blocks there are. Every other block is checked when it is read. Any of
+	// these throw std::runtime_error if a block is not in the format that
+	// front_code writes.
+	constexpr explicit front_coded_set(Blocks blocks):
+		blocks_(std::move(blocks))
+	{
+		if (block_count() == 0) {
+			return;
+		}
+		block_size_ = stored_key_count(0);
+		if (block_size_ > std::numeric_limits<std::size_t>::max() / block_count()) {
+			throw std::runtime_error("front coded set: wrong number of keys in a block");
+		}
+		first_key(0);
+		size_ = (block_count() - 1) * block_size_ + key_count(block_count() - 1);
+		first_key(block_count() - 1);
+	}
+
+	constexpr std::size_t size() const {
+		return size_;
+	}
+	constexpr bool empty() const {
+		return size_ == 0;
+	}
+	constexpr std::size_t block_count() const {
+		return static_cast<std::size_t>(std::ranges::size(blocks_));
+	}
+	constexpr Blocks const & blocks() const {
+		return blocks_;
+	}
+
+	constexpr iterator begin() const {
+		return iterator(*this, 0);
+	}
+	constexpr iterator end() const {
+		return iterator(*this, block_count(), size());
+	}
+
+	// The first key that is not less than key
+	constexpr iterator lower_bound(std::string_view const key) const {
+		// The first block that starts with a key greater than key. The answer
+		// is in the block before it, or is the first key of this one.
+		auto const blocks = std::views::iota(std::size_t(0), block_count());
+		auto const after = *std::ranges::partition_point(blocks, [&](std::size_t const block) {
+			return first_key(block) <= key;
+		});
+		if (after == 0) {
+			return begin();
+		}
+		auto it = iterator(*this, after - 1);
+		auto const last = std::min(after * block_size_, size());
+		while (it.index() != last and *it < key) {
+			++it;
+		}
+		return it;
+	}
+	constexpr bool contains(std::string_view const key) const {
+		auto const it = lower_bound(key);
+		return it != end() and *it == key;
+	}
+
+private:
+	constexpr std::size_t stored_key_count(std::size_t const block) const {
+		auto const view = std::string_view(blocks_[block]);
+		auto it = view.data();
+		return read_varint(it, view.data() + view.size());
+	}
+	// Every block but the last has block_size_ keys
+	constexpr std::size_t key_count(std::size_t const block) const {
+		auto const count = stored_key_count(block);
+		auto const is_last = block + 1 == block_count();
+		if (count == 0 or count > block_size_ or (!is_last and count != block_size_)) {
+			throw std::runtime_error("front coded set: wrong number of keys in a block");
+		}
+		return count;
+	}
+	constexpr std::string_view first_key(std::size_t const block) const {
+		auto const view = std::string_view(blocks_[block]);
+		auto it = view.data();
+		auto const end = view.data() + view.size();
+		read_varint(it, end);
+		auto const size = read_varint(it, end);
+		if (size > static_cast<std::size_t>(end - it)) {
+			throw std::runtime_error("front coded set: key does not fit in its block");
+		}
+		return std::string_view(it, size);
+	}
+
+	Blocks blocks_;
+	std::size_t block_size_ = 0;
+	std::size_t size_ = 0;
+};
+
+static_assert(std::forward_iterator<front_coded_set<string_column<>>::iterator>);
+
+// Front codes sorted keys into a set kept in memory
+template<std::ranges::input_range Range> requires string_like<std::ranges::range_value_t<Range>>
+constexpr auto make_front_coded_set(Range && keys, std::size_t const block_size = 16) {
+	auto blocks = string_column<>();
+	front_code(std::forward<Range>(keys), blocks, block_size);
+	return front_coded_set(std::move(blocks));
+}
+
+
+using allocator_type = std::allocator<char>;
+
+constexpr auto make_string(std::string_view const value) {
+	auto result = string(allocator_type());
+	for (auto const c : value) {
+		result.insert(result.end(), c);
+	}
+	return result;
+}
+
+// Checks every key, and lower_bound of every key and of something just before
+// and just after it
+template<typename Set>
+constexpr bool matches(Set const & set, std::vector<std::string_view> const & expected) {
+	if (set.size() != expected.size() or !std::ranges::equal(set, expected)) {
+		return false;
+	}
+	auto index = std::size_t(0);
+	for (auto it = set.begin(); it != set.end(); ++it) {
+		if (it.index() != index) {
+			return false;
+		}
+		++index;
+	}
+	auto const lower_bound_matches = [&](std::string_view const key) {
+		auto const it = set.lower_bound(key);
+		auto const expected_index = static_cast<std::size_t>(std::ranges::lower_bound(expected, key) - expected.begin());
+		return it.index() == expected_index and (it == set.end() or *it == expected[expected_index]);
+	};
+	for (auto const key : expected) {
+		auto before = std::string(key);
+		if (!before.empty()) {
+			before.pop_back();
+		}
+		if (!set.contains(key) or !lower_bound_matches(key) or !lower_bound_matches(before) or !lower_bound_matches(std::string(key) + '\0') or !lower_bound_matches(std::string(key) + '\xff')) {
+			return false;
+		}
+	}
+	return lower_bound_matches("") and lower_bound_matches("\xff\xff\xff");
+}
+
+constexpr bool test() {
+	{
+		auto out = std::string();
+		append_varint(out, 300);
+		assert(out == "\xac\x02");
+		auto it = static_cast<char const *>(out.data());
+		assert(read_varint(it, out.data() + out.size()) == 300);
+		assert(it == out.data() + out.size());
+
+		auto largest = std::string();
+		append_varint(largest, std::numeric_limits<std::size_t>::max());
+		it = largest.data();
+		assert(read_varint(it, largest.data() + largest.size()) == std::numeric_limits<std::size_t>::max());
+	}
+
+	auto const empty = make_front_coded_set(std::vector<std::string_view>());
+	assert(empty.empty());
+	assert(empty.begin() == empty.end());
+	assert(!empty.contains(""));
+	assert(empty.lower_bound("a") == empty.end());
+
+	auto const keys = std::vector<std::string_view>{
+		"",
+		"/api/v1/orders",
+		"/api/v1/orders/",
+		"/api/v1/orders/{id}",
+		"/api/v1/users",
+		"/api/v1/users/{id}",
+		"/api/v1/users/{id}/orders",
+		"/api/v2/users",
+		"/static",
+		"b",
+	};
+	for (std::size_t block_size = 1; block_size <= keys.size() + 1; ++block_size) {
+		auto const set = make_front_coded_set(keys, block_size);
+		assert(set.block_count() == (keys.size() + block_size - 1) / block_size);
+		assert(matches(set, keys));
+		assert(!set.contains("/api/v1/order"));
+		assert(!set.contains("/api/v3"));
+	}
+
+	// Keys that share long prefixes take fewer bytes than their characters,
+	// even with the sizes and counts
+	auto const set = make_front_coded_set(keys, 4);
+	auto characters = std::size_t(0);
+	for (auto const key : keys) {
+		characters += key.size();
+	}
+	assert(set.blocks().characters().size() < characters);
+
+	// Prototype strings, and a duplicate, which is only stored once
+	auto strings = std::vector<string<allocator_type>>();
+	strings.push_back(make_string("apple"));
+	strings.push_back(make_string("application"));
+	strings.push_back(make_string("application"));
+	strings.push_back(make_string("apply"));
+	auto const from_strings = make_front_coded_set(strings, 2);
+	assert(matches(from_strings, {"apple", "application", "apply"}));
+	return true;
+}
+
+// Blocks that did not come from front_code, such as from a corrupt file
+void test_malformed() {
+	auto const is_rejected = [](std::vector<std::string_view> const & blocks) {
+		try {
+			auto column = string_column<>();
+			for (auto const block : blocks) {
+				column.push_back(block);
+			}
+			auto const set = front_coded_set(std::move(column));
+			for (auto it = set.begin(); it != set.end(); ++it) {
+			}
+		} catch (std::runtime_error const &) {
+			return true;
+		}
+		return false;
+	};
+	using namespace std::string_view_literals;
+	assert(!is_rejected({"\x02\x01" "a" "\x01\x01" "b"sv, "\x01\x01" "c"sv}));
+	// A varint that runs off the end of the block
+	assert(is_rejected({"\x81"sv}));
+	assert(is_rejected({"\x01\x85"sv}));
+	// A varint with more bits than a std::size_t, which would shift by 64
+	assert(is_rejected({"\xff\xff\xff\xff\xff\xff\xff\xff\xff\x7f"sv}));
+	assert(is_rejected({"\x80\x80\x80\x80\x80\x80\x80\x80\x80\x80\x01"sv}));
+	// No keys, or a block other than the last with fewer keys than the first
+	assert(is_rejected({"\x00"sv}));
+	assert(is_rejected({"\xff\xff\xff\xff\xff\xff\xff\xff\x7f\x01" "a"sv, "\x01\x01" "b"sv, "\x01\x01" "c"sv}));
+	assert(is_rejected({"\x02\x01" "a" "\x01\x01" "b"sv, "\x01\x01" "c"sv, "\x02\x01" "d" "\x01\x01" "e"sv}));
+	assert(is_rejected({"\x01\x01" "a"sv, "\x02\x01" "b" "\x01\x01" "c"sv}));
+	// A first key longer than its block
+	assert(is_rejected({"\x01\x05" "ab"sv}));
+	// Later keys that share more than the key before them has, that are
+	// longer than the block, or that are missing, and bytes after the last key
+	assert(is_rejected({"\x02\x01" "a" "\x02\x01" "b"sv}));
+	assert(is_rejected({"\x02\x01" "a" "\x01\x05" "b"sv}));
+	assert(is_rejected({"\x03\x01" "a" "\x01\x01" "b"sv}));
+	assert(is_rejected({"\x01\x01" "a" "\x01\x01" "b"sv}));
+}
+
+std::vector<std::string> random_sorted_keys(std::mt19937_64 & engine, std::size_t const count) {
+	constexpr char alphabet[] = {'\0', 'a', 'b', '/', '\x80', '\xff'};
+	auto result = std::vector<std::string>(count);
+	for (auto & value : result) {
+		for (auto size = engine() % 12; size != 0; --size) {
+			value += alphabet[engine() % std::size(alphabet)];
+		}
+	}
+	std::ranges::sort(result);
+	auto const duplicates = std::ranges::unique(result);
+	result.erase(duplicates.begin(), duplicates.end());
+	return result;
+}
+
+void test_against_vector() {
+	auto engine = std::mt19937_64(1);
+	auto const path = (std::filesystem::temp_directory_path() / "front-coded-set-test.strtable").string();
+	for (int n = 0; n != 200; ++n) {
+		auto const keys = random_sorted_keys(engine, engine() % 500);
+		auto const views = std::vector<std::string_view>(keys.begin(), keys.end());
+		auto const block_size = engine() % 40 + 1;
+		auto const set = make_front_coded_set(keys, block_size);
+		assert(matches(set, views));
+
+		// The same blocks, written to a string table file and mapped
+		auto writer = string_table_writer(file_output(path.c_str()));
+		front_code(keys, writer, block_size);
+		std::move(writer).finish().close();
+		auto const mapped = front_coded_set(string_table(path.c_str()));
+		assert(matches(mapped, views));
+		assert(mapped.block_count() == set.block_count());
+		for (std::size_t block = 0; block != set.block_count(); ++block) {
+			assert(mapped.blocks()[block] == set.blocks()[block]);
+		}
+	}
+	std::filesystem::remove(path);
+}
+
+template<typename Function>
+double nanoseconds_per_operation(std::size_t const count, Function && function) {
+	auto const start = std::chrono::steady_clock::now();
+	function();
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+}
+
+// Routes and search terms that share long prefixes with their neighbors, the
+// way the keys of an autocomplete or routing table do
+std::vector<std::string> make_keys(std::size_t const count) {
+	auto engine = std::mt19937_64(1);
+	constexpr std::string_view prefixes[] = {"/api/v1/customers/", "/api/v1/orders/", "/api/v2/customers/", "/static/images/products/", "how to "};
+	constexpr std::string_view words[] = {"account", "billing", "cancel", "details", "history", "invoice", "refund", "settings", "shipping", "status"};
+	auto result = std::vector<std::string>(count);
+	for (auto & key : result) {
+		key = prefixes[engine() % std::size(prefixes)];
+		key += std::to_string(engine() % 1'000'000);
+		for (auto depth = engine() % 3; depth != 0; --depth) {
+			key += '/';
+			key += words[engine() % std::size(words)];
+		}
+	}
+	std::ranges::sort(result);
+	auto const duplicates = std::ranges::unique(result);
+	result.erase(duplicates.begin(), duplicates.end());
+	return result;
+}
+
+// Bytes for the objects and the characters, not counting the unused capacity
+// of the vector or what malloc adds to each allocation
+std::size_t bytes_used(std::vector<std::string> const & values) {
+	auto result = values.size() * sizeof(std::string);
+	for (auto const & value : values) {
+		if (value.size() >= sizeof(std::string) / 2) {
+			result += value.size() + 1;
+		}
+	}
+	return result;
+}
+
+template<typename Set>
+void benchmark_one(char const * const name, Set const & set, std::size_t const bytes, std::vector<std::string> const & queries, std::size_t const key_count) {
+	auto found = std::size_t(0);
+	auto const lookup_time = nanoseconds_per_operation(queries.size(), [&] {
+		for (auto const & query : queries) {
+			if constexpr (requires { set.contains(query); }) {
+				found += set.contains(query) ? 1 : 0;
+			} else {
+				found += std::ranges::binary_search(set, std::string_view(query)) ? 1 : 0;
+			}
+		}
+	});
+	auto const scan_time = nanoseconds_per_operation(key_count, [&] {
+		auto total = std::size_t(0);
+		for (auto const & key : set) {
+			total += std::string_view(key).size();
+		}
+		assert(total != 0);
+	});
+	std::printf("%-34s %10.1f %10.1f %10.1f %10zu\n", name, static_cast<double>(bytes) / static_cast<double>(key_count), lookup_time, scan_time, found);
+}
+
+void benchmark() {
+	auto const keys = make_keys(2'000'000);
+	auto characters = std::size_t(0);
+	for (auto const & key : keys) {
+		characters += key.size();
+	}
+	// Half of the queries are keys, and half are keys with one character
+	// changed, which are almost never keys
+	auto engine = std::mt19937_64(2);
+	auto queries = std::vector<std::string>(1'000'000);
+	for (auto & query : queries) {
+		query = keys[engine() % keys.size()];
+		if (engine() % 2 == 0) {
+			query[engine() % query.size()] = 'Z';
+		}
+	}
+	std::printf("%zu keys, %.1f characters each\n", keys.size(), static_cast<double>(characters) / static_cast<double>(keys.size()));
+	std::printf("%-34s %10s %10s %10s %10s\n", "", "bytes", "lookup ns", "scan ns", "found");
+
+	benchmark_one("sorted std::vector<std::string>", keys, bytes_used(keys), queries, keys.size());
+	auto column = string_column<>();
+	column.append_range(keys);
+	benchmark_one("sorted string_column", column, column.bytes_used(), queries, keys.size());
+	for (auto const block_size : {8, 16, 64}) {
+		auto const set = make_front_coded_set(keys, static_cast<std::size_t>(block_size));
+		auto const name = "front_coded_set, " + std::to_string(block_size) + " per block";
+		benchmark_one(name.c_str(), set, set.blocks().bytes_used(), queries, keys.size());
+	}
+
+	auto const path = (std::filesystem::temp_directory_path() / "front-coded-set-benchmark.strtable").string();
+	auto writer = string_table_writer(file_output(path.c_str()));
+	front_code(keys, writer);
+	std::move(writer).finish().close();
+	auto mapped = std::optional<front_coded_set<string_table>>();
+	auto const open_time = nanoseconds_per_operation(1, [&] {
+		mapped.emplace(string_table(path.c_str()));
+	});
+	benchmark_one("mapped front_coded_set, 16", *mapped, std::filesystem::file_size(path), queries, keys.size());
+	std::printf("opening the mapped set took %.3f ms\n", open_time / 1e6);
+	std::filesystem::remove(path);
+}
+
+int main() {
+	test();
+	static_assert(test());
+	test_malformed();
+	test_against_vector();
+	benchmark();
+}
@@ -0,0 +1,1268 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is to give both layouts a
+// std::hash that takes advantage of the small buffer, and to avoid hashing
+// the same large string more than once.
+//
+// Strings of up to 24 characters hash as three 64-bit words, padded with 0,
+// plus the size. A small string already is those words, because every byte
+// of the small buffer past the size is 0 (see comparison.cpp), so hashing it
+// is three loads and a fixed amount of arithmetic with no loop over the
+// characters. Longer strings run four lanes over each 32-byte block. Equal
+// characters hash the same in either layout and through std::string_view.
+//
+// Large strings cache their hash in a slot at the start of their heap
+// allocation, so the object layout does not change. The member functions that
+// change the characters, insert and pop_back, clear it. Writing through data()
+// or an iterator does not, so a large string must not be hashed again after
+// characters are changed that way. Compile with -DSTRING_CACHE_HASH=0 to turn
+// this off.
+//
+// hash_batch hashes a span of strings one at a time. Hashing four short
+// strings at once in AVX2 lanes was about twice as slow, because gathering the
+// words of four strings into one vector costs more than the scalar hash.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <compare>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+template<typename T>
+struct buffer {
+	constexpr buffer() = default;
+	buffer(buffer &&) = delete;
+	buffer(buffer const &) = delete;
+	buffer & operator=(buffer &&) = delete;
+	buffer & operator=(buffer const &) = delete;
+
+	alignas(std::size_t) T data[5000] = {};
+	T * pointer = data;
+};
+
+template<typename T>
+struct allocator {
+	using value_type = T;
+
+	explicit constexpr allocator(buffer<T> & buffer):
+		buffer_(&buffer)
+	{
+	}
+
+	constexpr auto allocate(std::size_t size) {
+		auto const result = buffer_->pointer;
+		buffer_->pointer += size;
+		return result;
+	}
+	constexpr void deallocate(T * ptr, std::size_t size) {
+	}
+
+private:
+	buffer<T> * buffer_;
+};
+
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+
+// Reads bytes in memory order, so that comparing two words as integers
+// compares them as unsigned characters, the same as memcmp.
+inline std::uint64_t load_big_endian(char const * const data) {
+	auto result = std::uint64_t();
+	std::memcpy(&result, data, sizeof(result));
+	if constexpr (std::endian::native == std::endian::little) {
+		result = __builtin_bswap64(result);
+	}
+	return result;
+}
+
+// The offsets of the words covering a small buffer of `capacity` bytes. The
+// last word overlaps the one before it when capacity is not a multiple of the
+// word size. The overlapping bytes are already known to be equal by the time
+// the last word matters, so this does not change any result.
+template<std::size_t capacity>
+constexpr auto word_offsets = [] {
+	static_assert(capacity >= sizeof(std::uint64_t));
+	constexpr auto word = sizeof(std::uint64_t);
+	auto result = std::array<std::size_t, (capacity + word - 1) / word>();
+	for (std::size_t n = 0; n != result.size(); ++n) {
+		result[n] = std::min(n * word, capacity - word);
+	}
+	return result;
+}();
+
+// These rely on every byte of both buffers past the size being 0.
+
+template<std::size_t capacity>
+bool small_buffer_equal(char const * const lhs, char const * const rhs) {
+	auto difference = std::uint64_t(0);
+	for (auto const offset : word_offsets<capacity>) {
+		difference |= load_big_endian(lhs + offset) ^ load_big_endian(rhs + offset);
+	}
+	return difference == 0;
+}
+
+// Bytes past the end of the shorter string are 0 in that string, and at
+// least 0 in the longer one, so comparing them cannot put the longer string
+// first. If everything matches, the shorter string is a prefix of the longer.
+template<std::size_t capacity>
+std::strong_ordering small_buffer_compare(char const * const lhs, std::size_t const lhs_size, char const * const rhs, std::size_t const rhs_size) {
+	for (auto const offset : word_offsets<capacity>) {
+		auto const lhs_word = load_big_endian(lhs + offset);
+		auto const rhs_word = load_big_endian(rhs + offset);
+		if (lhs_word != rhs_word) {
+			return lhs_word <=> rhs_word;
+		}
+	}
+	return lhs_size <=> rhs_size;
+}
+
+// glibc's memcmp, which this calls at run time, is already vectorized.
+constexpr std::strong_ordering compare(char const * const lhs, std::size_t const lhs_size, char const * const rhs, std::size_t const rhs_size) {
+	auto const result = std::char_traits<char>::compare(lhs, rhs, std::min(lhs_size, rhs_size));
+	return result != 0 ? result <=> 0 : lhs_size <=> rhs_size;
+}
+
+
+// Define STRING_CACHE_HASH to 0 to hash large strings every time.
+#ifndef STRING_CACHE_HASH
+	#define STRING_CACHE_HASH 1
+#endif
+
+constexpr auto cache_hashes = bool(STRING_CACHE_HASH);
+
+// Reads bytes in little-endian order on every target, so that a hash computed
+// during constant evaluation matches the one computed at run time.
+constexpr std::uint64_t load_little_endian(char const * const data) {
+	auto result = std::uint64_t(0);
+	if (std::is_constant_evaluated()) {
+		for (std::size_t n = 0; n != sizeof(result); ++n) {
+			result |= std::uint64_t(static_cast<unsigned char>(data[n])) << (n * CHAR_BIT);
+		}
+		return result;
+	}
+	std::memcpy(&result, data, sizeof(result));
+	if constexpr (std::endian::native == std::endian::big) {
+		result = __builtin_bswap64(result);
+	}
+	return result;
+}
+
+// Strings of up to this many characters hash as three words, padded with 0.
+constexpr std::size_t short_hash_size = 24;
+using short_hash_words = std::array<std::uint64_t, short_hash_size / sizeof(std::uint64_t)>;
+
+constexpr std::uint64_t hash_keys[] = {
+	0xbe4b'a423'396c'feb8,
+	0x1cad'21f7'2c81'017c,
+	0xdb97'9083'e96d'd4de,
+	0x1f67'b3b7'a4a4'4072,
+};
+constexpr std::uint64_t size_key = 0x9e37'79b1'85eb'ca87;
+constexpr std::uint64_t lane_multiplier = 0x9fb2'1c65'1e98'df25;
+
+// The multiply is of the 32-bit halves of the keyed word, which the compiler
+// can vectorize with a 32 by 32 to 64-bit multiply such as _mm256_mul_epu32. Adding the word with its halves
+// swapped keeps a word from being lost when one of those halves is 0.
+constexpr std::uint64_t accumulate(std::uint64_t const word, std::uint64_t const key) {
+	auto const keyed = word ^ key;
+	return (keyed & 0xffff'ffff) * (keyed >> 32) + std::rotl(word, 32);
+}
+
+constexpr std::uint64_t avalanche(std::uint64_t hash) {
+	hash ^= hash >> 37;
+	hash *= 0x1656'6791'9e37'79f9;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+constexpr std::size_t hash_short(short_hash_words const & words, std::size_t const size) {
+	auto result = size * size_key;
+	for (std::size_t n = 0; n != words.size(); ++n) {
+		result += accumulate(words[n], hash_keys[n]);
+	}
+	return avalanche(result);
+}
+
+// Each lane takes one word of every 32-byte block, and the last block
+// overlaps the one before it. Multiplying the lanes between blocks makes the
+// result depend on the order of the blocks.
+constexpr std::size_t hash_long(char const * const data, std::size_t const size) {
+	assert(size > short_hash_size);
+	constexpr auto block_size = std::size(hash_keys) * sizeof(std::uint64_t);
+	auto lanes = std::array<std::uint64_t, std::size(hash_keys)>();
+	auto add_block = [&](auto const word_offset) {
+		for (std::size_t n = 0; n != lanes.size(); ++n) {
+			lanes[n] = (lanes[n] + accumulate(load_little_endian(data + word_offset(n)), hash_keys[n])) * lane_multiplier;
+		}
+	};
+	if (size < block_size) {
+		add_block([=](std::size_t const n) { return std::min(n * sizeof(std::uint64_t), size - sizeof(std::uint64_t)); });
+	} else {
+		auto offset = std::size_t(0);
+		for (; offset + block_size <= size; offset += block_size) {
+			add_block([=](std::size_t const n) { return offset + n * sizeof(std::uint64_t); });
+		}
+		if (offset != size) {
+			add_block([=](std::size_t const n) { return size - block_size + n * sizeof(std::uint64_t); });
+		}
+	}
+	auto result = size * size_key;
+	for (std::size_t n = 0; n != lanes.size(); ++n) {
+		result += std::rotl(lanes[n], static_cast<int>(n * 16));
+	}
+	return avalanche(result);
+}
+
+constexpr short_hash_words padded_words(char const * const data, std::size_t const size) {
+	assert(size <= short_hash_size);
+	char padded[short_hash_size] = {};
+	copy(data, data + size, padded);
+	auto result = short_hash_words();
+	for (std::size_t n = 0; n != result.size(); ++n) {
+		result[n] = load_little_endian(padded + n * sizeof(std::uint64_t));
+	}
+	return result;
+}
+
+// This relies on every byte of the buffer past the size being 0. When the
+// buffer ends partway through the last word, that word is loaded from the end
+// of the buffer and shifted down, which fills the rest of it with 0.
+template<std::size_t capacity>
+short_hash_words small_buffer_words(char const * const buffer) {
+	static_assert(capacity >= 2 * sizeof(std::uint64_t) and capacity <= short_hash_size);
+	auto last = std::uint64_t(0);
+	if constexpr (capacity > 2 * sizeof(std::uint64_t)) {
+		last = load_little_endian(buffer + capacity - sizeof(std::uint64_t)) >> ((short_hash_size - capacity) * CHAR_BIT);
+	}
+	return {load_little_endian(buffer), load_little_endian(buffer + sizeof(std::uint64_t)), last};
+}
+
+// Hashes the same way as either string, so it can look them up by
+// std::string_view.
+constexpr std::size_t hash_bytes(char const * const data, std::size_t const size) {
+	return size <= short_hash_size ? hash_short(padded_words(data, size), size) : hash_long(data, size);
+}
+
+
+// With hash caching on, every heap allocation starts with a slot that holds
+// the hash of the string, or 0 if it is not known, followed by the
+// characters. Allocations are rounded up to a multiple of the slot size so
+// that every slot is aligned. Constant evaluation does not use the slot.
+constexpr std::size_t hash_slot_size = sizeof(std::size_t);
+
+constexpr std::size_t heap_allocation_size(std::size_t const capacity) {
+	return (capacity + 2 * hash_slot_size - 1) / hash_slot_size * hash_slot_size;
+}
+
+template<typename Allocator>
+constexpr char * allocate_heap(Allocator & alloc, std::size_t const capacity) {
+	using Alloc = allocator_traits<Allocator>;
+	if (std::is_constant_evaluated() or !cache_hashes) {
+		return Alloc::allocate(alloc, capacity);
+	}
+	auto const allocation = Alloc::allocate(alloc, heap_allocation_size(capacity));
+	::new(static_cast<void *>(allocation)) std::size_t(0);
+	return allocation + hash_slot_size;
+}
+
+template<typename Allocator>
+constexpr void deallocate_heap(Allocator & alloc, char * const data, std::size_t const capacity) {
+	using Alloc = allocator_traits<Allocator>;
+	if (std::is_constant_evaluated() or !cache_hashes) {
+		Alloc::deallocate(alloc, data, capacity);
+	} else {
+		Alloc::deallocate(alloc, data - hash_slot_size, heap_allocation_size(capacity));
+	}
+}
+
+inline std::atomic_ref<std::size_t> hash_slot(char * const data) {
+	return std::atomic_ref(*std::launder(reinterpret_cast<std::size_t *>(data - hash_slot_size)));
+}
+
+inline void invalidate_hash(char * const data) {
+	if constexpr (cache_hashes) {
+		hash_slot(data).store(0, std::memory_order_relaxed);
+	}
+}
+
+// Relaxed is enough: hash is const, so every thread that computes the hash of
+// the same characters stores the same value. A hash that happens to be 0 is
+// never cached.
+inline std::size_t cached_hash(char * const data, std::size_t const size) {
+	if constexpr (!cache_hashes) {
+		return hash_long(data, size);
+	} else {
+		auto const slot = hash_slot(data);
+		auto result = slot.load(std::memory_order_relaxed);
+		if (result == 0) {
+			result = hash_long(data, size);
+			slot.store(result, std::memory_order_relaxed);
+		}
+		return result;
+	}
+}
+
+
+
+
+namespace clang {
+
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = allocator<char>;
+
+private:
+	static constexpr std::size_t small_buffer_capacity = 23;
+
+	struct small_t {
+		char data[small_buffer_capacity] = {};
+	};
+	struct [[gnu::packed]] large_t {
+		static constexpr std::size_t bytes_remaining = 7;
+
+		template<typename It>
+		class range_view {
+		public:
+			constexpr range_view(It first, It last):
+				first_(first),
+				last_(last)
+			{
+			}
+			constexpr auto begin() const {
+				return first_;
+			}
+			constexpr auto end() const {
+				return last_;
+			}
+		private:
+			It first_;
+			It last_;
+		};
+
+		constexpr auto little_endian_capacity() const {
+			return range_view(
+				std::rbegin(rest_of_capacity),
+				std::rend(rest_of_capacity)
+			);
+		}
+		constexpr auto big_endian_capacity() {
+			return range_view(
+				std::begin(rest_of_capacity),
+				std::end(rest_of_capacity)
+			);
+		}
+
+		constexpr large_t(std::size_t set_size, std::size_t capacity, char * pointer) noexcept:
+			rest_of_capacity{},
+			size(set_size),
+			data(pointer)
+		{
+			assert(data != nullptr);
+			for (unsigned char & byte : big_endian_capacity()) {
+				capacity >>= CHAR_BIT;
+				byte = capacity;
+			}
+		}
+
+		unsigned char rest_of_capacity[bytes_remaining];
+		std::size_t size;
+		char * data;
+	};
+
+	[[no_unique_address]] allocator_type allocator_;
+	unsigned char size_or_first_byte_of_capacity_;
+	union U {
+		constexpr U() noexcept:
+			small{}
+		{
+		}
+		explicit constexpr U(std::size_t size, std::size_t capacity, char * data) noexcept:
+			large(size, capacity, data)
+		{
+		}
+		constexpr U(large_t set_large) noexcept:
+			large(set_large)
+		{
+		}
+
+		small_t small;
+		large_t large;
+	} u_;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return size_or_first_byte_of_capacity_ & 1;
+	}
+
+	constexpr void increment_size() {
+		if (is_large()) {
+			++u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ += (1 << 1);
+		}
+	}
+	constexpr void decrement_size() {
+		if (is_large()) {
+			--u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ -= (1 << 1);
+		}
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			deallocate_heap(alloc, u_.large.data, capacity());
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(size(), new_capacity, new_data);
+		assert(new_capacity & 1);
+		size_or_first_byte_of_capacity_ = new_capacity;
+	}
+
+	constexpr void clear_cached_hash() {
+		if (is_large() and !std::is_constant_evaluated()) {
+			invalidate_hash(data());
+		}
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		new_capacity |= 1;
+		auto alloc = get_allocator();
+		char * temp = allocate_heap(alloc, new_capacity);
+		copy(begin(), end(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		size_or_first_byte_of_capacity_(0),
+		u_{}
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.large);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+
+			other.u_ = U{};
+			other.size_or_first_byte_of_capacity_ = 0;
+		} else {
+			auto & osmall = other.u_.small;
+			u_ = U{};
+			copy(osmall.data, osmall.data + (other.size_or_first_byte_of_capacity_ >> 1), u_.small.data);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	// Does not clear the cached hash (see the top of the file)
+	constexpr char * data() {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr std::size_t size() const {
+		return is_large() ? u_.large.size : (size_or_first_byte_of_capacity_ >> 1);
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		if (!is_large()) {
+			return small_buffer_capacity;
+		}
+		std::size_t result = 0;
+		for (unsigned char const byte : u_.large.little_endian_capacity()) {
+			result |= byte;
+			result <<= CHAR_BIT;
+		}
+		result |= size_or_first_byte_of_capacity_;
+		return result;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		auto const local_size = size();
+		if (is_large() && capacity() > (local_size | 1)) {
+			if (local_size > small_buffer_capacity) {
+				force_reserve(local_size);
+			} else {
+				auto const data = u_.large.data;
+				auto const original_capacity = capacity();
+				u_ = U{};
+				size_or_first_byte_of_capacity_ = local_size << 1;
+				copy(data, data + local_size, u_.small.data);
+				auto alloc = get_allocator();
+				deallocate_heap(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		clear_cached_hash();
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = std::prev(end());
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = (capacity() * growth_factor) | 1;
+
+			auto alloc = get_allocator();
+			char * temp = allocate_heap(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+
+			relocate(temp, new_capacity);
+		}
+		increment_size();
+		return begin() + offset;
+	}
+
+	constexpr void pop_back() {
+		clear_cached_hash();
+		decrement_size();
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+		// Keeps the bytes of the small buffer past the size 0, which the
+		// comparisons and the hash rely on
+		*end() = '\0';
+	}
+
+	friend constexpr bool operator==(string const & lhs, string const & rhs) {
+		if (!std::is_constant_evaluated() and !lhs.is_large() and !rhs.is_large()) {
+			return lhs.size_or_first_byte_of_capacity_ == rhs.size_or_first_byte_of_capacity_ and small_buffer_equal<small_buffer_capacity>(lhs.u_.small.data, rhs.u_.small.data);
+		}
+		return lhs.size() == rhs.size() and std::char_traits<char>::compare(lhs.data(), rhs.data(), lhs.size()) == 0;
+	}
+	friend constexpr std::strong_ordering operator<=>(string const & lhs, string const & rhs) {
+		if (!std::is_constant_evaluated() and !lhs.is_large() and !rhs.is_large()) {
+			return small_buffer_compare<small_buffer_capacity>(lhs.u_.small.data, lhs.size(), rhs.u_.small.data, rhs.size());
+		}
+		return compare(lhs.data(), lhs.size(), rhs.data(), rhs.size());
+	}
+
+	// Requires size() <= short_hash_size
+	constexpr short_hash_words hash_words() const {
+		if (!std::is_constant_evaluated() and !is_large()) {
+			return small_buffer_words<small_buffer_capacity>(u_.small.data);
+		}
+		return padded_words(data(), size());
+	}
+	constexpr std::size_t hash() const {
+		if (size() <= short_hash_size) {
+			return hash_short(hash_words(), size());
+		}
+		if (std::is_constant_evaluated()) {
+			return hash_long(data(), size());
+		}
+		return cached_hash(u_.large.data, u_.large.size);
+	}
+};
+
+} // namespace clang
+
+namespace gcc {
+
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = allocator<char>;
+
+private:
+	[[no_unique_address]] allocator_type allocator_;
+	// This could be set to 8 to reduce the size of our string to 24 bytes
+	// (just like clang), but 7 characters (plus a null terminator) is likely
+	// too small of a buffer for most users.
+	static constexpr std::size_t small_buffer_capacity = 16;
+	union U{
+		constexpr U():
+			buffer{}
+		{
+		}
+		constexpr U(std::size_t c):
+			capacity(c)
+		{
+		}
+
+		char buffer[small_buffer_capacity];
+		std::size_t capacity;
+	} u_;
+	char * data_;
+	std::size_t size_ : 63;
+	// gcc and MSVC do not allow accessing the inactive member of a union just
+	// to get its address, so we use a bitfield to work around this.
+	bool is_large_ : 1;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return is_large_;
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			deallocate_heap(alloc, data_, u_.capacity);
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(new_capacity);
+		data_ = new_data;
+		is_large_ = true;
+	}
+
+	constexpr void clear_cached_hash() {
+		if (is_large() and !std::is_constant_evaluated()) {
+			invalidate_hash(data());
+		}
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		auto alloc = get_allocator();
+		char * temp = allocate_heap(alloc, new_capacity);
+		copy(begin(), end(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_{},
+		data_(u_.buffer),
+		size_(0),
+		is_large_(false)
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.capacity);
+			other.u_ = U{};
+		
+			data_ = other.data_;
+			other.data_ = other.u_.buffer;
+		
+			size_ = other.size_;
+			other.size_ = 0U;
+		
+			is_large_ = true;
+			other.is_large_ = false;
+
+		} else {
+			u_ = U{};
+			copy(other.data_, other.data_ + other.size_, u_.buffer);
+			data_ = u_.buffer;
+			size_ = other.size_;
+			is_large_ = false;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return data_;
+	}
+	// Does not clear the cached hash (see the top of the file)
+	constexpr char * data() {
+		return data_;
+	}
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		return is_large() ? u_.capacity : small_buffer_capacity;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		if (is_large() && capacity() > size()) {
+			if (size() > small_buffer_capacity) {
+				force_reserve(size());
+			} else {
+				auto const data = data_;
+				auto const original_capacity = u_.capacity;
+				u_ = U{};
+				copy(data, data + size_, u_.buffer);
+				data_ = u_.buffer;
+				is_large_ = false;
+				auto alloc = get_allocator();
+				deallocate_heap(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		clear_cached_hash();
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = end() - 1;
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = capacity() * growth_factor;
+
+			auto alloc = get_allocator();
+			char * temp = allocate_heap(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+		
+			relocate(temp, new_capacity);
+		}
+		++size_;
+		return begin() + offset;
+	}
+
+	constexpr void pop_back() {
+		clear_cached_hash();
+		--size_;
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+		// Keeps the bytes of the small buffer past the size 0, which the
+		// comparisons and the hash rely on
+		*end() = '\0';
+	}
+
+	friend constexpr bool operator==(string const & lhs, string const & rhs) {
+		if (!std::is_constant_evaluated() and !lhs.is_large() and !rhs.is_large()) {
+			return lhs.size_ == rhs.size_ and small_buffer_equal<small_buffer_capacity>(lhs.u_.buffer, rhs.u_.buffer);
+		}
+		return lhs.size() == rhs.size() and std::char_traits<char>::compare(lhs.data(), rhs.data(), lhs.size()) == 0;
+	}
+	friend constexpr std::strong_ordering operator<=>(string const & lhs, string const & rhs) {
+		if (!std::is_constant_evaluated() and !lhs.is_large() and !rhs.is_large()) {
+			return small_buffer_compare<small_buffer_capacity>(lhs.u_.buffer, lhs.size_, rhs.u_.buffer, rhs.size_);
+		}
+		return compare(lhs.data(), lhs.size(), rhs.data(), rhs.size());
+	}
+
+	// Requires size() <= short_hash_size
+	constexpr short_hash_words hash_words() const {
+		if (!std::is_constant_evaluated() and !is_large()) {
+			return small_buffer_words<small_buffer_capacity>(u_.buffer);
+		}
+		return padded_words(data(), size());
+	}
+	constexpr std::size_t hash() const {
+		if (size() <= short_hash_size) {
+			return hash_short(hash_words(), size());
+		}
+		if (std::is_constant_evaluated()) {
+			return hash_long(data(), size());
+		}
+		return cached_hash(data_, size_);
+	}
+};
+
+} // namespace gcc
+
+template<>
+struct std::hash<clang::string> {
+	constexpr std::size_t operator()(clang::string const & str) const {
+		return str.hash();
+	}
+};
+
+template<>
+struct std::hash<gcc::string> {
+	constexpr std::size_t operator()(gcc::string const & str) const {
+		return str.hash();
+	}
+};
+
+// Lets unordered containers of either string look up by std::string_view
+// without building a string.
+struct string_hash {
+	using is_transparent = void;
+
+	constexpr std::size_t operator()(std::string_view const str) const {
+		return hash_bytes(str.data(), str.size());
+	}
+	constexpr std::size_t operator()(clang::string const & str) const {
+		return str.hash();
+	}
+	constexpr std::size_t operator()(gcc::string const & str) const {
+		return str.hash();
+	}
+};
+
+
+// Gives the same results as calling hash on each string
+template<typename String>
+constexpr void hash_batch(std::span<String const> const strings, std::span<std::size_t> const result) {
+	assert(strings.size() == result.size());
+	for (std::size_t n = 0; n != strings.size(); ++n) {
+		result[n] = strings[n].hash();
+	}
+}
+
+template<typename String>
+constexpr String make_string(allocator<char> alloc, std::string_view const source) {
+	auto result = String(alloc);
+	for (char const c : source) {
+		result.insert(result.end(), c);
+	}
+	return result;
+}
+
+constexpr void test_individual(auto & str, char const * source) {
+	using String = std::remove_reference_t<decltype(str)>;
+	String temp(str.get_allocator());
+	for (auto it = source; *it != '\0'; ++it) {
+		str.insert(str.end(), *it);
+		temp.insert(temp.end(), *it);
+	}
+
+	temp.insert(temp.begin(), 'a');
+	temp.insert(temp.begin() + temp.size() / 2, 'b');
+	auto const size = std::char_traits<char>::length(source);
+	auto const middle = (size + 1) / 2;
+	assert(temp.size() == size + 2);
+	for (std::size_t n = 0; n != temp.size(); ++n) {
+		auto const expected = n == 0 ? 'a' : n == middle ? 'b' : n < middle ? source[n - 1] : source[n - 2];
+		assert(temp.data()[n] == expected);
+	}
+
+	// Inserting at the front, including each time that reallocates
+	String front(str.get_allocator());
+	for (std::size_t n = 0; n != 100; ++n) {
+		front.insert(front.begin(), static_cast<char>('0' + n % 10));
+	}
+	for (std::size_t n = 0; n != front.size(); ++n) {
+		assert(front.data()[n] == static_cast<char>('0' + (99 - n) % 10));
+	}
+
+	while (temp.size() != 0) {
+		temp.pop_back();
+	}
+	assert(temp.size() == 0);
+
+	auto temp2 = std::move(str);
+	str = std::move(temp2);
+
+	assert(str.data() != temp.data());
+	assert(str.size() == std::char_traits<char>::length(source));
+	assert(std::char_traits<char>::compare(str.data(), source, str.size()) == 0);
+	assert(str.capacity() >= str.size());
+
+	str.reserve(50);
+	str.shrink_to_fit();
+}
+
+template<typename String>
+constexpr void test_hash(allocator<char> alloc) {
+	auto hash = [](String const & str) {
+		return std::hash<String>()(str);
+	};
+	auto const empty = String(alloc);
+	auto const abc = make_string<String>(alloc, "abc");
+	auto const long_source = std::string_view("0123456789012345678901234567890123456789");
+
+	assert(hash(empty) == hash_bytes("", 0));
+	assert(hash(abc) == hash_bytes("abc", 3));
+	assert(hash(abc) != hash(empty));
+	assert(hash(abc) != hash(make_string<String>(alloc, "abd")));
+	assert(hash(make_string<String>(alloc, std::string_view("\0", 1))) != hash(empty));
+
+	auto popped = make_string<String>(alloc, "abcd");
+	popped.pop_back();
+	assert(hash(popped) == hash(abc));
+
+	auto large = make_string<String>(alloc, long_source);
+	assert(hash(large) == hash_bytes(long_source.data(), long_source.size()));
+	large.pop_back();
+	assert(hash(large) == hash_bytes(long_source.data(), long_source.size() - 1));
+
+	// Inserting without reallocating, into a string whose hash is cached
+	auto inserted = make_string<String>(alloc, long_source);
+	inserted.reserve(100);
+	assert(hash(inserted) == hash_bytes(long_source.data(), long_source.size()));
+	inserted.insert(inserted.begin() + 5, 'x');
+	assert(hash(inserted) == hash(make_string<String>(alloc, "01234x56789012345678901234567890123456789")));
+
+	auto shrunk = make_string<String>(alloc, "abc");
+	shrunk.reserve(100);
+	assert(hash(shrunk) == hash(abc));
+	shrunk.shrink_to_fit();
+	assert(hash(shrunk) == hash(abc));
+}
+
+template<typename String>
+constexpr void test_layout() {
+	buffer<char> buff{};
+	auto alloc = allocator(buff);
+
+	char const * short_source = "0123";
+	char const * long_source =
+		"0123456789"
+		"0123456789"
+		"0123456789"
+		"0123456789"
+		"0123456789";
+
+	String short_str(alloc);
+	test_individual(short_str, short_source);
+
+	String long_str(alloc);
+	test_individual(long_str, long_source);
+
+	String temp(alloc);
+	temp = std::move(long_str);
+	temp = std::move(short_str);
+
+	test_hash<String>(alloc);
+}
+
+constexpr bool test() {
+	test_layout<clang::string>();
+	test_layout<gcc::string>();
+	return true;
+}
+
+// Checks every size from 0 to 100 against hash_bytes, for strings built
+// directly, by popping characters from a longer string, and by shrinking a
+// large string back into the small buffer. A cached hash must be cleared by
+// insert and pop_back, and the batched hash must match hashing one at a time.
+template<typename String>
+void test_run_time() {
+	auto engine = std::minstd_rand(1);
+	auto random_string = [&](std::size_t const size) {
+		auto result = std::string(size, ' ');
+		for (char & c : result) {
+			c = static_cast<char>(std::uniform_int_distribution(0, 255)(engine));
+		}
+		return result;
+	};
+	auto storage = std::make_unique<buffer<char>>();
+	auto alloc = allocator(*storage);
+	for (std::size_t size = 0; size != 100; ++size) {
+		storage = std::make_unique<buffer<char>>();
+		alloc = allocator(*storage);
+		auto const source = random_string(size);
+		auto const expected = hash_bytes(source.data(), source.size());
+
+		auto const direct = make_string<String>(alloc, source);
+		assert(direct.hash() == expected);
+		assert(direct.hash() == expected);
+
+		auto popped = make_string<String>(alloc, source + "abcdefghijklmnopqrstuvwxyz");
+		assert(popped.hash() != expected);
+		for (std::size_t n = 0; n != 26; ++n) {
+			popped.pop_back();
+		}
+		assert(popped.hash() == expected);
+		popped.insert(popped.end(), 'x');
+		assert(popped.hash() == hash_bytes((source + 'x').data(), size + 1));
+
+		auto shrunk = make_string<String>(alloc, source);
+		shrunk.reserve(200);
+		assert(shrunk.hash() == expected);
+		shrunk.shrink_to_fit();
+		assert(shrunk.hash() == expected);
+		assert(string_hash()(shrunk) == string_hash()(std::string_view(source)));
+	}
+
+	storage = std::make_unique<buffer<char>>();
+	alloc = allocator(*storage);
+	auto strings = std::vector<String>();
+	for (std::size_t n = 0; n != 103; ++n) {
+		auto const size = n % 7 == 0 ? std::size_t(30) : std::uniform_int_distribution<std::size_t>(0, short_hash_size)(engine);
+		strings.push_back(make_string<String>(alloc, random_string(size)));
+	}
+	auto batched = std::vector<std::size_t>(strings.size());
+	hash_batch(std::span<String const>(strings), std::span(batched));
+	for (std::size_t n = 0; n != strings.size(); ++n) {
+		assert(batched[n] == strings[n].hash());
+	}
+}
+
+// Every string of up to two bytes, and of three bytes from a small alphabet,
+// gets a different hash.
+void test_collisions() {
+	auto hashes = std::unordered_set<std::size_t>();
+	auto expected_size = std::size_t(0);
+	auto add = [&](std::string_view const str) {
+		hashes.insert(hash_bytes(str.data(), str.size()));
+		++expected_size;
+		assert(hashes.size() == expected_size);
+	};
+	add("");
+	for (int a = 0; a != 256; ++a) {
+		add(std::string(1, static_cast<char>(a)));
+		for (int b = 0; b != 256; ++b) {
+			add(std::string{static_cast<char>(a), static_cast<char>(b)});
+		}
+	}
+	constexpr auto alphabet = std::string_view("abcdefghijklmnopqrstuvwxyz0123456789_");
+	for (char const a : alphabet) {
+		for (char const b : alphabet) {
+			for (char const c : alphabet) {
+				add(std::string{a, b, c});
+				add(std::string(40, '.') + a + b + c);
+			}
+		}
+	}
+}
+
+template<typename Function>
+double nanoseconds_per_hash(std::size_t const count, Function && function) {
+	auto const start = std::chrono::steady_clock::now();
+	function();
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+}
+
+// Hashes the same keys repeatedly, the way a hash join probes with the same
+// build-side keys.
+void benchmark() {
+	constexpr auto repetitions = std::size_t(100);
+	auto engine = std::minstd_rand(1);
+	auto sink = std::size_t(0);
+	auto run = [&](char const * const name, std::size_t const count, std::size_t const min_size, std::size_t const max_size) {
+		auto keys = std::vector<std::string>(count);
+		for (auto & key : keys) {
+			key.resize(std::uniform_int_distribution(min_size, max_size)(engine));
+			for (char & c : key) {
+				c = static_cast<char>(std::uniform_int_distribution(32, 126)(engine));
+			}
+		}
+		// Building a string of 200 characters one at a time allocates about
+		// 700 bytes from the bump allocator.
+		auto buffers = std::vector<std::unique_ptr<buffer<char>>>();
+		auto strings = std::vector<clang::string>();
+		for (auto const & key : keys) {
+			if (buffers.empty() or std::end(buffers.back()->data) - buffers.back()->pointer < 1024) {
+				buffers.push_back(std::make_unique<buffer<char>>());
+			}
+			strings.push_back(make_string<clang::string>(allocator(*buffers.back()), key));
+		}
+
+		auto const total = count * repetitions;
+		auto const std_time = nanoseconds_per_hash(total, [&] {
+			for (std::size_t n = 0; n != repetitions; ++n) {
+				for (auto const & key : keys) {
+					sink += std::hash<std::string>()(key);
+				}
+			}
+		});
+		auto const single_time = nanoseconds_per_hash(total, [&] {
+			for (std::size_t n = 0; n != repetitions; ++n) {
+				for (auto const & str : strings) {
+					sink += str.hash();
+				}
+			}
+		});
+		std::printf("%-20s %14.2f %14.2f\n", name, std_time, single_time);
+	};
+	std::printf("%-20s %14s %14s   (ns per hash)\n", "characters", "std::string", "hash");
+	run("0 to 24", 10'000, 0, 24);
+	run("100 to 200", 1'000, 100, 200);
+	std::printf("(checksum %zu)\n", sink % 10);
+}
+
+int main() {
+	test();
+	static_assert(test());
+	test_run_time<clang::string>();
+	test_run_time<gcc::string>();
+	test_collisions();
+	benchmark();
+}
@@ -0,0 +1,1812 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is to sort, search, and
+// transform large ranges of strings on many threads, and get the same result
+// as doing it on one.
+//
+// thread_pool is a small work-stealing pool. parallel_for splits its range in
+// half, queues one half, and keeps going with the other, so an idle thread
+// steals the largest piece of work that is left. Every algorithm here splits
+// its input into blocks that depend only on the size of the input. Each block
+// writes its own result, and those results are combined in block order, so
+// which thread ran which block never shows up in the result.
+//
+// parallel_sort reads the key of each string the same way as string-sort.cpp
+// and splits the keys into buckets by value. It sorts the buckets at the same
+// time with the radix sort from there, and then moves each string once.
+// parallel_transform can write strings that use per_thread_allocator from
+// concurrent-allocator.cpp, so each thread allocates from its own chunk of an
+// arena instead of contending on malloc.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <random>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+constexpr auto cache_line_size = std::size_t(64);
+
+// Every buffer, and every reset of one, takes an id that no other buffer has
+// had, so that a chunk a thread cached from a buffer that has since been
+// destroyed is never taken for a chunk of a new buffer at the same address.
+// 0 is never used.
+inline std::atomic<std::uint64_t> next_buffer_id = 1;
+
+// Unlike buffer, this lives on the heap: an arena shared by many threads is
+// much larger than anything we want on a stack.
+template<typename T>
+struct concurrent_buffer {
+	static_assert(cache_line_size % sizeof(T) == 0);
+	static constexpr auto elements_per_cache_line = cache_line_size / sizeof(T);
+
+	explicit concurrent_buffer(std::size_t const size):
+		data(static_cast<T *>(::operator new(size * sizeof(T), std::align_val_t(cache_line_size)))),
+		size(size)
+	{
+	}
+	concurrent_buffer(concurrent_buffer &&) = delete;
+	concurrent_buffer(concurrent_buffer const &) = delete;
+	concurrent_buffer & operator=(concurrent_buffer &&) = delete;
+	concurrent_buffer & operator=(concurrent_buffer const &) = delete;
+
+	~concurrent_buffer() {
+		::operator delete(data, std::align_val_t(cache_line_size));
+	}
+
+	// Rounding every chunk up to a whole number of cache lines keeps the next
+	// chunk aligned, no matter which thread gets it.
+	T * allocate_chunk(std::size_t const count) {
+		auto const rounded = (count + elements_per_cache_line - 1) / elements_per_cache_line * elements_per_cache_line;
+		auto const offset = used.fetch_add(rounded, std::memory_order_relaxed);
+		if (offset + rounded > size) {
+			throw std::bad_alloc();
+		}
+		return data + offset;
+	}
+
+	// Must not be called while any thread is still allocating.
+	void reset() {
+		used.store(0, std::memory_order_relaxed);
+		id = next_buffer_id.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	T * const data;
+	std::size_t const size;
+	std::uint64_t id = next_buffer_id.fetch_add(1, std::memory_order_relaxed);
+	// On its own cache line so that bumping it does not evict the members
+	// above, which every thread reads.
+	alignas(cache_line_size) std::atomic<std::size_t> used = 0;
+};
+
+template<typename T>
+struct concurrent_allocator {
+	using value_type = T;
+
+	explicit constexpr concurrent_allocator(concurrent_buffer<T> & buffer):
+		buffer_(&buffer)
+	{
+	}
+
+	auto allocate(std::size_t size) {
+		return buffer_->allocate_chunk(size);
+	}
+	constexpr void deallocate(T * ptr, std::size_t size) {
+	}
+
+private:
+	concurrent_buffer<T> * buffer_;
+};
+
+
+template<typename T>
+struct thread_chunk {
+	std::uint64_t buffer_id = 0;
+	T * pointer = nullptr;
+	T * end = nullptr;
+};
+
+// Trivially constructible, so accessing it is a single offset from the thread
+// pointer with no initialization guard.
+template<typename T>
+inline thread_local thread_chunk<T> current_chunk;
+
+template<typename T>
+struct per_thread_allocator {
+	using value_type = T;
+
+	static constexpr auto chunk_size = std::size_t(64 * 1024) / sizeof(T);
+
+	explicit constexpr per_thread_allocator(concurrent_buffer<T> & buffer):
+		buffer_(&buffer)
+	{
+	}
+
+	auto allocate(std::size_t size) {
+		auto & chunk = current_chunk<T>;
+		if (chunk.buffer_id != buffer_->id or static_cast<std::size_t>(chunk.end - chunk.pointer) < size) [[unlikely]] {
+			refill(chunk, size);
+		}
+		auto const result = chunk.pointer;
+		chunk.pointer += size;
+		return result;
+	}
+	constexpr void deallocate(T * ptr, std::size_t size) {
+	}
+
+private:
+	// Whatever is left of the previous chunk is abandoned. With chunks much
+	// larger than a typical string, that is a small fraction of the arena.
+	void refill(thread_chunk<T> & chunk, std::size_t const size) {
+		auto const count = std::max(chunk_size, size);
+		// Only once allocate_chunk has not thrown, or the old chunk would be
+		// taken for one from this buffer
+		chunk.pointer = buffer_->allocate_chunk(count);
+		chunk.end = chunk.pointer + count;
+		chunk.buffer_id = buffer_->id;
+	}
+
+	concurrent_buffer<T> * buffer_;
+};
+
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+// char is trivial, so outside of constant evaluation the characters can be
+// copied with memcpy instead of being constructed one at a time
+template<typename Allocator>
+constexpr char * copy_characters(Allocator alloc, char const * const first, char const * const last, char * const out) {
+	if (std::is_constant_evaluated()) {
+		return uninitialized_copy(alloc, first, last, out);
+	}
+	auto const count = static_cast<std::size_t>(last - first);
+	if (count != 0) {
+		std::memcpy(out, first, count);
+	}
+	return out + count;
+}
+
+
+// Reads bytes in memory order, so that comparing two words as integers
+// compares them as unsigned characters, the same as memcmp.
+inline std::uint64_t load_big_endian(char const * const data) {
+	auto result = std::uint64_t();
+	std::memcpy(&result, data, sizeof(result));
+	if constexpr (std::endian::native == std::endian::little) {
+		result = __builtin_bswap64(result);
+	}
+	return result;
+}
+
+// The characters from offset to offset + 8 as a big-endian integer, with 0
+// for any past the end. Comparing these as integers compares those
+// characters as unsigned char, the same as memcmp.
+constexpr std::uint64_t key_at(char const * const data, std::size_t const size, std::size_t const offset) {
+	constexpr auto word = sizeof(std::uint64_t);
+	auto const remaining = size - offset;
+	if (!std::is_constant_evaluated() and remaining >= word) {
+		return load_big_endian(data + offset);
+	}
+	auto result = std::uint64_t(0);
+	for (std::size_t n = 0; n != std::min(remaining, word); ++n) {
+		result |= std::uint64_t(static_cast<unsigned char>(data[offset + n])) << (CHAR_BIT * (word - 1 - n));
+	}
+	return result;
+}
+
+// key_at(data, size, 0) for a string that has storage for at least 8
+// characters, even if it is shorter than that. This loads the whole word and
+// then clears the characters past the size, whatever they are, so there is no
+// loop and no branch on the size.
+constexpr std::uint64_t prefix_key(char const * const data, std::size_t const size) {
+	if (std::is_constant_evaluated()) {
+		return key_at(data, size, 0);
+	}
+	auto const bits = CHAR_BIT * std::min(size, sizeof(std::uint64_t));
+	auto const mask = bits == 0 ? std::uint64_t(0) : ~std::uint64_t(0) << (64 - bits);
+	return load_big_endian(data) & mask;
+}
+
+namespace clang {
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	static constexpr std::size_t small_buffer_capacity = 23;
+
+	struct small_t {
+		char data[small_buffer_capacity] = {};
+	};
+	struct [[gnu::packed]] large_t {
+		static constexpr std::size_t bytes_remaining = 7;
+
+		template<typename It>
+		class range_view {
+		public:
+			constexpr range_view(It first, It last):
+				first_(first),
+				last_(last)
+			{
+			}
+			constexpr auto begin() const {
+				return first_;
+			}
+			constexpr auto end() const {
+				return last_;
+			}
+		private:
+			It first_;
+			It last_;
+		};
+
+		constexpr auto little_endian_capacity() const {
+			return range_view(
+				std::rbegin(rest_of_capacity),
+				std::rend(rest_of_capacity)
+			);
+		}
+		constexpr auto big_endian_capacity() {
+			return range_view(
+				std::begin(rest_of_capacity),
+				std::end(rest_of_capacity)
+			);
+		}
+
+		constexpr large_t(std::size_t set_size, std::size_t capacity, char * pointer) noexcept:
+			rest_of_capacity{},
+			size(set_size),
+			data(pointer)
+		{
+			assert(data != nullptr);
+			for (unsigned char & byte : big_endian_capacity()) {
+				capacity >>= CHAR_BIT;
+				byte = capacity;
+			}
+		}
+
+		unsigned char rest_of_capacity[bytes_remaining];
+		std::size_t size;
+		char * data;
+	};
+
+	[[no_unique_address]] allocator_type allocator_;
+	unsigned char size_or_first_byte_of_capacity_;
+	union U {
+		constexpr U() noexcept:
+			small{}
+		{
+		}
+		explicit constexpr U(std::size_t size, std::size_t capacity, char * data) noexcept:
+			large(size, capacity, data)
+		{
+		}
+		constexpr U(large_t set_large) noexcept:
+			large(set_large)
+		{
+		}
+
+		small_t small;
+		large_t large;
+	} u_;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return size_or_first_byte_of_capacity_ & 1;
+	}
+
+	constexpr void increment_size() {
+		if (is_large()) {
+			++u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ += (1 << 1);
+		}
+	}
+	constexpr void set_size(std::size_t const new_size) {
+		if (is_large()) {
+			u_.large.size = new_size;
+		} else {
+			size_or_first_byte_of_capacity_ = static_cast<unsigned char>(new_size << 1);
+		}
+	}
+	constexpr void decrement_size() {
+		if (is_large()) {
+			--u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ -= (1 << 1);
+		}
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, u_.large.data, capacity());
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(size(), new_capacity, new_data);
+		assert(new_capacity & 1);
+		size_or_first_byte_of_capacity_ = new_capacity;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		new_capacity |= 1;
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy_characters(alloc, data(), data() + size(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		size_or_first_byte_of_capacity_(0),
+		u_{}
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.large);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+
+			other.u_ = U{};
+			other.size_or_first_byte_of_capacity_ = 0;
+		} else {
+			auto & osmall = other.u_.small;
+			u_ = U{};
+			copy(osmall.data, osmall.data + (other.size_or_first_byte_of_capacity_ >> 1), u_.small.data);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr char * data() {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr std::size_t size() const {
+		return is_large() ? u_.large.size : (size_or_first_byte_of_capacity_ >> 1);
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		if (!is_large()) {
+			return small_buffer_capacity;
+		}
+		// The bytes after the first are the rest of the capacity in
+		// little-endian order, so on a little-endian target this is one load
+		// instead of a loop. append_and_overwrite checks the capacity for
+		// every number.
+		if (!std::is_constant_evaluated() and std::endian::native == std::endian::little) {
+			auto rest = std::size_t(0);
+			std::memcpy(&rest, u_.large.rest_of_capacity, large_t::bytes_remaining);
+			return (rest << CHAR_BIT) | size_or_first_byte_of_capacity_;
+		}
+		std::size_t result = 0;
+		for (unsigned char const byte : u_.large.little_endian_capacity()) {
+			result |= byte;
+			result <<= CHAR_BIT;
+		}
+		result |= size_or_first_byte_of_capacity_;
+		return result;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		auto const local_size = size();
+		if (is_large() && capacity() > (local_size | 1)) {
+			if (local_size > small_buffer_capacity) {
+				force_reserve(local_size);
+			} else {
+				auto const data = u_.large.data;
+				auto const original_capacity = capacity();
+				u_ = U{};
+				size_or_first_byte_of_capacity_ = local_size << 1;
+				copy(data, data + local_size, u_.small.data);
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = std::prev(end());
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = (capacity() * growth_factor) | 1;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+
+			relocate(temp, new_capacity);
+		}
+		increment_size();
+		return begin() + offset;
+	}
+
+	// Range append, which the proposal leaves out for brevity. A reallocation
+	// at least doubles the capacity, like insert, and copies the old
+	// characters and the new ones straight into place. That also makes it
+	// safe to append part of the string to itself.
+	constexpr void append(char const * const first, char const * const last) {
+		auto const new_size = size() + static_cast<std::size_t>(last - first);
+		auto alloc = get_allocator();
+		if (new_size <= capacity()) {
+			copy_characters(alloc, first, last, end());
+		} else {
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = std::max(new_size, capacity() * growth_factor) | 1;
+			char * temp = Alloc::allocate(alloc, new_capacity);
+			copy_characters(alloc, first, last, copy_characters(alloc, data(), data() + size(), temp));
+			relocate(temp, new_capacity);
+		}
+		set_size(new_size);
+	}
+
+	// Makes room for up to max_count more characters, then operation writes
+	// characters starting at the end and returns where it stopped. This is
+	// like resize_and_overwrite, except that it keeps what is already there.
+	template<typename Operation>
+	constexpr void append_and_overwrite(std::size_t const max_count, Operation operation) {
+		auto const required = size() + max_count;
+		if (required > capacity()) {
+			constexpr auto growth_factor = std::size_t{2};
+			force_reserve(std::max(required, capacity() * growth_factor));
+		}
+		char * const last = operation(end());
+		set_size(static_cast<std::size_t>(last - begin()));
+	}
+
+	// The first 8 characters, as prefix_key reads them. The small buffer holds
+	// 23 characters and an allocation holds more than that, so there is
+	// always a whole word to load.
+	constexpr std::uint64_t prefix_key() const {
+		if (is_large()) {
+			return ::prefix_key(u_.large.data, u_.large.size);
+		}
+		return ::prefix_key(u_.small.data, size_or_first_byte_of_capacity_ >> 1);
+	}
+
+	constexpr void pop_back() {
+		decrement_size();
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace clang
+
+namespace gcc {
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	[[no_unique_address]] allocator_type allocator_;
+	// This could be set to 8 to reduce the size of our string to 24 bytes
+	// (just like clang), but 7 characters (plus a null terminator) is likely
+	// too small of a buffer for most users.
+	static constexpr std::size_t small_buffer_capacity = 16;
+	union U{
+		constexpr U():
+			buffer{}
+		{
+		}
+		constexpr U(std::size_t c):
+			capacity(c)
+		{
+		}
+
+		char buffer[small_buffer_capacity];
+		std::size_t capacity;
+	} u_;
+	char * data_;
+	std::size_t size_ : 63;
+	// gcc and MSVC do not allow accessing the inactive member of a union just
+	// to get its address, so we use a bitfield to work around this.
+	bool is_large_ : 1;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return is_large_;
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, data_, u_.capacity);
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(new_capacity);
+		data_ = new_data;
+		is_large_ = true;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy_characters(alloc, data(), data() + size(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_{},
+		data_(u_.buffer),
+		size_(0),
+		is_large_(false)
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.capacity);
+			other.u_ = U{};
+		
+			data_ = other.data_;
+			other.data_ = other.u_.buffer;
+		
+			size_ = other.size_;
+			other.size_ = 0U;
+		
+			is_large_ = true;
+			other.is_large_ = false;
+
+		} else {
+			u_ = U{};
+			copy(other.data_, other.data_ + other.size_, u_.buffer);
+			data_ = u_.buffer;
+			size_ = other.size_;
+			is_large_ = false;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return data_;
+	}
+	constexpr char * data() {
+		return data_;
+	}
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		return is_large() ? u_.capacity : small_buffer_capacity;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		if (is_large() && capacity() > size()) {
+			if (size() > small_buffer_capacity) {
+				force_reserve(size());
+			} else {
+				auto const data = data_;
+				auto const original_capacity = u_.capacity;
+				u_ = U{};
+				copy(data, data + size_, u_.buffer);
+				data_ = u_.buffer;
+				is_large_ = false;
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = end() - 1;
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = capacity() * growth_factor;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+		
+			relocate(temp, new_capacity);
+		}
+		++size_;
+		return begin() + offset;
+	}
+
+	// Range append, which the proposal leaves out for brevity. A reallocation
+	// at least doubles the capacity, like insert, and copies the old
+	// characters and the new ones straight into place. That also makes it
+	// safe to append part of the string to itself.
+	constexpr void append(char const * const first, char const * const last) {
+		auto const new_size = size() + static_cast<std::size_t>(last - first);
+		auto alloc = get_allocator();
+		if (new_size <= capacity()) {
+			copy_characters(alloc, first, last, end());
+		} else {
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = std::max(new_size, capacity() * growth_factor);
+			char * temp = Alloc::allocate(alloc, new_capacity);
+			copy_characters(alloc, first, last, copy_characters(alloc, data(), data() + size(), temp));
+			relocate(temp, new_capacity);
+		}
+		size_ = new_size;
+	}
+
+	// Makes room for up to max_count more characters, then operation writes
+	// characters starting at the end and returns where it stopped. This is
+	// like resize_and_overwrite, except that it keeps what is already there.
+	template<typename Operation>
+	constexpr void append_and_overwrite(std::size_t const max_count, Operation operation) {
+		auto const required = size() + max_count;
+		if (required > capacity()) {
+			constexpr auto growth_factor = std::size_t{2};
+			force_reserve(std::max(required, capacity() * growth_factor));
+		}
+		char * const last = operation(end());
+		size_ = static_cast<std::size_t>(last - begin());
+	}
+
+	// The first 8 characters, as prefix_key reads them. data_ points to the
+	// small buffer of 16 characters or to an allocation of more than that,
+	// so there is always a whole word to load.
+	constexpr std::uint64_t prefix_key() const {
+		return ::prefix_key(data_, size_);
+	}
+
+	constexpr void pop_back() {
+		--size_;
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace gcc
+
+template<typename T>
+constexpr bool is_prototype_string = false;
+template<typename Allocator>
+constexpr bool is_prototype_string<clang::string<Allocator>> = true;
+template<typename Allocator>
+constexpr bool is_prototype_string<gcc::string<Allocator>> = true;
+
+template<typename T>
+concept prototype_string = is_prototype_string<T>;
+
+// Whether moving an object to a new address, and not destroying it at the
+// old one, is the same as copying its bytes. The clang layout has no pointer
+// into itself, so it can be relocated whenever its allocator can. The gcc
+// layout points into its own small buffer, so it cannot.
+template<typename T>
+constexpr bool is_trivially_relocatable = std::is_trivially_copyable_v<T>;
+// std::allocator has no state, but libstdc++ gives it a user-provided copy
+// constructor and destructor, so it is not trivially copyable
+template<typename T>
+constexpr bool is_trivially_relocatable<std::allocator<T>> = true;
+template<typename Allocator>
+constexpr bool is_trivially_relocatable<clang::string<Allocator>> = is_trivially_relocatable<Allocator>;
+
+// The key is the 8 characters of the string at the current depth, and index
+// is where the string is in the range being sorted.
+struct sort_entry {
+	std::uint64_t key;
+	std::size_t index;
+};
+
+// A stable least-significant-byte radix sort on the keys, using scratch as
+// the other buffer. It counts all 8 bytes in one pass, and skips any byte
+// that is the same in every key. Short strings are 0 in their low bytes, so
+// sorting strings of up to 4 characters usually takes 4 passes, not 8.
+constexpr void radix_sort(std::span<sort_entry> const entries, std::span<sort_entry> const scratch) {
+	constexpr auto radix = std::size_t(1) << CHAR_BIT;
+	auto counts = std::array<std::array<std::size_t, radix>, sizeof(std::uint64_t)>();
+	for (auto const entry : entries) {
+		for (std::size_t byte = 0; byte != sizeof(std::uint64_t); ++byte) {
+			++counts[byte][(entry.key >> (CHAR_BIT * byte)) % radix];
+		}
+	}
+	auto source = entries;
+	auto destination = scratch;
+	for (std::size_t byte = 0; byte != sizeof(std::uint64_t); ++byte) {
+		auto const shift = CHAR_BIT * byte;
+		auto & count = counts[byte];
+		if (count[(source.front().key >> shift) % radix] == source.size()) {
+			continue;
+		}
+		auto offset = std::size_t(0);
+		for (auto & bucket : count) {
+			offset += std::exchange(bucket, offset);
+		}
+		for (auto const entry : source) {
+			destination[count[(entry.key >> shift) % radix]++] = entry;
+		}
+		std::swap(source, destination);
+	}
+	if (source.data() != entries.data()) {
+		std::ranges::copy(source, entries.begin());
+	}
+}
+
+// Groups of at most this many strings are sorted by std::sort, which beats
+// counting 2048 buckets
+constexpr auto radix_sort_threshold = std::size_t(64);
+
+template<typename String>
+constexpr std::uint64_t key_at(String const & str, std::size_t const depth) {
+	return key_at(str.data(), str.size(), depth);
+}
+
+// For two strings that have the same characters up to depth + 8, with 0 for
+// any past the end. If one of them ends before depth + 8, it is a prefix of
+// the other, so the shorter one is first.
+template<typename String>
+constexpr bool tie_less(String const & lhs, String const & rhs, std::size_t const depth) {
+	auto const next = depth + sizeof(std::uint64_t);
+	if (lhs.size() < next or rhs.size() < next) {
+		return lhs.size() < rhs.size();
+	}
+	return std::string_view(lhs.data() + next, lhs.size() - next) < std::string_view(rhs.data() + next, rhs.size() - next);
+}
+
+// Each level of recursion handles 8 more characters of a shared prefix. Past
+// this many, a group is sorted by comparing the rest of the strings instead,
+// so that strings with a very long shared prefix cannot overflow the stack.
+constexpr auto max_radix_depth = std::size_t(32) * sizeof(std::uint64_t);
+
+// Every string in entries has at least depth characters and they all have
+// the same first depth characters. Each key is already set to the characters
+// from depth.
+template<typename String>
+constexpr void sort_entries(std::span<String const> const strings, std::span<sort_entry> const entries, std::span<sort_entry> const scratch, std::size_t const depth) {
+	if (entries.size() <= radix_sort_threshold or depth >= max_radix_depth) {
+		std::sort(entries.begin(), entries.end(), [=](sort_entry const lhs, sort_entry const rhs) {
+			return lhs.key != rhs.key ?
+				lhs.key < rhs.key :
+				tie_less(strings[lhs.index], strings[rhs.index], depth);
+		});
+		return;
+	}
+	radix_sort(entries, scratch);
+	auto const next = depth + sizeof(std::uint64_t);
+	for (auto first = entries.begin(); first != entries.end();) {
+		auto const last = std::find_if(first + 1, entries.end(), [=](sort_entry const entry) {
+			return entry.key != first->key;
+		});
+		if (last - first > 1) {
+			// Strings that end before the next depth are prefixes of the rest,
+			// so they go first, shortest first
+			auto const middle = std::partition(first, last, [=](sort_entry const entry) {
+				return strings[entry.index].size() < next;
+			});
+			std::sort(first, middle, [=](sort_entry const lhs, sort_entry const rhs) {
+				return strings[lhs.index].size() < strings[rhs.index].size();
+			});
+			if (last - middle > 1) {
+				for (auto & entry : std::span(middle, last)) {
+					entry.key = key_at(strings[entry.index], next);
+				}
+				auto const offset = static_cast<std::size_t>(middle - entries.begin());
+				auto const count = static_cast<std::size_t>(last - middle);
+				sort_entries(strings, entries.subspan(offset, count), scratch.subspan(offset, count), next);
+			}
+		}
+		first = last;
+	}
+}
+
+// Moves the string at entries[n].index to position n. Going through a buffer
+// reads the strings in a random order but independently of each other, and
+// writes them in order. Following the cycles of the permutation in place
+// would not need the buffer, but then every step waits on two cache misses
+// from the step before, which made it three times slower.
+template<typename String>
+constexpr void permute(std::span<String> const strings, std::span<sort_entry const> const entries) {
+	if (is_trivially_relocatable<String> and !std::is_constant_evaluated()) {
+		auto alloc = std::allocator<String>();
+		auto const buffer = alloc.allocate(strings.size());
+		for (std::size_t n = 0; n != entries.size(); ++n) {
+			std::memcpy(static_cast<void *>(buffer + n), std::addressof(strings[entries[n].index]), sizeof(String));
+		}
+		// Every string is in buffer exactly once, so this relocates them back
+		// without destroying anything
+		std::memcpy(static_cast<void *>(strings.data()), buffer, strings.size() * sizeof(String));
+		alloc.deallocate(buffer, strings.size());
+	} else {
+		auto sorted = std::vector<String>();
+		sorted.reserve(strings.size());
+		for (auto const entry : entries) {
+			sorted.push_back(std::move(strings[entry.index]));
+		}
+		std::ranges::move(sorted, strings.begin());
+	}
+}
+
+// Sorts strings in the order of std::string_view's operator<, which compares
+// characters as unsigned char. Equal strings may end up in any order, as with
+// std::sort. This allocates two arrays of 16 bytes per string, and then a
+// buffer for the strings once the second array is freed.
+template<std::ranges::contiguous_range Range> requires prototype_string<std::ranges::range_value_t<Range>>
+constexpr void sort_strings(Range && range) {
+	using String = std::ranges::range_value_t<Range>;
+	auto const strings = std::span<String>(std::ranges::data(range), std::ranges::size(range));
+	if (strings.size() < 2) {
+		return;
+	}
+	auto entries = std::vector<sort_entry>(strings.size());
+	for (std::size_t n = 0; n != strings.size(); ++n) {
+		entries[n] = sort_entry(strings[n].prefix_key(), n);
+	}
+	{
+		auto scratch = std::vector<sort_entry>(entries.size());
+		sort_entries(std::span<String const>(strings), std::span(entries), std::span(scratch), 0);
+	}
+	permute(strings, std::span<sort_entry const>(entries));
+}
+
+// One call to parallel_for. remaining counts the indices that have not
+// finished, and the thread that finishes the last one sets done.
+struct pool_job {
+	pool_job(void (*const run)(void * function, std::size_t index), void * const function, std::size_t const count):
+		run(run),
+		function(function),
+		remaining(count)
+	{
+	}
+
+	void (*run)(void * function, std::size_t index);
+	void * function;
+	std::atomic<std::size_t> remaining;
+	std::mutex mutex;
+	std::condition_variable finished;
+	bool done = false;
+};
+
+// The indices from first to last of one job
+struct pool_task {
+	pool_job * job;
+	std::size_t first;
+	std::size_t last;
+};
+
+// The owner takes the task it queued most recently, which is the smallest
+// and the most likely to still be in its cache. Other threads steal the
+// oldest, which is the largest.
+struct alignas(cache_line_size) task_queue {
+	std::optional<pool_task> pop_back() {
+		auto const lock = std::lock_guard(mutex);
+		if (tasks.empty()) {
+			return std::nullopt;
+		}
+		auto const result = tasks.back();
+		tasks.pop_back();
+		return result;
+	}
+	std::optional<pool_task> pop_front() {
+		auto const lock = std::lock_guard(mutex);
+		if (tasks.empty()) {
+			return std::nullopt;
+		}
+		auto const result = tasks.front();
+		tasks.pop_front();
+		return result;
+	}
+
+	std::mutex mutex;
+	std::deque<pool_task> tasks;
+};
+
+class thread_pool;
+
+// Which pool the current thread works for, and its queue in that pool
+inline thread_local thread_pool const * current_pool = nullptr;
+inline thread_local std::size_t current_queue = 0;
+
+// thread_count includes the thread that calls parallel_for, which works
+// alongside the others until there is nothing left to take. Threads outside
+// the pool share the last queue.
+class thread_pool {
+public:
+	explicit thread_pool(std::size_t const thread_count):
+		thread_count_(thread_count),
+		queues_(std::make_unique<task_queue[]>(thread_count))
+	{
+		assert(thread_count != 0);
+		workers_.reserve(thread_count - 1);
+		for (std::size_t n = 0; n != thread_count - 1; ++n) {
+			workers_.emplace_back([this, n] {
+				work(n);
+			});
+		}
+	}
+	thread_pool(thread_pool &&) = delete;
+	thread_pool(thread_pool const &) = delete;
+	thread_pool & operator=(thread_pool &&) = delete;
+	thread_pool & operator=(thread_pool const &) = delete;
+
+	~thread_pool() {
+		{
+			auto const lock = std::lock_guard(sleep_mutex_);
+			stopping_ = true;
+		}
+		wake_.notify_all();
+		for (auto & worker : workers_) {
+			worker.join();
+		}
+	}
+
+	std::size_t thread_count() const {
+		return thread_count_;
+	}
+
+	// Calls function(index) for every index from 0 to count, on any of the
+	// threads, and returns once all of them have returned. function must not
+	// call parallel_for on the same pool, because the thread that waits for
+	// it could be the only one that can run what it waits for.
+	template<typename Function>
+	void parallel_for(std::size_t const count, Function function) {
+		if (count == 0) {
+			return;
+		}
+		auto job = pool_job(
+			[](void * const f, std::size_t const index) {
+				(*static_cast<Function *>(f))(index);
+			},
+			std::addressof(function),
+			count
+		);
+		execute(pool_task(&job, 0, count));
+		while (job.remaining.load(std::memory_order_acquire) != 0) {
+			auto const task = find_task();
+			if (!task) {
+				break;
+			}
+			execute(*task);
+		}
+		auto lock = std::unique_lock(job.mutex);
+		job.finished.wait(lock, [&] { return job.done; });
+	}
+
+private:
+	std::size_t queue_index() const {
+		return current_pool == this ? current_queue : thread_count_ - 1;
+	}
+
+	void push(pool_task const task) {
+		{
+			auto & queue = queues_[queue_index()];
+			auto const lock = std::lock_guard(queue.mutex);
+			queue.tasks.push_back(task);
+		}
+		queued_.fetch_add(1, std::memory_order_release);
+		// A worker checks queued_ while it holds sleep_mutex_, so taking it
+		// here means the worker either sees the new task or is already
+		// waiting to be woken.
+		{
+			auto const lock = std::lock_guard(sleep_mutex_);
+		}
+		wake_.notify_one();
+	}
+
+	std::optional<pool_task> find_task() {
+		auto const self = queue_index();
+		auto task = queues_[self].pop_back();
+		for (std::size_t n = 1; !task and n != thread_count_; ++n) {
+			task = queues_[(self + n) % thread_count_].pop_front();
+		}
+		if (task) {
+			queued_.fetch_sub(1, std::memory_order_relaxed);
+		}
+		return task;
+	}
+
+	// Queues the upper half of the task until one index is left, and runs
+	// that one
+	void execute(pool_task task) {
+		while (task.last - task.first > 1) {
+			auto const middle = task.first + (task.last - task.first) / 2;
+			push(pool_task(task.job, middle, task.last));
+			task.last = middle;
+		}
+		auto & job = *task.job;
+		job.run(job.function, task.first);
+		if (job.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			// The thread in parallel_for cannot see done, and so cannot
+			// destroy job, until this releases the mutex
+			auto const lock = std::lock_guard(job.mutex);
+			job.done = true;
+			job.finished.notify_all();
+		}
+	}
+
+	void work(std::size_t const index) {
+		current_pool = this;
+		current_queue = index;
+		while (true) {
+			if (auto const task = find_task()) {
+				execute(*task);
+				continue;
+			}
+			auto lock = std::unique_lock(sleep_mutex_);
+			wake_.wait(lock, [&] {
+				return stopping_ or queued_.load(std::memory_order_acquire) != 0;
+			});
+			if (stopping_) {
+				return;
+			}
+		}
+	}
+
+	std::size_t thread_count_;
+	std::unique_ptr<task_queue[]> queues_;
+	std::vector<std::thread> workers_;
+	std::atomic<std::size_t> queued_ = 0;
+	std::mutex sleep_mutex_;
+	std::condition_variable wake_;
+	bool stopping_ = false;
+};
+
+constexpr std::size_t block_count(std::size_t const size, std::size_t const block_size) {
+	return (size + block_size - 1) / block_size;
+}
+
+// Calls function(first, last) for each block of block_size elements out of
+// size, the last one possibly shorter
+template<typename Function>
+void for_each_block(thread_pool & pool, std::size_t const size, std::size_t const block_size, Function function) {
+	pool.parallel_for(block_count(size, block_size), [&](std::size_t const block) {
+		auto const first = block * block_size;
+		function(first, std::min(first + block_size, size));
+	});
+}
+
+// Large enough that queueing a block costs little next to running it
+constexpr auto search_block_size = std::size_t(4096);
+
+template<std::ranges::random_access_range Range, typename Predicate>
+std::size_t parallel_count(thread_pool & pool, Range const & range, Predicate predicate) {
+	auto const first = std::ranges::begin(range);
+	auto const size = static_cast<std::size_t>(std::ranges::size(range));
+	auto counts = std::vector<std::size_t>(block_count(size, search_block_size));
+	for_each_block(pool, size, search_block_size, [&](std::size_t const block_first, std::size_t const block_last) {
+		auto count = std::size_t(0);
+		for (auto n = block_first; n != block_last; ++n) {
+			count += predicate(first[n]) ? 1 : 0;
+		}
+		counts[block_first / search_block_size] = count;
+	});
+	auto result = std::size_t(0);
+	for (auto const count : counts) {
+		result += count;
+	}
+	return result;
+}
+
+// Returns the lowest index for which predicate is true, or the size of range
+// if there is none. A block that starts after a match that was already found
+// is skipped, and every block before that match is searched all the way, so
+// it is always the first match no matter which blocks finish first.
+template<std::ranges::random_access_range Range, typename Predicate>
+std::size_t parallel_find(thread_pool & pool, Range const & range, Predicate predicate) {
+	auto const first = std::ranges::begin(range);
+	auto const size = static_cast<std::size_t>(std::ranges::size(range));
+	auto found = std::atomic<std::size_t>(size);
+	for_each_block(pool, size, search_block_size, [&](std::size_t const block_first, std::size_t const block_last) {
+		for (auto n = block_first; n != block_last and n < found.load(std::memory_order_relaxed); ++n) {
+			if (predicate(first[n])) {
+				auto previous = found.load(std::memory_order_relaxed);
+				while (n < previous and !found.compare_exchange_weak(previous, n, std::memory_order_relaxed)) {
+				}
+				return;
+			}
+		}
+	});
+	return found.load(std::memory_order_relaxed);
+}
+
+// Every index for which predicate is true, in order, like grep. Each block
+// collects its own matches, and they are joined in block order.
+template<std::ranges::random_access_range Range, typename Predicate>
+std::vector<std::size_t> parallel_find_all(thread_pool & pool, Range const & range, Predicate predicate) {
+	auto const first = std::ranges::begin(range);
+	auto const size = static_cast<std::size_t>(std::ranges::size(range));
+	auto matches = std::vector<std::vector<std::size_t>>(block_count(size, search_block_size));
+	for_each_block(pool, size, search_block_size, [&](std::size_t const block_first, std::size_t const block_last) {
+		auto & block_matches = matches[block_first / search_block_size];
+		for (auto n = block_first; n != block_last; ++n) {
+			if (predicate(first[n])) {
+				block_matches.push_back(n);
+			}
+		}
+	});
+	auto total = std::size_t(0);
+	for (auto const & block_matches : matches) {
+		total += block_matches.size();
+	}
+	auto result = std::vector<std::size_t>();
+	result.reserve(total);
+	for (auto const & block_matches : matches) {
+		result.insert(result.end(), block_matches.begin(), block_matches.end());
+	}
+	return result;
+}
+
+// Sets output[n] = function(input[n]) for every n. Each element is written by
+// exactly one call, so the result is the same on any number of threads. For
+// output strings that use per_thread_allocator, the characters come from the
+// chunk of the arena that belongs to the thread that made them.
+template<std::ranges::random_access_range Input, std::ranges::random_access_range Output, typename Function>
+void parallel_transform(thread_pool & pool, Input const & input, Output & output, Function function) {
+	auto const input_first = std::ranges::begin(input);
+	auto const output_first = std::ranges::begin(output);
+	auto const size = static_cast<std::size_t>(std::ranges::size(input));
+	assert(static_cast<std::size_t>(std::ranges::size(output)) == size);
+	for_each_block(pool, size, search_block_size, [&](std::size_t const block_first, std::size_t const block_last) {
+		for (auto n = block_first; n != block_last; ++n) {
+			output_first[n] = function(input_first[n]);
+		}
+	});
+}
+
+// Blocks for the passes over every string in parallel_sort
+constexpr auto sort_block_size = std::size_t(1) << 16;
+
+// parallel_sort splits the keys into about this many per bucket, and sorts
+// each bucket with sort_entries
+constexpr auto target_bucket_size = std::size_t(4096);
+constexpr auto max_bucket_count = std::size_t(1024);
+
+// Picks the keys that separate the buckets, from a sample of the keys spread
+// evenly across entries, so that the buckets come out about the same size.
+// Equal keys always go in the same bucket, so a key that many strings share
+// makes one bucket larger, and no result wrong.
+constexpr std::vector<std::uint64_t> choose_splitters(std::span<sort_entry const> const entries, std::size_t const bucket_count) {
+	constexpr auto oversampling = std::size_t(16);
+	auto const sample_size = std::min(entries.size(), bucket_count * oversampling);
+	auto sample = std::vector<std::uint64_t>(sample_size);
+	for (std::size_t n = 0; n != sample_size; ++n) {
+		sample[n] = entries[n * entries.size() / sample_size].key;
+	}
+	std::ranges::sort(sample);
+	auto splitters = std::vector<std::uint64_t>();
+	for (std::size_t n = 1; n < bucket_count and n < sample_size; ++n) {
+		auto const key = sample[n * sample_size / bucket_count];
+		if (splitters.empty() or splitters.back() != key) {
+			splitters.push_back(key);
+		}
+	}
+	return splitters;
+}
+
+// Bucket n has the keys from splitters[n - 1] up to, but not including,
+// splitters[n]. This is std::upper_bound without a branch on the result of
+// each comparison, which would be mispredicted half of the time.
+constexpr std::size_t bucket_of(std::span<std::uint64_t const> const splitters, std::uint64_t const key) {
+	if (splitters.empty()) {
+		return 0;
+	}
+	auto base = std::size_t(0);
+	for (auto size = splitters.size(); size > 1;) {
+		auto const half = size / 2;
+		base = splitters[base + half] <= key ? base + half : base;
+		size -= half;
+	}
+	return base + (splitters[base] <= key ? 1 : 0);
+}
+
+// permute from string-sort.cpp, with the reads and the writes each split
+// into blocks. All of the strings have to be out before any can go back.
+template<typename String>
+void parallel_permute(thread_pool & pool, std::span<String> const strings, std::span<sort_entry const> const entries) {
+	constexpr auto relocatable = is_trivially_relocatable<String>;
+	auto alloc = std::allocator<String>();
+	auto const buffer = alloc.allocate(strings.size());
+	for_each_block(pool, strings.size(), sort_block_size, [&](std::size_t const first, std::size_t const last) {
+		for (auto n = first; n != last; ++n) {
+			auto & source = strings[entries[n].index];
+			if constexpr (relocatable) {
+				std::memcpy(static_cast<void *>(buffer + n), std::addressof(source), sizeof(String));
+			} else {
+				std::construct_at(buffer + n, std::move(source));
+			}
+		}
+	});
+	for_each_block(pool, strings.size(), sort_block_size, [&](std::size_t const first, std::size_t const last) {
+		if constexpr (relocatable) {
+			std::memcpy(static_cast<void *>(strings.data() + first), buffer + first, (last - first) * sizeof(String));
+		} else {
+			for (auto n = first; n != last; ++n) {
+				strings[n] = std::move(buffer[n]);
+				std::destroy_at(buffer + n);
+			}
+		}
+	});
+	alloc.deallocate(buffer, strings.size());
+}
+
+// How many characters at the start of every string are the same in all of
+// them. Sorting can start after those, which keeps a prefix that every
+// string shares from putting all of them in one bucket.
+template<typename String>
+std::size_t common_prefix_size(thread_pool & pool, std::span<String const> const strings) {
+	auto const front = std::string_view(strings.front().data(), strings.front().size());
+	auto sizes = std::vector<std::size_t>(block_count(strings.size(), sort_block_size));
+	for_each_block(pool, strings.size(), sort_block_size, [&](std::size_t const first, std::size_t const last) {
+		auto prefix = front;
+		for (auto n = first; n != last; ++n) {
+			auto const str = std::string_view(strings[n].data(), strings[n].size());
+			prefix = prefix.substr(0, static_cast<std::size_t>(std::ranges::mismatch(prefix, str).in1 - prefix.begin()));
+		}
+		sizes[first / sort_block_size] = prefix.size();
+	});
+	return std::ranges::min(sizes);
+}
+
+// Sorts strings in the same order as sort_strings. It splits the keys into
+// buckets by value, so that every key in a bucket is less than every key in
+// the next one, and then sorts the buckets at the same time. Each block of
+// strings counts how many of its keys go in each bucket, so that it can put
+// them in place without waiting on any other block, and in the same order on
+// any number of threads.
+template<std::ranges::contiguous_range Range> requires prototype_string<std::ranges::range_value_t<Range>>
+void parallel_sort(thread_pool & pool, Range && range) {
+	using String = std::ranges::range_value_t<Range>;
+	auto const strings = std::span<String>(std::ranges::data(range), std::ranges::size(range));
+	if (strings.size() < 2) {
+		return;
+	}
+	auto const depth = common_prefix_size(pool, std::span<String const>(strings));
+	auto entries = std::vector<sort_entry>(strings.size());
+	for_each_block(pool, strings.size(), sort_block_size, [&](std::size_t const first, std::size_t const last) {
+		for (auto n = first; n != last; ++n) {
+			auto const key = depth == 0 ? strings[n].prefix_key() : key_at(strings[n], depth);
+			entries[n] = sort_entry(key, n);
+		}
+	});
+
+	auto const splitters = choose_splitters(entries, std::clamp(strings.size() / target_bucket_size, std::size_t(1), max_bucket_count));
+	auto const bucket_count = splitters.size() + 1;
+	auto const blocks = block_count(strings.size(), sort_block_size);
+	static_assert(max_bucket_count <= std::numeric_limits<std::uint16_t>::max());
+	auto buckets = std::vector<std::uint16_t>(strings.size());
+	// offsets[block * bucket_count + bucket] starts as how many keys of block
+	// are in bucket, and becomes where the first of them goes
+	auto offsets = std::vector<std::size_t>(blocks * bucket_count);
+	for_each_block(pool, strings.size(), sort_block_size, [&](std::size_t const first, std::size_t const last) {
+		auto const counts = std::span(offsets).subspan(first / sort_block_size * bucket_count, bucket_count);
+		for (auto n = first; n != last; ++n) {
+			auto const bucket = bucket_of(splitters, entries[n].key);
+			buckets[n] = static_cast<std::uint16_t>(bucket);
+			++counts[bucket];
+		}
+	});
+	auto bucket_starts = std::vector<std::size_t>(bucket_count + 1);
+	auto offset = std::size_t(0);
+	for (std::size_t bucket = 0; bucket != bucket_count; ++bucket) {
+		bucket_starts[bucket] = offset;
+		for (std::size_t block = 0; block != blocks; ++block) {
+			offset += std::exchange(offsets[block * bucket_count + bucket], offset);
+		}
+	}
+	bucket_starts[bucket_count] = offset;
+
+	auto partitioned = std::vector<sort_entry>(strings.size());
+	for_each_block(pool, strings.size(), sort_block_size, [&](std::size_t const first, std::size_t const last) {
+		auto const block_offsets = std::span(offsets).subspan(first / sort_block_size * bucket_count, bucket_count);
+		for (auto n = first; n != last; ++n) {
+			partitioned[block_offsets[buckets[n]]++] = entries[n];
+		}
+	});
+	pool.parallel_for(bucket_count, [&](std::size_t const bucket) {
+		auto const first = bucket_starts[bucket];
+		auto const count = bucket_starts[bucket + 1] - first;
+		sort_entries(std::span<String const>(strings), std::span(partitioned).subspan(first, count), std::span(entries).subspan(first, count), depth);
+	});
+	entries = {};
+	buckets = {};
+	parallel_permute(pool, strings, std::span<sort_entry const>(partitioned));
+}
+
+
+template<typename String>
+constexpr String make_string(typename String::allocator_type const alloc, std::string_view const source) {
+	auto result = String(alloc);
+	result.append(source.data(), source.data() + source.size());
+	return result;
+}
+
+template<typename String>
+constexpr String make_string(std::string_view const source) {
+	return make_string<String>(typename String::allocator_type(), source);
+}
+
+constexpr std::string_view as_view(auto const & str) {
+	return std::string_view(str.data(), str.size());
+}
+
+constexpr bool contains(auto const & str, std::string_view const needle) {
+	return as_view(str).find(needle) != std::string_view::npos;
+}
+
+// Every key in each bucket has to be less than every key in the next one,
+// and the buckets should come out about the same size
+constexpr bool splits_evenly(std::vector<std::uint64_t> const & keys, std::size_t const bucket_count) {
+	auto entries = std::vector<sort_entry>();
+	for (auto const key : keys) {
+		entries.push_back(sort_entry(key, entries.size()));
+	}
+	auto const splitters = choose_splitters(entries, bucket_count);
+	if (!std::ranges::is_sorted(splitters) or splitters.size() >= bucket_count) {
+		return false;
+	}
+	auto sizes = std::vector<std::size_t>(splitters.size() + 1);
+	for (auto const key : keys) {
+		auto const bucket = bucket_of(splitters, key);
+		if ((bucket != 0 and key < splitters[bucket - 1]) or (bucket != splitters.size() and key >= splitters[bucket])) {
+			return false;
+		}
+		++sizes[bucket];
+	}
+	return std::ranges::max(sizes) <= 2 * keys.size() / bucket_count;
+}
+
+constexpr bool test() {
+	using allocator_type = std::allocator<char>;
+	auto ascending = std::vector<std::uint64_t>();
+	auto shuffled = std::vector<std::uint64_t>();
+	for (std::uint64_t n = 0; n != 1000; ++n) {
+		ascending.push_back(n);
+		shuffled.push_back(n * 7919 % 1000);
+	}
+	assert(splits_evenly(ascending, 8));
+	assert(splits_evenly(shuffled, 10));
+	// When every key is the same, there can only be one bucket
+	assert(choose_splitters(std::vector<sort_entry>(100, sort_entry(5, 0)), 4).size() == 1);
+	assert(bucket_of(std::vector<std::uint64_t>{5}, 5) == 1);
+	assert(bucket_of(std::vector<std::uint64_t>{5}, 4) == 0);
+
+	auto const str = make_string<clang::string<allocator_type>>("a line with ERROR in it");
+	assert(contains(str, "ERROR"));
+	assert(!contains(str, "WARN"));
+	return true;
+}
+
+// Random strings from a small alphabet, so that many of them are equal or
+// prefixes of each other, and some of them long enough to be allocated
+std::vector<std::string> random_strings(std::mt19937_64 & engine, std::size_t const count) {
+	constexpr char alphabet[] = {'\0', 'a', 'b', '\x7f', '\x80', '\xff'};
+	auto const max_size = engine() % 40 + 1;
+	auto const shared = std::string(engine() % 20, 'p');
+	auto result = std::vector<std::string>(count);
+	for (auto & str : result) {
+		if (engine() % 2 == 0) {
+			str = shared;
+		}
+		for (auto size = engine() % max_size; size != 0; --size) {
+			str += alphabet[engine() % std::size(alphabet)];
+		}
+	}
+	return result;
+}
+
+template<typename String>
+std::vector<String> convert(std::vector<std::string> const & source) {
+	auto result = std::vector<String>();
+	result.reserve(source.size());
+	for (auto const & str : source) {
+		result.push_back(make_string<String>(str));
+	}
+	return result;
+}
+
+template<typename String>
+bool equal(std::vector<String> const & lhs, std::vector<std::string> const & rhs) {
+	return std::ranges::equal(lhs, rhs, [](String const & str, std::string const & expected) {
+		return as_view(str) == expected;
+	});
+}
+
+template<typename String>
+void check_sort(thread_pool & pool, std::vector<std::string> const & source) {
+	auto strings = convert<String>(source);
+	auto expected = source;
+	std::ranges::sort(expected);
+	parallel_sort(pool, strings);
+	assert(equal(strings, expected));
+}
+
+// Whatever the number of threads, every algorithm has to give the same
+// result as doing the same thing one element at a time
+void test_against_serial() {
+	auto engine = std::mt19937_64(1);
+	auto arena = concurrent_buffer<char>(std::size_t(1) << 26);
+	for (auto const thread_count : {1, 2, 3, 8}) {
+		auto pool = thread_pool(static_cast<std::size_t>(thread_count));
+		for (auto const size : {0, 1, 100, 4096, 4097, 70'000, 300'000}) {
+			auto const source = random_strings(engine, static_cast<std::size_t>(size));
+			check_sort<clang::string<std::allocator<char>>>(pool, source);
+			check_sort<gcc::string<std::allocator<char>>>(pool, source);
+
+			auto const strings = convert<clang::string<std::allocator<char>>>(source);
+			auto const needle = std::string_view("\x7f\x80");
+			auto const matches = [=](auto const & str) {
+				return contains(str, needle);
+			};
+			auto expected_matches = std::vector<std::size_t>();
+			for (std::size_t n = 0; n != source.size(); ++n) {
+				if (matches(source[n])) {
+					expected_matches.push_back(n);
+				}
+			}
+			assert(parallel_count(pool, strings, matches) == expected_matches.size());
+			assert(parallel_find_all(pool, strings, matches) == expected_matches);
+			auto const first_match = expected_matches.empty() ? source.size() : expected_matches.front();
+			assert(parallel_find(pool, strings, matches) == first_match);
+			// A match in the last block, after many blocks with none
+			assert(parallel_find(pool, strings, [&](auto const & str) { return &str == &strings.back(); }) == (size == 0 ? 0 : source.size() - 1));
+
+			using arena_string = clang::string<per_thread_allocator<char>>;
+			auto const alloc = per_thread_allocator(arena);
+			auto output = std::vector<arena_string>();
+			for (std::size_t n = 0; n != strings.size(); ++n) {
+				output.push_back(arena_string(alloc));
+			}
+			parallel_transform(pool, strings, output, [=](auto const & str) {
+				auto result = make_string<arena_string>(alloc, as_view(str));
+				result.insert(result.end(), '!');
+				return result;
+			});
+			for (std::size_t n = 0; n != source.size(); ++n) {
+				assert(as_view(output[n]) == source[n] + '!');
+			}
+			arena.reset();
+		}
+	}
+
+	// Enough shared prefix to overflow the stack with one level of recursion
+	// per 8 characters
+	auto pool = thread_pool(2);
+	auto long_strings = std::vector<std::string>(100, std::string(1'000'000, 'p'));
+	for (std::size_t n = 0; n < long_strings.size(); n += 2) {
+		long_strings[n] += static_cast<char>('a' + engine() % 3);
+	}
+	check_sort<clang::string<std::allocator<char>>>(pool, long_strings);
+}
+
+template<typename Function>
+double nanoseconds_per_operation(std::size_t const count, Function && function) {
+	auto const start = std::chrono::steady_clock::now();
+	function();
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+}
+
+// Lines of a service log, about 60 characters each, so none of them fit in
+// a small buffer
+std::vector<std::string> make_log_lines(std::size_t const count) {
+	auto engine = std::mt19937_64(1);
+	constexpr std::string_view levels[] = {"INFO", "INFO", "INFO", "WARN", "ERROR"};
+	constexpr std::string_view messages[] = {"request served", "cache miss", "upstream timeout", "retrying", "connection reset by peer"};
+	auto result = std::vector<std::string>(count);
+	for (auto & line : result) {
+		line += "2026-10-18T";
+		line += std::to_string(10 + engine() % 14);
+		line += ':';
+		line += std::to_string(10 + engine() % 50);
+		line += ':';
+		line += std::to_string(10 + engine() % 50);
+		line += " host-";
+		line += std::to_string(engine() % 1000);
+		line += ' ';
+		line += levels[engine() % std::size(levels)];
+		line += ' ';
+		line += messages[engine() % std::size(messages)];
+		line += " id=";
+		line += std::to_string(engine());
+	}
+	return result;
+}
+
+using benchmark_string = clang::string<std::allocator<char>>;
+using arena_string = clang::string<per_thread_allocator<char>>;
+
+constexpr arena_string to_upper(per_thread_allocator<char> const alloc, std::string_view const text) {
+	auto result = arena_string(alloc);
+	result.append_and_overwrite(text.size(), [=](char * out) {
+		for (auto const c : text) {
+			*out = 'a' <= c and c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+			++out;
+		}
+		return out;
+	});
+	return result;
+}
+
+void benchmark_threads(std::size_t const thread_count, std::vector<std::string> const & lines, concurrent_buffer<char> & arena) {
+	auto pool = thread_pool(thread_count);
+	auto strings = convert<benchmark_string>(lines);
+	auto const sort = nanoseconds_per_operation(strings.size(), [&] {
+		parallel_sort(pool, strings);
+	});
+	assert(std::ranges::is_sorted(strings, std::less(), as_view<benchmark_string>));
+
+	auto matches = std::size_t(0);
+	auto const count = nanoseconds_per_operation(strings.size(), [&] {
+		matches = parallel_count(pool, strings, [](auto const & str) { return contains(str, "ERROR upstream timeout"); });
+	});
+	assert(matches != 0);
+
+	auto const alloc = per_thread_allocator(arena);
+	auto output = std::vector<arena_string>();
+	for (std::size_t n = 0; n != strings.size(); ++n) {
+		output.push_back(arena_string(alloc));
+	}
+	auto const transform = nanoseconds_per_operation(strings.size(), [&] {
+		parallel_transform(pool, strings, output, [=](auto const & str) {
+			return to_upper(alloc, as_view(str));
+		});
+	});
+	assert(contains(output.front(), "2026-10-18T"));
+	output.clear();
+	arena.reset();
+	std::printf("%8zu %14.1f %14.1f %14.1f\n", thread_count, sort, count, transform);
+}
+
+void benchmark() {
+	auto const lines = make_log_lines(2'000'000);
+	auto arena = concurrent_buffer<char>(std::size_t(1) << 28);
+
+	std::printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+	std::printf("%8s %14s %14s %14s   (ns per string)\n", "threads", "sort", "count", "to_upper");
+	auto strings = convert<benchmark_string>(lines);
+	auto const sort = nanoseconds_per_operation(strings.size(), [&] {
+		sort_strings(strings);
+	});
+	auto matches = std::size_t(0);
+	auto const count = nanoseconds_per_operation(strings.size(), [&] {
+		matches = static_cast<std::size_t>(std::ranges::count_if(strings, [](auto const & str) { return contains(str, "ERROR upstream timeout"); }));
+	});
+	assert(matches != 0);
+	auto output = std::vector<std::string>(strings.size());
+	auto const transform = nanoseconds_per_operation(strings.size(), [&] {
+		std::ranges::transform(strings, output.begin(), [](auto const & str) {
+			auto result = std::string(as_view(str));
+			for (auto & c : result) {
+				c = 'a' <= c and c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+			}
+			return result;
+		});
+	});
+	std::printf("%8s %14.1f %14.1f %14.1f\n", "serial", sort, count, transform);
+
+	auto const max_threads = std::max(std::thread::hardware_concurrency(), 1U);
+	for (std::size_t thread_count = 1; thread_count <= max_threads; thread_count *= 2) {
+		benchmark_threads(thread_count, lines, arena);
+	}
+	if (!std::has_single_bit(max_threads)) {
+		benchmark_threads(max_threads, lines, arena);
+	}
+}
+
+int main() {
+	test();
+	static_assert(test());
+	test_against_serial();
+	benchmark();
+}
@@ -0,0 +1,544 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is to build lookup
+// tables for a fixed set of keywords during constant evaluation, so that a
+// program does not have to build them when it starts.
+//
+// make_keyword_table takes a list of keywords, removes duplicates, and finds
+// a minimal perfect hash for them, all at compile time. The result is a
+// keyword_table that maps each keyword to an index with one hash and one
+// comparison. Since index is consteval, the indexes can be case labels,
+// which is how this switches on a string.
+//
+// The hash is the one from hash.cpp, which gives the same value during
+// constant evaluation as at run time, and the same value for either string
+// layout as for a std::string_view. The keywords themselves are only ever
+// std::string_view here: building each one as a string one character at a
+// time costs more than gcc allows a constant expression to take for a few
+// hundred keywords.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <compare>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+
+// Reads bytes in little-endian order on every target, so that a hash computed
+// during constant evaluation matches the one computed at run time.
+constexpr std::uint64_t load_little_endian(char const * const data) {
+	auto result = std::uint64_t(0);
+	if (std::is_constant_evaluated()) {
+		for (std::size_t n = 0; n != sizeof(result); ++n) {
+			result |= std::uint64_t(static_cast<unsigned char>(data[n])) << (n * CHAR_BIT);
+		}
+		return result;
+	}
+	std::memcpy(&result, data, sizeof(result));
+	if constexpr (std::endian::native == std::endian::big) {
+		result = __builtin_bswap64(result);
+	}
+	return result;
+}
+
+// Strings of up to this many characters hash as three words, padded with 0.
+constexpr std::size_t short_hash_size = 24;
+using short_hash_words = std::array<std::uint64_t, short_hash_size / sizeof(std::uint64_t)>;
+
+constexpr std::uint64_t hash_keys[] = {
+	0xbe4b'a423'396c'feb8,
+	0x1cad'21f7'2c81'017c,
+	0xdb97'9083'e96d'd4de,
+	0x1f67'b3b7'a4a4'4072,
+};
+constexpr std::uint64_t size_key = 0x9e37'79b1'85eb'ca87;
+constexpr std::uint64_t lane_multiplier = 0x9fb2'1c65'1e98'df25;
+
+// The multiply is of the 32-bit halves of the keyed word, which is what
+// _mm256_mul_epu32 computes in each lane. Adding the word with its halves
+// swapped keeps a word from being lost when one of those halves is 0.
+constexpr std::uint64_t accumulate(std::uint64_t const word, std::uint64_t const key) {
+	auto const keyed = word ^ key;
+	return (keyed & 0xffff'ffff) * (keyed >> 32) + std::rotl(word, 32);
+}
+
+constexpr std::uint64_t avalanche(std::uint64_t hash) {
+	hash ^= hash >> 37;
+	hash *= 0x1656'6791'9e37'79f9;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+constexpr std::size_t hash_short(short_hash_words const & words, std::size_t const size) {
+	auto result = size * size_key;
+	for (std::size_t n = 0; n != words.size(); ++n) {
+		result += accumulate(words[n], hash_keys[n]);
+	}
+	return avalanche(result);
+}
+
+// Each lane takes one word of every 32-byte block, and the last block
+// overlaps the one before it. Multiplying the lanes between blocks makes the
+// result depend on the order of the blocks.
+constexpr std::size_t hash_long(char const * const data, std::size_t const size) {
+	assert(size > short_hash_size);
+	constexpr auto block_size = std::size(hash_keys) * sizeof(std::uint64_t);
+	auto lanes = std::array<std::uint64_t, std::size(hash_keys)>();
+	auto add_block = [&](auto const word_offset) {
+		for (std::size_t n = 0; n != lanes.size(); ++n) {
+			lanes[n] = (lanes[n] + accumulate(load_little_endian(data + word_offset(n)), hash_keys[n])) * lane_multiplier;
+		}
+	};
+	if (size < block_size) {
+		add_block([=](std::size_t const n) { return std::min(n * sizeof(std::uint64_t), size - sizeof(std::uint64_t)); });
+	} else {
+		auto offset = std::size_t(0);
+		for (; offset + block_size <= size; offset += block_size) {
+			add_block([=](std::size_t const n) { return offset + n * sizeof(std::uint64_t); });
+		}
+		if (offset != size) {
+			add_block([=](std::size_t const n) { return size - block_size + n * sizeof(std::uint64_t); });
+		}
+	}
+	auto result = size * size_key;
+	for (std::size_t n = 0; n != lanes.size(); ++n) {
+		result += std::rotl(lanes[n], static_cast<int>(n * 16));
+	}
+	return avalanche(result);
+}
+
+constexpr short_hash_words padded_words(char const * const data, std::size_t const size) {
+	assert(size <= short_hash_size);
+	char padded[short_hash_size] = {};
+	copy(data, data + size, padded);
+	auto result = short_hash_words();
+	for (std::size_t n = 0; n != result.size(); ++n) {
+		result[n] = load_little_endian(padded + n * sizeof(std::uint64_t));
+	}
+	return result;
+}
+
+// Hashes the same way as either string, so it can look them up by
+// std::string_view.
+constexpr std::size_t hash_bytes(char const * const data, std::size_t const size) {
+	return size <= short_hash_size ? hash_short(padded_words(data, size), size) : hash_long(data, size);
+}
+
+
+// Maps a hash onto [0, size) using its upper bits, which avoids a division
+constexpr std::size_t reduce(std::uint64_t const hash, std::size_t const size) {
+	return static_cast<std::size_t>((static_cast<unsigned __int128>(hash) * size) >> 64);
+}
+
+// The upper bits of the hash choose a bucket, and the displacement of the
+// bucket chooses where its keywords go: slot (first + multiplier * second +
+// offset) % size, where first and second come from rehashing the hash. This
+// is the CHD algorithm by Belazzougui, Botelho, and Dietzfelbinger.
+struct displacement {
+	std::uint32_t multiplier;
+	std::uint32_t offset;
+};
+
+constexpr std::size_t bucket_of(std::uint64_t const hash, std::size_t const bucket_count) {
+	return reduce(hash, bucket_count);
+}
+constexpr std::pair<std::size_t, std::size_t> slot_hashes(std::uint64_t const hash, std::size_t const size) {
+	auto const mixed = avalanche(hash ^ size_key);
+	return {reduce(mixed, size), reduce(std::rotl(mixed, 32), size)};
+}
+constexpr std::size_t slot_of(std::uint64_t const hash, displacement const bucket, std::size_t const size) {
+	auto const [first, second] = slot_hashes(hash, size);
+	return (first + bucket.multiplier * second + bucket.offset) % size;
+}
+
+// The views refer to the range of keywords, which has to outlive them
+constexpr std::vector<std::string_view> unique_keywords(auto const & keywords) {
+	auto result = std::vector<std::string_view>();
+	for (auto const & keyword : keywords) {
+		result.push_back(std::string_view(keyword));
+	}
+	std::ranges::sort(result);
+	auto const duplicates = std::ranges::unique(result);
+	result.erase(duplicates.begin(), duplicates.end());
+	return result;
+}
+
+// Places the buckets with the most keywords first, while there are still
+// plenty of free slots. A bucket with more than one keyword tries each
+// multiplier that spreads its keywords to different slots, and then each
+// offset, until they all land on free slots. A bucket with one keyword can
+// use its offset to go straight to any free slot, which is what makes this
+// fast enough to run in a constant expression.
+template<std::size_t bucket_count, std::size_t size>
+constexpr std::array<displacement, bucket_count> find_displacements(std::array<std::uint64_t, size> const & hashes) {
+	auto buckets = std::vector<std::vector<std::size_t>>(bucket_count);
+	for (std::size_t n = 0; n != size; ++n) {
+		buckets[bucket_of(hashes[n], bucket_count)].push_back(n);
+	}
+	auto order = std::vector<std::size_t>(bucket_count);
+	std::iota(order.begin(), order.end(), std::size_t(0));
+	std::ranges::sort(order, std::greater(), [&](std::size_t const bucket) {
+		return buckets[bucket].size();
+	});
+
+	auto result = std::array<displacement, bucket_count>();
+	auto taken = std::vector<bool>(size);
+	auto next_free = std::size_t(0);
+	auto bases = std::vector<std::size_t>();
+	auto place = [&](std::size_t const bucket) {
+		auto const & keywords = buckets[bucket];
+		if (keywords.size() == 1) {
+			while (taken[next_free]) {
+				++next_free;
+			}
+			auto const first = slot_hashes(hashes[keywords.front()], size).first;
+			result[bucket] = {0, static_cast<std::uint32_t>((next_free + size - first) % size)};
+			taken[next_free] = true;
+			return true;
+		}
+		for (std::size_t multiplier = 0; multiplier != size; ++multiplier) {
+			bases.clear();
+			for (auto const keyword : keywords) {
+				auto const [first, second] = slot_hashes(hashes[keyword], size);
+				bases.push_back((first + multiplier * second) % size);
+			}
+			std::ranges::sort(bases);
+			if (std::ranges::adjacent_find(bases) != bases.end()) {
+				continue;
+			}
+			// Only offsets that put the first keyword on a free slot can work
+			for (std::size_t slot = 0; slot != size; ++slot) {
+				if (taken[slot]) {
+					continue;
+				}
+				auto const offset = (slot + size - bases.front()) % size;
+				auto const fits = std::ranges::none_of(bases | std::views::drop(1), [&](std::size_t const base) {
+					return taken[(base + offset) % size];
+				});
+				if (fits) {
+					for (auto const base : bases) {
+						taken[(base + offset) % size] = true;
+					}
+					result[bucket] = {static_cast<std::uint32_t>(multiplier), static_cast<std::uint32_t>(offset)};
+					return true;
+				}
+			}
+		}
+		return false;
+	};
+	for (auto const bucket : order) {
+		if (buckets[bucket].empty()) {
+			break;
+		}
+		if (!place(bucket)) {
+			throw std::logic_error("Could not find a perfect hash. Two keywords might have the same hash.");
+		}
+	}
+	return result;
+}
+
+// A minimal perfect hash over a fixed set of keywords. Every keyword has an
+// index from 0 to size() - 1, and the characters of all of them are stored
+// back to back in index order. A lookup is one hash of the key, two array
+// reads, and one comparison, with no probing.
+//
+// This is meant to be a constexpr variable, so that all of it is in
+// read-only data and there is nothing to build when the program starts.
+template<std::size_t size_, std::size_t character_count, std::size_t bucket_count>
+class keyword_table {
+public:
+	static constexpr std::size_t not_found = size_;
+
+	constexpr keyword_table(std::array<char, character_count> const & characters, std::array<std::uint32_t, size_ + 1> const & offsets, std::array<displacement, bucket_count> const & displacements):
+		characters_(characters),
+		offsets_(offsets),
+		displacements_(displacements)
+	{
+	}
+
+	static constexpr std::size_t size() {
+		return size_;
+	}
+
+	constexpr std::string_view operator[](std::size_t const index) const {
+		assert(index < size_);
+		return std::string_view(characters_.data() + offsets_[index], offsets_[index + 1] - offsets_[index]);
+	}
+
+	// Returns not_found if key is not one of the keywords
+	constexpr std::size_t find(std::string_view const key) const {
+		if constexpr (size_ == 0) {
+			return not_found;
+		} else {
+			auto const hash = hash_bytes(key.data(), key.size());
+			auto const index = slot_of(hash, displacements_[bucket_of(hash, bucket_count)], size_);
+			return (*this)[index] == key ? index : not_found;
+		}
+	}
+
+	// For case labels. Using a key that is not a keyword does not compile.
+	consteval std::size_t index(std::string_view const key) const {
+		auto const result = find(key);
+		if (result == not_found) {
+			throw std::logic_error("Not a keyword");
+		}
+		return result;
+	}
+
+private:
+	std::array<char, character_count> characters_;
+	std::array<std::uint32_t, size_ + 1> offsets_;
+	std::array<displacement, bucket_count> displacements_;
+};
+
+// make_keywords is a lambda that returns a range of anything that converts
+// to std::string_view, such as a std::array of string literals. Duplicates
+// are removed. It is called during constant evaluation, so it can also build
+// keywords with std::string.
+//
+//     constexpr auto methods = make_keyword_table<[] {
+//         return std::array<std::string_view, 3>{"GET", "PUT", "POST"};
+//     }>();
+//
+//     switch (methods.find(method)) {
+//         case methods.index("GET"): ...
+//         case methods.index("POST"): ...
+//         case methods.not_found: ...
+//     }
+template<auto make_keywords>
+consteval auto make_keyword_table() {
+	constexpr auto counts = [] {
+		auto const source = make_keywords();
+		auto const keywords = unique_keywords(source);
+		auto characters = std::size_t(0);
+		for (auto const & keyword : keywords) {
+			characters += keyword.size();
+		}
+		return std::pair(keywords.size(), characters);
+	}();
+	constexpr auto size = counts.first;
+	constexpr auto character_count = counts.second;
+	constexpr auto bucket_count = size / 4 + 1;
+
+	auto const source = make_keywords();
+	auto const keywords = unique_keywords(source);
+	auto hashes = std::array<std::uint64_t, size>();
+	for (std::size_t n = 0; n != size; ++n) {
+		hashes[n] = hash_bytes(keywords[n].data(), keywords[n].size());
+	}
+	auto const displacements = find_displacements<bucket_count>(hashes);
+
+	auto keyword_at = std::array<std::size_t, size>();
+	for (std::size_t n = 0; n != size; ++n) {
+		keyword_at[slot_of(hashes[n], displacements[bucket_of(hashes[n], bucket_count)], size)] = n;
+	}
+	auto characters = std::array<char, character_count>();
+	auto offsets = std::array<std::uint32_t, size + 1>();
+	auto offset = std::size_t(0);
+	for (std::size_t index = 0; index != size; ++index) {
+		offsets[index] = static_cast<std::uint32_t>(offset);
+		auto const & keyword = keywords[keyword_at[index]];
+		std::ranges::copy(keyword, characters.begin() + offset);
+		offset += keyword.size();
+	}
+	offsets[size] = static_cast<std::uint32_t>(offset);
+	return keyword_table<size, character_count, bucket_count>(characters, offsets, displacements);
+}
+
+
+constexpr auto http_methods = make_keyword_table<[] {
+	return std::array<std::string_view, 9>{
+		"GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH",
+	};
+}>();
+
+enum class method {
+	safe,
+	unsafe,
+	unknown,
+};
+
+constexpr method classify(std::string_view const name) {
+	switch (http_methods.find(name)) {
+		case http_methods.index("GET"):
+		case http_methods.index("HEAD"):
+		case http_methods.index("OPTIONS"):
+		case http_methods.index("TRACE"):
+			return method::safe;
+		case http_methods.index("POST"):
+		case http_methods.index("PUT"):
+		case http_methods.index("DELETE"):
+		case http_methods.index("CONNECT"):
+		case http_methods.index("PATCH"):
+			return method::unsafe;
+		default:
+			return method::unknown;
+	}
+}
+
+static_assert(http_methods.size() == 9);
+static_assert(classify("GET") == method::safe);
+static_assert(classify("PATCH") == method::unsafe);
+static_assert(classify("get") == method::unknown);
+static_assert(classify("") == method::unknown);
+
+constexpr std::string_view header_names[] = {
+	"a-im", "accept", "accept-charset", "accept-datetime", "accept-encoding",
+	"accept-language", "accept-patch", "accept-ranges",
+	"access-control-allow-credentials", "access-control-allow-headers",
+	"access-control-allow-methods", "access-control-allow-origin",
+	"access-control-expose-headers", "access-control-max-age",
+	"access-control-request-headers", "access-control-request-method", "age",
+	"allow", "alt-svc", "authorization", "cache-control", "connection",
+	"content-disposition", "content-encoding", "content-language",
+	"content-length", "content-location", "content-range",
+	"content-security-policy", "content-type", "cookie", "date", "delta-base",
+	"etag", "expect", "expires", "forwarded", "from", "host", "http2-settings",
+	"if-match", "if-modified-since", "if-none-match", "if-range",
+	"if-unmodified-since", "im", "last-modified", "link", "location",
+	"max-forwards", "origin", "p3p", "pragma", "prefer", "preference-applied",
+	"proxy-authenticate", "proxy-authorization", "public-key-pins", "range",
+	"referer", "retry-after", "server", "set-cookie", "strict-transport-security",
+	"te", "tk", "trailer", "transfer-encoding", "upgrade", "user-agent", "vary",
+	"via", "warning", "www-authenticate", "x-content-type-options",
+	"x-forwarded-for", "x-forwarded-host", "x-forwarded-proto", "x-frame-options",
+	"x-request-id", "x-xss-protection",
+};
+
+// The standard names plus enough made up ones to reach 400, with every
+// standard name listed twice to check that duplicates are removed.
+constexpr auto make_header_names() {
+	auto result = std::vector<std::string>();
+	for (std::size_t repeat = 0; repeat != 2; ++repeat) {
+		for (auto const name : header_names) {
+			result.emplace_back(name);
+		}
+	}
+	for (std::size_t n = 0; n != 400 - std::size(header_names); ++n) {
+		auto name = std::string("x-vendor-header-");
+		for (auto value = n; ; value /= 10) {
+			name.insert(name.begin() + 16, static_cast<char>('0' + value % 10));
+			if (value < 10) {
+				break;
+			}
+		}
+		result.push_back(std::move(name));
+	}
+	return result;
+}
+
+constexpr auto headers = make_keyword_table<[] { return make_header_names(); }>();
+
+static_assert(headers.size() == 400);
+static_assert(headers[headers.index("content-type")] == "content-type");
+static_assert(headers[headers.index("x-vendor-header-318")] == "x-vendor-header-318");
+
+constexpr bool test() {
+	auto seen = std::array<bool, headers.size()>();
+	for (auto const & name : make_header_names()) {
+		auto const index = headers.find(name);
+		assert(index != headers.not_found);
+		assert(headers[index] == name);
+		seen[index] = true;
+	}
+	assert(std::ranges::all_of(seen, std::identity()));
+
+	assert(headers.find("") == headers.not_found);
+	assert(headers.find("content") == headers.not_found);
+	assert(headers.find("content-typ") == headers.not_found);
+	assert(headers.find("content-types") == headers.not_found);
+	assert(headers.find("Content-Type") == headers.not_found);
+	assert(headers.find("x-vendor-header-400") == headers.not_found);
+
+	constexpr auto empty = make_keyword_table<[] { return std::array<std::string_view, 0>(); }>();
+	assert(empty.find("") == empty.not_found);
+	return true;
+}
+
+template<typename Function>
+double nanoseconds_per_operation(std::size_t const count, Function && function) {
+	auto const start = std::chrono::steady_clock::now();
+	function();
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+}
+
+// The table has nothing to build at run time, which is the point. This
+// compares lookups against an std::unordered_map, and shows how long that
+// map takes to build.
+void benchmark() {
+	auto const names = make_header_names();
+	auto engine = std::minstd_rand(1);
+	auto lookups = std::vector<std::string>();
+	for (std::size_t n = 0; n != 1'000'000; ++n) {
+		auto name = names[std::uniform_int_distribution<std::size_t>(0, names.size() - 1)(engine)];
+		if (n % 4 == 0) {
+			name.back() = '?';
+		}
+		lookups.push_back(std::move(name));
+	}
+
+	auto map = std::unordered_map<std::string_view, std::size_t>();
+	auto const build_time = nanoseconds_per_operation(1, [&] {
+		for (std::size_t n = 0; n != headers.size(); ++n) {
+			map.emplace(headers[n], n);
+		}
+	});
+
+	auto sink = std::size_t(0);
+	auto const map_time = nanoseconds_per_operation(lookups.size(), [&] {
+		for (auto const & name : lookups) {
+			auto const it = map.find(name);
+			sink += it != map.end() ? it->second : headers.not_found;
+		}
+	});
+	auto const table_time = nanoseconds_per_operation(lookups.size(), [&] {
+		for (auto const & name : lookups) {
+			sink -= headers.find(name);
+		}
+	});
+	assert(sink == 0);
+	std::printf("keyword_table: %zu bytes, nothing to build\n", sizeof(headers));
+	std::printf("unordered_map: %.0f ns to build\n", build_time);
+	std::printf("%-20s %14s\n", "", "ns per lookup");
+	std::printf("%-20s %14.1f\n", "unordered_map", map_time);
+	std::printf("%-20s %14.1f\n", "keyword_table", table_time);
+}
+
+int main() {
+	test();
+	static_assert(test());
+	for (auto const name : header_names) {
+		assert(classify(name) == method::unknown);
+		assert(headers[headers.find(name)] == name);
+	}
+	benchmark();
+}
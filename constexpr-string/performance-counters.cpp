@@ -0,0 +1,1049 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20 and Linux. The goal of this version is to measure
+// the cost of the branch that the clang layout needs on every call to data()
+// and size(), which the gcc / MSVC layout avoids.
+//
+// perf_counters reads the hardware counters for cycles, instructions, branch
+// misses, and L1 data cache misses through perf_event_open. Where those are
+// not available (in most virtual machines, or with perf_event_paranoid set too
+// high), it falls back to the task clock software counter and the time stamp
+// counter, so the benchmark still runs and says which numbers are missing.
+//
+// Running the program reports each counter per operation for each layout on
+// each workload. The collections that mix small and large strings at random
+// are the ones where the clang layout cannot predict its branch.
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+#endif
+
+template<typename T>
+struct buffer {
+	constexpr buffer() = default;
+	buffer(buffer &&) = delete;
+	buffer(buffer const &) = delete;
+	buffer & operator=(buffer &&) = delete;
+	buffer & operator=(buffer const &) = delete;
+
+	T data[5000] = {};
+	T * pointer = data;
+};
+
+template<typename T>
+struct allocator {
+	using value_type = T;
+
+	explicit constexpr allocator(buffer<T> & buffer):
+		buffer_(&buffer)
+	{
+	}
+
+	constexpr auto allocate(std::size_t size) {
+		auto const result = buffer_->pointer;
+		buffer_->pointer += size;
+		return result;
+	}
+	constexpr void deallocate(T * ptr, std::size_t size) {
+	}
+
+private:
+	buffer<T> * buffer_;
+};
+
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+
+enum class counter {
+	cycles,
+	instructions,
+	branch_misses,
+	l1d_misses,
+};
+
+constexpr auto counter_count = std::size_t(4);
+
+struct counter_reading {
+	std::array<std::optional<double>, counter_count> hardware;
+	// Always available
+	double nanoseconds;
+	// Time stamp counter ticks, where the processor has one. These count at a
+	// fixed rate rather than the current clock speed.
+	std::optional<double> reference_cycles;
+
+	constexpr std::optional<double> operator[](counter const index) const {
+		return hardware[static_cast<std::size_t>(index)];
+	}
+};
+
+class perf_counters {
+public:
+	perf_counters() {
+		constexpr auto l1d_read_miss =
+			PERF_COUNT_HW_CACHE_L1D |
+			(PERF_COUNT_HW_CACHE_OP_READ << 8) |
+			(PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		hardware_[0] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+		hardware_[1] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+		hardware_[2] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+		hardware_[3] = open(PERF_TYPE_HW_CACHE, l1d_read_miss);
+		task_clock_ = open(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK);
+	}
+	perf_counters(perf_counters &&) = delete;
+	perf_counters(perf_counters const &) = delete;
+	perf_counters & operator=(perf_counters &&) = delete;
+	perf_counters & operator=(perf_counters const &) = delete;
+
+	~perf_counters() {
+		for (int const fd : hardware_) {
+			close(fd);
+		}
+		close(task_clock_);
+	}
+
+	bool has_hardware_counters() const {
+		return std::any_of(hardware_.begin(), hardware_.end(), [](int const fd) { return fd != -1; });
+	}
+
+	void start() {
+		for (int const fd : hardware_) {
+			enable(fd);
+		}
+		enable(task_clock_);
+		start_time_ = std::chrono::steady_clock::now();
+		start_ticks_ = time_stamp_counter();
+	}
+
+	// Divides every counter by operations
+	counter_reading stop(std::size_t const operations) {
+		auto const ticks = time_stamp_counter();
+		auto const elapsed = std::chrono::steady_clock::now() - start_time_;
+		for (int const fd : hardware_) {
+			disable(fd);
+		}
+		disable(task_clock_);
+
+		auto const divisor = static_cast<double>(operations);
+		auto result = counter_reading();
+		for (std::size_t n = 0; n != counter_count; ++n) {
+			if (auto const value = read(hardware_[n])) {
+				result.hardware[n] = *value / divisor;
+			}
+		}
+		auto const task_clock = read(task_clock_);
+		result.nanoseconds = (task_clock ? *task_clock : std::chrono::duration<double, std::nano>(elapsed).count()) / divisor;
+		if (ticks) {
+			result.reference_cycles = static_cast<double>(*ticks - *start_ticks_) / divisor;
+		}
+		return result;
+	}
+
+private:
+	static int open(std::uint32_t const type, std::uint64_t const config) {
+		auto attributes = perf_event_attr();
+		attributes.size = sizeof(attributes);
+		attributes.type = type;
+		attributes.config = config;
+		attributes.disabled = 1;
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+		// With more events than hardware counters, the kernel multiplexes them
+		// and these let us scale up to the full run.
+		attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+	}
+
+	static void enable(int const fd) {
+		if (fd != -1) {
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+	static void disable(int const fd) {
+		if (fd != -1) {
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+		}
+	}
+
+	static std::optional<double> read(int const fd) {
+		if (fd == -1) {
+			return std::nullopt;
+		}
+		struct {
+			std::uint64_t value;
+			std::uint64_t time_enabled;
+			std::uint64_t time_running;
+		} result;
+		if (::read(fd, &result, sizeof(result)) != sizeof(result) or result.time_running == 0) {
+			return std::nullopt;
+		}
+		return static_cast<double>(result.value) * static_cast<double>(result.time_enabled) / static_cast<double>(result.time_running);
+	}
+
+	static std::optional<std::uint64_t> time_stamp_counter() {
+		#if defined(__x86_64__) || defined(__i386__)
+			return __rdtsc();
+		#else
+			return std::nullopt;
+		#endif
+	}
+
+	std::array<int, counter_count> hardware_;
+	int task_clock_;
+	std::chrono::steady_clock::time_point start_time_;
+	std::optional<std::uint64_t> start_ticks_;
+};
+
+
+template<typename T>
+struct heap_allocator {
+	using value_type = T;
+
+	constexpr heap_allocator() = default;
+	template<typename U>
+	constexpr heap_allocator(heap_allocator<U>) {
+	}
+
+	T * allocate(std::size_t size) {
+		return std::allocator<T>().allocate(size);
+	}
+	void deallocate(T * ptr, std::size_t size) {
+		std::allocator<T>().deallocate(ptr, size);
+	}
+
+	friend constexpr bool operator==(heap_allocator, heap_allocator) = default;
+};
+
+
+namespace clang {
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	static constexpr std::size_t small_buffer_capacity = 23;
+
+	struct small_t {
+		char data[small_buffer_capacity] = {};
+	};
+	struct [[gnu::packed]] large_t {
+		static constexpr std::size_t bytes_remaining = 7;
+
+		template<typename It>
+		class range_view {
+		public:
+			constexpr range_view(It first, It last):
+				first_(first),
+				last_(last)
+			{
+			}
+			constexpr auto begin() const {
+				return first_;
+			}
+			constexpr auto end() const {
+				return last_;
+			}
+		private:
+			It first_;
+			It last_;
+		};
+
+		constexpr auto little_endian_capacity() const {
+			return range_view(
+				std::rbegin(rest_of_capacity),
+				std::rend(rest_of_capacity)
+			);
+		}
+		constexpr auto big_endian_capacity() {
+			return range_view(
+				std::begin(rest_of_capacity),
+				std::end(rest_of_capacity)
+			);
+		}
+
+		constexpr large_t(std::size_t set_size, std::size_t capacity, char * pointer) noexcept:
+			rest_of_capacity{},
+			size(set_size),
+			data(pointer)
+		{
+			assert(data != nullptr);
+			for (unsigned char & byte : big_endian_capacity()) {
+				capacity >>= CHAR_BIT;
+				byte = capacity;
+			}
+		}
+
+		unsigned char rest_of_capacity[bytes_remaining];
+		std::size_t size;
+		char * data;
+	};
+
+	[[no_unique_address]] allocator_type allocator_;
+	unsigned char size_or_first_byte_of_capacity_;
+	union U {
+		constexpr U() noexcept:
+			small{}
+		{
+		}
+		explicit constexpr U(std::size_t size, std::size_t capacity, char * data) noexcept:
+			large(size, capacity, data)
+		{
+		}
+		constexpr U(large_t set_large) noexcept:
+			large(set_large)
+		{
+		}
+
+		small_t small;
+		large_t large;
+	} u_;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return size_or_first_byte_of_capacity_ & 1;
+	}
+
+	constexpr void increment_size() {
+		if (is_large()) {
+			++u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ += (1 << 1);
+		}
+	}
+	constexpr void decrement_size() {
+		if (is_large()) {
+			--u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ -= (1 << 1);
+		}
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, u_.large.data, capacity());
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(size(), new_capacity, new_data);
+		assert(new_capacity & 1);
+		size_or_first_byte_of_capacity_ = new_capacity;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		new_capacity |= 1;
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy(begin(), end(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		size_or_first_byte_of_capacity_(0),
+		u_{}
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.large);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+
+			other.u_ = U{};
+			other.size_or_first_byte_of_capacity_ = 0;
+		} else {
+			auto & osmall = other.u_.small;
+			u_ = U{};
+			copy(osmall.data, osmall.data + (other.size_or_first_byte_of_capacity_ >> 1), u_.small.data);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr char * data() {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr std::size_t size() const {
+		return is_large() ? u_.large.size : (size_or_first_byte_of_capacity_ >> 1);
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		if (!is_large()) {
+			return small_buffer_capacity;
+		}
+		std::size_t result = 0;
+		for (unsigned char const byte : u_.large.little_endian_capacity()) {
+			result |= byte;
+			result <<= CHAR_BIT;
+		}
+		result |= size_or_first_byte_of_capacity_;
+		return result;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		auto const local_size = size();
+		if (is_large() && capacity() > (local_size | 1)) {
+			if (local_size > small_buffer_capacity) {
+				force_reserve(local_size);
+			} else {
+				auto const data = u_.large.data;
+				auto const original_capacity = capacity();
+				u_ = U{};
+				size_or_first_byte_of_capacity_ = local_size << 1;
+				copy(data, data + local_size, u_.small.data);
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = std::prev(end());
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = (capacity() * growth_factor) | 1;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+
+			relocate(temp, new_capacity);
+		}
+		increment_size();
+		return begin() + offset;
+	}
+
+	constexpr void pop_back() {
+		decrement_size();
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace clang
+
+namespace gcc {
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	[[no_unique_address]] allocator_type allocator_;
+	// This could be set to 8 to reduce the size of our string to 24 bytes
+	// (just like clang), but 7 characters (plus a null terminator) is likely
+	// too small of a buffer for most users.
+	static constexpr std::size_t small_buffer_capacity = 16;
+	union U{
+		constexpr U():
+			buffer{}
+		{
+		}
+		constexpr U(std::size_t c):
+			capacity(c)
+		{
+		}
+
+		char buffer[small_buffer_capacity];
+		std::size_t capacity;
+	} u_;
+	char * data_;
+	std::size_t size_ : 63;
+	// gcc and MSVC do not allow accessing the inactive member of a union just
+	// to get its address, so we use a bitfield to work around this.
+	bool is_large_ : 1;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return is_large_;
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, data_, u_.capacity);
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(new_capacity);
+		data_ = new_data;
+		is_large_ = true;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy(begin(), end(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_{},
+		data_(u_.buffer),
+		size_(0),
+		is_large_(false)
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.capacity);
+			other.u_ = U{};
+		
+			data_ = other.data_;
+			other.data_ = other.u_.buffer;
+		
+			size_ = other.size_;
+			other.size_ = 0U;
+		
+			is_large_ = true;
+			other.is_large_ = false;
+
+		} else {
+			u_ = U{};
+			copy(other.data_, other.data_ + other.size_, u_.buffer);
+			data_ = u_.buffer;
+			size_ = other.size_;
+			is_large_ = false;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return data_;
+	}
+	constexpr char * data() {
+		return data_;
+	}
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		return is_large() ? u_.capacity : small_buffer_capacity;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		if (is_large() && capacity() > size()) {
+			if (size() > small_buffer_capacity) {
+				force_reserve(size());
+			} else {
+				auto const data = data_;
+				auto const original_capacity = u_.capacity;
+				u_ = U{};
+				copy(data, data + size_, u_.buffer);
+				data_ = u_.buffer;
+				is_large_ = false;
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = end() - 1;
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = capacity() * growth_factor;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+		
+			relocate(temp, new_capacity);
+		}
+		++size_;
+		return begin() + offset;
+	}
+
+	constexpr void pop_back() {
+		--size_;
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace gcc
+
+using clang_string = clang::string<heap_allocator<char>>;
+using gcc_string = gcc::string<heap_allocator<char>>;
+
+// Keeps the compiler from discarding the results of a workload
+inline volatile std::size_t sink;
+
+template<typename String>
+String make_string(std::size_t const size) {
+	auto result = String(heap_allocator<char>());
+	for (std::size_t n = 0; n != size; ++n) {
+		result.insert(result.end(), static_cast<char>('a' + n % 26));
+	}
+	return result;
+}
+
+// Every string is either short enough for both small buffers or too long for
+// either, so both layouts make the same choice for each string.
+enum class mix {
+	small,
+	large,
+	random,
+};
+
+constexpr char const * to_string(mix const value) {
+	switch (value) {
+		case mix::small: return "small";
+		case mix::large: return "large";
+		case mix::random: return "random";
+	}
+	return "";
+}
+
+template<typename String>
+std::vector<String> make_strings(mix const kind, std::size_t const count) {
+	auto engine = std::minstd_rand(1);
+	auto result = std::vector<String>();
+	result.reserve(count);
+	for (std::size_t n = 0; n != count; ++n) {
+		auto const is_large =
+			kind == mix::large or
+			(kind == mix::random and std::bernoulli_distribution()(engine));
+		result.push_back(make_string<String>(is_large ? 40 : 10));
+	}
+	return result;
+}
+
+constexpr auto string_count = std::size_t(1) << 14;
+constexpr auto repetitions = std::size_t(50);
+
+struct workload {
+	char const * name;
+	// Returns the number of operations performed
+	std::size_t (*clang)(std::vector<clang_string> &);
+	std::size_t (*gcc)(std::vector<gcc_string> &);
+};
+
+template<typename String>
+std::size_t sum_sizes(std::vector<String> & strings) {
+	auto result = std::size_t(0);
+	for (std::size_t repetition = 0; repetition != repetitions; ++repetition) {
+		for (auto const & str : strings) {
+			result += str.size();
+		}
+	}
+	sink = result;
+	return repetitions * strings.size();
+}
+
+template<typename String>
+std::size_t read_first(std::vector<String> & strings) {
+	auto result = std::size_t(0);
+	for (std::size_t repetition = 0; repetition != repetitions; ++repetition) {
+		for (auto const & str : strings) {
+			result += static_cast<unsigned char>(*str.data());
+		}
+	}
+	sink = result;
+	return repetitions * strings.size();
+}
+
+template<typename String>
+std::size_t read_last(std::vector<String> & strings) {
+	auto result = std::size_t(0);
+	for (std::size_t repetition = 0; repetition != repetitions; ++repetition) {
+		for (auto const & str : strings) {
+			result += static_cast<unsigned char>(*std::prev(str.end()));
+		}
+	}
+	sink = result;
+	return repetitions * strings.size();
+}
+
+template<typename String>
+std::size_t overwrite_all(std::vector<String> & strings) {
+	auto operations = std::size_t(0);
+	for (auto & str : strings) {
+		for (char & c : str) {
+			++c;
+		}
+		operations += str.size();
+	}
+	sink = operations;
+	return operations;
+}
+
+template<typename String>
+std::size_t append_pop(std::vector<String> & strings) {
+	for (auto & str : strings) {
+		str.insert(str.end(), 'x');
+	}
+	for (auto & str : strings) {
+		str.pop_back();
+	}
+	return 2 * strings.size();
+}
+
+constexpr auto workloads = std::array{
+	workload{"sum_sizes", sum_sizes<clang_string>, sum_sizes<gcc_string>},
+	workload{"read_first", read_first<clang_string>, read_first<gcc_string>},
+	workload{"read_last", read_last<clang_string>, read_last<gcc_string>},
+	workload{"overwrite_all", overwrite_all<clang_string>, overwrite_all<gcc_string>},
+	workload{"append_pop", append_pop<clang_string>, append_pop<gcc_string>},
+};
+
+void print(char const * layout, char const * kind, char const * name, counter_reading const & reading) {
+	auto field = [](std::optional<double> const value) {
+		if (value) {
+			std::printf(" %10.2f", *value);
+		} else {
+			std::printf(" %10s", "-");
+		}
+	};
+	std::printf("%-6s %-7s %-14s", layout, kind, name);
+	field(reading[counter::cycles]);
+	field(reading[counter::instructions]);
+	field(reading[counter::branch_misses]);
+	field(reading[counter::l1d_misses]);
+	field(reading.reference_cycles);
+	field(reading.nanoseconds);
+	std::printf("\n");
+}
+
+void benchmark() {
+	auto counters = perf_counters();
+	if (!counters.has_hardware_counters()) {
+		std::printf("Hardware counters are not available, reporting only time\n");
+	}
+	std::printf(
+		"%-6s %-7s %-14s %10s %10s %10s %10s %10s %10s   (per operation)\n",
+		"layout", "strings", "workload", "cycles", "instrs", "br-miss", "l1d-miss", "ref-cycles", "ns"
+	);
+
+	auto run = [&](char const * layout, mix const kind, char const * name, auto & strings, auto const function) {
+		function(strings);
+		counters.start();
+		auto const operations = function(strings);
+		print(layout, to_string(kind), name, counters.stop(operations));
+	};
+
+	for (auto const kind : {mix::small, mix::large, mix::random}) {
+		auto clang_strings = make_strings<clang_string>(kind, string_count);
+		auto gcc_strings = make_strings<gcc_string>(kind, string_count);
+		for (auto const & work : workloads) {
+			run("clang", kind, work.name, clang_strings, work.clang);
+			run("gcc", kind, work.name, gcc_strings, work.gcc);
+		}
+	}
+}
+
+constexpr void test_individual(auto & str, char const * source) {
+	using String = std::remove_reference_t<decltype(str)>;
+	String temp(str.get_allocator());
+	for (auto it = source; *it != '\0'; ++it) {
+		str.insert(str.end(), *it);
+		temp.insert(temp.end(), *it);
+	}
+
+	temp.insert(temp.begin(), 'a');
+	temp.insert(temp.begin() + temp.size() / 2, 'b');
+	auto const size = std::char_traits<char>::length(source);
+	auto const middle = (size + 1) / 2;
+	assert(temp.size() == size + 2);
+	for (std::size_t n = 0; n != temp.size(); ++n) {
+		auto const expected = n == 0 ? 'a' : n == middle ? 'b' : n < middle ? source[n - 1] : source[n - 2];
+		assert(temp.data()[n] == expected);
+	}
+
+	// Inserting at the front, including each time that reallocates
+	String front(str.get_allocator());
+	for (std::size_t n = 0; n != 100; ++n) {
+		front.insert(front.begin(), static_cast<char>('0' + n % 10));
+	}
+	for (std::size_t n = 0; n != front.size(); ++n) {
+		assert(front.data()[n] == static_cast<char>('0' + (99 - n) % 10));
+	}
+
+	while (temp.size() != 0) {
+		temp.pop_back();
+	}
+	assert(temp.size() == 0);
+
+	auto temp2 = std::move(str);
+	str = std::move(temp2);
+
+	assert(str.data() != temp.data());
+	assert(str.size() == std::char_traits<char>::length(source));
+	assert(std::char_traits<char>::compare(str.data(), source, str.size()) == 0);
+	assert(str.capacity() >= str.size());
+
+	str.reserve(50);
+	str.shrink_to_fit();
+}
+
+template<typename String>
+constexpr void test_layout() {
+	buffer<char> buff{};
+	auto alloc = allocator(buff);
+
+	char const * short_source = "0123";
+	char const * long_source =
+		"0123456789"
+		"0123456789"
+		"0123456789"
+		"0123456789"
+		"0123456789";
+
+	String short_str(alloc);
+	test_individual(short_str, short_source);
+
+	String long_str(alloc);
+	test_individual(long_str, long_source);
+
+	String temp(alloc);
+	temp = std::move(long_str);
+	temp = std::move(short_str);
+}
+
+constexpr bool test() {
+	test_layout<clang::string<allocator<char>>>();
+	test_layout<gcc::string<allocator<char>>>();
+	return true;
+}
+
+void test_counters() {
+	auto counters = perf_counters();
+	counters.start();
+	auto const reading = counters.stop(1);
+	assert(reading.nanoseconds >= 0.0);
+	for (auto const value : reading.hardware) {
+		assert(!value or *value >= 0.0);
+	}
+
+	auto const strings = make_strings<clang_string>(mix::random, 100);
+	auto const large = std::count_if(strings.begin(), strings.end(), [](auto const & str) { return str.size() == 40; });
+	assert(large > 0 and large < 100);
+}
+
+int main() {
+	test();
+	static_assert(test());
+	test_counters();
+	benchmark();
+}
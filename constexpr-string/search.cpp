@@ -0,0 +1,1299 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is to add find, rfind, and
+// find_first_of to both layouts, staying usable in constant evaluation while
+// running vectorized code at run time.
+//
+// During constant evaluation, every search is a simple loop. At run time on
+// x86-64, they dispatch on the processor to AVX2 or SSE2 / SSSE3:
+//
+// * Single characters are found with one comparison per 16 or 32 bytes.
+// * Substrings are found by comparing the first and last characters of the
+//   needle at every position of a vector at once, and comparing the rest only
+//   where both match.
+// * find_first_of looks up each byte in a bitmap of the set with two byte
+//   shuffles, as long as the set is ASCII.
+// * A string in the small buffer is searched with one 16 byte load of the
+//   buffer (two overlapping loads for the 23 byte clang buffer), which can
+//   read past the size because the buffer belongs to the string object.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__x86_64__)
+	#include <immintrin.h>
+#endif
+
+template<typename T>
+struct buffer {
+	constexpr buffer() = default;
+	buffer(buffer &&) = delete;
+	buffer(buffer const &) = delete;
+	buffer & operator=(buffer &&) = delete;
+	buffer & operator=(buffer const &) = delete;
+
+	T data[5000] = {};
+	T * pointer = data;
+};
+
+template<typename T>
+struct allocator {
+	using value_type = T;
+
+	explicit constexpr allocator(buffer<T> & buffer):
+		buffer_(&buffer)
+	{
+	}
+
+	constexpr auto allocate(std::size_t size) {
+		auto const result = buffer_->pointer;
+		buffer_->pointer += size;
+		return result;
+	}
+	constexpr void deallocate(T * ptr, std::size_t size) {
+	}
+
+private:
+	buffer<T> * buffer_;
+};
+
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+
+constexpr auto npos = std::size_t(-1);
+
+// The scalar versions are what runs during constant evaluation, and the
+// reference the vectorized versions are tested against.
+
+constexpr std::size_t scalar_find_byte(char const * const data, std::size_t const size, char const c) {
+	for (std::size_t n = 0; n != size; ++n) {
+		if (data[n] == c) {
+			return n;
+		}
+	}
+	return npos;
+}
+
+constexpr std::size_t scalar_rfind_byte(char const * const data, std::size_t const size, char const c) {
+	for (auto n = size; n != 0; --n) {
+		if (data[n - 1] == c) {
+			return n - 1;
+		}
+	}
+	return npos;
+}
+
+constexpr bool equal(char const * const lhs, char const * const rhs, std::size_t const size) {
+	return std::char_traits<char>::compare(lhs, rhs, size) == 0;
+}
+
+// Requires needle_size != 0 and needle_size <= size
+constexpr std::size_t scalar_find(char const * const data, std::size_t const size, char const * const needle, std::size_t const needle_size) {
+	for (std::size_t n = 0; n != size - needle_size + 1; ++n) {
+		if (equal(data + n, needle, needle_size)) {
+			return n;
+		}
+	}
+	return npos;
+}
+
+class byte_set {
+public:
+	constexpr explicit byte_set(std::string_view const chars) {
+		for (char const c : chars) {
+			auto const byte = static_cast<unsigned char>(c);
+			bits_[byte / 64] |= std::uint64_t(1) << (byte % 64);
+		}
+	}
+
+	constexpr bool contains(char const c) const {
+		auto const byte = static_cast<unsigned char>(c);
+		return (bits_[byte / 64] >> (byte % 64)) & 1;
+	}
+
+	constexpr bool is_ascii() const {
+		return bits_[2] == 0 and bits_[3] == 0;
+	}
+
+	// Entry n has bit h set if the set contains the character h * 16 + n.
+	// This only describes ASCII characters.
+	constexpr std::array<unsigned char, 16> nibble_table() const {
+		auto result = std::array<unsigned char, 16>();
+		for (unsigned byte = 0; byte != 128; ++byte) {
+			if (contains(static_cast<char>(byte))) {
+				result[byte % 16] |= static_cast<unsigned char>(1U << (byte / 16));
+			}
+		}
+		return result;
+	}
+
+private:
+	std::array<std::uint64_t, 4> bits_ = {};
+};
+
+constexpr std::size_t scalar_find_first_of(char const * const data, std::size_t const size, byte_set const & set) {
+	for (std::size_t n = 0; n != size; ++n) {
+		if (set.contains(data[n])) {
+			return n;
+		}
+	}
+	return npos;
+}
+
+// Searching the small buffer can always load the whole buffer, even past the
+// size, because it is inside the string object. The buffer needs one 16 byte
+// load, or two overlapping loads when it is between 16 and 32 bytes. The
+// result has bit n set if data[n] matches, for n < size.
+template<std::size_t capacity>
+struct small_search {
+	static_assert(capacity <= 32);
+
+	static constexpr std::uint32_t low_bits(std::size_t const count) {
+		return count == 32 ? ~std::uint32_t(0) : (std::uint32_t(1) << count) - 1;
+	}
+
+	static constexpr std::uint32_t scalar_byte_mask(char const * const buffer, std::size_t const size, char const c) {
+		auto result = std::uint32_t(0);
+		for (std::size_t n = 0; n != size; ++n) {
+			result |= std::uint32_t(buffer[n] == c) << n;
+		}
+		return result;
+	}
+	static constexpr std::uint32_t scalar_set_mask(char const * const buffer, std::size_t const size, byte_set const & set) {
+		auto result = std::uint32_t(0);
+		for (std::size_t n = 0; n != size; ++n) {
+			result |= std::uint32_t(set.contains(buffer[n])) << n;
+		}
+		return result;
+	}
+
+	static std::uint32_t byte_mask(char const * buffer, std::size_t size, char c);
+	static std::uint32_t set_mask(char const * buffer, std::size_t size, byte_set const & set);
+};
+
+#if defined(__x86_64__)
+
+inline bool const has_avx2 = __builtin_cpu_supports("avx2");
+inline bool const has_ssse3 = __builtin_cpu_supports("ssse3");
+
+inline __m128i load16(char const * const data) {
+	return _mm_loadu_si128(reinterpret_cast<__m128i const *>(data));
+}
+[[gnu::target("avx2")]] inline __m256i load32(char const * const data) {
+	return _mm256_loadu_si256(reinterpret_cast<__m256i const *>(data));
+}
+
+inline std::uint32_t equal_mask(__m128i const block, __m128i const target) {
+	return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, target)));
+}
+[[gnu::target("avx2")]] inline std::uint32_t equal_mask(__m256i const block, __m256i const target) {
+	return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, target)));
+}
+
+// Looks up each byte's high nibble in the row of the table for its low nibble.
+// Bytes outside of ASCII have a high nibble of at least 8, which selects 0.
+[[gnu::target("ssse3")]] inline std::uint32_t set_mask(__m128i const block, __m128i const table) {
+	auto const bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+	auto const low_nibbles = _mm_set1_epi8(0x0F);
+	auto const row = _mm_shuffle_epi8(table, _mm_and_si128(block, low_nibbles));
+	auto const bit = _mm_shuffle_epi8(bits, _mm_and_si128(_mm_srli_epi16(block, 4), low_nibbles));
+	auto const misses = _mm_cmpeq_epi8(_mm_and_si128(row, bit), _mm_setzero_si128());
+	return ~static_cast<std::uint32_t>(_mm_movemask_epi8(misses)) & 0xFFFF;
+}
+[[gnu::target("avx2")]] inline std::uint32_t set_mask(__m256i const block, __m256i const table) {
+	auto const bits = _mm256_setr_epi8(
+		1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0,
+		1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0
+	);
+	auto const low_nibbles = _mm256_set1_epi8(0x0F);
+	auto const row = _mm256_shuffle_epi8(table, _mm256_and_si256(block, low_nibbles));
+	auto const bit = _mm256_shuffle_epi8(bits, _mm256_and_si256(_mm256_srli_epi16(block, 4), low_nibbles));
+	auto const misses = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), _mm256_setzero_si256());
+	return ~static_cast<std::uint32_t>(_mm256_movemask_epi8(misses));
+}
+
+inline __m128i load_table(byte_set const & set) {
+	auto const table = set.nibble_table();
+	return _mm_loadu_si128(reinterpret_cast<__m128i const *>(table.data()));
+}
+
+// Inputs shorter than one vector are handled by the narrower version. The
+// last partial vector is handled by loading the final full vector of the
+// input, which overlaps bytes that are already known not to match, so
+// nothing is read past the end.
+
+inline std::size_t sse2_find_byte(char const * const data, std::size_t const size, char const c) {
+	if (size < 16) {
+		return scalar_find_byte(data, size, c);
+	}
+	auto const target = _mm_set1_epi8(c);
+	for (std::size_t n = 0; n + 16 <= size; n += 16) {
+		if (auto const mask = equal_mask(load16(data + n), target)) {
+			return n + static_cast<std::size_t>(std::countr_zero(mask));
+		}
+	}
+	auto const last = size - 16;
+	auto const mask = equal_mask(load16(data + last), target);
+	return mask == 0 ? npos : last + static_cast<std::size_t>(std::countr_zero(mask));
+}
+
+[[gnu::target("avx2")]] inline std::size_t avx2_find_byte(char const * const data, std::size_t const size, char const c) {
+	if (size < 32) {
+		return sse2_find_byte(data, size, c);
+	}
+	auto const target = _mm256_set1_epi8(c);
+	for (std::size_t n = 0; n + 32 <= size; n += 32) {
+		if (auto const mask = equal_mask(load32(data + n), target)) {
+			return n + static_cast<std::size_t>(std::countr_zero(mask));
+		}
+	}
+	auto const last = size - 32;
+	auto const mask = equal_mask(load32(data + last), target);
+	return mask == 0 ? npos : last + static_cast<std::size_t>(std::countr_zero(mask));
+}
+
+inline std::size_t sse2_rfind_byte(char const * const data, std::size_t const size, char const c) {
+	if (size < 16) {
+		return scalar_rfind_byte(data, size, c);
+	}
+	auto const target = _mm_set1_epi8(c);
+	for (auto n = size; n >= 16; n -= 16) {
+		if (auto const mask = equal_mask(load16(data + n - 16), target)) {
+			return n - 16 + static_cast<std::size_t>(std::bit_width(mask)) - 1;
+		}
+	}
+	auto const mask = equal_mask(load16(data), target);
+	return mask == 0 ? npos : static_cast<std::size_t>(std::bit_width(mask)) - 1;
+}
+
+[[gnu::target("avx2")]] inline std::size_t avx2_rfind_byte(char const * const data, std::size_t const size, char const c) {
+	if (size < 32) {
+		return sse2_rfind_byte(data, size, c);
+	}
+	auto const target = _mm256_set1_epi8(c);
+	for (auto n = size; n >= 32; n -= 32) {
+		if (auto const mask = equal_mask(load32(data + n - 32), target)) {
+			return n - 32 + static_cast<std::size_t>(std::bit_width(mask)) - 1;
+		}
+	}
+	auto const mask = equal_mask(load32(data), target);
+	return mask == 0 ? npos : static_cast<std::size_t>(std::bit_width(mask)) - 1;
+}
+
+// Finds the candidate positions where both the first and last characters of
+// the needle match, and compares only the middle of those. This rejects
+// almost every position in one vector comparison, unlike checking the first
+// character alone. Requires needle_size >= 2 and needle_size <= size.
+inline std::size_t sse2_find(char const * const data, std::size_t const size, char const * const needle, std::size_t const needle_size) {
+	auto const positions = size - needle_size + 1;
+	auto const first = _mm_set1_epi8(needle[0]);
+	auto const last = _mm_set1_epi8(needle[needle_size - 1]);
+	auto n = std::size_t(0);
+	for (; n + 16 <= positions; n += 16) {
+		auto mask = equal_mask(load16(data + n), first) & equal_mask(load16(data + n + needle_size - 1), last);
+		for (; mask != 0; mask &= mask - 1) {
+			auto const position = n + static_cast<std::size_t>(std::countr_zero(mask));
+			if (equal(data + position + 1, needle + 1, needle_size - 2)) {
+				return position;
+			}
+		}
+	}
+	auto const remaining = scalar_find(data + n, size - n, needle, needle_size);
+	return remaining == npos ? npos : n + remaining;
+}
+
+[[gnu::target("avx2")]] inline std::size_t avx2_find(char const * const data, std::size_t const size, char const * const needle, std::size_t const needle_size) {
+	auto const positions = size - needle_size + 1;
+	auto const first = _mm256_set1_epi8(needle[0]);
+	auto const last = _mm256_set1_epi8(needle[needle_size - 1]);
+	auto n = std::size_t(0);
+	for (; n + 32 <= positions; n += 32) {
+		auto mask = equal_mask(load32(data + n), first) & equal_mask(load32(data + n + needle_size - 1), last);
+		for (; mask != 0; mask &= mask - 1) {
+			auto const position = n + static_cast<std::size_t>(std::countr_zero(mask));
+			if (equal(data + position + 1, needle + 1, needle_size - 2)) {
+				return position;
+			}
+		}
+	}
+	auto const remaining = sse2_find(data + n, size - n, needle, needle_size);
+	return remaining == npos ? npos : n + remaining;
+}
+
+// Requires set.is_ascii()
+[[gnu::target("ssse3")]] inline std::size_t ssse3_find_first_of(char const * const data, std::size_t const size, byte_set const & set) {
+	if (size < 16) {
+		return scalar_find_first_of(data, size, set);
+	}
+	auto const table = load_table(set);
+	for (std::size_t n = 0; n + 16 <= size; n += 16) {
+		if (auto const mask = set_mask(load16(data + n), table)) {
+			return n + static_cast<std::size_t>(std::countr_zero(mask));
+		}
+	}
+	auto const last = size - 16;
+	auto const mask = set_mask(load16(data + last), table);
+	return mask == 0 ? npos : last + static_cast<std::size_t>(std::countr_zero(mask));
+}
+
+// Requires set.is_ascii()
+[[gnu::target("avx2")]] inline std::size_t avx2_find_first_of(char const * const data, std::size_t const size, byte_set const & set) {
+	if (size < 32) {
+		return ssse3_find_first_of(data, size, set);
+	}
+	auto const table = _mm256_broadcastsi128_si256(load_table(set));
+	for (std::size_t n = 0; n + 32 <= size; n += 32) {
+		if (auto const mask = set_mask(load32(data + n), table)) {
+			return n + static_cast<std::size_t>(std::countr_zero(mask));
+		}
+	}
+	auto const last = size - 32;
+	auto const mask = set_mask(load32(data + last), table);
+	return mask == 0 ? npos : last + static_cast<std::size_t>(std::countr_zero(mask));
+}
+
+inline std::size_t find_byte(char const * const data, std::size_t const size, char const c) {
+	return has_avx2 ? avx2_find_byte(data, size, c) : sse2_find_byte(data, size, c);
+}
+inline std::size_t rfind_byte(char const * const data, std::size_t const size, char const c) {
+	return has_avx2 ? avx2_rfind_byte(data, size, c) : sse2_rfind_byte(data, size, c);
+}
+inline std::size_t find_substring(char const * const data, std::size_t const size, char const * const needle, std::size_t const needle_size) {
+	return has_avx2 ? avx2_find(data, size, needle, needle_size) : sse2_find(data, size, needle, needle_size);
+}
+inline std::size_t find_first_of(char const * const data, std::size_t const size, byte_set const & set) {
+	if (!set.is_ascii() or !has_ssse3) {
+		return scalar_find_first_of(data, size, set);
+	}
+	return has_avx2 ? avx2_find_first_of(data, size, set) : ssse3_find_first_of(data, size, set);
+}
+
+template<std::size_t capacity>
+std::uint32_t small_search<capacity>::byte_mask(char const * const buffer, std::size_t const size, char const c) {
+	auto const target = _mm_set1_epi8(c);
+	auto mask = equal_mask(load16(buffer), target);
+	if constexpr (capacity > 16) {
+		if (size > 16) {
+			mask |= equal_mask(load16(buffer + capacity - 16), target) << (capacity - 16);
+		}
+	}
+	return mask & low_bits(size);
+}
+
+template<std::size_t capacity>
+std::uint32_t small_search<capacity>::set_mask(char const * const buffer, std::size_t const size, byte_set const & set) {
+	if (!set.is_ascii() or !has_ssse3) {
+		return scalar_set_mask(buffer, size, set);
+	}
+	auto const table = load_table(set);
+	auto mask = ::set_mask(load16(buffer), table);
+	if constexpr (capacity > 16) {
+		if (size > 16) {
+			mask |= ::set_mask(load16(buffer + capacity - 16), table) << (capacity - 16);
+		}
+	}
+	return mask & low_bits(size);
+}
+
+#else
+
+inline std::size_t find_byte(char const * const data, std::size_t const size, char const c) {
+	return scalar_find_byte(data, size, c);
+}
+inline std::size_t rfind_byte(char const * const data, std::size_t const size, char const c) {
+	return scalar_rfind_byte(data, size, c);
+}
+inline std::size_t find_substring(char const * const data, std::size_t const size, char const * const needle, std::size_t const needle_size) {
+	return scalar_find(data, size, needle, needle_size);
+}
+inline std::size_t find_first_of(char const * const data, std::size_t const size, byte_set const & set) {
+	return scalar_find_first_of(data, size, set);
+}
+
+template<std::size_t capacity>
+std::uint32_t small_search<capacity>::byte_mask(char const * const buffer, std::size_t const size, char const c) {
+	return scalar_byte_mask(buffer, size, c);
+}
+template<std::size_t capacity>
+std::uint32_t small_search<capacity>::set_mask(char const * const buffer, std::size_t const size, byte_set const & set) {
+	return scalar_set_mask(buffer, size, set);
+}
+
+#endif
+
+// These are shared by both layouts. small_buffer is null when the string is
+// large or during constant evaluation.
+
+constexpr std::size_t add_offset(std::size_t const result, std::size_t const offset) {
+	return result == npos ? npos : result + offset;
+}
+
+template<std::size_t capacity>
+constexpr std::size_t string_find(char const * const data, char const * const small_buffer, std::size_t const size, char const c, std::size_t const pos) {
+	if (pos >= size) {
+		return npos;
+	}
+	if (std::is_constant_evaluated()) {
+		return add_offset(scalar_find_byte(data + pos, size - pos, c), pos);
+	}
+	if (small_buffer) {
+		auto const mask = small_search<capacity>::byte_mask(small_buffer, size, c) & ~small_search<capacity>::low_bits(pos);
+		return mask == 0 ? npos : static_cast<std::size_t>(std::countr_zero(mask));
+	}
+	return add_offset(find_byte(data + pos, size - pos, c), pos);
+}
+
+template<std::size_t capacity>
+constexpr std::size_t string_rfind(char const * const data, char const * const small_buffer, std::size_t const size, char const c, std::size_t const pos) {
+	if (size == 0) {
+		return npos;
+	}
+	auto const searched = std::min(pos, size - 1) + 1;
+	if (std::is_constant_evaluated()) {
+		return scalar_rfind_byte(data, searched, c);
+	}
+	if (small_buffer) {
+		auto const mask = small_search<capacity>::byte_mask(small_buffer, searched, c);
+		return mask == 0 ? npos : static_cast<std::size_t>(std::bit_width(mask)) - 1;
+	}
+	return rfind_byte(data, searched, c);
+}
+
+template<std::size_t capacity>
+constexpr std::size_t string_find(char const * const data, char const * const small_buffer, std::size_t const size, std::string_view const needle, std::size_t const pos) {
+	if (needle.size() == 1) {
+		return string_find<capacity>(data, small_buffer, size, needle.front(), pos);
+	}
+	if (pos > size or needle.size() > size - pos) {
+		return npos;
+	}
+	if (needle.empty()) {
+		return pos;
+	}
+	if (std::is_constant_evaluated()) {
+		return add_offset(scalar_find(data + pos, size - pos, needle.data(), needle.size()), pos);
+	}
+	if (small_buffer) {
+		using search = small_search<capacity>;
+		auto const last_start = size - needle.size();
+		auto mask =
+			search::byte_mask(small_buffer, size, needle.front()) &
+			(search::byte_mask(small_buffer, size, needle.back()) >> (needle.size() - 1)) &
+			search::low_bits(last_start + 1) &
+			~search::low_bits(pos);
+		for (; mask != 0; mask &= mask - 1) {
+			auto const position = static_cast<std::size_t>(std::countr_zero(mask));
+			if (equal(small_buffer + position + 1, needle.data() + 1, needle.size() - 2)) {
+				return position;
+			}
+		}
+		return npos;
+	}
+	return add_offset(find_substring(data + pos, size - pos, needle.data(), needle.size()), pos);
+}
+
+// Looks for the last occurrence of the first character of the needle, then
+// compares the rest, and repeats from just before that occurrence.
+template<std::size_t capacity>
+constexpr std::size_t string_rfind(char const * const data, char const * const small_buffer, std::size_t const size, std::string_view const needle, std::size_t const pos) {
+	if (needle.size() > size) {
+		return npos;
+	}
+	auto last_start = std::min(pos, size - needle.size());
+	if (needle.empty()) {
+		return last_start;
+	}
+	while (true) {
+		auto const found = string_rfind<capacity>(data, small_buffer, size, needle.front(), last_start);
+		if (found == npos) {
+			return npos;
+		}
+		if (equal(data + found + 1, needle.data() + 1, needle.size() - 1)) {
+			return found;
+		}
+		if (found == 0) {
+			return npos;
+		}
+		last_start = found - 1;
+	}
+}
+
+template<std::size_t capacity>
+constexpr std::size_t string_find_first_of(char const * const data, char const * const small_buffer, std::size_t const size, std::string_view const chars, std::size_t const pos) {
+	if (pos >= size) {
+		return npos;
+	}
+	if (chars.size() == 1) {
+		return string_find<capacity>(data, small_buffer, size, chars.front(), pos);
+	}
+	auto const set = byte_set(chars);
+	if (std::is_constant_evaluated()) {
+		return add_offset(scalar_find_first_of(data + pos, size - pos, set), pos);
+	}
+	if (small_buffer) {
+		auto const mask = small_search<capacity>::set_mask(small_buffer, size, set) & ~small_search<capacity>::low_bits(pos);
+		return mask == 0 ? npos : static_cast<std::size_t>(std::countr_zero(mask));
+	}
+	return add_offset(find_first_of(data + pos, size - pos, set), pos);
+}
+
+
+namespace clang {
+
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = allocator<char>;
+
+private:
+	static constexpr std::size_t small_buffer_capacity = 23;
+
+	struct small_t {
+		char data[small_buffer_capacity] = {};
+	};
+	struct [[gnu::packed]] large_t {
+		static constexpr std::size_t bytes_remaining = 7;
+
+		template<typename It>
+		class range_view {
+		public:
+			constexpr range_view(It first, It last):
+				first_(first),
+				last_(last)
+			{
+			}
+			constexpr auto begin() const {
+				return first_;
+			}
+			constexpr auto end() const {
+				return last_;
+			}
+		private:
+			It first_;
+			It last_;
+		};
+
+		constexpr auto little_endian_capacity() const {
+			return range_view(
+				std::rbegin(rest_of_capacity),
+				std::rend(rest_of_capacity)
+			);
+		}
+		constexpr auto big_endian_capacity() {
+			return range_view(
+				std::begin(rest_of_capacity),
+				std::end(rest_of_capacity)
+			);
+		}
+
+		constexpr large_t(std::size_t set_size, std::size_t capacity, char * pointer) noexcept:
+			rest_of_capacity{},
+			size(set_size),
+			data(pointer)
+		{
+			assert(data != nullptr);
+			for (unsigned char & byte : big_endian_capacity()) {
+				capacity >>= CHAR_BIT;
+				byte = capacity;
+			}
+		}
+
+		unsigned char rest_of_capacity[bytes_remaining];
+		std::size_t size;
+		char * data;
+	};
+
+	[[no_unique_address]] allocator_type allocator_;
+	unsigned char size_or_first_byte_of_capacity_;
+	union U {
+		constexpr U() noexcept:
+			small{}
+		{
+		}
+		explicit constexpr U(std::size_t size, std::size_t capacity, char * data) noexcept:
+			large(size, capacity, data)
+		{
+		}
+		constexpr U(large_t set_large) noexcept:
+			large(set_large)
+		{
+		}
+
+		small_t small;
+		large_t large;
+	} u_;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return size_or_first_byte_of_capacity_ & 1;
+	}
+
+	constexpr void increment_size() {
+		if (is_large()) {
+			++u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ += (1 << 1);
+		}
+	}
+	constexpr void decrement_size() {
+		if (is_large()) {
+			--u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ -= (1 << 1);
+		}
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, u_.large.data, capacity());
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(size(), new_capacity, new_data);
+		assert(new_capacity & 1);
+		size_or_first_byte_of_capacity_ = new_capacity;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		new_capacity |= 1;
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy(begin(), end(), temp);
+		relocate(temp, new_capacity);
+	}
+
+	// Null if the characters are not in the small buffer
+	constexpr char const * small_buffer() const {
+		return std::is_constant_evaluated() or is_large() ? nullptr : u_.small.data;
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		size_or_first_byte_of_capacity_(0),
+		u_{}
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.large);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+
+			other.u_ = U{};
+			other.size_or_first_byte_of_capacity_ = 0;
+		} else {
+			auto & osmall = other.u_.small;
+			u_ = U{};
+			copy(osmall.data, osmall.data + (other.size_or_first_byte_of_capacity_ >> 1), u_.small.data);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr char * data() {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr std::size_t size() const {
+		return is_large() ? u_.large.size : (size_or_first_byte_of_capacity_ >> 1);
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		if (!is_large()) {
+			return small_buffer_capacity;
+		}
+		std::size_t result = 0;
+		for (unsigned char const byte : u_.large.little_endian_capacity()) {
+			result |= byte;
+			result <<= CHAR_BIT;
+		}
+		result |= size_or_first_byte_of_capacity_;
+		return result;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		auto const local_size = size();
+		if (is_large() && capacity() > (local_size | 1)) {
+			if (local_size > small_buffer_capacity) {
+				force_reserve(local_size);
+			} else {
+				auto const data = u_.large.data;
+				auto const original_capacity = capacity();
+				u_ = U{};
+				size_or_first_byte_of_capacity_ = local_size << 1;
+				copy(data, data + local_size, u_.small.data);
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	static constexpr std::size_t npos = ::npos;
+
+	constexpr std::size_t find(char const c, std::size_t const pos = 0) const {
+		return string_find<small_buffer_capacity>(data(), small_buffer(), size(), c, pos);
+	}
+	constexpr std::size_t find(std::string_view const needle, std::size_t const pos = 0) const {
+		return string_find<small_buffer_capacity>(data(), small_buffer(), size(), needle, pos);
+	}
+	constexpr std::size_t rfind(char const c, std::size_t const pos = npos) const {
+		return string_rfind<small_buffer_capacity>(data(), small_buffer(), size(), c, pos);
+	}
+	constexpr std::size_t rfind(std::string_view const needle, std::size_t const pos = npos) const {
+		return string_rfind<small_buffer_capacity>(data(), small_buffer(), size(), needle, pos);
+	}
+	constexpr std::size_t find_first_of(std::string_view const chars, std::size_t const pos = 0) const {
+		return string_find_first_of<small_buffer_capacity>(data(), small_buffer(), size(), chars, pos);
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = std::prev(end());
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = (capacity() * growth_factor) | 1;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+
+			relocate(temp, new_capacity);
+		}
+		increment_size();
+		return begin() + offset;
+	}
+
+	constexpr void pop_back() {
+		decrement_size();
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace clang
+
+namespace gcc {
+
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = allocator<char>;
+
+private:
+	[[no_unique_address]] allocator_type allocator_;
+	// This could be set to 8 to reduce the size of our string to 24 bytes
+	// (just like clang), but 7 characters (plus a null terminator) is likely
+	// too small of a buffer for most users.
+	static constexpr std::size_t small_buffer_capacity = 16;
+	union U{
+		constexpr U():
+			buffer{}
+		{
+		}
+		constexpr U(std::size_t c):
+			capacity(c)
+		{
+		}
+
+		char buffer[small_buffer_capacity];
+		std::size_t capacity;
+	} u_;
+	char * data_;
+	std::size_t size_ : 63;
+	// gcc and MSVC do not allow accessing the inactive member of a union just
+	// to get its address, so we use a bitfield to work around this.
+	bool is_large_ : 1;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return is_large_;
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, data_, u_.capacity);
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(new_capacity);
+		data_ = new_data;
+		is_large_ = true;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy(begin(), end(), temp);
+		relocate(temp, new_capacity);
+	}
+
+	// Null if the characters are not in the small buffer
+	constexpr char const * small_buffer() const {
+		return std::is_constant_evaluated() or is_large() ? nullptr : u_.buffer;
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_{},
+		data_(u_.buffer),
+		size_(0),
+		is_large_(false)
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.capacity);
+			other.u_ = U{};
+		
+			data_ = other.data_;
+			other.data_ = other.u_.buffer;
+		
+			size_ = other.size_;
+			other.size_ = 0U;
+		
+			is_large_ = true;
+			other.is_large_ = false;
+
+		} else {
+			u_ = U{};
+			copy(other.data_, other.data_ + other.size_, u_.buffer);
+			data_ = u_.buffer;
+			size_ = other.size_;
+			is_large_ = false;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return data_;
+	}
+	constexpr char * data() {
+		return data_;
+	}
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		return is_large() ? u_.capacity : small_buffer_capacity;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		if (is_large() && capacity() > size()) {
+			if (size() > small_buffer_capacity) {
+				force_reserve(size());
+			} else {
+				auto const data = data_;
+				auto const original_capacity = u_.capacity;
+				u_ = U{};
+				copy(data, data + size_, u_.buffer);
+				data_ = u_.buffer;
+				is_large_ = false;
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	static constexpr std::size_t npos = ::npos;
+
+	constexpr std::size_t find(char const c, std::size_t const pos = 0) const {
+		return string_find<small_buffer_capacity>(data(), small_buffer(), size(), c, pos);
+	}
+	constexpr std::size_t find(std::string_view const needle, std::size_t const pos = 0) const {
+		return string_find<small_buffer_capacity>(data(), small_buffer(), size(), needle, pos);
+	}
+	constexpr std::size_t rfind(char const c, std::size_t const pos = npos) const {
+		return string_rfind<small_buffer_capacity>(data(), small_buffer(), size(), c, pos);
+	}
+	constexpr std::size_t rfind(std::string_view const needle, std::size_t const pos = npos) const {
+		return string_rfind<small_buffer_capacity>(data(), small_buffer(), size(), needle, pos);
+	}
+	constexpr std::size_t find_first_of(std::string_view const chars, std::size_t const pos = 0) const {
+		return string_find_first_of<small_buffer_capacity>(data(), small_buffer(), size(), chars, pos);
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = end() - 1;
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = capacity() * growth_factor;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+		
+			relocate(temp, new_capacity);
+		}
+		++size_;
+		return begin() + offset;
+	}
+
+	constexpr void pop_back() {
+		--size_;
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace gcc
+
+template<typename String>
+constexpr String make_string(allocator<char> alloc, std::string_view const source) {
+	auto result = String(alloc);
+	for (char const c : source) {
+		result.insert(result.end(), c);
+	}
+	return result;
+}
+
+constexpr void test_individual(auto & str, char const * source) {
+	using String = std::remove_reference_t<decltype(str)>;
+	String temp(str.get_allocator());
+	for (auto it = source; *it != '\0'; ++it) {
+		str.insert(str.end(), *it);
+		temp.insert(temp.end(), *it);
+	}
+
+	temp.insert(temp.begin(), 'a');
+	temp.insert(temp.begin() + temp.size() / 2, 'b');
+	auto const size = std::char_traits<char>::length(source);
+	auto const middle = (size + 1) / 2;
+	assert(temp.size() == size + 2);
+	for (std::size_t n = 0; n != temp.size(); ++n) {
+		auto const expected = n == 0 ? 'a' : n == middle ? 'b' : n < middle ? source[n - 1] : source[n - 2];
+		assert(temp.data()[n] == expected);
+	}
+
+	// Inserting at the front, including each time that reallocates
+	String front(str.get_allocator());
+	for (std::size_t n = 0; n != 100; ++n) {
+		front.insert(front.begin(), static_cast<char>('0' + n % 10));
+	}
+	for (std::size_t n = 0; n != front.size(); ++n) {
+		assert(front.data()[n] == static_cast<char>('0' + (99 - n) % 10));
+	}
+
+	while (temp.size() != 0) {
+		temp.pop_back();
+	}
+	assert(temp.size() == 0);
+
+	auto temp2 = std::move(str);
+	str = std::move(temp2);
+
+	assert(str.data() != temp.data());
+	assert(str.size() == std::char_traits<char>::length(source));
+	assert(std::char_traits<char>::compare(str.data(), source, str.size()) == 0);
+	assert(str.capacity() >= str.size());
+
+	str.reserve(50);
+	str.shrink_to_fit();
+}
+
+template<typename String>
+constexpr void test_search(allocator<char> alloc) {
+	auto const small = make_string<String>(alloc, "key=value; key");
+	assert(small.find('=') == 3);
+	assert(small.find('k', 1) == 11);
+	assert(small.find('z') == String::npos);
+	assert(small.find("key") == 0);
+	assert(small.find("key", 1) == 11);
+	assert(small.find("") == 0);
+	assert(small.find("keys") == String::npos);
+	assert(small.rfind('e') == 12);
+	assert(small.rfind('e', 11) == 8);
+	assert(small.rfind("key") == 11);
+	assert(small.rfind("key", 10) == 0);
+	assert(small.find_first_of(";=") == 3);
+	assert(small.find_first_of(";=", 4) == 9);
+	assert(small.find_first_of("xz!") == String::npos);
+
+	auto const large = make_string<String>(alloc, "GET /index.html HTTP/1.1 Host: example.com Accept: */*");
+	assert(large.find(':') == 29);
+	assert(large.find("HTTP") == 16);
+	assert(large.find("example.com") == 31);
+	assert(large.rfind(':') == 49);
+	assert(large.rfind("com") == 39);
+	assert(large.find_first_of("*:") == 29);
+	assert(large.find_first_of("*", 50) == 51);
+}
+
+template<typename String>
+constexpr void test_layout() {
+	buffer<char> buff{};
+	auto alloc = allocator(buff);
+
+	char const * short_source = "0123";
+	char const * long_source =
+		"0123456789"
+		"0123456789"
+		"0123456789"
+		"0123456789"
+		"0123456789";
+
+	String short_str(alloc);
+	test_individual(short_str, short_source);
+
+	String long_str(alloc);
+	test_individual(long_str, long_source);
+
+	String temp(alloc);
+	temp = std::move(long_str);
+	temp = std::move(short_str);
+
+	test_search<String>(alloc);
+}
+
+constexpr bool test() {
+	test_layout<clang::string>();
+	test_layout<gcc::string>();
+	return true;
+}
+
+// Compares every search against std::string_view at every position, for
+// sizes on both sides of the small buffer and vector widths. The alphabet is
+// small so that partial matches are common.
+template<typename String>
+void test_against_string_view() {
+	auto engine = std::minstd_rand(1);
+	auto random_string = [&](std::size_t const size) {
+		auto result = std::string(size, ' ');
+		for (char & c : result) {
+			c = static_cast<char>('a' + std::uniform_int_distribution(0, 3)(engine));
+		}
+		return result;
+	};
+	for (std::size_t size = 0; size != 100; ++size) {
+		auto buff = std::make_unique<buffer<char>>();
+		auto const source = random_string(size);
+		auto const expected = std::string_view(source);
+		auto const str = make_string<String>(allocator(*buff), source);
+		for (auto const needle_size : {1, 2, 3, 5, 17, 40}) {
+			auto const needle = random_string(static_cast<std::size_t>(needle_size));
+			for (std::size_t pos = 0; pos <= size + 1; ++pos) {
+				assert(str.find(needle[0], pos) == expected.find(needle[0], pos));
+				assert(str.rfind(needle[0], pos) == expected.rfind(needle[0], pos));
+				assert(str.find(needle, pos) == expected.find(needle, pos));
+				assert(str.rfind(needle, pos) == expected.rfind(needle, pos));
+				assert(str.find_first_of(needle, pos) == expected.find_first_of(needle, pos));
+			}
+			auto const occurring = source.substr(size / 3, static_cast<std::size_t>(needle_size));
+			assert(str.find(occurring) == expected.find(occurring));
+			assert(str.rfind(occurring) == expected.rfind(occurring));
+		}
+		auto const non_ascii = std::string("\xff" "c");
+		assert(str.find_first_of(non_ascii) == expected.find_first_of(non_ascii));
+	}
+}
+
+int main() {
+	test();
+	static_assert(test());
+	test_against_string_view<clang::string>();
+	test_against_string_view<gcc::string>();
+}
@@ -0,0 +1,1192 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is to split a string
+// into fields and join fields back into a string without allocating for each
+// field.
+//
+// split(text, delimiter) is a lazy range of std::string_view that refer to
+// text, so splitting allocates nothing. It finds the delimiters with the same
+// vector comparison that search.cpp uses to find a single character, on 64
+// bytes at a time. join adds up the exact size of the result before it
+// writes anything, and then append_and_overwrite from append-number.cpp
+// grows the target at most once. In constant evaluation both of them work
+// one character at a time.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <random>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+// char is trivial, so outside of constant evaluation the characters can be
+// copied with memcpy instead of being constructed one at a time
+template<typename Allocator>
+constexpr char * copy_characters(Allocator alloc, char const * const first, char const * const last, char * const out) {
+	if (std::is_constant_evaluated()) {
+		return uninitialized_copy(alloc, first, last, out);
+	}
+	auto const count = static_cast<std::size_t>(last - first);
+	if (count != 0) {
+		std::memcpy(out, first, count);
+	}
+	return out + count;
+}
+
+
+namespace clang {
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	static constexpr std::size_t small_buffer_capacity = 23;
+
+	struct small_t {
+		char data[small_buffer_capacity] = {};
+	};
+	struct [[gnu::packed]] large_t {
+		static constexpr std::size_t bytes_remaining = 7;
+
+		template<typename It>
+		class range_view {
+		public:
+			constexpr range_view(It first, It last):
+				first_(first),
+				last_(last)
+			{
+			}
+			constexpr auto begin() const {
+				return first_;
+			}
+			constexpr auto end() const {
+				return last_;
+			}
+		private:
+			It first_;
+			It last_;
+		};
+
+		constexpr auto little_endian_capacity() const {
+			return range_view(
+				std::rbegin(rest_of_capacity),
+				std::rend(rest_of_capacity)
+			);
+		}
+		constexpr auto big_endian_capacity() {
+			return range_view(
+				std::begin(rest_of_capacity),
+				std::end(rest_of_capacity)
+			);
+		}
+
+		constexpr large_t(std::size_t set_size, std::size_t capacity, char * pointer) noexcept:
+			rest_of_capacity{},
+			size(set_size),
+			data(pointer)
+		{
+			assert(data != nullptr);
+			for (unsigned char & byte : big_endian_capacity()) {
+				capacity >>= CHAR_BIT;
+				byte = capacity;
+			}
+		}
+
+		unsigned char rest_of_capacity[bytes_remaining];
+		std::size_t size;
+		char * data;
+	};
+
+	[[no_unique_address]] allocator_type allocator_;
+	unsigned char size_or_first_byte_of_capacity_;
+	union U {
+		constexpr U() noexcept:
+			small{}
+		{
+		}
+		explicit constexpr U(std::size_t size, std::size_t capacity, char * data) noexcept:
+			large(size, capacity, data)
+		{
+		}
+		constexpr U(large_t set_large) noexcept:
+			large(set_large)
+		{
+		}
+
+		small_t small;
+		large_t large;
+	} u_;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return size_or_first_byte_of_capacity_ & 1;
+	}
+
+	constexpr void increment_size() {
+		if (is_large()) {
+			++u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ += (1 << 1);
+		}
+	}
+	constexpr void set_size(std::size_t const new_size) {
+		if (is_large()) {
+			u_.large.size = new_size;
+		} else {
+			size_or_first_byte_of_capacity_ = static_cast<unsigned char>(new_size << 1);
+		}
+	}
+	constexpr void decrement_size() {
+		if (is_large()) {
+			--u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ -= (1 << 1);
+		}
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, u_.large.data, capacity());
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(size(), new_capacity, new_data);
+		assert(new_capacity & 1);
+		size_or_first_byte_of_capacity_ = new_capacity;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		new_capacity |= 1;
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy_characters(alloc, data(), data() + size(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		size_or_first_byte_of_capacity_(0),
+		u_{}
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.large);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+
+			other.u_ = U{};
+			other.size_or_first_byte_of_capacity_ = 0;
+		} else {
+			auto & osmall = other.u_.small;
+			u_ = U{};
+			copy(osmall.data, osmall.data + (other.size_or_first_byte_of_capacity_ >> 1), u_.small.data);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr char * data() {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr std::size_t size() const {
+		return is_large() ? u_.large.size : (size_or_first_byte_of_capacity_ >> 1);
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		if (!is_large()) {
+			return small_buffer_capacity;
+		}
+		// The bytes after the first are the rest of the capacity in
+		// little-endian order, so on a little-endian target this is one load
+		// instead of a loop. append_and_overwrite checks the capacity for
+		// every number.
+		if (!std::is_constant_evaluated() and std::endian::native == std::endian::little) {
+			auto rest = std::size_t(0);
+			std::memcpy(&rest, u_.large.rest_of_capacity, large_t::bytes_remaining);
+			return (rest << CHAR_BIT) | size_or_first_byte_of_capacity_;
+		}
+		std::size_t result = 0;
+		for (unsigned char const byte : u_.large.little_endian_capacity()) {
+			result |= byte;
+			result <<= CHAR_BIT;
+		}
+		result |= size_or_first_byte_of_capacity_;
+		return result;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		auto const local_size = size();
+		if (is_large() && capacity() > (local_size | 1)) {
+			if (local_size > small_buffer_capacity) {
+				force_reserve(local_size);
+			} else {
+				auto const data = u_.large.data;
+				auto const original_capacity = capacity();
+				u_ = U{};
+				size_or_first_byte_of_capacity_ = local_size << 1;
+				copy(data, data + local_size, u_.small.data);
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = std::prev(end());
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = (capacity() * growth_factor) | 1;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+
+			relocate(temp, new_capacity);
+		}
+		increment_size();
+		return begin() + offset;
+	}
+
+	// Range append, which the proposal leaves out for brevity. A reallocation
+	// at least doubles the capacity, like insert, and copies the old
+	// characters and the new ones straight into place. That also makes it
+	// safe to append part of the string to itself.
+	constexpr void append(char const * const first, char const * const last) {
+		auto const new_size = size() + static_cast<std::size_t>(last - first);
+		auto alloc = get_allocator();
+		if (new_size <= capacity()) {
+			copy_characters(alloc, first, last, end());
+		} else {
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = std::max(new_size, capacity() * growth_factor) | 1;
+			char * temp = Alloc::allocate(alloc, new_capacity);
+			copy_characters(alloc, first, last, copy_characters(alloc, data(), data() + size(), temp));
+			relocate(temp, new_capacity);
+		}
+		set_size(new_size);
+	}
+
+	// Makes room for up to max_count more characters, then operation writes
+	// characters starting at the end and returns where it stopped. This is
+	// like resize_and_overwrite, except that it keeps what is already there.
+	template<typename Operation>
+	constexpr void append_and_overwrite(std::size_t const max_count, Operation operation) {
+		auto const required = size() + max_count;
+		if (required > capacity()) {
+			constexpr auto growth_factor = std::size_t{2};
+			force_reserve(std::max(required, capacity() * growth_factor));
+		}
+		char * const last = operation(end());
+		set_size(static_cast<std::size_t>(last - begin()));
+	}
+
+	constexpr void pop_back() {
+		decrement_size();
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace clang
+
+namespace gcc {
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	[[no_unique_address]] allocator_type allocator_;
+	// This could be set to 8 to reduce the size of our string to 24 bytes
+	// (just like clang), but 7 characters (plus a null terminator) is likely
+	// too small of a buffer for most users.
+	static constexpr std::size_t small_buffer_capacity = 16;
+	union U{
+		constexpr U():
+			buffer{}
+		{
+		}
+		constexpr U(std::size_t c):
+			capacity(c)
+		{
+		}
+
+		char buffer[small_buffer_capacity];
+		std::size_t capacity;
+	} u_;
+	char * data_;
+	std::size_t size_ : 63;
+	// gcc and MSVC do not allow accessing the inactive member of a union just
+	// to get its address, so we use a bitfield to work around this.
+	bool is_large_ : 1;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return is_large_;
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, data_, u_.capacity);
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(new_capacity);
+		data_ = new_data;
+		is_large_ = true;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy_characters(alloc, data(), data() + size(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_{},
+		data_(u_.buffer),
+		size_(0),
+		is_large_(false)
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.capacity);
+			other.u_ = U{};
+		
+			data_ = other.data_;
+			other.data_ = other.u_.buffer;
+		
+			size_ = other.size_;
+			other.size_ = 0U;
+		
+			is_large_ = true;
+			other.is_large_ = false;
+
+		} else {
+			u_ = U{};
+			copy(other.data_, other.data_ + other.size_, u_.buffer);
+			data_ = u_.buffer;
+			size_ = other.size_;
+			is_large_ = false;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return data_;
+	}
+	constexpr char * data() {
+		return data_;
+	}
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		return is_large() ? u_.capacity : small_buffer_capacity;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		if (is_large() && capacity() > size()) {
+			if (size() > small_buffer_capacity) {
+				force_reserve(size());
+			} else {
+				auto const data = data_;
+				auto const original_capacity = u_.capacity;
+				u_ = U{};
+				copy(data, data + size_, u_.buffer);
+				data_ = u_.buffer;
+				is_large_ = false;
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = end() - 1;
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = capacity() * growth_factor;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+		
+			relocate(temp, new_capacity);
+		}
+		++size_;
+		return begin() + offset;
+	}
+
+	// Range append, which the proposal leaves out for brevity. A reallocation
+	// at least doubles the capacity, like insert, and copies the old
+	// characters and the new ones straight into place. That also makes it
+	// safe to append part of the string to itself.
+	constexpr void append(char const * const first, char const * const last) {
+		auto const new_size = size() + static_cast<std::size_t>(last - first);
+		auto alloc = get_allocator();
+		if (new_size <= capacity()) {
+			copy_characters(alloc, first, last, end());
+		} else {
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = std::max(new_size, capacity() * growth_factor);
+			char * temp = Alloc::allocate(alloc, new_capacity);
+			copy_characters(alloc, first, last, copy_characters(alloc, data(), data() + size(), temp));
+			relocate(temp, new_capacity);
+		}
+		size_ = new_size;
+	}
+
+	// Makes room for up to max_count more characters, then operation writes
+	// characters starting at the end and returns where it stopped. This is
+	// like resize_and_overwrite, except that it keeps what is already there.
+	template<typename Operation>
+	constexpr void append_and_overwrite(std::size_t const max_count, Operation operation) {
+		auto const required = size() + max_count;
+		if (required > capacity()) {
+			constexpr auto growth_factor = std::size_t{2};
+			force_reserve(std::max(required, capacity() * growth_factor));
+		}
+		char * const last = operation(end());
+		size_ = static_cast<std::size_t>(last - begin());
+	}
+
+	constexpr void pop_back() {
+		--size_;
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace gcc
+
+template<typename T>
+constexpr bool is_prototype_string = false;
+template<typename Allocator>
+constexpr bool is_prototype_string<clang::string<Allocator>> = true;
+template<typename Allocator>
+constexpr bool is_prototype_string<gcc::string<Allocator>> = true;
+
+template<typename T>
+concept prototype_string = is_prototype_string<T>;
+
+// Either string, or anything that converts to std::string_view
+template<typename T>
+concept string_like = prototype_string<T> or std::convertible_to<T const &, std::string_view>;
+
+template<string_like T>
+constexpr std::string_view as_view(T const & value) {
+	if constexpr (prototype_string<T>) {
+		return std::string_view(value.data(), value.size());
+	} else {
+		return std::string_view(value);
+	}
+}
+
+// Bit n is set if data[n] == c, for the first min(size, 64) bytes. This is
+// the comparison that search.cpp uses to find a single character, done on up
+// to four 16 byte vectors. As in search.cpp, a last partial vector is handled
+// by loading the final full vector, which overlaps bytes that are already
+// compared, so nothing is read past the end. Only text shorter than one
+// vector is compared one byte at a time.
+constexpr std::uint64_t delimiter_mask(char const * const data, std::size_t const size, char const c) {
+#if defined(__x86_64__)
+	if (!std::is_constant_evaluated() and size >= 16) {
+		auto const target = _mm_set1_epi8(c);
+		auto const block_mask = [&](std::size_t const offset) {
+			auto const block = _mm_loadu_si128(reinterpret_cast<__m128i const *>(data + offset));
+			auto const matches = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, target)));
+			return std::uint64_t(matches) << offset;
+		};
+		auto const count = std::min(size, std::size_t(64));
+		auto mask = std::uint64_t(0);
+		for (std::size_t n = 0; n + 16 <= count; n += 16) {
+			mask |= block_mask(n);
+		}
+		if (count % 16 != 0) {
+			mask |= block_mask(count - 16);
+		}
+		return mask;
+	}
+#endif
+	auto mask = std::uint64_t(0);
+	for (std::size_t n = 0; n != std::min(size, std::size_t(64)); ++n) {
+		mask |= std::uint64_t(data[n] == c) << n;
+	}
+	return mask;
+}
+
+// The parts of a std::string_view between each delimiter, as views into it.
+// There is always one more part than there are delimiters, so an empty text
+// has one empty part. Nothing is allocated.
+//
+// The iterator finds the delimiters in one 64 byte chunk at a time and keeps
+// them as a bit mask, so that a line with many short fields costs one vector
+// comparison per 64 bytes instead of one search per field.
+class split_view {
+public:
+	class iterator {
+	public:
+		using value_type = std::string_view;
+		using difference_type = std::ptrdiff_t;
+
+		constexpr iterator() = default;
+
+		constexpr explicit iterator(std::string_view const text, char const delimiter):
+			text_(text),
+			delimiter_(delimiter),
+			mask_(delimiter_mask(text.data(), text.size(), delimiter))
+		{
+			field_last_ = next_delimiter();
+		}
+
+		constexpr std::string_view operator*() const {
+			return std::string_view(text_.data() + field_first_, field_last_ - field_first_);
+		}
+
+		constexpr iterator & operator++() {
+			if (field_last_ == text_.size()) {
+				at_end_ = true;
+			} else {
+				field_first_ = field_last_ + 1;
+				field_last_ = next_delimiter();
+			}
+			return *this;
+		}
+		constexpr iterator operator++(int) {
+			auto result = *this;
+			++*this;
+			return result;
+		}
+
+		friend constexpr bool operator==(iterator const & lhs, iterator const & rhs) {
+			return lhs.at_end_ == rhs.at_end_ and (lhs.at_end_ or lhs.field_first_ == rhs.field_first_);
+		}
+		friend constexpr bool operator==(iterator const & it, std::default_sentinel_t) {
+			return it.at_end_;
+		}
+
+	private:
+		// Returns the size of the text if there are no delimiters left
+		constexpr std::size_t next_delimiter() {
+			while (mask_ == 0) {
+				chunk_ += 64;
+				if (chunk_ >= text_.size()) {
+					chunk_ = text_.size();
+					return text_.size();
+				}
+				mask_ = delimiter_mask(text_.data() + chunk_, text_.size() - chunk_, delimiter_);
+			}
+			auto const result = chunk_ + static_cast<std::size_t>(std::countr_zero(mask_));
+			mask_ &= mask_ - 1;
+			return result;
+		}
+
+		std::string_view text_;
+		char delimiter_ = '\0';
+		std::size_t chunk_ = 0;
+		// The delimiters in the chunk after field_last_
+		std::uint64_t mask_ = 0;
+		std::size_t field_first_ = 0;
+		std::size_t field_last_ = 0;
+		bool at_end_ = false;
+	};
+
+	constexpr split_view(std::string_view const text, char const delimiter):
+		text_(text),
+		delimiter_(delimiter)
+	{
+	}
+
+	constexpr iterator begin() const {
+		return iterator(text_, delimiter_);
+	}
+	static constexpr std::default_sentinel_t end() {
+		return std::default_sentinel;
+	}
+
+private:
+	std::string_view text_;
+	char delimiter_;
+};
+
+template<string_like String>
+constexpr split_view split(String const & text, char const delimiter) {
+	return split_view(as_view(text), delimiter);
+}
+
+// Whether the characters of view are part of target. Comparing pointers into
+// different objects with < is unspecified, and not allowed in constant
+// evaluation, where this compares the start of view with each character of
+// target instead.
+template<typename String>
+constexpr bool overlaps(String const & target, std::string_view const view) {
+	auto const first = target.data();
+	auto const last = first + target.size();
+	if (view.empty()) {
+		return false;
+	}
+	if (std::is_constant_evaluated()) {
+		for (auto it = first; it != last; ++it) {
+			if (it == view.data()) {
+				return true;
+			}
+		}
+		return false;
+	}
+	return std::less<>()(view.data(), last) and std::less<>()(first, view.data() + view.size());
+}
+
+// Appends the elements of range to target with separator between each of
+// them. It goes over range twice: once to add up the exact size, so that
+// target grows at most once, and once to write the characters. range must be
+// a forward range of string_like elements.
+//
+// If target has to grow and an element is part of target, such as a field
+// from split(target, ','), the result is written to new storage and only
+// then moved into target, so that no element is freed or overwritten before
+// it is copied.
+template<typename String, std::ranges::forward_range Range> requires string_like<std::ranges::range_value_t<Range>>
+constexpr void join_to(String & target, Range && range, std::string_view const separator) {
+	auto size = std::size_t(0);
+	auto count = std::size_t(0);
+	for (auto const & element : range) {
+		size += as_view(element).size();
+		++count;
+	}
+	if (count == 0) {
+		return;
+	}
+	size += (count - 1) * separator.size();
+	auto const write = [&](char * out) {
+		auto first = true;
+		for (auto const & element : range) {
+			if (!first) {
+				out = copy_characters(std::allocator<char>(), separator.data(), separator.data() + separator.size(), out);
+			}
+			first = false;
+			auto const view = as_view(element);
+			out = copy_characters(std::allocator<char>(), view.data(), view.data() + view.size(), out);
+		}
+		return out;
+	};
+	auto const aliased = target.size() + size > target.capacity() and std::ranges::any_of(range, [&](auto const & element) {
+		return overlaps(target, as_view(element));
+	});
+	if (!aliased) {
+		target.append_and_overwrite(size, write);
+		return;
+	}
+	auto result = String(target.get_allocator());
+	result.append_and_overwrite(target.size() + size, [&](char * const out) {
+		return write(copy_characters(std::allocator<char>(), std::as_const(target).data(), std::as_const(target).data() + target.size(), out));
+	});
+	target = std::move(result);
+}
+
+template<typename String, std::ranges::forward_range Range> requires string_like<std::ranges::range_value_t<Range>>
+constexpr String join(Range && range, std::string_view const separator, typename String::allocator_type alloc = typename String::allocator_type()) {
+	auto result = String(alloc);
+	join_to(result, range, separator);
+	return result;
+}
+
+template<typename String>
+constexpr String make_string(std::string_view const source) {
+	auto result = String(typename String::allocator_type());
+	result.append(source.data(), source.data() + source.size());
+	return result;
+}
+
+constexpr bool equal(auto const & str, std::string_view const expected) {
+	return std::string_view(str.data(), str.size()) == expected;
+}
+
+// What split should do, one character at a time
+constexpr std::vector<std::string_view> naive_split(std::string_view const text, char const delimiter) {
+	auto result = std::vector<std::string_view>();
+	auto first = std::size_t(0);
+	for (std::size_t n = 0; n != text.size(); ++n) {
+		if (text[n] == delimiter) {
+			result.push_back(text.substr(first, n - first));
+			first = n + 1;
+		}
+	}
+	result.push_back(text.substr(first));
+	return result;
+}
+
+constexpr bool matches_naive_split(std::string_view const text, char const delimiter) {
+	auto const expected = naive_split(text, delimiter);
+	auto it = expected.begin();
+	for (auto const field : split(text, delimiter)) {
+		if (it == expected.end() or field.data() != it->data() or field.size() != it->size()) {
+			return false;
+		}
+		++it;
+	}
+	return it == expected.end();
+}
+
+template<typename String>
+constexpr void test_layout() {
+	auto const row = make_string<String>("id,name,,email,");
+	auto fields = std::vector<std::string_view>();
+	for (auto const field : split(row, ',')) {
+		fields.push_back(field);
+	}
+	assert((fields == std::vector<std::string_view>{"id", "name", "", "email", ""}));
+	// The fields point into the string
+	assert(fields.front().data() == row.data());
+
+	auto const joined = join<String>(split(row, ','), " | ");
+	assert(equal(joined, "id | name |  | email | "));
+	assert(equal(join<String>(split(row, ','), ","), std::string_view(row.data(), row.size())));
+
+	// Short results fit in the small buffer of either layout
+	auto small = make_string<String>("");
+	auto const small_capacity = small.capacity();
+	join_to(small, std::array<std::string_view, 3>{"a", "b", "c"}, "::");
+	assert(equal(small, "a::b::c"));
+	assert(small.capacity() == small_capacity);
+
+	// Longer ones grow once, to exactly the right size
+	auto parts = std::vector<String>();
+	parts.push_back(make_string<String>("/usr/local/bin"));
+	parts.push_back(make_string<String>("/usr/bin"));
+	parts.push_back(make_string<String>("/home/user/.local/bin"));
+	auto path = make_string<String>("PATH=");
+	join_to(path, parts, ":");
+	assert(equal(path, "PATH=/usr/local/bin:/usr/bin:/home/user/.local/bin"));
+	assert((path.capacity() | 1) == (path.size() | 1));
+
+	auto nothing = make_string<String>("unchanged");
+	join_to(nothing, std::vector<std::string_view>(), ", ");
+	assert(equal(nothing, "unchanged"));
+
+	// Fields of the string being appended to, when it grows out of the small
+	// buffer and when it grows on the heap
+	auto self = make_string<String>("a,bb,ccc");
+	join_to(self, split(self, ','), ";");
+	assert(equal(self, "a,bb,ccca;bb;ccc"));
+	auto long_self = make_string<String>("id,name,email,created_at,updated_at");
+	join_to(long_self, split(long_self, ','), ";");
+	assert(equal(long_self, "id,name,email,created_at,updated_atid;name;email;created_at;updated_at"));
+}
+
+constexpr bool test() {
+	using allocator_type = std::allocator<char>;
+	test_layout<clang::string<allocator_type>>();
+	test_layout<gcc::string<allocator_type>>();
+
+	assert(matches_naive_split("", ','));
+	assert(matches_naive_split(",", ','));
+	assert(matches_naive_split("no delimiter", ','));
+	assert(matches_naive_split(",,a,,", ','));
+	assert(std::ranges::distance(split(std::string_view(""), ',')) == 1);
+
+	// Delimiters on either side of the 64 byte chunks
+	auto text = std::string(200, 'x');
+	for (auto const position : {0, 62, 63, 64, 65, 127, 128, 199}) {
+		text[static_cast<std::size_t>(position)] = ' ';
+	}
+	assert(matches_naive_split(text, ' '));
+	assert(equal(join<gcc::string<std::allocator<char>>>(split(text, ' '), " "), text));
+	return true;
+}
+
+// The delimiters found 64 bytes at a time have to match the ones found one
+// character at a time, for every length and for where the text starts
+void test_against_naive_split() {
+	auto engine = std::mt19937_64(1);
+	auto buffer = std::string(1024, ' ');
+	for (int n = 0; n != 200'000; ++n) {
+		auto const size = static_cast<std::size_t>(engine() % 300);
+		auto const offset = static_cast<std::size_t>(engine() % 64);
+		// From almost every character being a delimiter to almost none
+		auto const density = engine() % 64 + 1;
+		for (std::size_t index = 0; index != size; ++index) {
+			buffer[offset + index] = engine() % density == 0 ? ',' : 'a';
+		}
+		auto const text = std::string_view(buffer).substr(offset, size);
+		assert(matches_naive_split(text, ','));
+		assert(join<gcc::string<std::allocator<char>>>(split(text, ','), ",").size() == size);
+	}
+}
+
+// Counts calls to the global operator new, which std::allocator uses
+std::size_t allocations = 0;
+
+void * operator new(std::size_t const size) {
+	++allocations;
+	if (auto const result = std::malloc(size)) {
+		return result;
+	}
+	throw std::bad_alloc();
+}
+void operator delete(void * const ptr) noexcept {
+	std::free(ptr);
+}
+void operator delete(void * const ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+template<typename Function>
+double nanoseconds_per_operation(std::size_t const count, Function && function) {
+	auto const start = std::chrono::steady_clock::now();
+	function();
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+}
+
+// Rows of a CSV file, with short fields
+std::vector<std::string> make_csv_rows(std::size_t const count) {
+	auto engine = std::mt19937_64(1);
+	auto result = std::vector<std::string>(count);
+	for (auto & row : result) {
+		for (int field = 0; field != 12; ++field) {
+			if (field != 0) {
+				row += ',';
+			}
+			row += std::to_string(engine() % (std::uint64_t(1) << (engine() % 40)));
+		}
+	}
+	return result;
+}
+
+// Lines of an access log, with fields separated by spaces
+std::vector<std::string> make_log_lines(std::size_t const count) {
+	auto engine = std::mt19937_64(1);
+	constexpr std::string_view methods[] = {"GET", "PUT", "POST", "DELETE"};
+	constexpr std::string_view paths[] = {"/", "/v1/users/12345/preferences", "/health", "/v2/orders/search?status=open&limit=100"};
+	auto result = std::vector<std::string>(count);
+	for (auto & line : result) {
+		line += "10.0.";
+		line += std::to_string(engine() % 256);
+		line += '.';
+		line += std::to_string(engine() % 256);
+		line += " - - [18/Oct/2026:10:";
+		line += std::to_string(10 + engine() % 50);
+		line += ":00 +0000] ";
+		line += methods[engine() % std::size(methods)];
+		line += ' ';
+		line += paths[engine() % std::size(paths)];
+		line += " HTTP/1.1 ";
+		line += std::to_string(200 + engine() % 400);
+		line += ' ';
+		line += std::to_string(engine() % 100'000);
+	}
+	return result;
+}
+
+// Splits every line on delimiter and joins the fields back together with |
+template<typename Function>
+void benchmark_one(char const * const name, std::vector<std::string> const & lines, Function function) {
+	auto sink = std::size_t(0);
+	auto const before = allocations;
+	auto const time = nanoseconds_per_operation(lines.size(), [&] {
+		for (auto const & line : lines) {
+			sink += function(std::string_view(line));
+		}
+	});
+	assert(sink != 0);
+	std::printf("%-44s %14.1f %14.2f\n", name, time, static_cast<double>(allocations - before) / static_cast<double>(lines.size()));
+}
+
+// The usual way: a std::string for each field, and then += to join them
+std::vector<std::string> split_to_strings(std::string_view const text, char const delimiter) {
+	auto result = std::vector<std::string>();
+	auto first = std::size_t(0);
+	while (true) {
+		auto const last = text.find(delimiter, first);
+		if (last == std::string_view::npos) {
+			result.emplace_back(text.substr(first));
+			return result;
+		}
+		result.emplace_back(text.substr(first, last - first));
+		first = last + 1;
+	}
+}
+
+template<typename String>
+std::size_t split_and_join(std::string_view const line, char const delimiter) {
+	return join<String>(split(line, delimiter), "|").size();
+}
+
+void benchmark_lines(char const * const description, std::vector<std::string> const & lines, char const delimiter) {
+	std::printf("%-44s %14s %14s\n", description, "ns per line", "allocations");
+	benchmark_one("split: std::string_view::find", lines, [=](std::string_view const line) {
+		auto size = std::size_t(0);
+		for (auto first = std::size_t(0); first <= line.size();) {
+			auto const last = std::min(line.find(delimiter, first), line.size());
+			size += last - first;
+			first = last + 1;
+		}
+		return size;
+	});
+	benchmark_one("split: split_view", lines, [=](std::string_view const line) {
+		auto size = std::size_t(0);
+		for (auto const field : split(line, delimiter)) {
+			size += field.size();
+		}
+		return size;
+	});
+	benchmark_one("split and join: std::string per field", lines, [=](std::string_view const line) {
+		auto const fields = split_to_strings(line, delimiter);
+		auto result = std::string();
+		for (auto const & field : fields) {
+			if (!result.empty()) {
+				result += '|';
+			}
+			result += field;
+		}
+		return result.size();
+	});
+	benchmark_one("split and join: clang layout", lines, [=](std::string_view const line) {
+		return split_and_join<clang::string<std::allocator<char>>>(line, delimiter);
+	});
+	benchmark_one("split and join: gcc layout", lines, [=](std::string_view const line) {
+		return split_and_join<gcc::string<std::allocator<char>>>(line, delimiter);
+	});
+	std::printf("\n");
+}
+
+void benchmark() {
+	benchmark_lines("CSV rows", make_csv_rows(1'000'000), ',');
+	benchmark_lines("Access log lines", make_log_lines(1'000'000), ' ');
+}
+
+int main() {
+	test();
+	static_assert(test());
+	test_against_naive_split();
+	benchmark();
+}
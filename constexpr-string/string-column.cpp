@@ -0,0 +1,859 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is to store a large
+// number of strings in as little memory as possible, and still be able to get
+// any one of them as a string.
+//
+// A std::vector<std::string> costs 32 bytes for each string even when it is
+// empty, and every string that does not fit in the small buffer also costs a
+// separate allocation. string_column stores the characters of every string
+// back to back in one array, and where each one starts in another, the same
+// way an Arrow string column does. That is 4 bytes for each string on top of
+// its characters, and two allocations in total. Reading the strings in order
+// reads memory in order.
+//
+// Getting a string out of the column does not copy it. as_string returns a
+// string in the "external" state, which refers to characters that it does not
+// own. This is the same as the static state of static-storage.cpp, renamed
+// because the characters it refers to are in a column that was built at run
+// time rather than in static storage. Just like there, insert and pop_back
+// copy the characters before they change them, and data() and the iterators
+// do not, so code that writes through them calls detach first.
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <random>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+
+// Selects the constructor that refers to characters instead of copying them
+struct external_storage_t {
+	explicit external_storage_t() = default;
+};
+inline constexpr auto external_storage = external_storage_t();
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	[[no_unique_address]] allocator_type allocator_;
+	// This could be set to 8 to reduce the size of our string to 24 bytes
+	// (just like clang), but 7 characters (plus a null terminator) is likely
+	// too small of a buffer for most users.
+	static constexpr std::size_t small_buffer_capacity = 16;
+	union U{
+		constexpr U():
+			buffer{}
+		{
+		}
+		constexpr U(std::size_t c):
+			capacity(c)
+		{
+		}
+
+		char buffer[small_buffer_capacity];
+		std::size_t capacity;
+	} u_;
+	char * data_;
+	std::size_t size_ : 63;
+	// gcc and MSVC do not allow accessing the inactive member of a union just
+	// to get its address, so we use a bitfield to work around this.
+	bool is_large_ : 1;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return is_large_;
+	}
+
+	constexpr void deallocate() {
+		if (is_large() and !is_external()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, data_, u_.capacity);
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(new_capacity);
+		data_ = new_data;
+		is_large_ = true;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy(data_, data_ + size_, temp);
+		relocate(temp, new_capacity);
+	}
+
+	constexpr void copy_external_characters() {
+		if (size_ <= small_buffer_capacity) {
+			auto const source = data_;
+			u_ = U{};
+			copy(source, source + size_, u_.buffer);
+			data_ = u_.buffer;
+			is_large_ = false;
+		} else {
+			force_reserve(size_);
+		}
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_{},
+		data_(u_.buffer),
+		size_(0),
+		is_large_(false)
+	{
+	}
+
+	// value must outlive the string and every string it is moved into
+	constexpr string(external_storage_t, std::string_view const value, allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_(0),
+		data_(const_cast<char *>(value.data())),
+		size_(value.size()),
+		is_large_(true)
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.capacity);
+			other.u_ = U{};
+		
+			data_ = other.data_;
+			other.data_ = other.u_.buffer;
+		
+			size_ = other.size_;
+			other.size_ = 0U;
+		
+			is_large_ = true;
+			other.is_large_ = false;
+
+		} else {
+			u_ = U{};
+			copy(other.data_, other.data_ + other.size_, u_.buffer);
+			data_ = u_.buffer;
+			size_ = other.size_;
+			is_large_ = false;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return data_;
+	}
+	// Does not copy the characters of an external string (see detach)
+	constexpr char * data() {
+		return data_;
+	}
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		return is_external() ? size() : is_large() ? u_.capacity : small_buffer_capacity;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		if (is_large() && capacity() > size()) {
+			if (size() > small_buffer_capacity) {
+				force_reserve(size());
+			} else {
+				auto const data = data_;
+				auto const original_capacity = u_.capacity;
+				u_ = U{};
+				copy(data, data + size_, u_.buffer);
+				data_ = u_.buffer;
+				is_large_ = false;
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		// An external string has no spare capacity, so it always takes the
+		// reallocating path, which only reads the external characters.
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = end() - 1;
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = capacity() * growth_factor;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+		
+			relocate(temp, new_capacity);
+		}
+		++size_;
+		return begin() + offset;
+	}
+
+	// A string in the external state refers to characters that it does not
+	// own, such as an element of a string_column. It is marked as large with a
+	// capacity of 0, which no allocation has.
+	constexpr bool is_external() const {
+		return is_large_ and u_.capacity == 0;
+	}
+
+	// Copies the characters of an external string into storage that this
+	// string owns, so that they can be changed through data() or an iterator.
+	// Short strings go in the small buffer. Does nothing to any other string.
+	constexpr void detach() {
+		if (is_external()) {
+			copy_external_characters();
+		}
+	}
+
+	constexpr void pop_back() {
+		detach();
+		--size_;
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+
+template<typename Allocator>
+string(Allocator) -> string<Allocator>;
+
+// Anything with a data() and a size() of characters, such as string,
+// std::string, and std::string_view
+template<typename T>
+concept string_like = requires(T const & value) {
+	{ value.data() } -> std::convertible_to<char const *>;
+	{ value.size() } -> std::convertible_to<std::size_t>;
+};
+
+constexpr std::string_view as_view(string_like auto const & value) {
+	return std::string_view(value.data(), value.size());
+}
+
+// Many strings stored as their characters back to back in one array, and an
+// array of where each one starts, the same as an Arrow string column.
+// Offset is std::uint32_t for up to 4 GiB of characters, which makes the cost
+// of each string 4 bytes on top of its characters, or std::uint64_t for more.
+// Element n is the characters from offsets_[n] to offsets_[n + 1], so there
+// is one more offset than there are strings, and the first is 0.
+//
+// Adding strings can move the characters, which leaves any std::string_view
+// or external string from before that pointing at the old ones.
+template<std::unsigned_integral Offset = std::uint32_t>
+class string_column {
+public:
+	class iterator {
+	public:
+		using value_type = std::string_view;
+		using difference_type = std::ptrdiff_t;
+
+		constexpr iterator() = default;
+		constexpr iterator(char const * const characters, Offset const * const offset):
+			characters_(characters),
+			offset_(offset)
+		{
+		}
+
+		constexpr std::string_view operator*() const {
+			return std::string_view(characters_ + offset_[0], static_cast<std::size_t>(offset_[1] - offset_[0]));
+		}
+		constexpr std::string_view operator[](difference_type const index) const {
+			return *(*this + index);
+		}
+
+		constexpr iterator & operator++() {
+			++offset_;
+			return *this;
+		}
+		constexpr iterator operator++(int) {
+			auto const result = *this;
+			++*this;
+			return result;
+		}
+		constexpr iterator & operator--() {
+			--offset_;
+			return *this;
+		}
+		constexpr iterator operator--(int) {
+			auto const result = *this;
+			--*this;
+			return result;
+		}
+		constexpr iterator & operator+=(difference_type const offset) {
+			offset_ += offset;
+			return *this;
+		}
+		constexpr iterator & operator-=(difference_type const offset) {
+			offset_ -= offset;
+			return *this;
+		}
+		friend constexpr iterator operator+(iterator it, difference_type const offset) {
+			return it += offset;
+		}
+		friend constexpr iterator operator+(difference_type const offset, iterator it) {
+			return it += offset;
+		}
+		friend constexpr iterator operator-(iterator it, difference_type const offset) {
+			return it -= offset;
+		}
+		friend constexpr difference_type operator-(iterator const lhs, iterator const rhs) {
+			return lhs.offset_ - rhs.offset_;
+		}
+
+		friend constexpr bool operator==(iterator const lhs, iterator const rhs) {
+			return lhs.offset_ == rhs.offset_;
+		}
+		friend constexpr auto operator<=>(iterator const lhs, iterator const rhs) {
+			return lhs.offset_ <=> rhs.offset_;
+		}
+
+	private:
+		char const * characters_ = nullptr;
+		Offset const * offset_ = nullptr;
+	};
+	using const_iterator = iterator;
+
+	constexpr string_column():
+		offsets_(1, Offset(0))
+	{
+	}
+
+	constexpr std::size_t size() const {
+		return offsets_.size() - 1;
+	}
+	constexpr bool empty() const {
+		return size() == 0;
+	}
+	// All of the characters, with no separators between strings
+	constexpr std::string_view characters() const {
+		return std::string_view(characters_.data(), characters_.size());
+	}
+
+	constexpr std::string_view operator[](std::size_t const index) const {
+		assert(index < size());
+		auto const first = static_cast<std::size_t>(offsets_[index]);
+		auto const last = static_cast<std::size_t>(offsets_[index + 1]);
+		return std::string_view(characters_.data() + first, last - first);
+	}
+
+	// A string that refers to the characters in the column, and copies them
+	// only when it is changed
+	template<typename Allocator = std::allocator<char>>
+	constexpr string<Allocator> as_string(std::size_t const index, Allocator alloc = Allocator()) const {
+		return string<Allocator>(external_storage, (*this)[index], alloc);
+	}
+
+	constexpr iterator begin() const {
+		return iterator(characters_.data(), offsets_.data());
+	}
+	constexpr iterator end() const {
+		return iterator(characters_.data(), offsets_.data() + size());
+	}
+
+	constexpr void reserve(std::size_t const string_count, std::size_t const character_count) {
+		offsets_.reserve(string_count + 1);
+		characters_.reserve(character_count);
+	}
+
+	// If this throws, the column is unchanged. value can be an element of
+	// this column, which is copied before the characters can move.
+	constexpr void push_back(string_like auto const & value) {
+		auto const view = as_view(value);
+		if (contains_characters(view)) {
+			auto const copy = std::vector<char>(view.begin(), view.end());
+			push_back(std::string_view(copy.data(), copy.size()));
+			return;
+		}
+		auto const offset = next_offset(view.size());
+		// Growing offsets_ is the only thing after changing characters_ that
+		// could throw, so it is done first.
+		if (offsets_.size() == offsets_.capacity()) {
+			offsets_.reserve(2 * offsets_.size());
+		}
+		characters_.insert(characters_.end(), view.begin(), view.end());
+		offsets_.push_back(offset);
+	}
+
+	// Adds every string in range. For a forward range this adds up the sizes
+	// first, so that each array grows at most once.
+	template<std::ranges::input_range Range> requires string_like<std::ranges::range_value_t<Range>>
+	constexpr void append_range(Range && range) {
+		if constexpr (std::ranges::forward_range<Range>) {
+			auto string_count = std::size_t(0);
+			auto character_count = std::size_t(0);
+			for (auto const & value : range) {
+				++string_count;
+				character_count += value.size();
+			}
+			reserve(size() + string_count, characters_.size() + character_count);
+		}
+		for (auto const & value : range) {
+			push_back(value);
+		}
+	}
+
+	// What the column holds in memory, not counting the capacity that it has
+	// not used
+	constexpr std::size_t bytes_used() const {
+		return characters_.size() + offsets_.size() * sizeof(Offset);
+	}
+
+private:
+	// Comparing pointers into different objects with < is unspecified, and not
+	// allowed in constant evaluation, where this compares the start of view
+	// with each character instead.
+	constexpr bool contains_characters(std::string_view const view) const {
+		if (view.empty()) {
+			return false;
+		}
+		auto const first = characters_.data();
+		auto const last = first + characters_.size();
+		if (std::is_constant_evaluated()) {
+			for (auto it = first; it != last; ++it) {
+				if (it == view.data()) {
+					return true;
+				}
+			}
+			return false;
+		}
+		return std::less<>()(view.data(), last) and std::less<>()(first, view.data() + view.size());
+	}
+
+	// Where the next string ends, if it has size characters. Like
+	// std::vector, this throws std::length_error if that does not fit.
+	constexpr Offset next_offset(std::size_t const size) const {
+		if (size > std::numeric_limits<Offset>::max() - characters_.size()) {
+			throw std::length_error("string_column: too many characters for the offset type");
+		}
+		return static_cast<Offset>(characters_.size() + size);
+	}
+
+	std::vector<char> characters_;
+	std::vector<Offset> offsets_;
+};
+
+static_assert(std::random_access_iterator<string_column<>::iterator>);
+static_assert(std::ranges::random_access_range<string_column<> const>);
+
+
+using allocator_type = std::allocator<char>;
+
+constexpr auto make_string(std::string_view const value) {
+	auto result = string(allocator_type());
+	for (auto const c : value) {
+		result.insert(result.end(), c);
+	}
+	return result;
+}
+
+template<typename Column>
+constexpr bool matches(Column const & column, std::vector<std::string_view> const & expected) {
+	if (column.size() != expected.size() or !std::ranges::equal(column, expected)) {
+		return false;
+	}
+	for (std::size_t n = 0; n != expected.size(); ++n) {
+		if (column[n] != expected[n] or column.begin()[static_cast<std::ptrdiff_t>(n)] != expected[n]) {
+			return false;
+		}
+	}
+	auto characters = std::string();
+	for (auto const value : expected) {
+		characters += value;
+	}
+	return column.characters() == characters;
+}
+
+template<typename Offset>
+constexpr void test_column() {
+	auto column = string_column<Offset>();
+	assert(column.empty());
+	assert(column.begin() == column.end());
+	assert(column.bytes_used() == sizeof(Offset));
+
+	column.push_back(std::string_view("first"));
+	column.push_back(std::string());
+	column.push_back(std::string("a std::string that is too long for its small buffer"));
+	column.push_back(make_string("a prototype string"));
+	assert(matches(column, {"first", "", "a std::string that is too long for its small buffer", "a prototype string"}));
+	assert(column.bytes_used() == column.characters().size() + 5 * sizeof(Offset));
+
+	auto strings = std::vector<string<allocator_type>>();
+	strings.push_back(make_string("x"));
+	strings.push_back(make_string("0123456789abcdefghij"));
+	column.append_range(strings);
+	column.append_range(std::vector<std::string_view>{"y", ""});
+	column.append_range(std::vector<std::string_view>());
+	assert(matches(column, {"first", "", "a std::string that is too long for its small buffer", "a prototype string", "x", "0123456789abcdefghij", "y", ""}));
+
+	// An external string has the characters of the column, and copies them
+	// before it changes them
+	auto external = column.as_string(5);
+	assert(external.is_external());
+	assert(std::as_const(external).data() == column[5].data());
+	assert(external.size() == 20);
+	auto moved = std::move(external);
+	assert(moved.is_external());
+	moved.insert(moved.end(), '!');
+	assert(!moved.is_external());
+	assert(as_view(moved) == "0123456789abcdefghij!");
+	assert(column[5] == "0123456789abcdefghij");
+
+	// Writing through data() has to detach first
+	auto changed = column.as_string(5);
+	assert(changed.data() == column[5].data());
+	assert(changed.is_external());
+	changed.detach();
+	assert(!changed.is_external());
+	changed.data()[0] = '9';
+	assert(as_view(changed) == "9123456789abcdefghij");
+	assert(column[5] == "0123456789abcdefghij");
+
+	auto short_external = column.as_string(4);
+	short_external.pop_back();
+	assert(!short_external.is_external());
+	assert(short_external.size() == 0);
+	assert(column[4] == "x");
+
+	// Elements of the column itself, while the characters move many times
+	auto copies = string_column<Offset>();
+	copies.push_back(std::string_view("0123456789"));
+	for (std::size_t n = 0; n != 100; ++n) {
+		copies.push_back(copies[n]);
+		copies.push_back(copies[n].substr(copies[n].size() / 2));
+	}
+	assert(copies.size() == 201);
+	for (std::size_t n = 0; n != copies.size(); ++n) {
+		assert(std::string_view("0123456789").ends_with(copies[n]));
+	}
+	assert(copies[1] == "0123456789");
+	assert(copies[2] == "56789");
+	assert(copies[3] == "0123456789");
+}
+
+constexpr bool test() {
+	test_column<std::uint32_t>();
+	test_column<std::uint64_t>();
+	return true;
+}
+
+void test_offset_overflow() {
+	auto column = string_column<std::uint8_t>();
+	column.push_back(std::string(200, 'a'));
+	auto thrown = false;
+	try {
+		column.push_back(std::string(100, 'b'));
+	} catch (std::length_error const &) {
+		thrown = true;
+	}
+	assert(thrown);
+	// Nothing changed
+	assert(column.size() == 1);
+	assert(column.characters().size() == 200);
+	column.push_back(std::string(55, 'c'));
+	assert(column[1] == std::string(55, 'c'));
+}
+
+void test_against_vector() {
+	auto engine = std::mt19937_64(1);
+	for (int n = 0; n != 1000; ++n) {
+		auto expected = std::vector<std::string>();
+		auto column = string_column<>();
+		for (auto count = engine() % 200; count != 0; --count) {
+			auto value = std::string(engine() % 40, 'a');
+			for (auto & c : value) {
+				c = static_cast<char>(engine());
+			}
+			if (engine() % 2 == 0) {
+				column.push_back(value);
+			} else {
+				column.append_range(std::vector{value});
+			}
+			expected.push_back(std::move(value));
+		}
+		assert(matches(column, std::vector<std::string_view>(expected.begin(), expected.end())));
+		for (std::size_t index = 0; index != expected.size(); ++index) {
+			auto const str = column.as_string(index);
+			assert(as_view(str) == expected[index]);
+		}
+	}
+}
+
+template<typename Function>
+double nanoseconds_per_operation(std::size_t const count, Function && function) {
+	auto const start = std::chrono::steady_clock::now();
+	function();
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+}
+
+// URLs and identifiers from 6 to about 60 characters, about half of which fit
+// in the small buffer of std::string
+std::vector<std::string> make_values(std::size_t const count) {
+	auto engine = std::mt19937_64(1);
+	constexpr std::string_view hosts[] = {"https://example.com/", "https://cdn.example.net/assets/", "http://10.0.0.1:8080/"};
+	auto result = std::vector<std::string>(count);
+	for (auto & value : result) {
+		if (engine() % 2 == 0) {
+			value = hosts[engine() % std::size(hosts)];
+		}
+		for (auto size = engine() % 20 + 6; size != 0; --size) {
+			value += static_cast<char>('a' + engine() % 26);
+		}
+	}
+	return result;
+}
+
+// Bytes for the objects and the characters, not counting the unused capacity
+// of the vector or what malloc adds to each allocation
+std::size_t bytes_used(std::vector<std::string> const & values) {
+	auto result = values.size() * sizeof(std::string);
+	for (auto const & value : values) {
+		if (value.size() >= sizeof(std::string) / 2) {
+			result += value.size() + 1;
+		}
+	}
+	return result;
+}
+
+struct scan_result {
+	std::size_t matches;
+	std::size_t characters;
+};
+
+// Counts the values that start with https:// and adds up their sizes, which
+// reads every value once in order
+scan_result scan(auto const & values) {
+	auto result = scan_result(0, 0);
+	for (auto const & value : values) {
+		auto const view = std::string_view(value);
+		result.matches += view.starts_with("https://") ? 1 : 0;
+		result.characters += view.size();
+	}
+	return result;
+}
+
+// Reads the values at random indices
+std::size_t random_access(auto const & values, std::vector<std::uint32_t> const & indices) {
+	auto result = std::size_t(0);
+	for (auto const index : indices) {
+		auto const view = std::string_view(values[index]);
+		result += view.size() + static_cast<unsigned char>(view.back());
+	}
+	return result;
+}
+
+template<typename Values>
+void benchmark_one(char const * const name, std::vector<std::string> const & source, std::vector<std::uint32_t> const & indices, auto build, auto bytes) {
+	auto values = Values();
+	auto const build_time = nanoseconds_per_operation(source.size(), [&] {
+		build(values, source);
+	});
+	auto result = scan_result();
+	auto const scan_time = nanoseconds_per_operation(source.size(), [&] {
+		result = scan(values);
+	});
+	assert(result.matches != 0 and result.characters != 0);
+	auto sum = std::size_t(0);
+	auto const random_time = nanoseconds_per_operation(indices.size(), [&] {
+		sum = random_access(values, indices);
+	});
+	assert(sum != 0);
+	std::printf("%-36s %10.1f %10.1f %10.1f %10.1f\n", name, static_cast<double>(bytes(values)) / static_cast<double>(source.size()), build_time, scan_time, random_time);
+}
+
+void benchmark() {
+	constexpr auto count = std::size_t(5'000'000);
+	auto const source = make_values(count);
+	auto engine = std::mt19937_64(2);
+	auto indices = std::vector<std::uint32_t>(1'000'000);
+	for (auto & index : indices) {
+		index = static_cast<std::uint32_t>(engine() % count);
+	}
+	auto characters = std::size_t(0);
+	for (auto const & value : source) {
+		characters += value.size();
+	}
+	std::printf("%zu values, %.1f characters each\n", count, static_cast<double>(characters) / static_cast<double>(count));
+	std::printf("%-36s %10s %10s %10s %10s\n", "", "bytes", "build ns", "scan ns", "random ns");
+	benchmark_one<std::vector<std::string>>("std::vector<std::string>", source, indices, [](auto & values, auto const & from) {
+		for (auto const & value : from) {
+			values.push_back(value);
+		}
+	}, [](auto const & values) {
+		return bytes_used(values);
+	});
+	benchmark_one<string_column<>>("string_column, push_back", source, indices, [](auto & values, auto const & from) {
+		for (auto const & value : from) {
+			values.push_back(value);
+		}
+	}, [](auto const & values) {
+		return values.bytes_used();
+	});
+	benchmark_one<string_column<>>("string_column, append_range", source, indices, [](auto & values, auto const & from) {
+		values.append_range(from);
+	}, [](auto const & values) {
+		return values.bytes_used();
+	});
+	benchmark_one<string_column<std::uint64_t>>("string_column<std::uint64_t>", source, indices, [](auto & values, auto const & from) {
+		values.append_range(from);
+	}, [](auto const & values) {
+		return values.bytes_used();
+	});
+}
+
+int main() {
+	test();
+	static_assert(test());
+	test_offset_overflow();
+	test_against_vector();
+	benchmark();
+}
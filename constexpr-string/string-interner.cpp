@@ -0,0 +1,739 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is to replace strings
+// that repeat many times, such as the few thousand tags carried by millions
+// of events, with 32-bit handles. Each distinct string is stored once, and
+// comparing or hashing a handle is comparing or hashing an integer.
+//
+// string_interner copies each new string into a concurrent_buffer<char>, the
+// arena from concurrent-allocator.cpp, through a per_thread_allocator, so
+// threads interning at the same time do not contend on the arena. The table
+// from string to handle is open addressing over atomic 64-bit slots. Finding
+// a string that is already interned takes no lock and writes nothing shared.
+// Inserting a new one claims an empty slot with a compare-and-swap, so only
+// threads inserting into the same slot ever wait for each other.
+//
+// A handle is a dense index: the first string interned is 0, the next 1, and
+// so on. That lets a vector indexed by handle replace a map keyed by string.
+//
+// Running the program benchmarks an event pipeline with std::string tags and
+// with handles, and interning on several threads against a std::mutex around
+// a std::unordered_map.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+constexpr auto cache_line_size = std::size_t(64);
+
+// Every buffer, and every reset of one, takes an id that no other buffer has
+// had, so that a chunk a thread cached from a buffer that has since been
+// destroyed is never taken for a chunk of a new buffer at the same address.
+// 0 is never used.
+inline std::atomic<std::uint64_t> next_buffer_id = 1;
+
+// Unlike buffer, this lives on the heap: an arena shared by many threads is
+// much larger than anything we want on a stack.
+template<typename T>
+struct concurrent_buffer {
+	static_assert(cache_line_size % sizeof(T) == 0);
+	static constexpr auto elements_per_cache_line = cache_line_size / sizeof(T);
+
+	explicit concurrent_buffer(std::size_t const size):
+		data(static_cast<T *>(::operator new(size * sizeof(T), std::align_val_t(cache_line_size)))),
+		size(size)
+	{
+	}
+	concurrent_buffer(concurrent_buffer &&) = delete;
+	concurrent_buffer(concurrent_buffer const &) = delete;
+	concurrent_buffer & operator=(concurrent_buffer &&) = delete;
+	concurrent_buffer & operator=(concurrent_buffer const &) = delete;
+
+	~concurrent_buffer() {
+		::operator delete(data, std::align_val_t(cache_line_size));
+	}
+
+	// Rounding every chunk up to a whole number of cache lines keeps the next
+	// chunk aligned, no matter which thread gets it.
+	T * allocate_chunk(std::size_t const count) {
+		auto const rounded = (count + elements_per_cache_line - 1) / elements_per_cache_line * elements_per_cache_line;
+		auto const offset = used.fetch_add(rounded, std::memory_order_relaxed);
+		if (offset + rounded > size) {
+			throw std::bad_alloc();
+		}
+		return data + offset;
+	}
+
+	// Must not be called while any thread is still allocating.
+	void reset() {
+		used.store(0, std::memory_order_relaxed);
+		id = next_buffer_id.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	T * const data;
+	std::size_t const size;
+	std::uint64_t id = next_buffer_id.fetch_add(1, std::memory_order_relaxed);
+	// On its own cache line so that bumping it does not evict the members
+	// above, which every thread reads.
+	alignas(cache_line_size) std::atomic<std::size_t> used = 0;
+};
+
+template<typename T>
+struct concurrent_allocator {
+	using value_type = T;
+
+	explicit constexpr concurrent_allocator(concurrent_buffer<T> & buffer):
+		buffer_(&buffer)
+	{
+	}
+
+	auto allocate(std::size_t size) {
+		return buffer_->allocate_chunk(size);
+	}
+	constexpr void deallocate(T * ptr, std::size_t size) {
+	}
+
+private:
+	concurrent_buffer<T> * buffer_;
+};
+
+
+template<typename T>
+struct thread_chunk {
+	std::uint64_t buffer_id = 0;
+	T * pointer = nullptr;
+	T * end = nullptr;
+};
+
+// Trivially constructible, so accessing it is a single offset from the thread
+// pointer with no initialization guard.
+template<typename T>
+inline thread_local thread_chunk<T> current_chunk;
+
+template<typename T>
+struct per_thread_allocator {
+	using value_type = T;
+
+	static constexpr auto chunk_size = std::size_t(64 * 1024) / sizeof(T);
+
+	explicit constexpr per_thread_allocator(concurrent_buffer<T> & buffer):
+		buffer_(&buffer)
+	{
+	}
+
+	auto allocate(std::size_t size) {
+		auto & chunk = current_chunk<T>;
+		if (chunk.buffer_id != buffer_->id or static_cast<std::size_t>(chunk.end - chunk.pointer) < size) [[unlikely]] {
+			refill(chunk, size);
+		}
+		auto const result = chunk.pointer;
+		chunk.pointer += size;
+		return result;
+	}
+	constexpr void deallocate(T * ptr, std::size_t size) {
+	}
+
+private:
+	// Whatever is left of the previous chunk is abandoned. With chunks much
+	// larger than a typical string, that is a small fraction of the arena.
+	void refill(thread_chunk<T> & chunk, std::size_t const size) {
+		auto const count = std::max(chunk_size, size);
+		// Only once allocate_chunk has not thrown, or the old chunk would be
+		// taken for one from this buffer
+		chunk.pointer = buffer_->allocate_chunk(count);
+		chunk.end = chunk.pointer + count;
+		chunk.buffer_id = buffer_->id;
+	}
+
+	concurrent_buffer<T> * buffer_;
+};
+
+// Reads bytes in little-endian order on every target, so that a hash computed
+// during constant evaluation matches the one computed at run time.
+constexpr std::uint64_t load_little_endian(char const * const data) {
+	auto result = std::uint64_t(0);
+	if (std::is_constant_evaluated()) {
+		for (std::size_t n = 0; n != sizeof(result); ++n) {
+			result |= std::uint64_t(static_cast<unsigned char>(data[n])) << (n * CHAR_BIT);
+		}
+		return result;
+	}
+	std::memcpy(&result, data, sizeof(result));
+	if constexpr (std::endian::native == std::endian::big) {
+		result = __builtin_bswap64(result);
+	}
+	return result;
+}
+
+// Strings of up to this many characters hash as three words, padded with 0.
+constexpr std::size_t short_hash_size = 24;
+using short_hash_words = std::array<std::uint64_t, short_hash_size / sizeof(std::uint64_t)>;
+
+constexpr std::uint64_t hash_keys[] = {
+	0xbe4b'a423'396c'feb8,
+	0x1cad'21f7'2c81'017c,
+	0xdb97'9083'e96d'd4de,
+	0x1f67'b3b7'a4a4'4072,
+};
+constexpr std::uint64_t size_key = 0x9e37'79b1'85eb'ca87;
+constexpr std::uint64_t lane_multiplier = 0x9fb2'1c65'1e98'df25;
+
+// The multiply is of the 32-bit halves of the keyed word, which is what
+// _mm256_mul_epu32 computes in each lane. Adding the word with its halves
+// swapped keeps a word from being lost when one of those halves is 0.
+constexpr std::uint64_t accumulate(std::uint64_t const word, std::uint64_t const key) {
+	auto const keyed = word ^ key;
+	return (keyed & 0xffff'ffff) * (keyed >> 32) + std::rotl(word, 32);
+}
+
+constexpr std::uint64_t avalanche(std::uint64_t hash) {
+	hash ^= hash >> 37;
+	hash *= 0x1656'6791'9e37'79f9;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+constexpr std::size_t hash_short(short_hash_words const & words, std::size_t const size) {
+	auto result = size * size_key;
+	for (std::size_t n = 0; n != words.size(); ++n) {
+		result += accumulate(words[n], hash_keys[n]);
+	}
+	return avalanche(result);
+}
+
+// Each lane takes one word of every 32-byte block, and the last block
+// overlaps the one before it. Multiplying the lanes between blocks makes the
+// result depend on the order of the blocks.
+constexpr std::size_t hash_long(char const * const data, std::size_t const size) {
+	assert(size > short_hash_size);
+	constexpr auto block_size = std::size(hash_keys) * sizeof(std::uint64_t);
+	auto lanes = std::array<std::uint64_t, std::size(hash_keys)>();
+	auto add_block = [&](auto const word_offset) {
+		for (std::size_t n = 0; n != lanes.size(); ++n) {
+			lanes[n] = (lanes[n] + accumulate(load_little_endian(data + word_offset(n)), hash_keys[n])) * lane_multiplier;
+		}
+	};
+	if (size < block_size) {
+		add_block([=](std::size_t const n) { return std::min(n * sizeof(std::uint64_t), size - sizeof(std::uint64_t)); });
+	} else {
+		auto offset = std::size_t(0);
+		for (; offset + block_size <= size; offset += block_size) {
+			add_block([=](std::size_t const n) { return offset + n * sizeof(std::uint64_t); });
+		}
+		if (offset != size) {
+			add_block([=](std::size_t const n) { return size - block_size + n * sizeof(std::uint64_t); });
+		}
+	}
+	auto result = size * size_key;
+	for (std::size_t n = 0; n != lanes.size(); ++n) {
+		result += std::rotl(lanes[n], static_cast<int>(n * 16));
+	}
+	return avalanche(result);
+}
+
+constexpr short_hash_words padded_words(char const * const data, std::size_t const size) {
+	assert(size <= short_hash_size);
+	char padded[short_hash_size] = {};
+	std::copy_n(data, size, padded);
+	auto result = short_hash_words();
+	for (std::size_t n = 0; n != result.size(); ++n) {
+		result[n] = load_little_endian(padded + n * sizeof(std::uint64_t));
+	}
+	return result;
+}
+
+// The hash from hash.cpp, which is the same as the hash of a string with
+// these characters in either layout there
+constexpr std::size_t hash_bytes(char const * const data, std::size_t const size) {
+	return size <= short_hash_size ? hash_short(padded_words(data, size), size) : hash_long(data, size);
+}
+
+// A string interned in a string_interner. Two handles from the same interner
+// are equal exactly when their strings are. They are ordered by when their
+// strings were first interned, not by the strings.
+class string_handle {
+public:
+	constexpr explicit string_handle(std::uint32_t const value):
+		value_(value)
+	{
+	}
+
+	constexpr std::uint32_t value() const {
+		return value_;
+	}
+
+	friend constexpr auto operator<=>(string_handle, string_handle) = default;
+
+private:
+	std::uint32_t value_;
+};
+
+template<>
+struct std::hash<string_handle> {
+	constexpr std::size_t operator()(string_handle const handle) const {
+		return handle.value();
+	}
+};
+
+// Maps strings to handles, up to capacity distinct strings. A string is
+// copied into the arena the first time it is interned, and the handle stays
+// valid as long as the interner and the arena do. Every member function can
+// be called by any number of threads at once.
+//
+// Each slot of the table is 0 if it is empty, or else has a tag from the hash
+// of its string in the high 32 bits and the handle + 1 in the low 32 bits. A
+// slot whose low 32 bits are 0 has been claimed by a thread that has not
+// finished inserting its string. Slots are never emptied, so a string stays
+// in the first slot it was inserted into.
+class string_interner {
+public:
+	string_interner(concurrent_buffer<char> & arena, std::uint32_t const capacity):
+		arena_(arena),
+		capacity_(capacity),
+		mask_(std::bit_ceil(std::size_t(capacity) * 2) - 1),
+		slots_(std::make_unique<std::atomic<std::uint64_t>[]>(mask_ + 1)),
+		entries_(std::make_unique<entry[]>(capacity))
+	{
+	}
+
+	// Throws std::length_error if value is new and there are already capacity
+	// strings. Does not wait unless another thread is inserting a string in
+	// the slot this one needs.
+	string_handle intern(std::string_view const value) {
+		auto const hash = hash_bytes(value.data(), value.size());
+		auto const tag = tag_of(hash);
+		auto copy = static_cast<char const *>(nullptr);
+		auto reserved = false;
+		for (auto index = hash & mask_; ; index = (index + 1) & mask_) {
+			auto & slot = slots_[index];
+			auto current = slot.load(std::memory_order_acquire);
+			if (current == 0) {
+				if (!reserved) {
+					reserved = reserve(slot);
+				}
+				if (reserved) {
+					if (copy == nullptr) {
+						try {
+							copy = store(value);
+						} catch (...) {
+							reserved_.fetch_sub(1, std::memory_order_relaxed);
+							throw;
+						}
+					}
+					if (slot.compare_exchange_strong(current, tag, std::memory_order_acquire)) {
+						auto const id = count_.fetch_add(1, std::memory_order_acq_rel);
+						entries_[id] = entry{copy, value.size()};
+						slot.store(tag | (id + 1), std::memory_order_release);
+						return string_handle(id);
+					}
+				} else {
+					current = slot.load(std::memory_order_acquire);
+				}
+			}
+			if ((current & tag_mask) != tag) {
+				continue;
+			}
+			while ((current & id_mask) == 0) {
+				std::this_thread::yield();
+				current = slot.load(std::memory_order_acquire);
+			}
+			auto const handle = string_handle(static_cast<std::uint32_t>((current & id_mask) - 1));
+			if ((*this)[handle] == value) {
+				// The copy, if there is one, is left unused in the arena
+				if (reserved) {
+					reserved_.fetch_sub(1, std::memory_order_relaxed);
+				}
+				return handle;
+			}
+		}
+	}
+
+	// Never waits. A string that another thread is still inserting is not
+	// found.
+	std::optional<string_handle> find(std::string_view const value) const {
+		auto const hash = hash_bytes(value.data(), value.size());
+		auto const tag = tag_of(hash);
+		for (auto index = hash & mask_; ; index = (index + 1) & mask_) {
+			auto const current = slots_[index].load(std::memory_order_acquire);
+			if (current == 0) {
+				return std::nullopt;
+			}
+			if ((current & tag_mask) != tag or (current & id_mask) == 0) {
+				continue;
+			}
+			auto const handle = string_handle(static_cast<std::uint32_t>((current & id_mask) - 1));
+			if ((*this)[handle] == value) {
+				return handle;
+			}
+		}
+	}
+
+	std::string_view operator[](string_handle const handle) const {
+		auto const & value = entries_[handle.value()];
+		return std::string_view(value.data, value.size);
+	}
+
+	// How many handles have been given out. Once no thread is interning, the
+	// handles are 0 through size() - 1.
+	std::uint32_t size() const {
+		return count_.load(std::memory_order_acquire);
+	}
+	std::uint32_t capacity() const {
+		return capacity_;
+	}
+
+private:
+	static constexpr auto id_mask = std::uint64_t(0xFFFF'FFFF);
+	static constexpr auto tag_mask = ~id_mask;
+
+	struct entry {
+		char const * data = nullptr;
+		std::size_t size = 0;
+	};
+
+	// The high bits of the hash, which the low bits that pick the first slot
+	// do not overlap unless the table has over 4 billion slots. Never 0, so a
+	// claimed slot is never empty.
+	static std::uint64_t tag_of(std::size_t const hash) {
+		return (std::uint64_t(hash) | (std::uint64_t(1) << 32)) & tag_mask;
+	}
+
+	char const * store(std::string_view const value) {
+		auto const result = per_thread_allocator<char>(arena_).allocate(value.size());
+		std::copy_n(value.data(), value.size(), result);
+		return result;
+	}
+
+	// Reserves room for one more string, so that every thread that claims a
+	// slot can be given a handle. When there is no room, another thread may
+	// still be inserting this same string, so this waits for the threads that
+	// have reserved room to finish. Returns false if slot was filled while
+	// waiting, and throws if the interner is full.
+	bool reserve(std::atomic<std::uint64_t> const & slot) {
+		auto reserved = reserved_.load(std::memory_order_relaxed);
+		while (true) {
+			if (reserved < capacity_) {
+				if (reserved_.compare_exchange_weak(reserved, reserved + 1, std::memory_order_relaxed)) {
+					return true;
+				}
+				continue;
+			}
+			auto const full = count_.load(std::memory_order_acquire) == capacity_;
+			if (slot.load(std::memory_order_relaxed) != 0) {
+				return false;
+			}
+			if (full) {
+				throw std::length_error("string_interner is full");
+			}
+			std::this_thread::yield();
+			reserved = reserved_.load(std::memory_order_relaxed);
+		}
+	}
+
+	concurrent_buffer<char> & arena_;
+	std::uint32_t const capacity_;
+	std::size_t const mask_;
+	std::unique_ptr<std::atomic<std::uint64_t>[]> const slots_;
+	std::unique_ptr<entry[]> const entries_;
+	std::atomic<std::uint32_t> count_ = 0;
+	std::atomic<std::uint32_t> reserved_ = 0;
+};
+
+constexpr bool test() {
+	// The hash does not depend on where the characters are, so the same
+	// string always starts probing at the same slot
+	constexpr char first[] = "region=eu-west-1, a string longer than 24";
+	char second[std::size(first)] = {};
+	std::copy_n(first, std::size(first), second);
+	assert(hash_bytes(first, std::size(first) - 1) == hash_bytes(second, std::size(second) - 1));
+	assert(hash_bytes(first, 5) != hash_bytes(first, 6));
+
+	auto const a = string_handle(3);
+	auto const b = string_handle(7);
+	assert(a == string_handle(3));
+	assert(a != b);
+	assert(a < b);
+	assert(std::hash<string_handle>()(b) == 7);
+	return true;
+}
+
+void test_single_thread() {
+	auto arena = concurrent_buffer<char>(1 << 20);
+	auto interner = string_interner(arena, 1000);
+	assert(!interner.find("a"));
+	auto const a = interner.intern("a");
+	auto const b = interner.intern("b");
+	auto const empty = interner.intern("");
+	assert(a == string_handle(0));
+	assert(b == string_handle(1));
+	assert(empty == string_handle(2));
+	assert(interner.intern("a") == a);
+	assert(interner.find("b") == b);
+	assert(interner.find("") == empty);
+	assert(!interner.find("c"));
+	assert(interner[a] == "a");
+	assert(interner[empty] == "");
+
+	// The interner keeps its own copy
+	auto value = std::string("a string that is too long for the small buffer");
+	auto const long_handle = interner.intern(value);
+	value[0] = 'A';
+	assert(interner[long_handle] == "a string that is too long for the small buffer");
+	assert(interner.intern(value) != long_handle);
+	assert(interner.size() == 5);
+
+	auto handles = std::vector<string_handle>();
+	for (std::uint32_t n = interner.size(); n != interner.capacity(); ++n) {
+		handles.push_back(interner.intern(std::to_string(n)));
+	}
+	for (std::uint32_t n = 0; n != handles.size(); ++n) {
+		assert(handles[n] == string_handle(n + 5));
+		assert(interner[handles[n]] == std::to_string(n + 5));
+		assert(interner.find(std::to_string(n + 5)) == handles[n]);
+	}
+
+	// A string that is already interned can still be found when it is full
+	auto threw = false;
+	try {
+		interner.intern("one too many");
+	} catch (std::length_error const &) {
+		threw = true;
+	}
+	assert(threw);
+	assert(interner.intern("b") == b);
+	assert(interner.size() == interner.capacity());
+}
+
+// Every thread interns the same strings in a different order, filling the
+// interner exactly, so that threads race to insert each string and to reserve
+// the last of the room
+void test_threads() {
+	constexpr auto thread_count = std::size_t(8);
+	constexpr auto string_count = std::uint32_t(2000);
+	auto values = std::vector<std::string>();
+	for (std::uint32_t n = 0; n != string_count; ++n) {
+		values.push_back("tag-" + std::to_string(n * 7919));
+	}
+	auto arena = concurrent_buffer<char>(thread_count * string_count * 64 + thread_count * per_thread_allocator<char>::chunk_size);
+	auto interner = string_interner(arena, string_count);
+	auto handles = std::vector<std::vector<string_handle>>(thread_count);
+	auto threads = std::vector<std::thread>();
+	for (std::size_t thread = 0; thread != thread_count; ++thread) {
+		threads.emplace_back([&, thread] {
+			auto order = std::vector<std::uint32_t>(string_count);
+			for (std::uint32_t n = 0; n != string_count; ++n) {
+				order[n] = n;
+			}
+			std::ranges::shuffle(order, std::mt19937_64(thread));
+			auto & result = handles[thread];
+			result.resize(string_count, string_handle(0));
+			for (auto const index : order) {
+				result[index] = interner.intern(values[index]);
+			}
+		});
+	}
+	for (auto & thread : threads) {
+		thread.join();
+	}
+
+	assert(interner.size() == string_count);
+	auto seen = std::vector<bool>(string_count);
+	for (std::uint32_t n = 0; n != string_count; ++n) {
+		auto const handle = handles[0][n];
+		for (auto const & other : handles) {
+			assert(other[n] == handle);
+		}
+		assert(handle.value() < string_count);
+		assert(!seen[handle.value()]);
+		seen[handle.value()] = true;
+		assert(interner[handle] == values[n]);
+		assert(interner.find(values[n]) == handle);
+	}
+}
+
+template<typename Function>
+double nanoseconds_per_operation(std::size_t const count, Function && function) {
+	auto const start = std::chrono::steady_clock::now();
+	function();
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+}
+
+// The interner an event pipeline would write without this file
+class locked_interner {
+public:
+	string_handle intern(std::string_view const value) {
+		auto const lock = std::lock_guard(mutex_);
+		auto const [it, inserted] = handles_.try_emplace(std::string(value), static_cast<std::uint32_t>(handles_.size()));
+		return string_handle(it->second);
+	}
+
+private:
+	std::mutex mutex_;
+	std::unordered_map<std::string, std::uint32_t> handles_;
+};
+
+// A few thousand key=value tags, most of them too long for the small buffer of
+// std::string
+std::vector<std::string> make_tags(std::size_t const count) {
+	auto engine = std::mt19937_64(1);
+	constexpr std::string_view keys[] = {"service=", "region=", "host=", "endpoint=/api/v2/", "status=", "customer_tier="};
+	constexpr std::string_view values[] = {"checkout", "eu-west-", "us-east-", "ingest-worker-", "orders/", "premium-"};
+	auto result = std::vector<std::string>();
+	while (result.size() != count) {
+		auto tag = std::string(keys[engine() % std::size(keys)]);
+		tag += values[engine() % std::size(values)];
+		tag += std::to_string(engine() % 1000);
+		if (std::ranges::find(result, tag) == result.end()) {
+			result.push_back(std::move(tag));
+		}
+	}
+	return result;
+}
+
+// Skewed, so a few tags are on most events
+std::vector<std::uint32_t> make_events(std::size_t const count, std::size_t const tag_count) {
+	auto engine = std::mt19937_64(2);
+	auto distribution = std::uniform_real_distribution<double>(0.0, 1.0);
+	auto result = std::vector<std::uint32_t>(count);
+	for (auto & event : result) {
+		auto const x = distribution(engine);
+		event = static_cast<std::uint32_t>(static_cast<double>(tag_count) * x * x * x);
+	}
+	return result;
+}
+
+// Bytes for the objects and the characters, not counting what malloc adds to
+// each allocation
+std::size_t bytes_used(std::vector<std::string> const & values) {
+	auto result = values.size() * sizeof(std::string);
+	for (auto const & value : values) {
+		if (value.size() >= sizeof(std::string) / 2) {
+			result += value.size() + 1;
+		}
+	}
+	return result;
+}
+
+void benchmark() {
+	constexpr auto tag_count = std::size_t(4000);
+	constexpr auto event_count = std::size_t(5'000'000);
+	auto const tags = make_tags(tag_count);
+	auto const events = make_events(event_count, tag_count);
+	auto arena = concurrent_buffer<char>(std::size_t(1) << 24);
+	auto interner = string_interner(arena, tag_count);
+
+	auto strings = std::vector<std::string>();
+	auto const string_time = nanoseconds_per_operation(event_count, [&] {
+		strings.reserve(event_count);
+		for (auto const event : events) {
+			strings.push_back(tags[event]);
+		}
+	});
+	auto handles = std::vector<string_handle>();
+	auto const handle_time = nanoseconds_per_operation(event_count, [&] {
+		handles.reserve(event_count);
+		for (auto const event : events) {
+			handles.push_back(interner.intern(tags[event]));
+		}
+	});
+	auto characters = std::size_t(0);
+	for (std::uint32_t n = 0; n != interner.size(); ++n) {
+		characters += interner[string_handle(n)].size();
+	}
+
+	auto const & needle = tags[1];
+	auto const needle_handle = *interner.find(needle);
+	auto matches = std::size_t(0);
+	auto const string_count_time = nanoseconds_per_operation(event_count, [&] {
+		matches = static_cast<std::size_t>(std::ranges::count(strings, needle));
+	});
+	auto const handle_count_time = nanoseconds_per_operation(event_count, [&] {
+		assert(static_cast<std::size_t>(std::ranges::count(handles, needle_handle)) == matches);
+	});
+
+	auto string_histogram = std::unordered_map<std::string, std::size_t>();
+	auto const string_histogram_time = nanoseconds_per_operation(event_count, [&] {
+		for (auto const & value : strings) {
+			++string_histogram[value];
+		}
+	});
+	auto handle_histogram = std::vector<std::size_t>();
+	auto const handle_histogram_time = nanoseconds_per_operation(event_count, [&] {
+		handle_histogram.resize(interner.size());
+		for (auto const handle : handles) {
+			++handle_histogram[handle.value()];
+		}
+	});
+	assert(handle_histogram[needle_handle.value()] == string_histogram[needle]);
+
+	std::printf("%zu events with one of %u tags\n", event_count, interner.size());
+	std::printf("%-28s %14s %14s\n", "", "std::string", "handle");
+	std::printf("%-28s %14.1f %14.1f\n", "bytes per event", static_cast<double>(bytes_used(strings)) / static_cast<double>(event_count), static_cast<double>(handles.size() * sizeof(string_handle) + characters) / static_cast<double>(event_count));
+	std::printf("%-28s %14.1f %14.1f\n", "ns to tag an event", string_time, handle_time);
+	std::printf("%-28s %14.2f %14.2f\n", "ns per event, count equal", string_count_time, handle_count_time);
+	std::printf("%-28s %14.1f %14.1f\n", "ns per event, histogram", string_histogram_time, handle_histogram_time);
+
+	std::printf("\nhardware threads: %u\n", std::thread::hardware_concurrency());
+	std::printf("%8s %14s %14s   (ns per event)\n", "threads", "mutex + map", "interner");
+	auto const max_threads = std::max(std::size_t(std::thread::hardware_concurrency()), std::size_t(8));
+	for (std::size_t thread_count = 1; thread_count <= max_threads; thread_count *= 2) {
+		auto const time_threads = [&](auto & shared) {
+			auto threads = std::vector<std::thread>();
+			return nanoseconds_per_operation(event_count, [&] {
+				for (std::size_t thread = 0; thread != thread_count; ++thread) {
+					threads.emplace_back([&, thread] {
+						auto const first = event_count * thread / thread_count;
+						auto const last = event_count * (thread + 1) / thread_count;
+						for (auto n = first; n != last; ++n) {
+							shared.intern(tags[events[n]]);
+						}
+					});
+				}
+				for (auto & thread : threads) {
+					thread.join();
+				}
+			});
+		};
+		auto locked = locked_interner();
+		auto const locked_time = time_threads(locked);
+		arena.reset();
+		auto concurrent = string_interner(arena, tag_count);
+		auto const concurrent_time = time_threads(concurrent);
+		std::printf("%8zu %14.1f %14.1f\n", thread_count, locked_time, concurrent_time);
+	}
+}
+
+int main() {
+	test();
+	static_assert(test());
+	test_single_thread();
+	test_threads();
+	benchmark();
+}
@@ -0,0 +1,1151 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is to sort a container
+// of strings without comparing strings for most of the work.
+//
+// std::sort compares strings O(n log n) times, and every comparison calls
+// data() on both (a branch in the clang layout), follows a pointer for large
+// strings, and calls memcmp. sort_strings instead reads the first 8
+// characters of each string once, straight from its small buffer or its
+// allocation, as a big-endian integer. It radix sorts those integers along
+// with the position of their string. Only strings whose first 8 characters
+// are the same need more than that, and those are sorted the same way by
+// their next 8 characters, until a group is small enough for std::sort.
+// Last, the strings are moved into their sorted positions. The clang layout
+// has no pointer into itself, so that is a memcpy of 24 bytes rather than a
+// move assignment.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <random>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+// char is trivial, so outside of constant evaluation the characters can be
+// copied with memcpy instead of being constructed one at a time
+template<typename Allocator>
+constexpr char * copy_characters(Allocator alloc, char const * const first, char const * const last, char * const out) {
+	if (std::is_constant_evaluated()) {
+		return uninitialized_copy(alloc, first, last, out);
+	}
+	auto const count = static_cast<std::size_t>(last - first);
+	if (count != 0) {
+		std::memcpy(out, first, count);
+	}
+	return out + count;
+}
+
+
+// Reads bytes in memory order, so that comparing two words as integers
+// compares them as unsigned characters, the same as memcmp.
+inline std::uint64_t load_big_endian(char const * const data) {
+	auto result = std::uint64_t();
+	std::memcpy(&result, data, sizeof(result));
+	if constexpr (std::endian::native == std::endian::little) {
+		result = __builtin_bswap64(result);
+	}
+	return result;
+}
+
+// The characters from offset to offset + 8 as a big-endian integer, with 0
+// for any past the end. Comparing these as integers compares those
+// characters as unsigned char, the same as memcmp.
+constexpr std::uint64_t key_at(char const * const data, std::size_t const size, std::size_t const offset) {
+	constexpr auto word = sizeof(std::uint64_t);
+	auto const remaining = size - offset;
+	if (!std::is_constant_evaluated() and remaining >= word) {
+		return load_big_endian(data + offset);
+	}
+	auto result = std::uint64_t(0);
+	for (std::size_t n = 0; n != std::min(remaining, word); ++n) {
+		result |= std::uint64_t(static_cast<unsigned char>(data[offset + n])) << (CHAR_BIT * (word - 1 - n));
+	}
+	return result;
+}
+
+// key_at(data, size, 0) for a string that has storage for at least 8
+// characters, even if it is shorter than that. This loads the whole word and
+// then clears the characters past the size, whatever they are, so there is no
+// loop and no branch on the size.
+constexpr std::uint64_t prefix_key(char const * const data, std::size_t const size) {
+	if (std::is_constant_evaluated()) {
+		return key_at(data, size, 0);
+	}
+	auto const bits = CHAR_BIT * std::min(size, sizeof(std::uint64_t));
+	auto const mask = bits == 0 ? std::uint64_t(0) : ~std::uint64_t(0) << (64 - bits);
+	return load_big_endian(data) & mask;
+}
+
+namespace clang {
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	static constexpr std::size_t small_buffer_capacity = 23;
+
+	struct small_t {
+		char data[small_buffer_capacity] = {};
+	};
+	struct [[gnu::packed]] large_t {
+		static constexpr std::size_t bytes_remaining = 7;
+
+		template<typename It>
+		class range_view {
+		public:
+			constexpr range_view(It first, It last):
+				first_(first),
+				last_(last)
+			{
+			}
+			constexpr auto begin() const {
+				return first_;
+			}
+			constexpr auto end() const {
+				return last_;
+			}
+		private:
+			It first_;
+			It last_;
+		};
+
+		constexpr auto little_endian_capacity() const {
+			return range_view(
+				std::rbegin(rest_of_capacity),
+				std::rend(rest_of_capacity)
+			);
+		}
+		constexpr auto big_endian_capacity() {
+			return range_view(
+				std::begin(rest_of_capacity),
+				std::end(rest_of_capacity)
+			);
+		}
+
+		constexpr large_t(std::size_t set_size, std::size_t capacity, char * pointer) noexcept:
+			rest_of_capacity{},
+			size(set_size),
+			data(pointer)
+		{
+			assert(data != nullptr);
+			for (unsigned char & byte : big_endian_capacity()) {
+				capacity >>= CHAR_BIT;
+				byte = capacity;
+			}
+		}
+
+		unsigned char rest_of_capacity[bytes_remaining];
+		std::size_t size;
+		char * data;
+	};
+
+	[[no_unique_address]] allocator_type allocator_;
+	unsigned char size_or_first_byte_of_capacity_;
+	union U {
+		constexpr U() noexcept:
+			small{}
+		{
+		}
+		explicit constexpr U(std::size_t size, std::size_t capacity, char * data) noexcept:
+			large(size, capacity, data)
+		{
+		}
+		constexpr U(large_t set_large) noexcept:
+			large(set_large)
+		{
+		}
+
+		small_t small;
+		large_t large;
+	} u_;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return size_or_first_byte_of_capacity_ & 1;
+	}
+
+	constexpr void increment_size() {
+		if (is_large()) {
+			++u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ += (1 << 1);
+		}
+	}
+	constexpr void set_size(std::size_t const new_size) {
+		if (is_large()) {
+			u_.large.size = new_size;
+		} else {
+			size_or_first_byte_of_capacity_ = static_cast<unsigned char>(new_size << 1);
+		}
+	}
+	constexpr void decrement_size() {
+		if (is_large()) {
+			--u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ -= (1 << 1);
+		}
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, u_.large.data, capacity());
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(size(), new_capacity, new_data);
+		assert(new_capacity & 1);
+		size_or_first_byte_of_capacity_ = new_capacity;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		new_capacity |= 1;
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy_characters(alloc, data(), data() + size(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		size_or_first_byte_of_capacity_(0),
+		u_{}
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.large);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+
+			other.u_ = U{};
+			other.size_or_first_byte_of_capacity_ = 0;
+		} else {
+			auto & osmall = other.u_.small;
+			u_ = U{};
+			copy(osmall.data, osmall.data + (other.size_or_first_byte_of_capacity_ >> 1), u_.small.data);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr char * data() {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr std::size_t size() const {
+		return is_large() ? u_.large.size : (size_or_first_byte_of_capacity_ >> 1);
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		if (!is_large()) {
+			return small_buffer_capacity;
+		}
+		// The bytes after the first are the rest of the capacity in
+		// little-endian order, so on a little-endian target this is one load
+		// instead of a loop. append_and_overwrite checks the capacity for
+		// every number.
+		if (!std::is_constant_evaluated() and std::endian::native == std::endian::little) {
+			auto rest = std::size_t(0);
+			std::memcpy(&rest, u_.large.rest_of_capacity, large_t::bytes_remaining);
+			return (rest << CHAR_BIT) | size_or_first_byte_of_capacity_;
+		}
+		std::size_t result = 0;
+		for (unsigned char const byte : u_.large.little_endian_capacity()) {
+			result |= byte;
+			result <<= CHAR_BIT;
+		}
+		result |= size_or_first_byte_of_capacity_;
+		return result;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		auto const local_size = size();
+		if (is_large() && capacity() > (local_size | 1)) {
+			if (local_size > small_buffer_capacity) {
+				force_reserve(local_size);
+			} else {
+				auto const data = u_.large.data;
+				auto const original_capacity = capacity();
+				u_ = U{};
+				size_or_first_byte_of_capacity_ = local_size << 1;
+				copy(data, data + local_size, u_.small.data);
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = std::prev(end());
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = (capacity() * growth_factor) | 1;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+
+			relocate(temp, new_capacity);
+		}
+		increment_size();
+		return begin() + offset;
+	}
+
+	// Range append, which the proposal leaves out for brevity. A reallocation
+	// at least doubles the capacity, like insert, and copies the old
+	// characters and the new ones straight into place. That also makes it
+	// safe to append part of the string to itself.
+	constexpr void append(char const * const first, char const * const last) {
+		auto const new_size = size() + static_cast<std::size_t>(last - first);
+		auto alloc = get_allocator();
+		if (new_size <= capacity()) {
+			copy_characters(alloc, first, last, end());
+		} else {
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = std::max(new_size, capacity() * growth_factor) | 1;
+			char * temp = Alloc::allocate(alloc, new_capacity);
+			copy_characters(alloc, first, last, copy_characters(alloc, data(), data() + size(), temp));
+			relocate(temp, new_capacity);
+		}
+		set_size(new_size);
+	}
+
+	// Makes room for up to max_count more characters, then operation writes
+	// characters starting at the end and returns where it stopped. This is
+	// like resize_and_overwrite, except that it keeps what is already there.
+	template<typename Operation>
+	constexpr void append_and_overwrite(std::size_t const max_count, Operation operation) {
+		auto const required = size() + max_count;
+		if (required > capacity()) {
+			constexpr auto growth_factor = std::size_t{2};
+			force_reserve(std::max(required, capacity() * growth_factor));
+		}
+		char * const last = operation(end());
+		set_size(static_cast<std::size_t>(last - begin()));
+	}
+
+	// The first 8 characters, as prefix_key reads them. The small buffer holds
+	// 23 characters and an allocation holds more than that, so there is
+	// always a whole word to load.
+	constexpr std::uint64_t prefix_key() const {
+		if (is_large()) {
+			return ::prefix_key(u_.large.data, u_.large.size);
+		}
+		return ::prefix_key(u_.small.data, size_or_first_byte_of_capacity_ >> 1);
+	}
+
+	constexpr void pop_back() {
+		decrement_size();
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace clang
+
+namespace gcc {
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	[[no_unique_address]] allocator_type allocator_;
+	// This could be set to 8 to reduce the size of our string to 24 bytes
+	// (just like clang), but 7 characters (plus a null terminator) is likely
+	// too small of a buffer for most users.
+	static constexpr std::size_t small_buffer_capacity = 16;
+	union U{
+		constexpr U():
+			buffer{}
+		{
+		}
+		constexpr U(std::size_t c):
+			capacity(c)
+		{
+		}
+
+		char buffer[small_buffer_capacity];
+		std::size_t capacity;
+	} u_;
+	char * data_;
+	std::size_t size_ : 63;
+	// gcc and MSVC do not allow accessing the inactive member of a union just
+	// to get its address, so we use a bitfield to work around this.
+	bool is_large_ : 1;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return is_large_;
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, data_, u_.capacity);
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(new_capacity);
+		data_ = new_data;
+		is_large_ = true;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy_characters(alloc, data(), data() + size(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_{},
+		data_(u_.buffer),
+		size_(0),
+		is_large_(false)
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.capacity);
+			other.u_ = U{};
+		
+			data_ = other.data_;
+			other.data_ = other.u_.buffer;
+		
+			size_ = other.size_;
+			other.size_ = 0U;
+		
+			is_large_ = true;
+			other.is_large_ = false;
+
+		} else {
+			u_ = U{};
+			copy(other.data_, other.data_ + other.size_, u_.buffer);
+			data_ = u_.buffer;
+			size_ = other.size_;
+			is_large_ = false;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return data_;
+	}
+	constexpr char * data() {
+		return data_;
+	}
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		return is_large() ? u_.capacity : small_buffer_capacity;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		if (is_large() && capacity() > size()) {
+			if (size() > small_buffer_capacity) {
+				force_reserve(size());
+			} else {
+				auto const data = data_;
+				auto const original_capacity = u_.capacity;
+				u_ = U{};
+				copy(data, data + size_, u_.buffer);
+				data_ = u_.buffer;
+				is_large_ = false;
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = end() - 1;
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = capacity() * growth_factor;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+		
+			relocate(temp, new_capacity);
+		}
+		++size_;
+		return begin() + offset;
+	}
+
+	// Range append, which the proposal leaves out for brevity. A reallocation
+	// at least doubles the capacity, like insert, and copies the old
+	// characters and the new ones straight into place. That also makes it
+	// safe to append part of the string to itself.
+	constexpr void append(char const * const first, char const * const last) {
+		auto const new_size = size() + static_cast<std::size_t>(last - first);
+		auto alloc = get_allocator();
+		if (new_size <= capacity()) {
+			copy_characters(alloc, first, last, end());
+		} else {
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = std::max(new_size, capacity() * growth_factor);
+			char * temp = Alloc::allocate(alloc, new_capacity);
+			copy_characters(alloc, first, last, copy_characters(alloc, data(), data() + size(), temp));
+			relocate(temp, new_capacity);
+		}
+		size_ = new_size;
+	}
+
+	// Makes room for up to max_count more characters, then operation writes
+	// characters starting at the end and returns where it stopped. This is
+	// like resize_and_overwrite, except that it keeps what is already there.
+	template<typename Operation>
+	constexpr void append_and_overwrite(std::size_t const max_count, Operation operation) {
+		auto const required = size() + max_count;
+		if (required > capacity()) {
+			constexpr auto growth_factor = std::size_t{2};
+			force_reserve(std::max(required, capacity() * growth_factor));
+		}
+		char * const last = operation(end());
+		size_ = static_cast<std::size_t>(last - begin());
+	}
+
+	// The first 8 characters, as prefix_key reads them. data_ points to the
+	// small buffer of 16 characters or to an allocation of more than that,
+	// so there is always a whole word to load.
+	constexpr std::uint64_t prefix_key() const {
+		return ::prefix_key(data_, size_);
+	}
+
+	constexpr void pop_back() {
+		--size_;
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace gcc
+
+template<typename T>
+constexpr bool is_prototype_string = false;
+template<typename Allocator>
+constexpr bool is_prototype_string<clang::string<Allocator>> = true;
+template<typename Allocator>
+constexpr bool is_prototype_string<gcc::string<Allocator>> = true;
+
+template<typename T>
+concept prototype_string = is_prototype_string<T>;
+
+// Whether moving an object to a new address, and not destroying it at the
+// old one, is the same as copying its bytes. The clang layout has no pointer
+// into itself, so it can be relocated whenever its allocator can. The gcc
+// layout points into its own small buffer, so it cannot.
+template<typename T>
+constexpr bool is_trivially_relocatable = std::is_trivially_copyable_v<T>;
+// std::allocator has no state, but libstdc++ gives it a user-provided copy
+// constructor and destructor, so it is not trivially copyable
+template<typename T>
+constexpr bool is_trivially_relocatable<std::allocator<T>> = true;
+template<typename Allocator>
+constexpr bool is_trivially_relocatable<clang::string<Allocator>> = is_trivially_relocatable<Allocator>;
+
+// The key is the 8 characters of the string at the current depth, and index
+// is where the string is in the range being sorted.
+struct sort_entry {
+	std::uint64_t key;
+	std::size_t index;
+};
+
+// A stable least-significant-byte radix sort on the keys, using scratch as
+// the other buffer. It counts all 8 bytes in one pass, and skips any byte
+// that is the same in every key. Short strings are 0 in their low bytes, so
+// sorting strings of up to 4 characters usually takes 4 passes, not 8.
+constexpr void radix_sort(std::span<sort_entry> const entries, std::span<sort_entry> const scratch) {
+	constexpr auto radix = std::size_t(1) << CHAR_BIT;
+	auto counts = std::array<std::array<std::size_t, radix>, sizeof(std::uint64_t)>();
+	for (auto const entry : entries) {
+		for (std::size_t byte = 0; byte != sizeof(std::uint64_t); ++byte) {
+			++counts[byte][(entry.key >> (CHAR_BIT * byte)) % radix];
+		}
+	}
+	auto source = entries;
+	auto destination = scratch;
+	for (std::size_t byte = 0; byte != sizeof(std::uint64_t); ++byte) {
+		auto const shift = CHAR_BIT * byte;
+		auto & count = counts[byte];
+		if (count[(source.front().key >> shift) % radix] == source.size()) {
+			continue;
+		}
+		auto offset = std::size_t(0);
+		for (auto & bucket : count) {
+			offset += std::exchange(bucket, offset);
+		}
+		for (auto const entry : source) {
+			destination[count[(entry.key >> shift) % radix]++] = entry;
+		}
+		std::swap(source, destination);
+	}
+	if (source.data() != entries.data()) {
+		std::ranges::copy(source, entries.begin());
+	}
+}
+
+// Groups of at most this many strings are sorted by std::sort, which beats
+// counting 2048 buckets
+constexpr auto radix_sort_threshold = std::size_t(64);
+
+template<typename String>
+constexpr std::uint64_t key_at(String const & str, std::size_t const depth) {
+	return key_at(str.data(), str.size(), depth);
+}
+
+// For two strings that have the same characters up to depth + 8, with 0 for
+// any past the end. If one of them ends before depth + 8, it is a prefix of
+// the other, so the shorter one is first.
+template<typename String>
+constexpr bool tie_less(String const & lhs, String const & rhs, std::size_t const depth) {
+	auto const next = depth + sizeof(std::uint64_t);
+	if (lhs.size() < next or rhs.size() < next) {
+		return lhs.size() < rhs.size();
+	}
+	return std::string_view(lhs.data() + next, lhs.size() - next) < std::string_view(rhs.data() + next, rhs.size() - next);
+}
+
+// Each level of recursion handles 8 more characters of a shared prefix. Past
+// this many, a group is sorted by comparing the rest of the strings instead,
+// so that strings with a very long shared prefix cannot overflow the stack.
+constexpr auto max_radix_depth = std::size_t(32) * sizeof(std::uint64_t);
+
+// Every string in entries has at least depth characters and they all have
+// the same first depth characters. Each key is already set to the characters
+// from depth.
+template<typename String>
+constexpr void sort_entries(std::span<String const> const strings, std::span<sort_entry> const entries, std::span<sort_entry> const scratch, std::size_t const depth) {
+	if (entries.size() <= radix_sort_threshold or depth >= max_radix_depth) {
+		std::sort(entries.begin(), entries.end(), [=](sort_entry const lhs, sort_entry const rhs) {
+			return lhs.key != rhs.key ?
+				lhs.key < rhs.key :
+				tie_less(strings[lhs.index], strings[rhs.index], depth);
+		});
+		return;
+	}
+	radix_sort(entries, scratch);
+	auto const next = depth + sizeof(std::uint64_t);
+	for (auto first = entries.begin(); first != entries.end();) {
+		auto const last = std::find_if(first + 1, entries.end(), [=](sort_entry const entry) {
+			return entry.key != first->key;
+		});
+		if (last - first > 1) {
+			// Strings that end before the next depth are prefixes of the rest,
+			// so they go first, shortest first
+			auto const middle = std::partition(first, last, [=](sort_entry const entry) {
+				return strings[entry.index].size() < next;
+			});
+			std::sort(first, middle, [=](sort_entry const lhs, sort_entry const rhs) {
+				return strings[lhs.index].size() < strings[rhs.index].size();
+			});
+			if (last - middle > 1) {
+				for (auto & entry : std::span(middle, last)) {
+					entry.key = key_at(strings[entry.index], next);
+				}
+				auto const offset = static_cast<std::size_t>(middle - entries.begin());
+				auto const count = static_cast<std::size_t>(last - middle);
+				sort_entries(strings, entries.subspan(offset, count), scratch.subspan(offset, count), next);
+			}
+		}
+		first = last;
+	}
+}
+
+// Moves the string at entries[n].index to position n. Going through a buffer
+// reads the strings in a random order but independently of each other, and
+// writes them in order. Following the cycles of the permutation in place
+// would not need the buffer, but then every step waits on two cache misses
+// from the step before, which made it three times slower.
+template<typename String>
+constexpr void permute(std::span<String> const strings, std::span<sort_entry const> const entries) {
+	if (is_trivially_relocatable<String> and !std::is_constant_evaluated()) {
+		auto alloc = std::allocator<String>();
+		auto const buffer = alloc.allocate(strings.size());
+		for (std::size_t n = 0; n != entries.size(); ++n) {
+			std::memcpy(static_cast<void *>(buffer + n), std::addressof(strings[entries[n].index]), sizeof(String));
+		}
+		// Every string is in buffer exactly once, so this relocates them back
+		// without destroying anything
+		std::memcpy(static_cast<void *>(strings.data()), buffer, strings.size() * sizeof(String));
+		alloc.deallocate(buffer, strings.size());
+	} else {
+		auto sorted = std::vector<String>();
+		sorted.reserve(strings.size());
+		for (auto const entry : entries) {
+			sorted.push_back(std::move(strings[entry.index]));
+		}
+		std::ranges::move(sorted, strings.begin());
+	}
+}
+
+// Sorts strings in the order of std::string_view's operator<, which compares
+// characters as unsigned char. Equal strings may end up in any order, as with
+// std::sort. This allocates two arrays of 16 bytes per string, and then a
+// buffer for the strings once the second array is freed.
+template<std::ranges::contiguous_range Range> requires prototype_string<std::ranges::range_value_t<Range>>
+constexpr void sort_strings(Range && range) {
+	using String = std::ranges::range_value_t<Range>;
+	auto const strings = std::span<String>(std::ranges::data(range), std::ranges::size(range));
+	if (strings.size() < 2) {
+		return;
+	}
+	auto entries = std::vector<sort_entry>(strings.size());
+	for (std::size_t n = 0; n != strings.size(); ++n) {
+		entries[n] = sort_entry(strings[n].prefix_key(), n);
+	}
+	{
+		auto scratch = std::vector<sort_entry>(entries.size());
+		sort_entries(std::span<String const>(strings), std::span(entries), std::span(scratch), 0);
+	}
+	permute(strings, std::span<sort_entry const>(entries));
+}
+
+
+template<typename String>
+constexpr String make_string(std::string_view const source) {
+	auto result = String(typename String::allocator_type());
+	result.append(source.data(), source.data() + source.size());
+	return result;
+}
+
+constexpr std::string_view as_view(auto const & str) {
+	return std::string_view(str.data(), str.size());
+}
+
+template<typename String>
+constexpr bool is_sorted(std::vector<String> const & strings) {
+	return std::ranges::is_sorted(strings, std::less(), [](String const & str) { return as_view(str); });
+}
+
+// Sorts the strings and checks that they match what std::sort gives for the
+// same ones as std::string_view
+template<typename String>
+constexpr bool sorts_like_std_sort(std::vector<String> strings) {
+	auto expected = std::vector<std::string>();
+	for (auto const & str : strings) {
+		expected.emplace_back(as_view(str));
+	}
+	std::ranges::sort(expected);
+	sort_strings(strings);
+	return std::ranges::equal(strings, expected, std::equal_to(), as_view<String>, [](std::string const & str) { return std::string_view(str); });
+}
+
+template<typename String>
+constexpr void test_layout() {
+	auto const make = [](std::initializer_list<std::string_view> const sources) {
+		auto result = std::vector<String>();
+		for (auto const source : sources) {
+			result.push_back(make_string<String>(source));
+		}
+		return result;
+	};
+	assert(sorts_like_std_sort(make({})));
+	assert(sorts_like_std_sort(make({"only"})));
+	assert(sorts_like_std_sort(make({"pear", "apple", "fig", "banana", "apple", ""})));
+	// Prefixes, embedded 0, and characters that are negative as char
+	using namespace std::string_view_literals;
+	assert(sorts_like_std_sort(make({"ab", "a", "a\0"sv, "a\0\0"sv, "\xff", "", "\x80z", "a\0b"sv})));
+	// The same first 8 characters, and then the same first 16
+	assert(sorts_like_std_sort(make({
+		"customer:0042",
+		"customer:0041",
+		"customer",
+		"customer:",
+		"customer:0041:billing:address",
+		"customer:0041:billing:account",
+		"customer:0041:billing",
+		"customers",
+	})));
+
+	// More than the threshold, all with a common prefix, so that it radix
+	// sorts at more than one depth
+	auto many = std::vector<String>();
+	for (std::size_t n = 0; n != 3 * radix_sort_threshold; ++n) {
+		auto str = make_string<String>("/usr/share/doc/");
+		auto const value = (n * 37) % 101;
+		str.insert(str.end(), static_cast<char>('a' + value % 26));
+		str.insert(str.end(), static_cast<char>('a' + value / 26));
+		many.push_back(std::move(str));
+	}
+	assert(sorts_like_std_sort(std::move(many)));
+
+	// pop_back leaves the old characters in the small buffer, and the key
+	// must not include them
+	auto popped = make({"az", "ay", "a"});
+	for (auto & str : popped) {
+		str.insert(str.end(), 'z');
+		str.pop_back();
+	}
+	popped[0].pop_back();
+	assert(sorts_like_std_sort(std::move(popped)));
+}
+
+constexpr bool test() {
+	using allocator_type = std::allocator<char>;
+	test_layout<clang::string<allocator_type>>();
+	test_layout<gcc::string<allocator_type>>();
+
+	assert(key_at("abcdefghij", 10, 0) == 0x6162636465666768);
+	assert(key_at("abcdefghij", 10, 8) == 0x696a000000000000);
+	assert(key_at("\xff", 1, 0) == 0xff00000000000000);
+	return true;
+}
+
+static_assert(is_trivially_relocatable<clang::string<std::allocator<char>>>);
+static_assert(!is_trivially_relocatable<gcc::string<std::allocator<char>>>);
+
+// Random strings from a small alphabet, so that many of them are equal or
+// prefixes of each other, and some of them long enough to be allocated
+template<typename String>
+std::vector<String> random_strings(std::mt19937_64 & engine, std::size_t const count) {
+	constexpr char alphabet[] = {'\0', 'a', 'b', '\x7f', '\x80', '\xff'};
+	auto const max_size = engine() % 40 + 1;
+	auto const shared = std::string(engine() % 20, 'p');
+	auto result = std::vector<String>();
+	for (std::size_t n = 0; n != count; ++n) {
+		auto str = make_string<String>(engine() % 2 == 0 ? std::string_view(shared) : "");
+		for (auto size = engine() % max_size; size != 0; --size) {
+			str.insert(str.end(), alphabet[engine() % std::size(alphabet)]);
+		}
+		if (engine() % 8 == 0 and str.size() != 0) {
+			str.pop_back();
+		}
+		result.push_back(std::move(str));
+	}
+	return result;
+}
+
+void test_against_std_sort() {
+	auto engine = std::mt19937_64(1);
+	for (int n = 0; n != 2'000; ++n) {
+		auto const count = static_cast<std::size_t>(engine() % 1000);
+		assert(sorts_like_std_sort(random_strings<clang::string<std::allocator<char>>>(engine, count)));
+		assert(sorts_like_std_sort(random_strings<gcc::string<std::allocator<char>>>(engine, count)));
+	}
+
+	// Enough shared prefix to overflow the stack with one level of recursion
+	// per 8 characters
+	auto const prefix = std::string(1'000'000, 'p');
+	auto long_strings = std::vector<clang::string<std::allocator<char>>>();
+	for (std::size_t n = 0; n != 100; ++n) {
+		auto str = make_string<clang::string<std::allocator<char>>>(prefix);
+		if (n % 2 == 0) {
+			str.insert(str.end(), static_cast<char>('a' + engine() % 3));
+		}
+		long_strings.push_back(std::move(str));
+	}
+	assert(sorts_like_std_sort(std::move(long_strings)));
+}
+
+template<typename Function>
+double nanoseconds_per_operation(std::size_t const count, Function && function) {
+	auto const start = std::chrono::steady_clock::now();
+	function();
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+}
+
+// Lowercase words of 3 to 12 characters, which all fit in either small buffer
+std::vector<std::string> make_short_keys(std::size_t const count) {
+	auto engine = std::mt19937_64(1);
+	auto result = std::vector<std::string>(count);
+	for (auto & key : result) {
+		for (auto size = engine() % 10 + 3; size != 0; --size) {
+			key += static_cast<char>('a' + engine() % 26);
+		}
+	}
+	return result;
+}
+
+// Keys like "user:0000123456:session", which share their first 8 characters
+std::vector<std::string> make_prefixed_keys(std::size_t const count) {
+	auto engine = std::mt19937_64(1);
+	constexpr std::string_view suffixes[] = {"", ":session", ":profile", ":settings:notifications"};
+	auto result = std::vector<std::string>(count);
+	for (auto & key : result) {
+		auto digits = std::to_string(engine() % 10'000'000'000);
+		key = "user:" + std::string(10 - digits.size(), '0') + digits;
+		key += suffixes[engine() % std::size(suffixes)];
+	}
+	return result;
+}
+
+template<typename String>
+std::vector<String> convert(std::vector<std::string> const & keys) {
+	auto result = std::vector<String>();
+	result.reserve(keys.size());
+	for (auto const & key : keys) {
+		result.push_back(make_string<String>(key));
+	}
+	return result;
+}
+
+template<typename String, typename Sort>
+void benchmark_one(char const * const name, std::vector<std::string> const & keys, Sort sort) {
+	auto strings = convert<String>(keys);
+	auto const time = nanoseconds_per_operation(strings.size(), [&] {
+		sort(strings);
+	});
+	assert(is_sorted(strings));
+	std::printf("%-44s %14.1f\n", name, time);
+}
+
+void benchmark_keys(char const * const description, std::vector<std::string> const & keys) {
+	auto const by_view = [](auto const & lhs, auto const & rhs) {
+		return as_view(lhs) < as_view(rhs);
+	};
+	std::printf("%-44s %14s\n", description, "ns per string");
+	benchmark_one<std::string>("std::sort: std::string", keys, [](auto & strings) {
+		std::ranges::sort(strings);
+	});
+	benchmark_one<clang::string<std::allocator<char>>>("std::sort: clang layout", keys, [=](auto & strings) {
+		std::ranges::sort(strings, by_view);
+	});
+	benchmark_one<gcc::string<std::allocator<char>>>("std::sort: gcc layout", keys, [=](auto & strings) {
+		std::ranges::sort(strings, by_view);
+	});
+	benchmark_one<clang::string<std::allocator<char>>>("sort_strings: clang layout", keys, [](auto & strings) {
+		sort_strings(strings);
+	});
+	benchmark_one<gcc::string<std::allocator<char>>>("sort_strings: gcc layout", keys, [](auto & strings) {
+		sort_strings(strings);
+	});
+	std::printf("\n");
+}
+
+void benchmark() {
+	benchmark_keys("Short keys", make_short_keys(2'000'000));
+	benchmark_keys("Keys with a common prefix", make_prefixed_keys(2'000'000));
+}
+
+int main() {
+	test();
+	static_assert(test());
+	test_against_std_sort();
+	benchmark();
+}
@@ -0,0 +1,1415 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20 and POSIX. The goal of this version is to load a
+// file of millions of strings without reading it.
+//
+// Parsing a file into one std::string per line takes a long time for a large
+// file, and the strings take more memory than the file. A string table file
+// is laid out the same way as string_column from string-column.cpp: the
+// characters of every string back to back, and an index of where each one
+// starts. A reader maps the file into memory and uses it where it is, so
+// opening a table takes the same time however big it is, and the pages are
+// only read when a string on them is used. The pages belong to the page
+// cache, so every process that maps the same file shares them.
+//
+// string_table_view reads a table from memory and hands out std::string_view,
+// or a string in the external state from string-column.cpp, which copies the
+// characters only when it is changed. string_table_writer streams strings to
+// a file as they are added, and writes the index at the end.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <random>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+
+// Selects the constructor that refers to characters instead of copying them
+struct external_storage_t {
+	explicit external_storage_t() = default;
+};
+inline constexpr auto external_storage = external_storage_t();
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	[[no_unique_address]] allocator_type allocator_;
+	// This could be set to 8 to reduce the size of our string to 24 bytes
+	// (just like clang), but 7 characters (plus a null terminator) is likely
+	// too small of a buffer for most users.
+	static constexpr std::size_t small_buffer_capacity = 16;
+	union U{
+		constexpr U():
+			buffer{}
+		{
+		}
+		constexpr U(std::size_t c):
+			capacity(c)
+		{
+		}
+
+		char buffer[small_buffer_capacity];
+		std::size_t capacity;
+	} u_;
+	char * data_;
+	std::size_t size_ : 63;
+	// gcc and MSVC do not allow accessing the inactive member of a union just
+	// to get its address, so we use a bitfield to work around this.
+	bool is_large_ : 1;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return is_large_;
+	}
+
+	constexpr void deallocate() {
+		if (is_large() and !is_external()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, data_, u_.capacity);
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(new_capacity);
+		data_ = new_data;
+		is_large_ = true;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy(data_, data_ + size_, temp);
+		relocate(temp, new_capacity);
+	}
+
+	constexpr void copy_external_characters() {
+		if (size_ <= small_buffer_capacity) {
+			auto const source = data_;
+			u_ = U{};
+			copy(source, source + size_, u_.buffer);
+			data_ = u_.buffer;
+			is_large_ = false;
+		} else {
+			force_reserve(size_);
+		}
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_{},
+		data_(u_.buffer),
+		size_(0),
+		is_large_(false)
+	{
+	}
+
+	// value must outlive the string and every string it is moved into
+	constexpr string(external_storage_t, std::string_view const value, allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_(0),
+		data_(const_cast<char *>(value.data())),
+		size_(value.size()),
+		is_large_(true)
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.capacity);
+			other.u_ = U{};
+		
+			data_ = other.data_;
+			other.data_ = other.u_.buffer;
+		
+			size_ = other.size_;
+			other.size_ = 0U;
+		
+			is_large_ = true;
+			other.is_large_ = false;
+
+		} else {
+			u_ = U{};
+			copy(other.data_, other.data_ + other.size_, u_.buffer);
+			data_ = u_.buffer;
+			size_ = other.size_;
+			is_large_ = false;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return data_;
+	}
+	// Does not copy the characters of an external string (see detach)
+	constexpr char * data() {
+		return data_;
+	}
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		return is_external() ? size() : is_large() ? u_.capacity : small_buffer_capacity;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		if (is_large() && capacity() > size()) {
+			if (size() > small_buffer_capacity) {
+				force_reserve(size());
+			} else {
+				auto const data = data_;
+				auto const original_capacity = u_.capacity;
+				u_ = U{};
+				copy(data, data + size_, u_.buffer);
+				data_ = u_.buffer;
+				is_large_ = false;
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		// An external string has no spare capacity, so it always takes the
+		// reallocating path, which only reads the external characters.
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = end() - 1;
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = capacity() * growth_factor;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+		
+			relocate(temp, new_capacity);
+		}
+		++size_;
+		return begin() + offset;
+	}
+
+	// A string in the external state refers to characters that it does not
+	// own, such as an element of a string_column. It is marked as large with a
+	// capacity of 0, which no allocation has.
+	constexpr bool is_external() const {
+		return is_large_ and u_.capacity == 0;
+	}
+
+	// Copies the characters of an external string into storage that this
+	// string owns, so that they can be changed through data() or an iterator.
+	// Short strings go in the small buffer. Does nothing to any other string.
+	constexpr void detach() {
+		if (is_external()) {
+			copy_external_characters();
+		}
+	}
+
+	constexpr void pop_back() {
+		detach();
+		--size_;
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+
+template<typename Allocator>
+string(Allocator) -> string<Allocator>;
+
+// Anything with a data() and a size() of characters, such as string,
+// std::string, and std::string_view
+template<typename T>
+concept string_like = requires(T const & value) {
+	{ value.data() } -> std::convertible_to<char const *>;
+	{ value.size() } -> std::convertible_to<std::size_t>;
+};
+
+constexpr std::string_view as_view(string_like auto const & value) {
+	return std::string_view(value.data(), value.size());
+}
+
+// Many strings stored as their characters back to back in one array, and an
+// array of where each one starts, the same as an Arrow string column.
+// Offset is std::uint32_t for up to 4 GiB of characters, which makes the cost
+// of each string 4 bytes on top of its characters, or std::uint64_t for more.
+// Element n is the characters from offsets_[n] to offsets_[n + 1], so there
+// is one more offset than there are strings, and the first is 0.
+//
+// Adding strings can move the characters, which leaves any std::string_view
+// or external string from before that pointing at the old ones.
+template<std::unsigned_integral Offset = std::uint32_t>
+class string_column {
+public:
+	class iterator {
+	public:
+		using value_type = std::string_view;
+		using difference_type = std::ptrdiff_t;
+
+		constexpr iterator() = default;
+		constexpr iterator(char const * const characters, Offset const * const offset):
+			characters_(characters),
+			offset_(offset)
+		{
+		}
+
+		constexpr std::string_view operator*() const {
+			return std::string_view(characters_ + offset_[0], static_cast<std::size_t>(offset_[1] - offset_[0]));
+		}
+		constexpr std::string_view operator[](difference_type const index) const {
+			return *(*this + index);
+		}
+
+		constexpr iterator & operator++() {
+			++offset_;
+			return *this;
+		}
+		constexpr iterator operator++(int) {
+			auto const result = *this;
+			++*this;
+			return result;
+		}
+		constexpr iterator & operator--() {
+			--offset_;
+			return *this;
+		}
+		constexpr iterator operator--(int) {
+			auto const result = *this;
+			--*this;
+			return result;
+		}
+		constexpr iterator & operator+=(difference_type const offset) {
+			offset_ += offset;
+			return *this;
+		}
+		constexpr iterator & operator-=(difference_type const offset) {
+			offset_ -= offset;
+			return *this;
+		}
+		friend constexpr iterator operator+(iterator it, difference_type const offset) {
+			return it += offset;
+		}
+		friend constexpr iterator operator+(difference_type const offset, iterator it) {
+			return it += offset;
+		}
+		friend constexpr iterator operator-(iterator it, difference_type const offset) {
+			return it -= offset;
+		}
+		friend constexpr difference_type operator-(iterator const lhs, iterator const rhs) {
+			return lhs.offset_ - rhs.offset_;
+		}
+
+		friend constexpr bool operator==(iterator const lhs, iterator const rhs) {
+			return lhs.offset_ == rhs.offset_;
+		}
+		friend constexpr auto operator<=>(iterator const lhs, iterator const rhs) {
+			return lhs.offset_ <=> rhs.offset_;
+		}
+
+	private:
+		char const * characters_ = nullptr;
+		Offset const * offset_ = nullptr;
+	};
+	using const_iterator = iterator;
+
+	constexpr string_column():
+		offsets_(1, Offset(0))
+	{
+	}
+
+	constexpr std::size_t size() const {
+		return offsets_.size() - 1;
+	}
+	constexpr bool empty() const {
+		return size() == 0;
+	}
+	// All of the characters, with no separators between strings
+	constexpr std::string_view characters() const {
+		return std::string_view(characters_.data(), characters_.size());
+	}
+
+	constexpr std::string_view operator[](std::size_t const index) const {
+		assert(index < size());
+		auto const first = static_cast<std::size_t>(offsets_[index]);
+		auto const last = static_cast<std::size_t>(offsets_[index + 1]);
+		return std::string_view(characters_.data() + first, last - first);
+	}
+
+	// A string that refers to the characters in the column, and copies them
+	// only when it is changed
+	template<typename Allocator = std::allocator<char>>
+	constexpr string<Allocator> as_string(std::size_t const index, Allocator alloc = Allocator()) const {
+		return string<Allocator>(external_storage, (*this)[index], alloc);
+	}
+
+	constexpr iterator begin() const {
+		return iterator(characters_.data(), offsets_.data());
+	}
+	constexpr iterator end() const {
+		return iterator(characters_.data(), offsets_.data() + size());
+	}
+
+	constexpr void reserve(std::size_t const string_count, std::size_t const character_count) {
+		offsets_.reserve(string_count + 1);
+		characters_.reserve(character_count);
+	}
+
+	// If this throws, the column is unchanged. value can be an element of
+	// this column, which is copied before the characters can move.
+	constexpr void push_back(string_like auto const & value) {
+		auto const view = as_view(value);
+		if (contains_characters(view)) {
+			auto const copy = std::vector<char>(view.begin(), view.end());
+			push_back(std::string_view(copy.data(), copy.size()));
+			return;
+		}
+		auto const offset = next_offset(view.size());
+		// Growing offsets_ is the only thing after changing characters_ that
+		// could throw, so it is done first.
+		if (offsets_.size() == offsets_.capacity()) {
+			offsets_.reserve(2 * offsets_.size());
+		}
+		characters_.insert(characters_.end(), view.begin(), view.end());
+		offsets_.push_back(offset);
+	}
+
+	// Adds every string in range. For a forward range this adds up the sizes
+	// first, so that each array grows at most once.
+	template<std::ranges::input_range Range> requires string_like<std::ranges::range_value_t<Range>>
+	constexpr void append_range(Range && range) {
+		if constexpr (std::ranges::forward_range<Range>) {
+			auto string_count = std::size_t(0);
+			auto character_count = std::size_t(0);
+			for (auto const & value : range) {
+				++string_count;
+				character_count += value.size();
+			}
+			reserve(size() + string_count, characters_.size() + character_count);
+		}
+		for (auto const & value : range) {
+			push_back(value);
+		}
+	}
+
+	// What the column holds in memory, not counting the capacity that it has
+	// not used
+	constexpr std::size_t bytes_used() const {
+		return characters_.size() + offsets_.size() * sizeof(Offset);
+	}
+
+private:
+	// Comparing pointers into different objects with < is unspecified, and not
+	// allowed in constant evaluation, where this compares the start of view
+	// with each character instead.
+	constexpr bool contains_characters(std::string_view const view) const {
+		if (view.empty()) {
+			return false;
+		}
+		auto const first = characters_.data();
+		auto const last = first + characters_.size();
+		if (std::is_constant_evaluated()) {
+			for (auto it = first; it != last; ++it) {
+				if (it == view.data()) {
+					return true;
+				}
+			}
+			return false;
+		}
+		return std::less<>()(view.data(), last) and std::less<>()(first, view.data() + view.size());
+	}
+
+	// Where the next string ends, if it has size characters. Like
+	// std::vector, this throws std::length_error if that does not fit.
+	constexpr Offset next_offset(std::size_t const size) const {
+		if (size > std::numeric_limits<Offset>::max() - characters_.size()) {
+			throw std::length_error("string_column: too many characters for the offset type");
+		}
+		return static_cast<Offset>(characters_.size() + size);
+	}
+
+	std::vector<char> characters_;
+	std::vector<Offset> offsets_;
+};
+
+static_assert(std::random_access_iterator<string_column<>::iterator>);
+static_assert(std::ranges::random_access_range<string_column<> const>);
+
+
+// On a little-endian machine, this is one load at run time
+template<std::unsigned_integral T>
+constexpr T load_little_endian(char const * const ptr) {
+	auto result = T(0);
+	if (!std::is_constant_evaluated() and std::endian::native == std::endian::little) {
+		std::memcpy(&result, ptr, sizeof(result));
+		return result;
+	}
+	for (std::size_t n = 0; n != sizeof(T); ++n) {
+		result |= static_cast<T>(static_cast<unsigned char>(ptr[n])) << (CHAR_BIT * n);
+	}
+	return result;
+}
+
+template<std::unsigned_integral T>
+constexpr void store_little_endian(char * const ptr, T const value) {
+	for (std::size_t n = 0; n != sizeof(T); ++n) {
+		ptr[n] = static_cast<char>(static_cast<unsigned char>(value >> (CHAR_BIT * n)));
+	}
+}
+
+// The layout of a string table file. Every number is little-endian.
+//
+//   header   magic, version, offset_size, string_count, data_offset,
+//            data_size, index_offset
+//   data     the characters of every string, back to back
+//   index    string_count + 1 offsets into data, each offset_size bytes
+//
+// Element n is the characters in data from index[n] to index[n + 1]. The
+// index comes after the data so that a writer can stream the strings out
+// before it knows how many there are, or whether 4 byte offsets are enough.
+// The data starts at a multiple of the alignment the writer was given, and
+// the index at a multiple of that and of offset_size, so a reader that maps
+// the file can use both where they are.
+struct string_table_header {
+	static constexpr auto magic = std::string_view("strtable");
+	static constexpr auto current_version = std::uint32_t(1);
+	static constexpr auto size = std::size_t(48);
+
+	std::uint32_t version = current_version;
+	std::uint32_t offset_size = 0;
+	std::uint64_t string_count = 0;
+	std::uint64_t data_offset = 0;
+	std::uint64_t data_size = 0;
+	std::uint64_t index_offset = 0;
+};
+
+constexpr std::array<char, string_table_header::size> encode(string_table_header const header) {
+	auto result = std::array<char, string_table_header::size>();
+	std::ranges::copy(string_table_header::magic, result.data());
+	store_little_endian(result.data() + 8, header.version);
+	store_little_endian(result.data() + 12, header.offset_size);
+	store_little_endian(result.data() + 16, header.string_count);
+	store_little_endian(result.data() + 24, header.data_offset);
+	store_little_endian(result.data() + 32, header.data_size);
+	store_little_endian(result.data() + 40, header.index_offset);
+	return result;
+}
+
+// Checks that everything the header points to is inside of file, but does
+// not look at the data or the index
+constexpr string_table_header decode_header(std::string_view const file) {
+	if (file.size() < string_table_header::size or !file.starts_with(string_table_header::magic)) {
+		throw std::runtime_error("string table: not a string table");
+	}
+	auto const header = string_table_header(
+		load_little_endian<std::uint32_t>(file.data() + 8),
+		load_little_endian<std::uint32_t>(file.data() + 12),
+		load_little_endian<std::uint64_t>(file.data() + 16),
+		load_little_endian<std::uint64_t>(file.data() + 24),
+		load_little_endian<std::uint64_t>(file.data() + 32),
+		load_little_endian<std::uint64_t>(file.data() + 40)
+	);
+	if (header.version != string_table_header::current_version) {
+		throw std::runtime_error("string table: unsupported version");
+	}
+	if (header.offset_size != 4 and header.offset_size != 8) {
+		throw std::runtime_error("string table: offsets must be 4 or 8 bytes");
+	}
+	auto const fits = [=](std::uint64_t const offset, std::uint64_t const size) {
+		return offset <= file.size() and size <= file.size() - offset;
+	};
+	auto const max_strings = (file.size() - std::min<std::uint64_t>(header.index_offset, file.size())) / header.offset_size;
+	if (!fits(header.data_offset, header.data_size) or header.index_offset % header.offset_size != 0 or header.string_count >= max_strings) {
+		throw std::runtime_error("string table: truncated");
+	}
+	return header;
+}
+
+// The strings in a string table that is already in memory. Nothing is
+// copied: every string_view and external string points into file.
+//
+// Opening a table reads the header and the first and last offset, so that it
+// costs the same however many strings there are. The offsets in between are
+// not checked unless you call offsets_are_valid.
+class string_table_view {
+public:
+	class iterator {
+	public:
+		using value_type = std::string_view;
+		using difference_type = std::ptrdiff_t;
+
+		constexpr iterator() = default;
+		constexpr iterator(string_table_view const & table, std::size_t const index):
+			table_(&table),
+			index_(index)
+		{
+		}
+
+		constexpr std::string_view operator*() const {
+			return (*table_)[index_];
+		}
+		constexpr std::string_view operator[](difference_type const index) const {
+			return *(*this + index);
+		}
+
+		constexpr iterator & operator++() {
+			++index_;
+			return *this;
+		}
+		constexpr iterator operator++(int) {
+			auto const result = *this;
+			++*this;
+			return result;
+		}
+		constexpr iterator & operator--() {
+			--index_;
+			return *this;
+		}
+		constexpr iterator operator--(int) {
+			auto const result = *this;
+			--*this;
+			return result;
+		}
+		constexpr iterator & operator+=(difference_type const offset) {
+			index_ += static_cast<std::size_t>(offset);
+			return *this;
+		}
+		constexpr iterator & operator-=(difference_type const offset) {
+			index_ -= static_cast<std::size_t>(offset);
+			return *this;
+		}
+		friend constexpr iterator operator+(iterator it, difference_type const offset) {
+			return it += offset;
+		}
+		friend constexpr iterator operator+(difference_type const offset, iterator it) {
+			return it += offset;
+		}
+		friend constexpr iterator operator-(iterator it, difference_type const offset) {
+			return it -= offset;
+		}
+		friend constexpr difference_type operator-(iterator const lhs, iterator const rhs) {
+			return static_cast<difference_type>(lhs.index_ - rhs.index_);
+		}
+
+		friend constexpr bool operator==(iterator const lhs, iterator const rhs) {
+			return lhs.index_ == rhs.index_;
+		}
+		friend constexpr auto operator<=>(iterator const lhs, iterator const rhs) {
+			return lhs.index_ <=> rhs.index_;
+		}
+
+	private:
+		string_table_view const * table_ = nullptr;
+		std::size_t index_ = 0;
+	};
+	using const_iterator = iterator;
+
+	constexpr explicit string_table_view(std::string_view const file):
+		header_(decode_header(file)),
+		data_(file.data() + header_.data_offset),
+		index_(file.data() + header_.index_offset)
+	{
+		if (offset(0) != 0 or offset(size()) != header_.data_size) {
+			throw std::runtime_error("string table: the index does not cover the data");
+		}
+	}
+
+	constexpr std::size_t size() const {
+		return static_cast<std::size_t>(header_.string_count);
+	}
+	constexpr bool empty() const {
+		return size() == 0;
+	}
+	constexpr std::string_view characters() const {
+		return std::string_view(data_, static_cast<std::size_t>(header_.data_size));
+	}
+	constexpr string_table_header const & header() const {
+		return header_;
+	}
+
+	constexpr std::string_view operator[](std::size_t const index) const {
+		assert(index < size());
+		auto const first = offset(index);
+		auto const last = offset(index + 1);
+		assert(first <= last and last <= header_.data_size);
+		return std::string_view(data_ + first, static_cast<std::size_t>(last - first));
+	}
+
+	// A string that refers to the characters in the table, and copies them
+	// only when it is changed
+	template<typename Allocator = std::allocator<char>>
+	constexpr string<Allocator> as_string(std::size_t const index, Allocator alloc = Allocator()) const {
+		return string<Allocator>(external_storage, (*this)[index], alloc);
+	}
+
+	constexpr iterator begin() const {
+		return iterator(*this, 0);
+	}
+	constexpr iterator end() const {
+		return iterator(*this, size());
+	}
+
+	// Reads the whole index. A table that passes this can be used without
+	// trusting whoever wrote it.
+	constexpr bool offsets_are_valid() const {
+		auto previous = std::uint64_t(0);
+		for (std::size_t index = 1; index <= size(); ++index) {
+			auto const current = offset(index);
+			if (current < previous) {
+				return false;
+			}
+			previous = current;
+		}
+		return true;
+	}
+
+private:
+	constexpr std::uint64_t offset(std::size_t const index) const {
+		return header_.offset_size == sizeof(std::uint32_t) ?
+			load_little_endian<std::uint32_t>(index_ + index * sizeof(std::uint32_t)) :
+			load_little_endian<std::uint64_t>(index_ + index * sizeof(std::uint64_t));
+	}
+
+	string_table_header header_;
+	char const * data_;
+	char const * index_;
+};
+
+static_assert(std::random_access_iterator<string_table_view::iterator>);
+static_assert(std::ranges::random_access_range<string_table_view const>);
+
+template<typename>
+constexpr auto is_string_column = false;
+
+template<typename Offset>
+constexpr auto is_string_column<string_column<Offset>> = true;
+
+// Where string_table_writer sends its bytes. overwrite is called once, at
+// the end, to fill in the header.
+template<typename T>
+concept string_table_output = requires(T & output, std::string_view const bytes, std::size_t const position) {
+	output.write(bytes);
+	output.overwrite(position, bytes);
+};
+
+// Keeps the table in memory, which is mostly useful for tests
+struct memory_output {
+	constexpr void write(std::string_view const bytes) {
+		contents.insert(contents.end(), bytes.begin(), bytes.end());
+	}
+	constexpr void overwrite(std::size_t const position, std::string_view const bytes) {
+		std::ranges::copy(bytes, contents.begin() + static_cast<std::ptrdiff_t>(position));
+	}
+
+	std::vector<char> contents;
+};
+
+class file_output {
+public:
+	explicit file_output(char const * const path):
+		file_(std::fopen(path, "wb"))
+	{
+		if (!file_) {
+			throw std::system_error(errno, std::generic_category(), path);
+		}
+		// The default buffer of a few KiB means a system call for every few
+		// strings
+		std::setvbuf(file_.get(), nullptr, _IOFBF, 1 << 20);
+	}
+
+	void write(std::string_view const bytes) {
+		if (std::fwrite(bytes.data(), 1, bytes.size(), file_.get()) != bytes.size()) {
+			throw std::system_error(errno, std::generic_category(), "string table: write");
+		}
+	}
+	void overwrite(std::size_t const position, std::string_view const bytes) {
+		if (std::fseek(file_.get(), static_cast<long>(position), SEEK_SET) != 0) {
+			throw std::system_error(errno, std::generic_category(), "string table: seek");
+		}
+		write(bytes);
+	}
+
+	// Unlike the destructor, this reports an error from writing what is still
+	// in the buffer
+	void close() {
+		if (std::fclose(file_.release()) != 0) {
+			throw std::system_error(errno, std::generic_category(), "string table: close");
+		}
+	}
+
+private:
+	struct closer {
+		void operator()(std::FILE * const file) const {
+			std::fclose(file);
+		}
+	};
+	std::unique_ptr<std::FILE, closer> file_;
+};
+
+// Writes the strings as they are added, and keeps only their offsets in
+// memory until finish writes the index and the header.
+template<string_table_output Output>
+class string_table_writer {
+public:
+	// alignment must be a power of 2. Aligning to the page size lets a reader
+	// map the data or the index on their own.
+	constexpr explicit string_table_writer(Output output, std::size_t const alignment = 1):
+		output_(std::move(output)),
+		alignment_(alignment)
+	{
+		assert(std::has_single_bit(alignment));
+		write_padding(string_table_header::size);
+		data_offset_ = align(alignment_);
+		offsets_.push_back(0);
+	}
+
+	constexpr void push_back(string_like auto const & value) {
+		auto const view = as_view(value);
+		output_.write(view);
+		position_ += view.size();
+		offsets_.push_back(offsets_.back() + view.size());
+	}
+
+	// A column already has its characters back to back, so they are written
+	// all at once
+	template<std::ranges::input_range Range> requires string_like<std::ranges::range_value_t<Range>>
+	constexpr void append_range(Range && range) {
+		if constexpr (is_string_column<std::remove_cvref_t<Range>>) {
+			output_.write(range.characters());
+			position_ += range.characters().size();
+			offsets_.reserve(offsets_.size() + range.size());
+			for (auto const value : range) {
+				offsets_.push_back(offsets_.back() + value.size());
+			}
+		} else {
+			for (auto const & value : range) {
+				push_back(value);
+			}
+		}
+	}
+
+	// Writes the index and the header, and gives back the output. Nothing
+	// can be added after this.
+	constexpr Output finish() && {
+		auto const data_size = offsets_.back();
+		auto const offset_size = data_size <= std::numeric_limits<std::uint32_t>::max() ? sizeof(std::uint32_t) : sizeof(std::uint64_t);
+		auto const index_offset = align(std::max(alignment_, offset_size));
+		if (offset_size == sizeof(std::uint32_t)) {
+			write_index<std::uint32_t>();
+		} else {
+			write_index<std::uint64_t>();
+		}
+		auto const header = encode(string_table_header(
+			string_table_header::current_version,
+			static_cast<std::uint32_t>(offset_size),
+			offsets_.size() - 1,
+			data_offset_,
+			data_size,
+			index_offset
+		));
+		output_.overwrite(0, std::string_view(header.data(), header.size()));
+		return std::move(output_);
+	}
+
+private:
+	constexpr void write_padding(std::size_t size) {
+		constexpr auto zeros = std::array<char, 256>();
+		while (size != 0) {
+			auto const count = std::min(size, zeros.size());
+			output_.write(std::string_view(zeros.data(), count));
+			position_ += count;
+			size -= count;
+		}
+	}
+	// Pads to the next multiple of alignment, and returns where that is
+	constexpr std::uint64_t align(std::size_t const alignment) {
+		write_padding((alignment - position_ % alignment) % alignment);
+		return position_;
+	}
+
+	template<typename Offset>
+	constexpr void write_index() {
+		auto buffer = std::array<char, 4096>();
+		auto const per_buffer = buffer.size() / sizeof(Offset);
+		for (std::size_t first = 0; first < offsets_.size(); first += per_buffer) {
+			auto const count = std::min(per_buffer, offsets_.size() - first);
+			for (std::size_t n = 0; n != count; ++n) {
+				store_little_endian(buffer.data() + n * sizeof(Offset), static_cast<Offset>(offsets_[first + n]));
+			}
+			output_.write(std::string_view(buffer.data(), count * sizeof(Offset)));
+			position_ += count * sizeof(Offset);
+		}
+	}
+
+	Output output_;
+	std::size_t alignment_;
+	std::uint64_t position_ = 0;
+	std::uint64_t data_offset_ = 0;
+	std::vector<std::uint64_t> offsets_;
+};
+
+// A whole file mapped read only. Pages are read from the file the first time
+// they are used, and because they are never written, the kernel can drop
+// them when memory is short and read them again later.
+class mapped_file {
+public:
+	explicit mapped_file(char const * const path) {
+		auto const fd = ::open(path, O_RDONLY | O_CLOEXEC);
+		if (fd == -1) {
+			throw std::system_error(errno, std::generic_category(), path);
+		}
+		struct stat status;
+		if (::fstat(fd, &status) != 0) {
+			auto const error = errno;
+			::close(fd);
+			throw std::system_error(error, std::generic_category(), path);
+		}
+		size_ = static_cast<std::size_t>(status.st_size);
+		if (size_ != 0) {
+			auto const address = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (address == MAP_FAILED) {
+				auto const error = errno;
+				::close(fd);
+				throw std::system_error(error, std::generic_category(), path);
+			}
+			data_ = static_cast<char const *>(address);
+		}
+		// The mapping keeps the file open
+		::close(fd);
+	}
+	mapped_file(mapped_file && other) noexcept:
+		data_(std::exchange(other.data_, nullptr)),
+		size_(std::exchange(other.size_, 0))
+	{
+	}
+	mapped_file & operator=(mapped_file && other) noexcept {
+		std::swap(data_, other.data_);
+		std::swap(size_, other.size_);
+		return *this;
+	}
+	~mapped_file() {
+		if (data_) {
+			::munmap(const_cast<char *>(data_), size_);
+		}
+	}
+
+	std::string_view contents() const {
+		return std::string_view(data_, size_);
+	}
+
+private:
+	char const * data_ = nullptr;
+	std::size_t size_ = 0;
+};
+
+// A string table file, mapped into memory. Moving it does not move the
+// mapping, so the strings it hands out stay valid until it is destroyed.
+class string_table {
+public:
+	explicit string_table(char const * const path):
+		file_(path),
+		view_(file_.contents())
+	{
+	}
+
+	string_table_view const & view() const {
+		return view_;
+	}
+	std::size_t size() const {
+		return view_.size();
+	}
+	std::string_view operator[](std::size_t const index) const {
+		return view_[index];
+	}
+	template<typename Allocator = std::allocator<char>>
+	string<Allocator> as_string(std::size_t const index, Allocator alloc = Allocator()) const {
+		return view_.as_string(index, alloc);
+	}
+	auto begin() const {
+		return view_.begin();
+	}
+	auto end() const {
+		return view_.end();
+	}
+
+private:
+	mapped_file file_;
+	string_table_view view_;
+};
+
+template<std::ranges::input_range Range> requires string_like<std::ranges::range_value_t<Range>>
+void write_string_table(char const * const path, Range && range, std::size_t const alignment = 1) {
+	auto writer = string_table_writer(file_output(path), alignment);
+	writer.append_range(std::forward<Range>(range));
+	std::move(writer).finish().close();
+}
+
+
+using allocator_type = std::allocator<char>;
+
+constexpr auto make_string(std::string_view const value) {
+	auto result = string(allocator_type());
+	for (auto const c : value) {
+		result.insert(result.end(), c);
+	}
+	return result;
+}
+
+constexpr bool matches(string_table_view const & table, std::vector<std::string_view> const & expected) {
+	if (table.size() != expected.size() or !std::ranges::equal(table, expected) or !table.offsets_are_valid()) {
+		return false;
+	}
+	for (std::size_t n = 0; n != expected.size(); ++n) {
+		if (table[n] != expected[n] or table.begin()[static_cast<std::ptrdiff_t>(n)] != expected[n]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// A table with 8 byte offsets, which the writer only uses for more than
+// 4 GiB of characters
+constexpr std::string make_wide_table() {
+	auto result = std::string(string_table_header::size, '\0');
+	result += "onetwo";
+	result.resize(64, '\0');
+	for (std::uint64_t const offset : {0, 3, 3, 6}) {
+		auto bytes = std::array<char, sizeof(std::uint64_t)>();
+		store_little_endian(bytes.data(), offset);
+		result.append(bytes.data(), bytes.size());
+	}
+	auto const header = encode(string_table_header(string_table_header::current_version, 8, 3, 48, 6, 64));
+	std::ranges::copy(header, result.begin());
+	return result;
+}
+
+constexpr bool test() {
+	assert(load_little_endian<std::uint32_t>("\x01\x02\x03\x84") == 0x84030201);
+	auto bytes = std::array<char, 8>();
+	store_little_endian(bytes.data(), std::uint64_t(0x0102030405060708));
+	assert(bytes[0] == 8 and bytes[7] == 1);
+
+	{
+		auto const output = string_table_writer(memory_output()).finish();
+		auto const contents = as_view(output.contents);
+		auto const table = string_table_view(contents);
+		assert(table.empty());
+		assert(table.begin() == table.end());
+		assert(contents.size() == string_table_header::size + sizeof(std::uint32_t));
+	}
+
+	{
+		auto writer = string_table_writer(memory_output(), 64);
+		writer.push_back(std::string_view("alpha"));
+		writer.push_back(std::string());
+		writer.push_back(make_string("a prototype string"));
+		auto column = string_column<>();
+		column.push_back(std::string_view("from a column"));
+		column.push_back(std::string_view(""));
+		writer.append_range(column);
+		writer.append_range(std::vector<std::string_view>{"z"});
+		auto const output = std::move(writer).finish();
+		auto const contents = as_view(output.contents);
+
+		auto const table = string_table_view(contents);
+		assert(matches(table, {"alpha", "", "a prototype string", "from a column", "", "z"}));
+		assert(table.header().offset_size == sizeof(std::uint32_t));
+		assert(table.header().data_offset % 64 == 0);
+		assert(table.header().index_offset % 64 == 0);
+		assert(table.characters() == "alphaa prototype stringfrom a columnz");
+
+		auto str = table.as_string(2);
+		assert(str.is_external());
+		assert(std::as_const(str).data() == table[2].data());
+		str.insert(str.end(), '!');
+		assert(!str.is_external());
+		assert(as_view(str) == "a prototype string!");
+		assert(table[2] == "a prototype string");
+	}
+
+	{
+		auto const contents = make_wide_table();
+		auto const table = string_table_view(contents);
+		assert(table.header().offset_size == sizeof(std::uint64_t));
+		assert(matches(table, {"one", "", "two"}));
+	}
+	return true;
+}
+
+template<typename Function>
+bool throws(Function && function) {
+	try {
+		function();
+	} catch (std::exception const &) {
+		return true;
+	}
+	return false;
+}
+
+void test_invalid() {
+	auto writer = string_table_writer(memory_output());
+	writer.append_range(std::vector<std::string_view>{"first", "second", "third"});
+	auto const contents = std::string(as_view(std::move(writer).finish().contents));
+	assert(matches(string_table_view(contents), {"first", "second", "third"}));
+
+	auto const changed = [&](std::size_t const position, char const value) {
+		auto result = contents;
+		result[position] = value;
+		return result;
+	};
+	assert(throws([&] { string_table_view(""); }));
+	assert(throws([&] { string_table_view(contents.substr(0, contents.size() - 1)); }));
+	assert(throws([&] { string_table_view(changed(0, 'S')); }));
+	// version
+	assert(throws([&] { string_table_view(changed(8, 2)); }));
+	// offset_size
+	assert(throws([&] { string_table_view(changed(12, 3)); }));
+	// string_count
+	assert(throws([&] { string_table_view(changed(16, 4)); }));
+	// data_size
+	assert(throws([&] { string_table_view(changed(32, 15)); }));
+	// The last offset
+	assert(throws([&] { string_table_view(changed(contents.size() - 4, 15)); }));
+
+	// Offsets that go backwards are only found by checking all of them
+	auto const backwards = changed(contents.size() - 8, 2);
+	assert(!string_table_view(backwards).offsets_are_valid());
+}
+
+std::vector<std::string> random_strings(std::mt19937_64 & engine, std::size_t const count) {
+	auto result = std::vector<std::string>(count);
+	for (auto & value : result) {
+		value.resize(engine() % 40);
+		for (auto & c : value) {
+			c = static_cast<char>(engine());
+		}
+	}
+	return result;
+}
+
+void test_file() {
+	auto const path = (std::filesystem::temp_directory_path() / "string-table-test.strtable").string();
+	auto engine = std::mt19937_64(1);
+	for (auto const alignment : {1, 8, 4096}) {
+		auto const expected = random_strings(engine, engine() % 10'000);
+		auto column = string_column<>();
+		column.append_range(expected);
+		auto writer = string_table_writer(file_output(path.c_str()), static_cast<std::size_t>(alignment));
+		writer.append_range(column);
+		writer.append_range(expected);
+		std::move(writer).finish().close();
+
+		auto opened = string_table(path.c_str());
+		// The strings stay where they are when the table is moved
+		auto const first = opened.size() == 0 ? nullptr : opened[0].data();
+		auto const table = std::move(opened);
+		assert(table.size() == 2 * expected.size());
+		assert(table.view().header().data_offset % static_cast<std::size_t>(alignment) == 0);
+		for (std::size_t n = 0; n != expected.size(); ++n) {
+			assert(table[n] == expected[n]);
+			assert(as_view(table.as_string(expected.size() + n)) == expected[n]);
+		}
+		assert(table.size() == 0 or table[0].data() == first);
+	}
+
+	write_string_table(path.c_str(), std::vector<std::string_view>());
+	assert(string_table(path.c_str()).size() == 0);
+	std::filesystem::resize_file(path, 0);
+	assert(throws([&] { string_table(path.c_str()); }));
+	std::filesystem::remove(path);
+	assert(throws([&] { string_table(path.c_str()); }));
+}
+
+template<typename Function>
+double nanoseconds_per_operation(std::size_t const count, Function && function) {
+	auto const start = std::chrono::steady_clock::now();
+	function();
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+}
+
+// URLs and identifiers from 6 to about 60 characters
+std::vector<std::string> make_values(std::size_t const count) {
+	auto engine = std::mt19937_64(1);
+	constexpr std::string_view hosts[] = {"https://example.com/", "https://cdn.example.net/assets/", "http://10.0.0.1:8080/"};
+	auto result = std::vector<std::string>(count);
+	for (auto & value : result) {
+		if (engine() % 2 == 0) {
+			value = hosts[engine() % std::size(hosts)];
+		}
+		for (auto size = engine() % 20 + 6; size != 0; --size) {
+			value += static_cast<char>('a' + engine() % 26);
+		}
+	}
+	return result;
+}
+
+// What most services do now: one string per line, each copied into its own
+// std::string
+std::vector<std::string> parse_lines(char const * const path) {
+	auto const file = std::fopen(path, "rb");
+	assert(file);
+	auto contents = std::string();
+	auto buffer = std::array<char, 1 << 16>();
+	while (auto const count = std::fread(buffer.data(), 1, buffer.size(), file)) {
+		contents.append(buffer.data(), count);
+	}
+	std::fclose(file);
+	auto result = std::vector<std::string>();
+	for (auto const line : std::views::split(contents, '\n')) {
+		result.emplace_back(line.begin(), line.end());
+	}
+	result.pop_back();
+	return result;
+}
+
+// Bytes for the objects and the characters, not counting the unused capacity
+// of the vector or what malloc adds to each allocation
+std::size_t bytes_used(std::vector<std::string> const & values) {
+	auto result = values.size() * sizeof(std::string);
+	for (auto const & value : values) {
+		if (value.size() >= sizeof(std::string) / 2) {
+			result += value.size() + 1;
+		}
+	}
+	return result;
+}
+
+std::size_t scan(auto const & values) {
+	auto result = std::size_t(0);
+	for (auto const & value : values) {
+		auto const view = std::string_view(value);
+		result += view.starts_with("https://") ? view.size() : 0;
+	}
+	return result;
+}
+
+std::size_t random_access(auto const & values, std::vector<std::uint32_t> const & indices) {
+	auto result = std::size_t(0);
+	for (auto const index : indices) {
+		auto const view = std::string_view(values[index]);
+		result += view.size() + static_cast<unsigned char>(view.back());
+	}
+	return result;
+}
+
+void benchmark() {
+	constexpr auto count = std::size_t(5'000'000);
+	auto const values = make_values(count);
+	auto const directory = std::filesystem::temp_directory_path();
+	auto const text_path = (directory / "string-table-benchmark.txt").string();
+	auto const table_path = (directory / "string-table-benchmark.strtable").string();
+	{
+		auto text = file_output(text_path.c_str());
+		for (auto const & value : values) {
+			text.write(value);
+			text.write("\n");
+		}
+		text.close();
+	}
+	auto const write_time = nanoseconds_per_operation(count, [&] {
+		write_string_table(table_path.c_str(), values, 4096);
+	});
+	std::printf("%zu values, written at %.1f ns each, text file %.1f MB, table file %.1f MB\n", count, write_time, static_cast<double>(std::filesystem::file_size(text_path)) / 1e6, static_cast<double>(std::filesystem::file_size(table_path)) / 1e6);
+
+	auto engine = std::mt19937_64(2);
+	auto indices = std::vector<std::uint32_t>(1'000'000);
+	for (auto & index : indices) {
+		index = static_cast<std::uint32_t>(engine() % count);
+	}
+	std::printf("%-30s %12s %12s %12s %12s\n", "", "load ms", "heap MB", "scan ns", "random ns");
+
+	auto parsed = std::vector<std::string>();
+	auto const parse_time = nanoseconds_per_operation(1, [&] {
+		parsed = parse_lines(text_path.c_str());
+	});
+	assert(parsed == values);
+	auto sum = std::size_t(0);
+	auto const parsed_scan = nanoseconds_per_operation(count, [&] { sum += scan(parsed); });
+	auto const parsed_random = nanoseconds_per_operation(indices.size(), [&] { sum += random_access(parsed, indices); });
+	std::printf("%-30s %12.1f %12.1f %12.1f %12.1f\n", "parse into std::string", parse_time / 1e6, static_cast<double>(bytes_used(parsed)) / 1e6, parsed_scan, parsed_random);
+	parsed = {};
+
+	auto table = std::optional<string_table>();
+	auto const open_time = nanoseconds_per_operation(1, [&] {
+		table.emplace(table_path.c_str());
+	});
+	assert(table->size() == count);
+	// The first scan reads the pages in from the page cache
+	auto const first_scan = nanoseconds_per_operation(count, [&] { sum += scan(*table); });
+	auto const table_scan = nanoseconds_per_operation(count, [&] { sum += scan(*table); });
+	auto const table_random = nanoseconds_per_operation(indices.size(), [&] { sum += random_access(*table, indices); });
+	std::printf("%-30s %12.3f %12.1f %12.1f %12.1f\n", "mmap string_table", open_time / 1e6, 0.0, table_scan, table_random);
+	std::printf("%-30s %12s %12s %12.1f\n", "  first scan after mmap", "", "", first_scan);
+	assert(sum != 0);
+
+	std::filesystem::remove(text_path);
+	std::filesystem::remove(table_path);
+}
+
+int main() {
+	test();
+	static_assert(test());
+	test_invalid();
+	test_file();
+	benchmark();
+}
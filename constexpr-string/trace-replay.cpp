@@ -0,0 +1,1277 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is to choose between the
+// two layouts from what a program actually does with its strings, without
+// needing the strings themselves.
+//
+// traced_string wraps any string and logs every operation that can change its
+// size or storage to a compact binary trace. The replayer runs a trace against
+// the clang layout (24 bytes, 23 byte small buffer, branch on every access),
+// the gcc / MSVC layout (32 bytes, 16 byte small buffer, no branch) and
+// std::string, and reports the time, number of allocations, and peak memory
+// (heap plus the string objects themselves) for each. The clang-like versions
+// in this directory all share one layout, as do the gcc-like versions, so the
+// replayer uses clang-abi-compatible and gcc-msvc-compat to stand for them.
+//
+// Usage:
+//     trace-replay record <trace>    writes a synthetic trace
+//     trace-replay <trace>           replays a trace
+//     trace-replay                   replays a synthetic trace
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <random>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+template<typename T>
+struct buffer {
+	constexpr buffer() = default;
+	buffer(buffer &&) = delete;
+	buffer(buffer const &) = delete;
+	buffer & operator=(buffer &&) = delete;
+	buffer & operator=(buffer const &) = delete;
+
+	T data[5000] = {};
+	T * pointer = data;
+};
+
+template<typename T>
+struct allocator {
+	using value_type = T;
+
+	explicit constexpr allocator(buffer<T> & buffer):
+		buffer_(&buffer)
+	{
+	}
+
+	constexpr auto allocate(std::size_t size) {
+		auto const result = buffer_->pointer;
+		buffer_->pointer += size;
+		return result;
+	}
+	constexpr void deallocate(T * ptr, std::size_t size) {
+	}
+
+private:
+	buffer<T> * buffer_;
+};
+
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+
+// Shared by every replay. Replays run on one thread, so these are not atomic.
+struct memory_usage {
+	std::size_t allocations = 0;
+	std::size_t bytes_held = 0;
+	std::size_t peak_bytes_held = 0;
+
+	void add(std::size_t const bytes) {
+		bytes_held += bytes;
+		peak_bytes_held = std::max(peak_bytes_held, bytes_held);
+	}
+	void remove(std::size_t const bytes) {
+		bytes_held -= bytes;
+	}
+};
+
+inline auto replay_memory = memory_usage();
+
+template<typename T>
+struct counting_allocator {
+	using value_type = T;
+
+	constexpr counting_allocator() = default;
+	template<typename U>
+	constexpr counting_allocator(counting_allocator<U>) {
+	}
+
+	T * allocate(std::size_t size) {
+		++replay_memory.allocations;
+		replay_memory.add(size * sizeof(T));
+		return std::allocator<T>().allocate(size);
+	}
+	void deallocate(T * ptr, std::size_t size) {
+		replay_memory.remove(size * sizeof(T));
+		std::allocator<T>().deallocate(ptr, size);
+	}
+
+	friend constexpr bool operator==(counting_allocator, counting_allocator) = default;
+};
+
+
+namespace clang {
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	static constexpr std::size_t small_buffer_capacity = 23;
+
+	struct small_t {
+		char data[small_buffer_capacity] = {};
+	};
+	struct [[gnu::packed]] large_t {
+		static constexpr std::size_t bytes_remaining = 7;
+
+		template<typename It>
+		class range_view {
+		public:
+			constexpr range_view(It first, It last):
+				first_(first),
+				last_(last)
+			{
+			}
+			constexpr auto begin() const {
+				return first_;
+			}
+			constexpr auto end() const {
+				return last_;
+			}
+		private:
+			It first_;
+			It last_;
+		};
+
+		constexpr auto little_endian_capacity() const {
+			return range_view(
+				std::rbegin(rest_of_capacity),
+				std::rend(rest_of_capacity)
+			);
+		}
+		constexpr auto big_endian_capacity() {
+			return range_view(
+				std::begin(rest_of_capacity),
+				std::end(rest_of_capacity)
+			);
+		}
+
+		constexpr large_t(std::size_t set_size, std::size_t capacity, char * pointer) noexcept:
+			rest_of_capacity{},
+			size(set_size),
+			data(pointer)
+		{
+			assert(data != nullptr);
+			for (unsigned char & byte : big_endian_capacity()) {
+				capacity >>= CHAR_BIT;
+				byte = capacity;
+			}
+		}
+
+		unsigned char rest_of_capacity[bytes_remaining];
+		std::size_t size;
+		char * data;
+	};
+
+	[[no_unique_address]] allocator_type allocator_;
+	unsigned char size_or_first_byte_of_capacity_;
+	union U {
+		constexpr U() noexcept:
+			small{}
+		{
+		}
+		explicit constexpr U(std::size_t size, std::size_t capacity, char * data) noexcept:
+			large(size, capacity, data)
+		{
+		}
+		constexpr U(large_t set_large) noexcept:
+			large(set_large)
+		{
+		}
+
+		small_t small;
+		large_t large;
+	} u_;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return size_or_first_byte_of_capacity_ & 1;
+	}
+
+	constexpr void increment_size() {
+		if (is_large()) {
+			++u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ += (1 << 1);
+		}
+	}
+	constexpr void decrement_size() {
+		if (is_large()) {
+			--u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ -= (1 << 1);
+		}
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, u_.large.data, capacity());
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(size(), new_capacity, new_data);
+		assert(new_capacity & 1);
+		size_or_first_byte_of_capacity_ = new_capacity;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		new_capacity |= 1;
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy(begin(), end(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		size_or_first_byte_of_capacity_(0),
+		u_{}
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.large);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+
+			other.u_ = U{};
+			other.size_or_first_byte_of_capacity_ = 0;
+		} else {
+			auto & osmall = other.u_.small;
+			u_ = U{};
+			copy(osmall.data, osmall.data + (other.size_or_first_byte_of_capacity_ >> 1), u_.small.data);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr char * data() {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr std::size_t size() const {
+		return is_large() ? u_.large.size : (size_or_first_byte_of_capacity_ >> 1);
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		if (!is_large()) {
+			return small_buffer_capacity;
+		}
+		std::size_t result = 0;
+		for (unsigned char const byte : u_.large.little_endian_capacity()) {
+			result |= byte;
+			result <<= CHAR_BIT;
+		}
+		result |= size_or_first_byte_of_capacity_;
+		return result;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		auto const local_size = size();
+		if (is_large() && capacity() > (local_size | 1)) {
+			if (local_size > small_buffer_capacity) {
+				force_reserve(local_size);
+			} else {
+				auto const data = u_.large.data;
+				auto const original_capacity = capacity();
+				u_ = U{};
+				size_or_first_byte_of_capacity_ = local_size << 1;
+				copy(data, data + local_size, u_.small.data);
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = std::prev(end());
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = (capacity() * growth_factor) | 1;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+
+			relocate(temp, new_capacity);
+		}
+		increment_size();
+		return begin() + offset;
+	}
+
+	constexpr void pop_back() {
+		decrement_size();
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace clang
+
+namespace gcc {
+
+template<typename Allocator>
+class string {
+public:
+	using const_iterator = char const *;
+	using iterator = char *;
+	using allocator_type = Allocator;
+
+private:
+	[[no_unique_address]] allocator_type allocator_;
+	// This could be set to 8 to reduce the size of our string to 24 bytes
+	// (just like clang), but 7 characters (plus a null terminator) is likely
+	// too small of a buffer for most users.
+	static constexpr std::size_t small_buffer_capacity = 16;
+	union U{
+		constexpr U():
+			buffer{}
+		{
+		}
+		constexpr U(std::size_t c):
+			capacity(c)
+		{
+		}
+
+		char buffer[small_buffer_capacity];
+		std::size_t capacity;
+	} u_;
+	char * data_;
+	std::size_t size_ : 63;
+	// gcc and MSVC do not allow accessing the inactive member of a union just
+	// to get its address, so we use a bitfield to work around this.
+	bool is_large_ : 1;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return is_large_;
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, data_, u_.capacity);
+		}
+	}
+
+	constexpr void relocate(char * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(new_capacity);
+		data_ = new_data;
+		is_large_ = true;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		auto alloc = get_allocator();
+		char * temp = Alloc::allocate(alloc, new_capacity);
+		copy(begin(), end(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_{},
+		data_(u_.buffer),
+		size_(0),
+		is_large_(false)
+	{
+	}
+
+	constexpr string(string && other) noexcept:
+		string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr string & operator=(string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.capacity);
+			other.u_ = U{};
+		
+			data_ = other.data_;
+			other.data_ = other.u_.buffer;
+		
+			size_ = other.size_;
+			other.size_ = 0U;
+		
+			is_large_ = true;
+			other.is_large_ = false;
+
+		} else {
+			u_ = U{};
+			copy(other.data_, other.data_ + other.size_, u_.buffer);
+			data_ = u_.buffer;
+			size_ = other.size_;
+			is_large_ = false;
+		}
+
+		return *this;
+	}
+
+	constexpr ~string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr char const * data() const {
+		return data_;
+	}
+	constexpr char * data() {
+		return data_;
+	}
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		return is_large() ? u_.capacity : small_buffer_capacity;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		if (is_large() && capacity() > size()) {
+			if (size() > small_buffer_capacity) {
+				force_reserve(size());
+			} else {
+				auto const data = data_;
+				auto const original_capacity = u_.capacity;
+				u_ = U{};
+				copy(data, data + size_, u_.buffer);
+				data_ = u_.buffer;
+				is_large_ = false;
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, char const value) {
+		auto construct = [&](char * position, char const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = end() - 1;
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = capacity() * growth_factor;
+
+			auto alloc = get_allocator();
+			char * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+		
+			relocate(temp, new_capacity);
+		}
+		++size_;
+		return begin() + offset;
+	}
+
+	constexpr void pop_back() {
+		--size_;
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+} // namespace gcc
+
+enum class operation : std::uint8_t {
+	construct,
+	destroy,
+	insert,
+	pop_back,
+	move_construct,
+	move_assign,
+	reserve,
+	shrink_to_fit,
+};
+
+constexpr bool has_argument(operation const op) {
+	switch (op) {
+		case operation::insert:
+		case operation::move_construct:
+		case operation::move_assign:
+		case operation::reserve:
+			return true;
+		default:
+			return false;
+	}
+}
+
+// Strings are identified by small integers that are reused once a string is
+// destroyed, so a replay needs only as many slots as the trace has strings
+// alive at once. argument is the offset for insert, the source for moves, and
+// the requested capacity for reserve.
+struct trace_entry {
+	operation op;
+	std::uint32_t target;
+	std::uint64_t argument;
+
+	friend bool operator==(trace_entry, trace_entry) = default;
+};
+
+// A trace starts with the magic string and the version. Each entry is then the
+// operation as a single byte, followed by the target and the argument (if the
+// operation has one) as LEB128 variable-length integers.
+constexpr auto trace_magic = std::string_view("strtrace");
+constexpr auto trace_version = std::uint8_t(1);
+
+class trace_recorder {
+public:
+	explicit trace_recorder(std::ostream & stream):
+		stream_(stream)
+	{
+		stream_.write(trace_magic.data(), static_cast<std::streamsize>(trace_magic.size()));
+		stream_.put(static_cast<char>(trace_version));
+	}
+
+	std::uint32_t construct() {
+		auto const id = new_id();
+		write(operation::construct, id);
+		return id;
+	}
+	std::uint32_t move_construct(std::uint32_t const source) {
+		auto const id = new_id();
+		write(operation::move_construct, id, source);
+		return id;
+	}
+	void destroy(std::uint32_t const id) {
+		write(operation::destroy, id);
+		free_ids_.push_back(id);
+	}
+	void insert(std::uint32_t const id, std::size_t const offset) {
+		write(operation::insert, id, offset);
+	}
+	void pop_back(std::uint32_t const id) {
+		write(operation::pop_back, id);
+	}
+	void move_assign(std::uint32_t const target, std::uint32_t const source) {
+		write(operation::move_assign, target, source);
+	}
+	void reserve(std::uint32_t const id, std::size_t const capacity) {
+		write(operation::reserve, id, capacity);
+	}
+	void shrink_to_fit(std::uint32_t const id) {
+		write(operation::shrink_to_fit, id);
+	}
+
+private:
+	std::uint32_t new_id() {
+		if (free_ids_.empty()) {
+			return next_id_++;
+		}
+		auto const id = free_ids_.back();
+		free_ids_.pop_back();
+		return id;
+	}
+
+	void write_integer(std::uint64_t value) {
+		while (value >= 0x80) {
+			stream_.put(static_cast<char>((value & 0x7F) | 0x80));
+			value >>= 7;
+		}
+		stream_.put(static_cast<char>(value));
+	}
+
+	void write(operation const op, std::uint32_t const target, std::uint64_t const argument = 0) {
+		stream_.put(static_cast<char>(op));
+		write_integer(target);
+		if (has_argument(op)) {
+			write_integer(argument);
+		}
+	}
+
+	std::ostream & stream_;
+	std::uint32_t next_id_ = 0;
+	std::vector<std::uint32_t> free_ids_;
+};
+
+// Has the same interface as the strings in this directory, and records what
+// is done to the string it wraps
+template<typename String>
+class traced_string {
+public:
+	using const_iterator = typename String::const_iterator;
+	using iterator = typename String::iterator;
+	using allocator_type = typename String::allocator_type;
+
+	explicit traced_string(trace_recorder & recorder, allocator_type alloc = allocator_type()):
+		recorder_(&recorder),
+		id_(recorder.construct()),
+		value_(alloc)
+	{
+	}
+
+	traced_string(traced_string && other) noexcept:
+		recorder_(other.recorder_),
+		id_(recorder_->move_construct(other.id_)),
+		value_(std::move(other.value_))
+	{
+	}
+
+	traced_string & operator=(traced_string && other) noexcept {
+		recorder_->move_assign(id_, other.id_);
+		value_ = std::move(other.value_);
+		return *this;
+	}
+
+	~traced_string() {
+		recorder_->destroy(id_);
+	}
+
+	allocator_type get_allocator() const {
+		return value_.get_allocator();
+	}
+
+	char const * data() const {
+		return value_.data();
+	}
+	char * data() {
+		return value_.data();
+	}
+	std::size_t size() const {
+		return value_.size();
+	}
+
+	const_iterator begin() const {
+		return value_.begin();
+	}
+	iterator begin() {
+		return value_.begin();
+	}
+	const_iterator end() const {
+		return value_.end();
+	}
+	iterator end() {
+		return value_.end();
+	}
+
+	std::size_t capacity() const {
+		return value_.capacity();
+	}
+	void reserve(std::size_t const requested_capacity) {
+		recorder_->reserve(id_, requested_capacity);
+		value_.reserve(requested_capacity);
+	}
+	void shrink_to_fit() {
+		recorder_->shrink_to_fit(id_);
+		value_.shrink_to_fit();
+	}
+
+	iterator insert(const_iterator const position, char const value) {
+		recorder_->insert(id_, static_cast<std::size_t>(position - begin()));
+		return value_.insert(position, value);
+	}
+
+	void pop_back() {
+		recorder_->pop_back(id_);
+		value_.pop_back();
+	}
+
+private:
+	trace_recorder * recorder_;
+	std::uint32_t id_;
+	String value_;
+};
+
+inline std::vector<trace_entry> read_trace(std::istream & stream) {
+	auto header = std::string(trace_magic.size(), '\0');
+	stream.read(header.data(), static_cast<std::streamsize>(header.size()));
+	if (!stream or header != trace_magic) {
+		throw std::runtime_error("Not a string trace");
+	}
+	if (stream.get() != trace_version) {
+		throw std::runtime_error("Unsupported string trace version");
+	}
+
+	auto read_integer = [&] {
+		auto result = std::uint64_t(0);
+		for (int shift = 0; ; shift += 7) {
+			auto const byte = stream.get();
+			if (byte == std::istream::traits_type::eof() or shift >= 64) {
+				throw std::runtime_error("Truncated string trace");
+			}
+			result |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0) {
+				return result;
+			}
+		}
+	};
+
+	// The state of each string after each entry, so that a replay never uses
+	// a slot that has no string in it, inserts past the end of a string or
+	// pops from an empty one. A moved-from string has an unspecified size, and
+	// the layouts do not agree on it, so only operations that are valid at any
+	// size can use it until something is moved into it.
+	struct string_state {
+		bool alive = false;
+		bool size_known = true;
+		std::uint64_t size = 0;
+	};
+	auto strings = std::vector<string_state>();
+	auto state = [&](std::uint64_t const id) {
+		return id < strings.size() ? strings[id] : string_state();
+	};
+
+	auto result = std::vector<trace_entry>();
+	for (auto op = stream.get(); op != std::istream::traits_type::eof(); op = stream.get()) {
+		if (op > static_cast<int>(operation::shrink_to_fit)) {
+			throw std::runtime_error("Invalid operation in string trace");
+		}
+		auto entry = trace_entry{static_cast<operation>(op), 0, 0};
+		auto const target = read_integer();
+		if (target > std::numeric_limits<std::uint32_t>::max()) {
+			throw std::runtime_error("Invalid string in string trace");
+		}
+		entry.target = static_cast<std::uint32_t>(target);
+		if (has_argument(entry.op)) {
+			entry.argument = read_integer();
+		}
+
+		auto current = state(entry.target);
+		if (entry.op == operation::construct or entry.op == operation::move_construct) {
+			if (current.alive) {
+				throw std::runtime_error("String constructed twice in string trace");
+			}
+		} else if (!current.alive) {
+			throw std::runtime_error("Use of a string that does not exist in string trace");
+		}
+		switch (entry.op) {
+			case operation::construct:
+				current = string_state{true, true, 0};
+				break;
+			case operation::destroy:
+				current.alive = false;
+				break;
+			case operation::insert:
+				if (entry.argument != 0 and (!current.size_known or entry.argument > current.size)) {
+					throw std::runtime_error("Insert past the end of a string in string trace");
+				}
+				++current.size;
+				break;
+			case operation::pop_back:
+				if (!current.size_known or current.size == 0) {
+					throw std::runtime_error("Pop from a string that may be empty in string trace");
+				}
+				--current.size;
+				break;
+			case operation::move_construct:
+			case operation::move_assign: {
+				auto const source = state(entry.argument);
+				if (!source.alive) {
+					throw std::runtime_error("Move from a string that does not exist in string trace");
+				}
+				strings[entry.argument].size_known = false;
+				current = source;
+				current.size_known = source.size_known and entry.argument != entry.target;
+				break;
+			}
+			case operation::reserve:
+			case operation::shrink_to_fit:
+				break;
+		}
+		if (entry.target >= strings.size()) {
+			strings.resize(std::size_t(entry.target) + 1);
+		}
+		strings[entry.target] = current;
+		result.push_back(entry);
+	}
+	return result;
+}
+
+
+struct replay_result {
+	std::chrono::nanoseconds time;
+	std::size_t allocations;
+	std::size_t peak_bytes;
+	// Combines the size of every string when it is destroyed, so that replays
+	// of the same trace can be checked against each other. Moved-from strings
+	// are left out, as their contents are unspecified.
+	std::size_t checksum;
+};
+
+template<typename String>
+replay_result replay(std::span<trace_entry const> const trace) {
+	auto slot_count = std::size_t(0);
+	for (auto const entry : trace) {
+		slot_count = std::max(slot_count, std::size_t(entry.target) + 1);
+	}
+	auto strings = std::vector<std::optional<String>>(slot_count);
+	auto moved_from = std::vector<bool>(slot_count);
+	auto checksum = std::size_t(0);
+
+	auto destroy = [&](std::uint32_t const id) {
+		if (!moved_from[id]) {
+			checksum = checksum * 31 + strings[id]->size();
+		}
+		strings[id].reset();
+		replay_memory.remove(sizeof(String));
+	};
+
+	replay_memory = memory_usage();
+	auto const start = std::chrono::steady_clock::now();
+	for (auto const entry : trace) {
+		auto & target = strings[entry.target];
+		switch (entry.op) {
+			case operation::construct:
+				replay_memory.add(sizeof(String));
+				target.emplace(typename String::allocator_type());
+				moved_from[entry.target] = false;
+				break;
+			case operation::destroy:
+				destroy(entry.target);
+				break;
+			case operation::insert: {
+				if (entry.argument > target->size()) {
+					throw std::runtime_error("Insert past the end of a string in string trace");
+				}
+				auto const position = target->begin() + static_cast<std::ptrdiff_t>(entry.argument);
+				target->insert(position, static_cast<char>('a' + entry.argument % 26));
+				break;
+			}
+			case operation::pop_back:
+				if (target->size() == 0) {
+					throw std::runtime_error("Pop from an empty string in string trace");
+				}
+				target->pop_back();
+				break;
+			case operation::move_construct:
+				replay_memory.add(sizeof(String));
+				target.emplace(std::move(*strings[entry.argument]));
+				moved_from[entry.target] = false;
+				moved_from[entry.argument] = true;
+				break;
+			case operation::move_assign:
+				*target = std::move(*strings[entry.argument]);
+				moved_from[entry.target] = false;
+				moved_from[entry.argument] = true;
+				break;
+			case operation::reserve:
+				target->reserve(entry.argument);
+				break;
+			case operation::shrink_to_fit:
+				target->shrink_to_fit();
+				break;
+		}
+	}
+	for (std::uint32_t id = 0; id != strings.size(); ++id) {
+		if (strings[id]) {
+			destroy(id);
+		}
+	}
+	auto const time = std::chrono::steady_clock::now() - start;
+	assert(replay_memory.bytes_held == 0);
+	return replay_result{time, replay_memory.allocations, replay_memory.peak_bytes_held, checksum};
+}
+
+using clang_string = clang::string<counting_allocator<char>>;
+using gcc_string = gcc::string<counting_allocator<char>>;
+using std_string = std::basic_string<char, std::char_traits<char>, counting_allocator<char>>;
+
+void replay_all(std::span<trace_entry const> const trace) {
+	auto print = [](char const * name, std::size_t const object_size, replay_result const result) {
+		std::printf(
+			"%-8s %6zu %12.3f %12zu %12zu\n",
+			name,
+			object_size,
+			std::chrono::duration<double, std::milli>(result.time).count(),
+			result.allocations,
+			result.peak_bytes
+		);
+	};
+	std::printf("%zu operations\n", trace.size());
+	std::printf("%-8s %6s %12s %12s %12s\n", "layout", "sizeof", "ms", "allocations", "peak bytes");
+	auto const clang_result = replay<clang_string>(trace);
+	print("clang", sizeof(clang_string), clang_result);
+	auto const gcc_result = replay<gcc_string>(trace);
+	print("gcc", sizeof(gcc_string), gcc_result);
+	auto const std_result = replay<std_string>(trace);
+	print("std", sizeof(std_string), std_result);
+	if (clang_result.checksum != gcc_result.checksum or clang_result.checksum != std_result.checksum) {
+		throw std::runtime_error("Replays disagree on the sizes of the strings");
+	}
+}
+
+// Roughly what a request handler does: build a few short keys and a longer
+// value per request, keep some of them for a while, and trim some.
+void generate_trace(trace_recorder & recorder) {
+	using string = traced_string<std::string>;
+	auto engine = std::minstd_rand(1);
+	auto between = [&](std::size_t const min, std::size_t const max) {
+		return std::uniform_int_distribution<std::size_t>(min, max)(engine);
+	};
+	auto append = [](string & str, std::size_t const count) {
+		for (std::size_t n = 0; n != count; ++n) {
+			str.insert(str.end(), 'x');
+		}
+	};
+
+	auto kept = std::vector<string>();
+	for (std::size_t request = 0; request != 20'000; ++request) {
+		auto key = string(recorder);
+		append(key, between(4, 20));
+
+		auto value = string(recorder);
+		if (between(0, 3) == 0) {
+			value.reserve(64);
+		}
+		append(value, between(10, 120));
+		if (between(0, 7) == 0) {
+			value.insert(value.begin(), '/');
+		}
+		while (value.size() > 40 and between(0, 1) == 0) {
+			value.pop_back();
+		}
+		if (value.size() < value.capacity() / 2) {
+			value.shrink_to_fit();
+		}
+
+		if (kept.size() == 100) {
+			kept[request % 100] = std::move(key);
+		} else {
+			kept.push_back(std::move(key));
+		}
+	}
+}
+
+constexpr void test_individual(auto & str, char const * source) {
+	using String = std::remove_reference_t<decltype(str)>;
+	String temp(str.get_allocator());
+	for (auto it = source; *it != '\0'; ++it) {
+		str.insert(str.end(), *it);
+		temp.insert(temp.end(), *it);
+	}
+
+	temp.insert(temp.begin(), 'a');
+	temp.insert(temp.begin() + temp.size() / 2, 'b');
+	auto const size = std::char_traits<char>::length(source);
+	auto const middle = (size + 1) / 2;
+	assert(temp.size() == size + 2);
+	for (std::size_t n = 0; n != temp.size(); ++n) {
+		auto const expected = n == 0 ? 'a' : n == middle ? 'b' : n < middle ? source[n - 1] : source[n - 2];
+		assert(temp.data()[n] == expected);
+	}
+
+	// Inserting at the front, including each time that reallocates
+	String front(str.get_allocator());
+	for (std::size_t n = 0; n != 100; ++n) {
+		front.insert(front.begin(), static_cast<char>('0' + n % 10));
+	}
+	for (std::size_t n = 0; n != front.size(); ++n) {
+		assert(front.data()[n] == static_cast<char>('0' + (99 - n) % 10));
+	}
+
+	while (temp.size() != 0) {
+		temp.pop_back();
+	}
+	assert(temp.size() == 0);
+
+	auto temp2 = std::move(str);
+	str = std::move(temp2);
+
+	assert(str.data() != temp.data());
+	assert(str.size() == std::char_traits<char>::length(source));
+	assert(std::char_traits<char>::compare(str.data(), source, str.size()) == 0);
+	assert(str.capacity() >= str.size());
+
+	str.reserve(50);
+	str.shrink_to_fit();
+}
+
+template<typename String>
+constexpr void test_layout() {
+	buffer<char> buff{};
+	auto alloc = allocator(buff);
+
+	char const * short_source = "0123";
+	char const * long_source =
+		"0123456789"
+		"0123456789"
+		"0123456789"
+		"0123456789"
+		"0123456789";
+
+	String short_str(alloc);
+	test_individual(short_str, short_source);
+
+	String long_str(alloc);
+	test_individual(long_str, long_source);
+
+	String temp(alloc);
+	temp = std::move(long_str);
+	temp = std::move(short_str);
+}
+
+constexpr bool test() {
+	test_layout<clang::string<allocator<char>>>();
+	test_layout<gcc::string<allocator<char>>>();
+	return true;
+}
+
+void test_trace() {
+	auto stream = std::stringstream();
+	{
+		auto recorder = trace_recorder(stream);
+		auto str = traced_string<std::string>(recorder);
+		for (std::size_t n = 0; n != 200; ++n) {
+			str.insert(str.end(), 'x');
+		}
+		str.pop_back();
+		auto other = std::move(str);
+		other.reserve(300);
+		other.shrink_to_fit();
+		str = std::move(other);
+	}
+	auto const trace = read_trace(stream);
+	assert(trace.size() == 1 + 200 + 1 + 1 + 1 + 1 + 1 + 2);
+	assert((trace[0] == trace_entry{operation::construct, 0, 0}));
+	assert((trace[200] == trace_entry{operation::insert, 0, 199}));
+	assert((trace[202] == trace_entry{operation::move_construct, 1, 0}));
+	assert((trace[203] == trace_entry{operation::reserve, 1, 300}));
+	assert((trace[205] == trace_entry{operation::move_assign, 0, 1}));
+	assert((trace[207] == trace_entry{operation::destroy, 0, 0}));
+
+	auto const clang_result = replay<clang_string>(trace);
+	auto const gcc_result = replay<gcc_string>(trace);
+	// 23 -> 47 -> 95 -> 191 -> 383 -> shrink to 199
+	assert(clang_result.allocations == 5);
+	// 16 -> 32 -> 64 -> 128 -> 256 -> 300 -> shrink to 199
+	assert(gcc_result.allocations == 6);
+	assert(clang_result.checksum == gcc_result.checksum);
+
+	auto const is_rejected = [](std::string_view const contents) {
+		auto bad = std::stringstream(std::string(contents));
+		try {
+			read_trace(bad);
+		} catch (std::runtime_error const &) {
+			return true;
+		}
+		return false;
+	};
+	assert(is_rejected("strtrace\x07"));
+	assert(!is_rejected(std::string_view("strtrace\x01\x00\x00\x01\x00", 13)));
+	// Moving from a string that was never constructed
+	assert(is_rejected(std::string_view("strtrace\x01\x04\x00\x05", 12)));
+	// Using a string after it is destroyed
+	assert(is_rejected(std::string_view("strtrace\x01\x00\x00\x01\x00\x03\x00", 15)));
+	// Constructing a string that already exists
+	assert(is_rejected(std::string_view("strtrace\x01\x00\x00\x00\x00", 13)));
+	// Inserting past the end
+	assert(is_rejected(std::string_view("strtrace\x01\x00\x00\x02\x00\x80\x01", 15)));
+	assert(!is_rejected(std::string_view("strtrace\x01\x00\x00\x02\x00\x00\x02\x00\x01", 17)));
+	// Popping from an empty string, or from a moved-from string, whose size
+	// depends on the layout
+	assert(is_rejected(std::string_view("strtrace\x01\x00\x00\x03\x00", 13)));
+	assert(is_rejected(std::string_view("strtrace\x01\x00\x00\x02\x00\x00\x04\x01\x00\x03\x00", 19)));
+	assert(!is_rejected(std::string_view("strtrace\x01\x00\x00\x02\x00\x00\x04\x01\x00\x03\x01", 19)));
+}
+
+int main(int argc, char ** argv) {
+	test();
+	static_assert(test());
+	test_trace();
+
+	if (argc == 3 and argv[1] == std::string_view("record")) {
+		auto file = std::ofstream(argv[2], std::ios::binary);
+		auto recorder = trace_recorder(file);
+		generate_trace(recorder);
+	} else if (argc == 2) {
+		auto file = std::ifstream(argv[1], std::ios::binary);
+		replay_all(read_trace(file));
+	} else {
+		auto stream = std::stringstream();
+		{
+			auto recorder = trace_recorder(stream);
+			generate_trace(recorder);
+		}
+		replay_all(read_trace(stream));
+	}
+}
@@ -0,0 +1,1520 @@
+// Copyright David Stone 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// This code requires C++20. The goal of this version is to make both layouts
+// work for char8_t, char16_t, and char32_t, and to validate UTF-8 and
+// transcode it with vector instructions.
+//
+// basic_string<CharT, Allocator> keeps the size of each layout. The small
+// buffer holds as many characters as fit in the bytes that it has, so the
+// clang layout holds 23 chars, 11 char16_ts, or 5 char32_ts. Its capacity
+// is still packed into the first word, after the padding that aligns the
+// characters.
+//
+// is_valid_utf8 uses the lookup algorithm from simdjson with SSSE3, or AVX2
+// when the processor has it, and skips blocks of ASCII. append_utf8
+// validates, adds up the exact size of the result, and then writes UTF-16 or
+// UTF-32 straight into the storage of the target, which grows at most once.
+// Blocks of ASCII are widened with SSE2 and everything else is decoded one
+// code point at a time. In constant evaluation all of it works one byte at
+// a time.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+template<typename Allocator>
+struct allocator_traits : private std::allocator_traits<std::decay_t<Allocator>> {
+private:
+	using base = std::allocator_traits<std::decay_t<Allocator>>;
+public:
+	using typename base::allocator_type;
+	using typename base::value_type;
+	using typename base::pointer;
+	using typename base::const_pointer;
+	using typename base::void_pointer;
+	using typename base::const_void_pointer;
+	using typename base::difference_type;
+	using typename base::size_type;
+	using typename base::propagate_on_container_copy_assignment;
+	using typename base::propagate_on_container_move_assignment;
+	using typename base::propagate_on_container_swap;
+	using typename base::is_always_equal;
+
+	template<typename T>
+	using rebind_alloc = typename base::template rebind_alloc<T>;
+	template<typename T>
+	using rebind_traits = std::allocator_traits<rebind_alloc<T>>;
+
+	using base::max_size;
+	using base::select_on_container_copy_construction;
+
+	static constexpr auto allocate(allocator_type & allocator, std::size_t size) {
+		return allocator.allocate(size);
+	}
+
+	template<typename T>
+	static constexpr auto deallocate(allocator_type & allocator, T * const ptr, std::size_t size) {
+		return allocator.deallocate(ptr, size);
+	}
+
+
+	template<typename T, typename... Args>
+	static constexpr void construct(allocator_type &, T * const ptr, Args && ... args) {
+		*ptr = T(std::forward<Args>(args)...);
+	}
+
+
+	template<typename T>
+	static constexpr void destroy(allocator_type &, T * const ptr) {
+	}
+};
+
+
+template<typename Allocator, typename InputIterator, typename ForwardIterator>
+constexpr ForwardIterator uninitialized_copy(Allocator alloc, InputIterator first, InputIterator const last, ForwardIterator out) {
+	using Alloc = allocator_traits<Allocator>;
+	for (; first != last; ++first) {
+		Alloc::construct(alloc, std::addressof(*out), *first);
+		++out;
+	}
+	return out;
+}
+
+template<typename InputIterator, typename OutputIterator>
+constexpr auto copy(InputIterator first, InputIterator const last, OutputIterator out) {
+	for (; first != last; ++first) {
+		*out = *first;
+		++out;
+	}
+	return out;
+}
+
+// Every character type is trivial, so outside of constant evaluation the
+// characters can be copied with memcpy instead of being constructed one at a
+// time
+template<typename Allocator, typename CharT>
+constexpr CharT * copy_characters(Allocator alloc, CharT const * const first, CharT const * const last, CharT * const out) {
+	if (std::is_constant_evaluated()) {
+		return uninitialized_copy(alloc, first, last, out);
+	}
+	auto const count = static_cast<std::size_t>(last - first);
+	if (count != 0) {
+		std::memcpy(out, first, count * sizeof(CharT));
+	}
+	return out + count;
+}
+
+
+namespace clang {
+
+template<typename CharT, typename Allocator>
+class basic_string {
+public:
+	using value_type = CharT;
+	using const_iterator = CharT const *;
+	using iterator = CharT *;
+	using allocator_type = Allocator;
+
+private:
+	// The first byte is the size, and the characters start at the next
+	// multiple of their alignment, so the whole string is still three words
+	// with the size and pointer of a large string in the same place: 23 chars,
+	// 11 char16_ts, or 5 char32_ts.
+	static constexpr std::size_t small_buffer_capacity = (3 * sizeof(std::size_t) - alignof(CharT)) / sizeof(CharT);
+
+	struct small_t {
+		CharT data[small_buffer_capacity] = {};
+	};
+	struct [[gnu::packed]] large_t {
+		// The rest of the first word, after the padding that aligns the
+		// characters of a small string. The padding is not part of the
+		// capacity, which limits a string of char32_t to 2^40 - 1 elements.
+		static constexpr std::size_t bytes_remaining = sizeof(std::size_t) - alignof(CharT);
+
+		template<typename It>
+		class range_view {
+		public:
+			constexpr range_view(It first, It last):
+				first_(first),
+				last_(last)
+			{
+			}
+			constexpr auto begin() const {
+				return first_;
+			}
+			constexpr auto end() const {
+				return last_;
+			}
+		private:
+			It first_;
+			It last_;
+		};
+
+		constexpr auto little_endian_capacity() const {
+			return range_view(
+				std::rbegin(rest_of_capacity),
+				std::rend(rest_of_capacity)
+			);
+		}
+		constexpr auto big_endian_capacity() {
+			return range_view(
+				std::begin(rest_of_capacity),
+				std::end(rest_of_capacity)
+			);
+		}
+
+		constexpr large_t(std::size_t set_size, std::size_t capacity, CharT * pointer) noexcept:
+			rest_of_capacity{},
+			size(set_size),
+			data(pointer)
+		{
+			assert(data != nullptr);
+			for (unsigned char & byte : big_endian_capacity()) {
+				capacity >>= CHAR_BIT;
+				byte = capacity;
+			}
+		}
+
+		unsigned char rest_of_capacity[bytes_remaining];
+		std::size_t size;
+		CharT * data;
+	};
+
+	[[no_unique_address]] allocator_type allocator_;
+	unsigned char size_or_first_byte_of_capacity_;
+	union U {
+		constexpr U() noexcept:
+			small{}
+		{
+		}
+		explicit constexpr U(std::size_t size, std::size_t capacity, CharT * data) noexcept:
+			large(size, capacity, data)
+		{
+		}
+		constexpr U(large_t set_large) noexcept:
+			large(set_large)
+		{
+		}
+
+		small_t small;
+		large_t large;
+	} u_;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return size_or_first_byte_of_capacity_ & 1;
+	}
+
+	constexpr void increment_size() {
+		if (is_large()) {
+			++u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ += (1 << 1);
+		}
+	}
+	constexpr void set_size(std::size_t const new_size) {
+		if (is_large()) {
+			u_.large.size = new_size;
+		} else {
+			size_or_first_byte_of_capacity_ = static_cast<unsigned char>(new_size << 1);
+		}
+	}
+	constexpr void decrement_size() {
+		if (is_large()) {
+			--u_.large.size;
+		} else {
+			size_or_first_byte_of_capacity_ -= (1 << 1);
+		}
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, u_.large.data, capacity());
+		}
+	}
+
+	constexpr void relocate(CharT * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(size(), new_capacity, new_data);
+		assert(new_capacity & 1);
+		size_or_first_byte_of_capacity_ = new_capacity;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		assert(new_capacity <= max_size());
+		new_capacity |= 1;
+		auto alloc = get_allocator();
+		CharT * temp = Alloc::allocate(alloc, new_capacity);
+		copy_characters(alloc, data(), data() + size(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr basic_string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		size_or_first_byte_of_capacity_(0),
+		u_{}
+	{
+	}
+
+	constexpr basic_string(basic_string && other) noexcept:
+		basic_string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr basic_string & operator=(basic_string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.large);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+
+			other.u_ = U{};
+			other.size_or_first_byte_of_capacity_ = 0;
+		} else {
+			auto & osmall = other.u_.small;
+			u_ = U{};
+			copy(osmall.data, osmall.data + (other.size_or_first_byte_of_capacity_ >> 1), u_.small.data);
+			size_or_first_byte_of_capacity_ = other.size_or_first_byte_of_capacity_;
+		}
+
+		return *this;
+	}
+
+	constexpr ~basic_string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr CharT const * data() const {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr CharT * data() {
+		return is_large() ? u_.large.data : u_.small.data;
+	}
+	constexpr std::size_t size() const {
+		return is_large() ? u_.large.size : (size_or_first_byte_of_capacity_ >> 1);
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	static constexpr std::size_t max_size() {
+		return std::numeric_limits<std::size_t>::max() >> (CHAR_BIT * (alignof(CharT) - 1));
+	}
+	constexpr std::size_t capacity() const {
+		if (!is_large()) {
+			return small_buffer_capacity;
+		}
+		// The bytes after the first are the rest of the capacity in
+		// little-endian order, so on a little-endian target this is one load
+		// instead of a loop. append_and_overwrite checks the capacity for
+		// every number.
+		if (!std::is_constant_evaluated() and std::endian::native == std::endian::little) {
+			auto rest = std::size_t(0);
+			std::memcpy(&rest, u_.large.rest_of_capacity, large_t::bytes_remaining);
+			return (rest << CHAR_BIT) | size_or_first_byte_of_capacity_;
+		}
+		std::size_t result = 0;
+		for (unsigned char const byte : u_.large.little_endian_capacity()) {
+			result |= byte;
+			result <<= CHAR_BIT;
+		}
+		result |= size_or_first_byte_of_capacity_;
+		return result;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		auto const local_size = size();
+		if (is_large() && capacity() > (local_size | 1)) {
+			if (local_size > small_buffer_capacity) {
+				force_reserve(local_size);
+			} else {
+				auto const data = u_.large.data;
+				auto const original_capacity = capacity();
+				u_ = U{};
+				size_or_first_byte_of_capacity_ = local_size << 1;
+				copy(data, data + local_size, u_.small.data);
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, CharT const value) {
+		auto construct = [&](CharT * position, CharT const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = std::prev(end());
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = (capacity() * growth_factor) | 1;
+
+			auto alloc = get_allocator();
+			CharT * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+
+			relocate(temp, new_capacity);
+		}
+		increment_size();
+		return begin() + offset;
+	}
+
+	// Range append, which the proposal leaves out for brevity. A reallocation
+	// at least doubles the capacity, like insert, and copies the old
+	// characters and the new ones straight into place. That also makes it
+	// safe to append part of the string to itself.
+	constexpr void append(CharT const * const first, CharT const * const last) {
+		auto const new_size = size() + static_cast<std::size_t>(last - first);
+		auto alloc = get_allocator();
+		if (new_size <= capacity()) {
+			copy_characters(alloc, first, last, end());
+		} else {
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = std::max(new_size, capacity() * growth_factor) | 1;
+			CharT * temp = Alloc::allocate(alloc, new_capacity);
+			copy_characters(alloc, first, last, copy_characters(alloc, data(), data() + size(), temp));
+			relocate(temp, new_capacity);
+		}
+		set_size(new_size);
+	}
+
+	// Makes room for up to max_count more characters, then operation writes
+	// characters starting at the end and returns where it stopped. This is
+	// like resize_and_overwrite, except that it keeps what is already there.
+	template<typename Operation>
+	constexpr void append_and_overwrite(std::size_t const max_count, Operation operation) {
+		auto const required = size() + max_count;
+		if (required > capacity()) {
+			constexpr auto growth_factor = std::size_t{2};
+			force_reserve(std::max(required, capacity() * growth_factor));
+		}
+		CharT * const last = operation(end());
+		set_size(static_cast<std::size_t>(last - begin()));
+	}
+
+	// Like std::string::resize_and_overwrite: makes room for count
+	// characters, keeping the ones that are already there, and then
+	// operation(data(), count) writes them and returns the new size.
+	template<typename Operation>
+	constexpr void resize_and_overwrite(std::size_t const count, Operation operation) {
+		if (count > capacity()) {
+			force_reserve(count);
+		}
+		set_size(static_cast<std::size_t>(operation(data(), count)));
+	}
+
+	constexpr void pop_back() {
+		decrement_size();
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+template<typename Allocator>
+using string = basic_string<char, Allocator>;
+template<typename Allocator>
+using u8string = basic_string<char8_t, Allocator>;
+template<typename Allocator>
+using u16string = basic_string<char16_t, Allocator>;
+template<typename Allocator>
+using u32string = basic_string<char32_t, Allocator>;
+
+} // namespace clang
+
+namespace gcc {
+
+template<typename CharT, typename Allocator>
+class basic_string {
+public:
+	using value_type = CharT;
+	using const_iterator = CharT const *;
+	using iterator = CharT *;
+	using allocator_type = Allocator;
+
+private:
+	[[no_unique_address]] allocator_type allocator_;
+	// This could be set to 8 to reduce the size of our string to 24 bytes
+	// (just like clang), but 7 characters (plus a null terminator) is likely
+	// too small of a buffer for most users. Wider characters get the same 16
+	// bytes.
+	static constexpr std::size_t small_buffer_capacity = 16 / sizeof(CharT);
+	union U{
+		constexpr U():
+			buffer{}
+		{
+		}
+		constexpr U(std::size_t c):
+			capacity(c)
+		{
+		}
+
+		CharT buffer[small_buffer_capacity];
+		std::size_t capacity;
+	} u_;
+	CharT * data_;
+	std::size_t size_ : 63;
+	// gcc and MSVC do not allow accessing the inactive member of a union just
+	// to get its address, so we use a bitfield to work around this.
+	bool is_large_ : 1;
+
+	using Alloc = allocator_traits<allocator_type>;
+
+	constexpr bool is_large() const {
+		return is_large_;
+	}
+
+	constexpr void deallocate() {
+		if (is_large()) {
+			auto alloc = get_allocator();
+			Alloc::deallocate(alloc, data_, u_.capacity);
+		}
+	}
+
+	constexpr void relocate(CharT * new_data, std::size_t new_capacity) {
+		deallocate();
+		u_ = U(new_capacity);
+		data_ = new_data;
+		is_large_ = true;
+	}
+
+	constexpr void force_reserve(std::size_t new_capacity) {
+		auto alloc = get_allocator();
+		CharT * temp = Alloc::allocate(alloc, new_capacity);
+		copy_characters(alloc, data(), data() + size(), temp);
+		relocate(temp, new_capacity);
+	}
+
+public:
+	explicit constexpr basic_string(allocator_type alloc) noexcept:
+		allocator_(alloc),
+		u_{},
+		data_(u_.buffer),
+		size_(0),
+		is_large_(false)
+	{
+	}
+
+	constexpr basic_string(basic_string && other) noexcept:
+		basic_string(other.get_allocator())
+	{
+		*this = std::move(other);
+	}
+
+	constexpr basic_string & operator=(basic_string && other) noexcept {
+		deallocate();
+
+		if (other.is_large()) {
+			u_ = U(other.u_.capacity);
+			other.u_ = U{};
+		
+			data_ = other.data_;
+			other.data_ = other.u_.buffer;
+		
+			size_ = other.size_;
+			other.size_ = 0U;
+		
+			is_large_ = true;
+			other.is_large_ = false;
+
+		} else {
+			u_ = U{};
+			copy(other.data_, other.data_ + other.size_, u_.buffer);
+			data_ = u_.buffer;
+			size_ = other.size_;
+			is_large_ = false;
+		}
+
+		return *this;
+	}
+
+	constexpr ~basic_string() {
+		deallocate();
+	}
+
+	constexpr allocator_type get_allocator() const {
+		return allocator_;
+	}
+
+	constexpr CharT const * data() const {
+		return data_;
+	}
+	constexpr CharT * data() {
+		return data_;
+	}
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr const_iterator begin() const {
+		return data();
+	}
+	constexpr iterator begin() {
+		return data();
+	}
+	constexpr const_iterator end() const {
+		return begin() + size();
+	}
+	constexpr iterator end() {
+		return begin() + size();
+	}
+
+	constexpr std::size_t capacity() const {
+		return is_large() ? u_.capacity : small_buffer_capacity;
+	}
+	constexpr void reserve(std::size_t requested_capacity) {
+		if (requested_capacity > capacity()) {
+			force_reserve(requested_capacity);
+		}
+	}
+	constexpr void shrink_to_fit() {
+		if (is_large() && capacity() > size()) {
+			if (size() > small_buffer_capacity) {
+				force_reserve(size());
+			} else {
+				auto const data = data_;
+				auto const original_capacity = u_.capacity;
+				u_ = U{};
+				copy(data, data + size_, u_.buffer);
+				data_ = u_.buffer;
+				is_large_ = false;
+				auto alloc = get_allocator();
+				Alloc::deallocate(alloc, data, original_capacity);
+			}
+		}
+	}
+
+	constexpr iterator insert(const_iterator const_position, CharT const value) {
+		auto construct = [&](CharT * position, CharT const v) {
+			auto alloc = get_allocator();
+			Alloc::construct(alloc, position, v);
+		};
+
+		auto const offset = const_position - begin();
+		auto const position = begin() + offset;
+		if (size() < capacity()) {
+			if (offset == size()) {
+				construct(position, value);
+			} else {
+				auto const prev_end = end() - 1;
+				construct(end(), *prev_end);
+				::copy(std::make_reverse_iterator(prev_end), std::make_reverse_iterator(position), std::make_reverse_iterator(end()));
+				*position = value;
+			}
+		} else {
+			// There is a reallocation required, so just put everything in the
+			// correct place to begin with
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = capacity() * growth_factor;
+
+			auto alloc = get_allocator();
+			CharT * temp = Alloc::allocate(alloc, new_capacity);
+
+			uninitialized_copy(alloc, begin(), position, temp);
+			Alloc::construct(alloc, temp + offset, value);
+			if (offset != size()) {
+				uninitialized_copy(alloc, position, end(), std::next(temp + offset));
+			}
+		
+			relocate(temp, new_capacity);
+		}
+		++size_;
+		return begin() + offset;
+	}
+
+	// Range append, which the proposal leaves out for brevity. A reallocation
+	// at least doubles the capacity, like insert, and copies the old
+	// characters and the new ones straight into place. That also makes it
+	// safe to append part of the string to itself.
+	constexpr void append(CharT const * const first, CharT const * const last) {
+		auto const new_size = size() + static_cast<std::size_t>(last - first);
+		auto alloc = get_allocator();
+		if (new_size <= capacity()) {
+			copy_characters(alloc, first, last, end());
+		} else {
+			constexpr auto growth_factor = std::size_t{2};
+			auto const new_capacity = std::max(new_size, capacity() * growth_factor);
+			CharT * temp = Alloc::allocate(alloc, new_capacity);
+			copy_characters(alloc, first, last, copy_characters(alloc, data(), data() + size(), temp));
+			relocate(temp, new_capacity);
+		}
+		size_ = new_size;
+	}
+
+	// Makes room for up to max_count more characters, then operation writes
+	// characters starting at the end and returns where it stopped. This is
+	// like resize_and_overwrite, except that it keeps what is already there.
+	template<typename Operation>
+	constexpr void append_and_overwrite(std::size_t const max_count, Operation operation) {
+		auto const required = size() + max_count;
+		if (required > capacity()) {
+			constexpr auto growth_factor = std::size_t{2};
+			force_reserve(std::max(required, capacity() * growth_factor));
+		}
+		CharT * const last = operation(end());
+		size_ = static_cast<std::size_t>(last - begin());
+	}
+
+	// Like std::string::resize_and_overwrite: makes room for count
+	// characters, keeping the ones that are already there, and then
+	// operation(data(), count) writes them and returns the new size.
+	template<typename Operation>
+	constexpr void resize_and_overwrite(std::size_t const count, Operation operation) {
+		if (count > capacity()) {
+			force_reserve(count);
+		}
+		size_ = static_cast<std::size_t>(operation(data(), count));
+	}
+
+	constexpr void pop_back() {
+		--size_;
+		auto alloc = get_allocator();
+		Alloc::destroy(alloc, end());
+	}
+};
+
+template<typename Allocator>
+using string = basic_string<char, Allocator>;
+template<typename Allocator>
+using u8string = basic_string<char8_t, Allocator>;
+template<typename Allocator>
+using u16string = basic_string<char16_t, Allocator>;
+template<typename Allocator>
+using u32string = basic_string<char32_t, Allocator>;
+
+} // namespace gcc
+
+template<typename Byte>
+concept utf8_byte = std::same_as<Byte, char> or std::same_as<Byte, char8_t>;
+
+constexpr bool is_continuation(unsigned char const byte) {
+	return (byte & 0xc0) == 0x80;
+}
+
+// What the Unicode standard calls well-formed UTF-8 (table 3-7): no overlong
+// forms, no surrogates, nothing after U+10FFFF, and no sequence that is cut
+// off at the end. This is what constant evaluation uses, and what the vector
+// versions are tested against.
+template<utf8_byte Byte>
+constexpr bool scalar_is_valid_utf8(Byte const * const data, std::size_t const size) {
+	auto byte = [=](std::size_t const index) {
+		return static_cast<unsigned char>(data[index]);
+	};
+	for (std::size_t n = 0; n != size;) {
+		auto const lead = byte(n);
+		if (lead < 0x80) {
+			++n;
+			continue;
+		}
+		auto const length = lead < 0xc2 ? 0 : lead < 0xe0 ? 2 : lead < 0xf0 ? 3 : lead < 0xf5 ? 4 : 0;
+		if (length == 0 or size - n < static_cast<std::size_t>(length)) {
+			return false;
+		}
+		// The second byte has a smaller range after some leads
+		auto const second = byte(n + 1);
+		auto const second_first = lead == 0xe0 ? 0xa0 : lead == 0xf0 ? 0x90 : 0x80;
+		auto const second_last = lead == 0xed ? 0x9f : lead == 0xf4 ? 0x8f : 0xbf;
+		if (second < second_first or second > second_last) {
+			return false;
+		}
+		for (auto index = n + 2; index != n + static_cast<std::size_t>(length); ++index) {
+			if (!is_continuation(byte(index))) {
+				return false;
+			}
+		}
+		n += static_cast<std::size_t>(length);
+	}
+	return true;
+}
+
+#if defined(__x86_64__)
+
+inline bool const has_avx2 = __builtin_cpu_supports("avx2");
+inline bool const has_ssse3 = __builtin_cpu_supports("ssse3");
+
+inline __m128i load16(void const * const data) {
+	return _mm_loadu_si128(static_cast<__m128i const *>(data));
+}
+[[gnu::target("avx2")]] inline __m256i load32(void const * const data) {
+	return _mm256_loadu_si256(static_cast<__m256i const *>(data));
+}
+
+// The lookup algorithm by John Keiser and Daniel Lemire, from "Validating
+// UTF-8 In Less Than One Instruction Per Byte", which is what simdjson uses.
+// Three table lookups, on the high and low nibble of each byte and the high
+// nibble of the byte after it, give a set of errors that each pair of bytes
+// could be. A bit that is set in all three is an error, except that two
+// continuation bytes in a row are expected in the third and fourth bytes of
+// a sequence.
+namespace utf8_error {
+
+constexpr std::uint8_t too_short = 1 << 0;
+constexpr std::uint8_t too_long = 1 << 1;
+constexpr std::uint8_t overlong_3 = 1 << 2;
+constexpr std::uint8_t too_large = 1 << 3;
+constexpr std::uint8_t surrogate = 1 << 4;
+constexpr std::uint8_t overlong_2 = 1 << 5;
+constexpr std::uint8_t too_large_1000 = 1 << 6;
+constexpr std::uint8_t overlong_4 = 1 << 6;
+constexpr std::uint8_t two_continuations = 1 << 7;
+constexpr std::uint8_t carry = too_short | too_long | two_continuations;
+
+using table = std::array<std::uint8_t, 16>;
+
+// Indexed by the high nibble of the first byte
+constexpr auto first_high = table{
+	// ASCII
+	too_long, too_long, too_long, too_long,
+	too_long, too_long, too_long, too_long,
+	// Continuation
+	two_continuations, two_continuations, two_continuations, two_continuations,
+	// 1100, the lead of a two byte sequence, which can be overlong
+	too_short | overlong_2,
+	// 1101
+	too_short,
+	// 1110, the lead of a three byte sequence
+	too_short | overlong_3 | surrogate,
+	// 1111, the lead of a four byte sequence
+	too_short | too_large | too_large_1000 | overlong_4,
+};
+
+// Indexed by the low nibble of the first byte
+constexpr auto first_low = table{
+	// 0000
+	carry | overlong_3 | overlong_2 | overlong_4,
+	// 0001
+	carry | overlong_2,
+	// 001x
+	carry,
+	carry,
+	// 0100
+	carry | too_large,
+	// 0101 to 1100
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+	// 1101
+	carry | too_large | too_large_1000 | surrogate,
+	// 111x
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+};
+
+// Indexed by the high nibble of the second byte
+constexpr auto second_high = table{
+	// ASCII
+	too_short, too_short, too_short, too_short,
+	too_short, too_short, too_short, too_short,
+	// 1000
+	too_long | overlong_2 | two_continuations | overlong_3 | too_large_1000 | overlong_4,
+	// 1001
+	too_long | overlong_2 | two_continuations | overlong_3 | too_large,
+	// 101x
+	too_long | overlong_2 | two_continuations | surrogate | too_large,
+	too_long | overlong_2 | two_continuations | surrogate | too_large,
+	// 11xx, a lead
+	too_short, too_short, too_short, too_short,
+};
+
+} // namespace utf8_error
+
+// The same 16 entry table in each 128-bit lane
+inline __m128i load_table(utf8_error::table const & table) {
+	return load16(table.data());
+}
+[[gnu::target("avx2")]] inline __m256i broadcast_table(utf8_error::table const & table) {
+	return _mm256_broadcastsi128_si256(load16(table.data()));
+}
+
+// The bytes of input, shifted up by count bytes, with the last bytes of
+// previous shifted in
+template<int count>
+[[gnu::target("ssse3")]] inline __m128i previous_bytes(__m128i const input, __m128i const previous) {
+	return _mm_alignr_epi8(input, previous, 16 - count);
+}
+template<int count>
+[[gnu::target("avx2")]] inline __m256i previous_bytes(__m256i const input, __m256i const previous) {
+	return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(previous, input, 0x21), 16 - count);
+}
+
+// All the errors in one vector, given the vector before it
+[[gnu::target("ssse3")]] inline __m128i utf8_errors(__m128i const input, __m128i const previous) {
+	auto const low_nibbles = _mm_set1_epi8(0x0f);
+	auto const first = previous_bytes<1>(input, previous);
+	auto const special_cases = _mm_and_si128(
+		_mm_and_si128(
+			_mm_shuffle_epi8(load_table(utf8_error::first_high), _mm_and_si128(_mm_srli_epi16(first, 4), low_nibbles)),
+			_mm_shuffle_epi8(load_table(utf8_error::first_low), _mm_and_si128(first, low_nibbles))
+		),
+		_mm_shuffle_epi8(load_table(utf8_error::second_high), _mm_and_si128(_mm_srli_epi16(input, 4), low_nibbles))
+	);
+	// Whether this byte has to be the third or fourth byte of a sequence
+	auto const third_or_fourth = _mm_or_si128(
+		_mm_subs_epu8(previous_bytes<2>(input, previous), _mm_set1_epi8(static_cast<char>(0xe0 - 0x80))),
+		_mm_subs_epu8(previous_bytes<3>(input, previous), _mm_set1_epi8(static_cast<char>(0xf0 - 0x80)))
+	);
+	return _mm_xor_si128(_mm_and_si128(third_or_fourth, _mm_set1_epi8(static_cast<char>(0x80))), special_cases);
+}
+[[gnu::target("avx2")]] inline __m256i utf8_errors(__m256i const input, __m256i const previous) {
+	auto const low_nibbles = _mm256_set1_epi8(0x0f);
+	auto const first = previous_bytes<1>(input, previous);
+	auto const special_cases = _mm256_and_si256(
+		_mm256_and_si256(
+			_mm256_shuffle_epi8(broadcast_table(utf8_error::first_high), _mm256_and_si256(_mm256_srli_epi16(first, 4), low_nibbles)),
+			_mm256_shuffle_epi8(broadcast_table(utf8_error::first_low), _mm256_and_si256(first, low_nibbles))
+		),
+		_mm256_shuffle_epi8(broadcast_table(utf8_error::second_high), _mm256_and_si256(_mm256_srli_epi16(input, 4), low_nibbles))
+	);
+	auto const third_or_fourth = _mm256_or_si256(
+		_mm256_subs_epu8(previous_bytes<2>(input, previous), _mm256_set1_epi8(static_cast<char>(0xe0 - 0x80))),
+		_mm256_subs_epu8(previous_bytes<3>(input, previous), _mm256_set1_epi8(static_cast<char>(0xf0 - 0x80)))
+	);
+	return _mm256_xor_si256(_mm256_and_si256(third_or_fourth, _mm256_set1_epi8(static_cast<char>(0x80))), special_cases);
+}
+
+// Not zero if the vector ends partway through a sequence, which is only an
+// error if nothing comes after it
+inline __m128i incomplete_at_end(__m128i const input) {
+	auto const maximums = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, static_cast<char>(0xf0 - 1), static_cast<char>(0xe0 - 1), static_cast<char>(0xc0 - 1));
+	return _mm_subs_epu8(input, maximums);
+}
+[[gnu::target("avx2")]] inline __m256i incomplete_at_end(__m256i const input) {
+	auto const maximums = _mm256_setr_epi8(
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, static_cast<char>(0xf0 - 1), static_cast<char>(0xe0 - 1), static_cast<char>(0xc0 - 1)
+	);
+	return _mm256_subs_epu8(input, maximums);
+}
+
+// A block of ASCII cannot have an error, other than the sequence at the end
+// of the block before it being cut off. The last partial block is copied to
+// a buffer padded with 0, which is ASCII, so that it can be checked the same
+// way without reading past the end.
+struct ssse3_utf8_state {
+	__m128i errors;
+	__m128i previous;
+	__m128i previous_incomplete;
+};
+struct avx2_utf8_state {
+	__m256i errors;
+	__m256i previous;
+	__m256i previous_incomplete;
+};
+
+[[gnu::target("ssse3")]] inline void check_block(ssse3_utf8_state & state, __m128i const input) {
+	if (_mm_movemask_epi8(input) == 0) {
+		state.errors = _mm_or_si128(state.errors, state.previous_incomplete);
+	} else {
+		state.errors = _mm_or_si128(state.errors, utf8_errors(input, state.previous));
+		state.previous_incomplete = incomplete_at_end(input);
+	}
+	state.previous = input;
+}
+[[gnu::target("avx2")]] inline void check_block(avx2_utf8_state & state, __m256i const input) {
+	if (_mm256_movemask_epi8(input) == 0) {
+		state.errors = _mm256_or_si256(state.errors, state.previous_incomplete);
+	} else {
+		state.errors = _mm256_or_si256(state.errors, utf8_errors(input, state.previous));
+		state.previous_incomplete = incomplete_at_end(input);
+	}
+	state.previous = input;
+}
+
+[[gnu::target("ssse3")]] inline bool ssse3_is_valid_utf8(char const * const data, std::size_t const size) {
+	auto state = ssse3_utf8_state{_mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128()};
+	auto n = std::size_t(0);
+	for (; n + 16 <= size; n += 16) {
+		check_block(state, load16(data + n));
+	}
+	if (n != size) {
+		char buffer[16] = {};
+		std::memcpy(buffer, data + n, size - n);
+		check_block(state, load16(buffer));
+	}
+	auto const errors = _mm_or_si128(state.errors, state.previous_incomplete);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(errors, _mm_setzero_si128())) == 0xffff;
+}
+[[gnu::target("avx2")]] inline bool avx2_is_valid_utf8(char const * const data, std::size_t const size) {
+	auto state = avx2_utf8_state{_mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256()};
+	auto n = std::size_t(0);
+	for (; n + 32 <= size; n += 32) {
+		check_block(state, load32(data + n));
+	}
+	if (n != size) {
+		char buffer[32] = {};
+		std::memcpy(buffer, data + n, size - n);
+		check_block(state, load32(buffer));
+	}
+	auto const errors = _mm256_or_si256(state.errors, state.previous_incomplete);
+	return _mm256_testz_si256(errors, errors) != 0;
+}
+
+#endif
+
+template<utf8_byte Byte>
+constexpr bool is_valid_utf8(Byte const * const data, std::size_t const size) {
+#if defined(__x86_64__)
+	if (!std::is_constant_evaluated() and has_ssse3) {
+		auto const bytes = reinterpret_cast<char const *>(data);
+		return has_avx2 ? avx2_is_valid_utf8(bytes, size) : ssse3_is_valid_utf8(bytes, size);
+	}
+#endif
+	return scalar_is_valid_utf8(data, size);
+}
+constexpr bool is_valid_utf8(std::string_view const text) {
+	return is_valid_utf8(text.data(), text.size());
+}
+constexpr bool is_valid_utf8(std::u8string_view const text) {
+	return is_valid_utf8(text.data(), text.size());
+}
+
+
+// Transcoding assumes that the input is valid, which append_utf8 checks
+// first. The size of the result is one code unit for each byte that is not
+// a continuation, plus one more in UTF-16 for each four byte sequence, which
+// is a surrogate pair.
+
+template<typename CharT>
+constexpr std::size_t scalar_transcoded_size(unsigned char const byte) {
+	return std::size_t(!is_continuation(byte)) + std::size_t(sizeof(CharT) == 2 and byte >= 0xf0);
+}
+
+template<typename CharT, utf8_byte Byte>
+constexpr std::size_t transcoded_size(Byte const * const data, std::size_t const size) {
+	auto result = std::size_t(0);
+	auto n = std::size_t(0);
+#if defined(__x86_64__)
+	if (!std::is_constant_evaluated()) {
+		auto const bytes = reinterpret_cast<char const *>(data);
+		// Continuation bytes are from -128 to -65 as signed
+		auto const last_continuation = _mm_set1_epi8(-65);
+		auto const four_byte_lead = _mm_set1_epi8(static_cast<char>(0xf0));
+		for (; size - n >= 16; n += 16) {
+			auto const input = load16(bytes + n);
+			result += static_cast<std::size_t>(std::popcount(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpgt_epi8(input, last_continuation)))));
+			if constexpr (sizeof(CharT) == 2) {
+				auto const leads = _mm_cmpeq_epi8(_mm_max_epu8(input, four_byte_lead), input);
+				result += static_cast<std::size_t>(std::popcount(static_cast<unsigned>(_mm_movemask_epi8(leads))));
+			}
+		}
+	}
+#endif
+	for (; n != size; ++n) {
+		result += scalar_transcoded_size<CharT>(static_cast<unsigned char>(data[n]));
+	}
+	return result;
+}
+
+// Decodes the sequence at data[n], and moves n past it
+template<utf8_byte Byte>
+constexpr char32_t decode_utf8(Byte const * const data, std::size_t & n) {
+	auto byte = [&](std::size_t const offset) {
+		return static_cast<char32_t>(static_cast<unsigned char>(data[n + offset]));
+	};
+	auto const lead = byte(0);
+	if (lead < 0x80) {
+		n += 1;
+		return lead;
+	} else if (lead < 0xe0) {
+		auto const result = ((lead & 0x1f) << 6) | (byte(1) & 0x3f);
+		n += 2;
+		return result;
+	} else if (lead < 0xf0) {
+		auto const result = ((lead & 0x0f) << 12) | ((byte(1) & 0x3f) << 6) | (byte(2) & 0x3f);
+		n += 3;
+		return result;
+	} else {
+		auto const result = ((lead & 0x07) << 18) | ((byte(1) & 0x3f) << 12) | ((byte(2) & 0x3f) << 6) | (byte(3) & 0x3f);
+		n += 4;
+		return result;
+	}
+}
+
+template<typename CharT>
+constexpr CharT * encode(char32_t const code_point, CharT * out) {
+	if constexpr (sizeof(CharT) == 4) {
+		*out = static_cast<CharT>(code_point);
+		return out + 1;
+	} else {
+		static_assert(sizeof(CharT) == 2);
+		if (code_point < 0x10000) {
+			*out = static_cast<CharT>(code_point);
+			return out + 1;
+		}
+		auto const offset = code_point - 0x10000;
+		out[0] = static_cast<CharT>(0xd800 + (offset >> 10));
+		out[1] = static_cast<CharT>(0xdc00 + (offset & 0x3ff));
+		return out + 2;
+	}
+}
+
+#if defined(__x86_64__)
+
+// Widens 16 ASCII bytes to 16 code units
+template<typename CharT>
+void store_ascii(__m128i const input, CharT * const out) {
+	auto const zero = _mm_setzero_si128();
+	auto const low = _mm_unpacklo_epi8(input, zero);
+	auto const high = _mm_unpackhi_epi8(input, zero);
+	if constexpr (sizeof(CharT) == 2) {
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out), low);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 8), high);
+	} else {
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_unpacklo_epi16(low, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 4), _mm_unpackhi_epi16(low, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 8), _mm_unpacklo_epi16(high, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 12), _mm_unpackhi_epi16(high, zero));
+	}
+}
+
+#endif
+
+// Blocks of 16 ASCII bytes are widened with one vector operation each. Other
+// blocks are decoded one code point at a time, which can end a few bytes
+// into the next block.
+template<utf8_byte Byte, typename CharT>
+constexpr CharT * transcode_utf8(Byte const * const data, std::size_t const size, CharT * out) {
+	auto n = std::size_t(0);
+#if defined(__x86_64__)
+	if (!std::is_constant_evaluated()) {
+		auto const bytes = reinterpret_cast<char const *>(data);
+		while (size - n >= 16) {
+			auto const input = load16(bytes + n);
+			if (_mm_movemask_epi8(input) == 0) {
+				store_ascii(input, out);
+				out += 16;
+				n += 16;
+				continue;
+			}
+			for (auto const block_end = n + 16; n < block_end;) {
+				out = encode(decode_utf8(data, n), out);
+			}
+		}
+	}
+#endif
+	while (n != size) {
+		out = encode(decode_utf8(data, n), out);
+	}
+	return out;
+}
+
+// Appends text to target, converted to the encoding of its character type:
+// UTF-8 for char8_t, UTF-16 for char16_t, or UTF-32 for char32_t. It
+// validates text first and returns false, leaving target as it was, if text
+// is not valid UTF-8. Otherwise it works out the exact size of the result,
+// so target grows at most once, and writes into the storage of target.
+template<typename String, utf8_byte Byte>
+constexpr bool append_utf8(String & target, Byte const * const data, std::size_t const size) {
+	using CharT = typename String::value_type;
+	if (!is_valid_utf8(data, size)) {
+		return false;
+	}
+	if constexpr (std::same_as<CharT, char8_t>) {
+		target.append_and_overwrite(size, [=](char8_t * const out) {
+			return std::transform(data, data + size, out, [](Byte const byte) { return static_cast<char8_t>(byte); });
+		});
+	} else {
+		static_assert(std::same_as<CharT, char16_t> or std::same_as<CharT, char32_t>);
+		target.append_and_overwrite(transcoded_size<CharT>(data, size), [=](CharT * const out) {
+			return transcode_utf8(data, size, out);
+		});
+	}
+	return true;
+}
+template<typename String>
+constexpr bool append_utf8(String & target, std::string_view const text) {
+	return append_utf8(target, text.data(), text.size());
+}
+template<typename String>
+constexpr bool append_utf8(String & target, std::u8string_view const text) {
+	return append_utf8(target, text.data(), text.size());
+}
+
+template<typename String, typename CharT>
+constexpr bool equal(String const & str, std::basic_string_view<CharT> const expected) {
+	return std::basic_string_view<CharT>(str.data(), str.size()) == expected;
+}
+
+template<typename String>
+constexpr String make_empty() {
+	return String(typename String::allocator_type());
+}
+
+// Each layout keeps its size for every character type, and fits as many
+// characters in its small buffer as the bytes allow
+static_assert(sizeof(clang::string<std::allocator<char>>) == 24);
+static_assert(sizeof(clang::u16string<std::allocator<char16_t>>) == 24);
+static_assert(sizeof(clang::u32string<std::allocator<char32_t>>) == 24);
+static_assert(sizeof(gcc::string<std::allocator<char>>) == 32);
+static_assert(sizeof(gcc::u16string<std::allocator<char16_t>>) == 32);
+static_assert(sizeof(gcc::u32string<std::allocator<char32_t>>) == 32);
+
+template<typename String>
+constexpr void test_basic_operations(std::size_t const small_capacity) {
+	using CharT = typename String::value_type;
+	auto str = make_empty<String>();
+	assert(str.capacity() == small_capacity);
+	for (std::size_t n = 0; n != 1000; ++n) {
+		str.insert(str.end(), static_cast<CharT>(n));
+		assert(str.size() == n + 1);
+		assert(str.capacity() >= str.size());
+	}
+	for (std::size_t n = 0; n != 1000; ++n) {
+		assert(str.data()[n] == static_cast<CharT>(n));
+	}
+	str.insert(str.begin() + 1, CharT(7));
+	assert(str.data()[0] == CharT(0) and str.data()[1] == CharT(7) and str.data()[2] == CharT(1));
+	auto moved = std::move(str);
+	assert(moved.size() == 1001);
+	while (moved.size() > small_capacity) {
+		moved.pop_back();
+	}
+	moved.shrink_to_fit();
+	assert(moved.capacity() == small_capacity);
+	assert(moved.data()[small_capacity - 1] == static_cast<CharT>(small_capacity - 2));
+}
+
+template<template<typename> typename Layout>
+constexpr void test_transcoding() {
+	constexpr auto text = std::u8string_view(u8"héllo € \U0001F600!");
+	auto utf16 = make_empty<Layout<std::allocator<char16_t>>>();
+	assert(append_utf8(utf16, text));
+	assert(equal(utf16, std::u16string_view(u"héllo € \U0001F600!")));
+	auto utf32 = make_empty<Layout<std::allocator<char32_t>>>();
+	assert(append_utf8(utf32, text));
+	assert(equal(utf32, std::u32string_view(U"héllo € \U0001F600!")));
+	// Appends to what is already there
+	assert(append_utf8(utf32, std::string_view("\xe2\x82\xac")));
+	assert(equal(utf32, std::u32string_view(U"héllo € \U0001F600!€")));
+	auto utf8 = make_empty<Layout<std::allocator<char8_t>>>();
+	assert(append_utf8(utf8, std::string_view("\xe2\x82\xac")));
+	assert(append_utf8(utf8, text));
+	assert(equal(utf8, std::u8string_view(u8"€héllo € \U0001F600!")));
+
+	auto invalid = make_empty<Layout<std::allocator<char16_t>>>();
+	assert(append_utf8(invalid, std::u8string_view(u8"ok, still valid")));
+	assert(!append_utf8(invalid, std::string_view("\xed\xa0\x80")));
+	assert(equal(invalid, std::u16string_view(u"ok, still valid")));
+}
+
+template<typename Allocator>
+using clang_layout = clang::basic_string<typename Allocator::value_type, Allocator>;
+template<typename Allocator>
+using gcc_layout = gcc::basic_string<typename Allocator::value_type, Allocator>;
+
+constexpr bool test() {
+	test_basic_operations<clang::string<std::allocator<char>>>(23);
+	test_basic_operations<clang::u16string<std::allocator<char16_t>>>(11);
+	test_basic_operations<clang::u32string<std::allocator<char32_t>>>(5);
+	test_basic_operations<gcc::string<std::allocator<char>>>(16);
+	test_basic_operations<gcc::u16string<std::allocator<char16_t>>>(8);
+	test_basic_operations<gcc::u32string<std::allocator<char32_t>>>(4);
+
+	assert(is_valid_utf8(""));
+	assert(is_valid_utf8("plain ASCII"));
+	assert(is_valid_utf8(u8"\u0080߿ࠀ퟿￿\U00010000\U0010FFFF"));
+	assert(!is_valid_utf8("\x80"));
+	// Overlong forms
+	assert(!is_valid_utf8("\xc0\x80"));
+	assert(!is_valid_utf8("\xc1\xbf"));
+	assert(!is_valid_utf8("\xe0\x9f\xbf"));
+	assert(!is_valid_utf8("\xf0\x8f\xbf\xbf"));
+	// Surrogates, and after U+10FFFF
+	assert(!is_valid_utf8("\xed\xa0\x80"));
+	assert(!is_valid_utf8("\xf4\x90\x80\x80"));
+	assert(!is_valid_utf8("\xf5\x80\x80\x80"));
+	// Cut off
+	assert(!is_valid_utf8("\xe2\x82"));
+	assert(!is_valid_utf8("\xe2\x82 "));
+
+	test_transcoding<clang_layout>();
+	test_transcoding<gcc_layout>();
+	return true;
+}
+
+// UTF-8 that is mostly valid, with some mistakes of every kind, from a mix
+// of ASCII and code points of each length
+std::string random_utf8(std::mt19937_64 & engine, std::size_t const code_points) {
+	auto result = std::string();
+	for (std::size_t n = 0; n != code_points; ++n) {
+		auto code_point = char32_t();
+		switch (engine() % 5) {
+			case 0: case 1: code_point = static_cast<char32_t>(engine() % 0x80); break;
+			case 2: code_point = static_cast<char32_t>(0x80 + engine() % (0x800 - 0x80)); break;
+			case 3: code_point = static_cast<char32_t>(0x800 + engine() % (0x10000 - 0x800)); break;
+			default: code_point = static_cast<char32_t>(0x10000 + engine() % (0x110000 - 0x10000)); break;
+		}
+		if (0xd800 <= code_point and code_point <= 0xdfff) {
+			code_point = U'x';
+		}
+		if (code_point < 0x80) {
+			result += static_cast<char>(code_point);
+		} else if (code_point < 0x800) {
+			result += static_cast<char>(0xc0 | (code_point >> 6));
+			result += static_cast<char>(0x80 | (code_point & 0x3f));
+		} else if (code_point < 0x10000) {
+			result += static_cast<char>(0xe0 | (code_point >> 12));
+			result += static_cast<char>(0x80 | ((code_point >> 6) & 0x3f));
+			result += static_cast<char>(0x80 | (code_point & 0x3f));
+		} else {
+			result += static_cast<char>(0xf0 | (code_point >> 18));
+			result += static_cast<char>(0x80 | ((code_point >> 12) & 0x3f));
+			result += static_cast<char>(0x80 | ((code_point >> 6) & 0x3f));
+			result += static_cast<char>(0x80 | (code_point & 0x3f));
+		}
+	}
+	if (!result.empty() and engine() % 2 == 0) {
+		auto const index = engine() % result.size();
+		switch (engine() % 3) {
+			case 0: result[index] = static_cast<char>(engine()); break;
+			case 1: result.erase(index, 1); break;
+			default: result.insert(index, 1, static_cast<char>(0x80 + engine() % 0x80)); break;
+		}
+	}
+	return result;
+}
+
+template<typename String>
+void check_transcoding(std::string const & text, bool const valid) {
+	using CharT = typename String::value_type;
+	auto str = make_empty<String>();
+	assert(append_utf8(str, text) == valid);
+	if (!valid) {
+		assert(str.size() == 0);
+		return;
+	}
+	auto expected = std::basic_string<CharT>();
+	for (std::size_t n = 0; n != text.size();) {
+		CharT buffer[2];
+		auto const end = encode(decode_utf8(text.data(), n), buffer);
+		for (auto it = buffer; it != end; ++it) {
+			expected.push_back(*it);
+		}
+	}
+	assert(equal(str, std::basic_string_view<CharT>(expected)));
+}
+
+void test_against_scalar() {
+	auto engine = std::mt19937_64(1);
+	for (int n = 0; n != 200'000; ++n) {
+		auto const text = random_utf8(engine, engine() % 80);
+		auto const valid = scalar_is_valid_utf8(text.data(), text.size());
+		assert(is_valid_utf8(text) == valid);
+#if defined(__x86_64__)
+		if (has_ssse3) {
+			assert(ssse3_is_valid_utf8(text.data(), text.size()) == valid);
+		}
+		if (has_avx2) {
+			assert(avx2_is_valid_utf8(text.data(), text.size()) == valid);
+		}
+#endif
+		check_transcoding<clang::u16string<std::allocator<char16_t>>>(text, valid);
+		check_transcoding<gcc::u32string<std::allocator<char32_t>>>(text, valid);
+	}
+}
+
+// Counts calls to the global operator new, which std::allocator uses
+std::size_t allocations = 0;
+
+void * operator new(std::size_t const size) {
+	++allocations;
+	if (auto const result = std::malloc(size)) {
+		return result;
+	}
+	throw std::bad_alloc();
+}
+void operator delete(void * const ptr) noexcept {
+	std::free(ptr);
+}
+void operator delete(void * const ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+template<typename Function>
+double nanoseconds_per_operation(std::size_t const count, Function && function) {
+	auto const start = std::chrono::steady_clock::now();
+	function();
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+}
+
+// JSON payloads, which are almost all ASCII
+std::vector<std::string> make_json_payloads(std::size_t const count) {
+	auto engine = std::mt19937_64(1);
+	auto result = std::vector<std::string>(count);
+	for (auto & payload : result) {
+		payload = "{\"id\":" + std::to_string(engine()) + ",\"items\":[";
+		for (int n = 0; n != 12; ++n) {
+			payload += "{\"sku\":\"SKU-" + std::to_string(engine() % 100'000) + "\",\"name\":\"Widget, size " + std::to_string(engine() % 50) + "\",\"price\":" + std::to_string(engine() % 10'000) + "},";
+		}
+		payload += "{\"note\":\"caf\xc3\xa9 \xe2\x82\xac" + std::to_string(engine() % 100) + "\"}]}";
+	}
+	return result;
+}
+
+// Text in a mix of languages, where most code points take two or three bytes
+std::vector<std::string> make_mixed_text(std::size_t const count) {
+	constexpr std::string_view words[] = {
+		"\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e",
+		"\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82",
+		"\xce\xba\xce\xb1\xce\xbb\xce\xb7\xce\xbc\xce\xad\xcf\x81\xce\xb1",
+		"hello",
+		"\xf0\x9f\x98\x80",
+		"\xed\x95\x9c\xea\xb5\xad\xec\x96\xb4",
+	};
+	auto engine = std::mt19937_64(1);
+	auto result = std::vector<std::string>(count);
+	for (auto & text : result) {
+		for (int n = 0; n != 60; ++n) {
+			text += words[engine() % std::size(words)];
+			text += ' ';
+		}
+	}
+	return result;
+}
+
+template<typename Function>
+void benchmark_one(char const * const name, std::vector<std::string> const & inputs, Function function) {
+	auto bytes = std::size_t(0);
+	for (auto const & input : inputs) {
+		bytes += input.size();
+	}
+	auto sink = std::size_t(0);
+	auto const before = allocations;
+	auto const time = nanoseconds_per_operation(bytes, [&] {
+		for (auto const & input : inputs) {
+			sink += function(input);
+		}
+	});
+	assert(sink != 0);
+	std::printf("%-44s %14.2f %14.2f\n", name, 1.0 / time, static_cast<double>(allocations - before) / static_cast<double>(inputs.size()));
+}
+
+// The usual way to decode: one code point at a time, with push_back
+std::size_t push_back_utf16(std::string const & text) {
+	if (!scalar_is_valid_utf8(text.data(), text.size())) {
+		return 0;
+	}
+	auto result = std::u16string();
+	for (std::size_t n = 0; n != text.size();) {
+		auto const code_point = decode_utf8(text.data(), n);
+		char16_t buffer[2];
+		auto const last = encode(code_point, buffer);
+		for (auto it = buffer; it != last; ++it) {
+			result.push_back(*it);
+		}
+	}
+	return result.size();
+}
+
+template<typename String>
+std::size_t append_to_layout(std::string const & text) {
+	auto result = make_empty<String>();
+	append_utf8(result, text);
+	return result.size();
+}
+
+void benchmark_inputs(char const * const description, std::vector<std::string> const & inputs) {
+	std::printf("%-44s %14s %14s\n", description, "GB per second", "allocations");
+	benchmark_one("validate: one code point at a time", inputs, [](std::string const & text) {
+		return std::size_t(scalar_is_valid_utf8(text.data(), text.size()));
+	});
+#if defined(__x86_64__)
+	if (has_ssse3) {
+		benchmark_one("validate: SSSE3", inputs, [](std::string const & text) {
+			return std::size_t(ssse3_is_valid_utf8(text.data(), text.size()));
+		});
+	}
+	if (has_avx2) {
+		benchmark_one("validate: AVX2", inputs, [](std::string const & text) {
+			return std::size_t(avx2_is_valid_utf8(text.data(), text.size()));
+		});
+	}
+#endif
+	benchmark_one("to UTF-16: std::u16string and push_back", inputs, push_back_utf16);
+	benchmark_one("to UTF-16: clang layout, append_utf8", inputs, append_to_layout<clang::u16string<std::allocator<char16_t>>>);
+	benchmark_one("to UTF-16: gcc layout, append_utf8", inputs, append_to_layout<gcc::u16string<std::allocator<char16_t>>>);
+	benchmark_one("to UTF-32: gcc layout, append_utf8", inputs, append_to_layout<gcc::u32string<std::allocator<char32_t>>>);
+	std::printf("\n");
+}
+
+void benchmark() {
+	benchmark_inputs("JSON payloads", make_json_payloads(20'000));
+	benchmark_inputs("Mixed languages", make_mixed_text(20'000));
+}
+
+int main() {
+	test();
+	static_assert(test());
+	test_against_scalar();
+	benchmark();
+}